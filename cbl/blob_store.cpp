@@ -0,0 +1,156 @@
+#include "blob_store.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "compressed_file.h"
+#include "date.h"
+#include "log.h"
+#include "sqlite.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace cbl {
+
+// The last access time of an entry is only updated if it is older than this, so that most reads do not require a
+// write transaction.
+static constexpr DateDiff ACCESS_TIME_RESOLUTION = DateDiff::fromHours(1);
+
+BlobStore::BlobStore(const string& path, const BlobStoreParams& params) : m_params(params) {
+  // Values can be downloaded again, so durability is not important.
+  m_database = sqlite::Database::open(path, {.synchronousMode = sqlite::SYNC_NORMAL}, [](sqlite::Database& database) {
+    database.execMany(
+        "CREATE TABLE blobs(key TEXT PRIMARY KEY, value BLOB NOT NULL, "
+        "uncompressed_size INTEGER NOT NULL, stored_size INTEGER NOT NULL, last_access INTEGER NOT NULL, "
+        "expiration INTEGER NOT NULL);"
+        "CREATE INDEX blobs_last_access ON blobs(last_access);");
+  });
+  m_database.execMany("PRAGMA journal_mode = WAL;", sqlite::UNLOCKED);
+}
+
+bool BlobStore::get(const string& key, string& value) {
+  const int64_t now = Date::now().toTimeT();
+  int64_t lastAccess = 0;
+  {
+    sqlite::ReadTransaction transaction(m_database, CBL_HERE);
+    sqlite::Statement statement = m_database.prepareAndBind(
+        "SELECT value, uncompressed_size, stored_size, last_access, expiration FROM blobs WHERE key = ?1;", key);
+    if (!statement.step()) {
+      return false;
+    }
+    int64_t expiration = statement.columnInt64(4);
+    if (expiration != 0 && expiration <= now) {
+      return false;
+    }
+    string_view storedValue(static_cast<const char*>(statement.columnBlob(0)), statement.columnSize(0));
+    int64_t uncompressedSize = statement.columnInt64(1);
+    value = statement.columnInt64(2) == uncompressedSize ? string(storedValue)
+                                                         : uncompressString(storedValue, uncompressedSize);
+    lastAccess = statement.columnInt64(3);
+  }
+  if (lastAccess + ACCESS_TIME_RESOLUTION.seconds() <= now) {
+    sqlite::WriteTransaction transaction(m_database, CBL_HERE);
+    m_database.exec("UPDATE blobs SET last_access = ?2 WHERE key = ?1;", key, now);
+    transaction.commit();
+  }
+  return true;
+}
+
+void BlobStore::put(const string& key, string_view value, DateDiff ttl) {
+  putInternal(key, value, ttl, /* replace = */ true);
+}
+
+bool BlobStore::putIfAbsent(const string& key, string_view value, DateDiff ttl) {
+  return putInternal(key, value, ttl, /* replace = */ false);
+}
+
+bool BlobStore::putInternal(const string& key, string_view value, DateDiff ttl, bool replace) {
+  const int64_t now = Date::now().toTimeT();
+  string compressedValue;
+  string_view storedValue = value;
+  if (m_params.compress) {
+    compressedValue = compressString(value);
+    if (compressedValue.size() < value.size()) {
+      storedValue = compressedValue;
+    }
+  }
+  sqlite::WriteTransaction transaction(m_database, CBL_HERE);
+  if (!replace) {
+    sqlite::Statement statement = m_database.prepareAndBind("SELECT expiration FROM blobs WHERE key = ?1;", key);
+    if (statement.step()) {
+      int64_t expiration = statement.columnInt64(0);
+      if (expiration == 0 || expiration > now) {
+        return false;
+      }
+    }
+  }
+  removeInTransaction(key);
+  sqlite::Statement statement = m_database.prepare(
+      "INSERT INTO blobs(key, value, uncompressed_size, stored_size, last_access, expiration) "
+      "VALUES (?1, ?2, ?3, ?4, ?5, ?6);");
+  statement.bind(1, key);
+  statement.bindBlob(2, storedValue);
+  statement.bind(3, static_cast<int64_t>(value.size()));
+  statement.bind(4, static_cast<int64_t>(storedValue.size()));
+  statement.bind(5, now);
+  statement.bind(6, ttl == DateDiff::nullDiff() ? int64_t(0) : now + ttl.seconds());
+  statement.step();
+  m_database.saveGlobalInt64("blobs_total_size",
+                             m_database.loadGlobalInt64("blobs_total_size", 0) + storedValue.size());
+  evictIfNeeded();
+  transaction.commit();
+  return true;
+}
+
+void BlobStore::remove(const string& key) {
+  sqlite::WriteTransaction transaction(m_database, CBL_HERE);
+  removeInTransaction(key);
+  transaction.commit();
+}
+
+void BlobStore::removeInTransaction(const string& key) {
+  sqlite::Statement statement = m_database.prepareAndBind("SELECT stored_size FROM blobs WHERE key = ?1;", key);
+  if (statement.step()) {
+    int64_t storedSize = statement.columnInt64(0);
+    m_database.exec("DELETE FROM blobs WHERE key = ?1;", key);
+    m_database.saveGlobalInt64("blobs_total_size", m_database.loadGlobalInt64("blobs_total_size", 0) - storedSize);
+  }
+}
+
+void BlobStore::evictIfNeeded() {
+  if (m_params.maxSize <= 0) return;
+  int64_t totalSize = m_database.loadGlobalInt64("blobs_total_size", 0);
+  if (totalSize <= m_params.maxSize) return;
+  const int64_t targetSize = m_params.maxSize - m_params.maxSize / 10;
+  vector<string> keysToRemove;
+  {
+    // Expired entries first, then the least recently used ones.
+    sqlite::Statement statement = m_database.prepareAndBind(
+        "SELECT key, stored_size FROM blobs ORDER BY expiration != 0 AND expiration <= ?1 DESC, last_access, rowid;",
+        static_cast<int64_t>(Date::now().toTimeT()));
+    while (totalSize > targetSize && statement.step()) {
+      keysToRemove.emplace_back(statement.columnTextNotNull(0));
+      totalSize -= statement.columnInt64(1);
+    }
+  }
+  for (const string& key : keysToRemove) {
+    m_database.exec("DELETE FROM blobs WHERE key = ?1;", key);
+  }
+  m_database.saveGlobalInt64("blobs_total_size", totalSize);
+}
+
+int64_t BlobStore::numEntries() {
+  sqlite::ReadTransaction transaction(m_database, CBL_HERE);
+  sqlite::Statement statement = m_database.prepare("SELECT COUNT(*) FROM blobs;");
+  CBL_ASSERT(statement.step());
+  return statement.columnInt64(0);
+}
+
+int64_t BlobStore::totalSize() {
+  sqlite::ReadTransaction transaction(m_database, CBL_HERE);
+  return m_database.loadGlobalInt64("blobs_total_size", 0);
+}
+
+}  // namespace cbl
@@ -0,0 +1,53 @@
+// Size-bounded key-value store of blobs in a SQLite database, used for data that can be downloaded again if it is
+// evicted (e.g. HTTP responses or the content of revisions).
+// Values are compressed if this makes them smaller. Each entry has an optional expiration date. When the total size
+// exceeds the maximum, expired entries and then least recently used entries are evicted.
+// The database can be shared by several processes. It is in WAL mode, so that readers are not blocked by writers.
+#ifndef CBL_BLOB_STORE_H
+#define CBL_BLOB_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "date.h"
+#include "sqlite.h"
+
+namespace cbl {
+
+struct BlobStoreParams {
+  // Maximum total size of stored values, after compression. When it is exceeded, expired entries and then least
+  // recently used entries are evicted until the size goes down to 90% of the maximum. 0 means no limit.
+  int64_t maxSize = 0;
+  // If true, values are compressed with zlib (unless the compressed version is not smaller).
+  bool compress = true;
+};
+
+class BlobStore {
+public:
+  explicit BlobStore(const std::string& path, const BlobStoreParams& params = {});
+
+  // If the store contains a non-expired entry for key, sets value to it and returns true.
+  bool get(const std::string& key, std::string& value);
+  // Adds or replaces the entry for key. nullDiff() means that the entry never expires.
+  void put(const std::string& key, std::string_view value, DateDiff ttl = DateDiff::nullDiff());
+  // Adds an entry for key if there is no non-expired one. Returns true if the entry was added.
+  bool putIfAbsent(const std::string& key, std::string_view value, DateDiff ttl = DateDiff::nullDiff());
+  void remove(const std::string& key);
+
+  int64_t numEntries();
+  // Total size of stored values, after compression.
+  int64_t totalSize();
+
+private:
+  bool putInternal(const std::string& key, std::string_view value, DateDiff ttl, bool replace);
+  // These functions must be called within a write transaction.
+  void removeInTransaction(const std::string& key);
+  void evictIfNeeded();
+
+  sqlite::Database m_database;
+  BlobStoreParams m_params;
+};
+
+}  // namespace cbl
+
+#endif
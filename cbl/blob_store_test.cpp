@@ -0,0 +1,92 @@
+#include "blob_store.h"
+#include <string>
+#include "date.h"
+#include "log.h"
+#include "tempfile.h"
+#include "unittest.h"
+
+using std::string;
+
+namespace cbl {
+
+class BlobStoreTest : public cbl::Test {
+private:
+  void setUp() override { Date::setFrozenValueOfNow(Date::fromISO8601("2020-01-01T00:00:00Z")); }
+
+  CBL_TEST_CASE(GetPutRemove) {
+    TempDir tempDir;
+    string value;
+    {
+      BlobStore store(tempDir.path() + "/store.sqlite");
+      CBL_ASSERT(!store.get("k1", value));
+      store.put("k1", "short");
+      store.put("k2", string(10000, 'x'));
+      store.put("k3", "");
+      CBL_ASSERT(store.get("k1", value));
+      CBL_ASSERT_EQ(value, "short");
+      CBL_ASSERT(store.get("k3", value));
+      CBL_ASSERT_EQ(value, "");
+      store.put("k1", "replaced");
+      CBL_ASSERT_EQ(store.numEntries(), 3);
+      // "short" and "replaced" are not compressed, but 10000 'x' are.
+      CBL_ASSERT(store.totalSize() > 8 && store.totalSize() < 200) << store.totalSize();
+      store.remove("k3");
+      store.remove("k4");
+      CBL_ASSERT(!store.get("k3", value));
+      CBL_ASSERT_EQ(store.numEntries(), 2);
+    }
+    // The data is persistent.
+    BlobStore store(tempDir.path() + "/store.sqlite", {.compress = false});
+    CBL_ASSERT(store.get("k1", value));
+    CBL_ASSERT_EQ(value, "replaced");
+    CBL_ASSERT(store.get("k2", value));
+    CBL_ASSERT_EQ(value, string(10000, 'x'));
+    store.put("k5", string(1000, 'y'));
+    CBL_ASSERT(store.totalSize() > 1000 && store.totalSize() < 1200) << store.totalSize();
+  }
+
+  CBL_TEST_CASE(PutIfAbsent) {
+    TempDir tempDir;
+    BlobStore store(tempDir.path() + "/store.sqlite");
+    CBL_ASSERT(store.putIfAbsent("k1", "first", DateDiff::fromHours(1)));
+    CBL_ASSERT(!store.putIfAbsent("k1", "second"));
+    string value;
+    CBL_ASSERT(store.get("k1", value));
+    CBL_ASSERT_EQ(value, "first");
+    // An expired entry is replaced.
+    Date::advanceFrozenClock(DateDiff::fromHours(2));
+    CBL_ASSERT(store.putIfAbsent("k1", "third"));
+    CBL_ASSERT(store.get("k1", value));
+    CBL_ASSERT_EQ(value, "third");
+    CBL_ASSERT_EQ(store.numEntries(), 1);
+  }
+
+  CBL_TEST_CASE(Eviction) {
+    TempDir tempDir;
+    BlobStore store(tempDir.path() + "/store.sqlite", {.maxSize = 1000, .compress = false});
+    for (int i = 0; i < 9; i++) {
+      store.put("k" + std::to_string(i), string(100, 'a' + i), i == 5 ? DateDiff::fromHours(1) : DateDiff::nullDiff());
+      Date::advanceFrozenClock(DateDiff::fromHours(2));
+    }
+    string value;
+    // k0 is the least recently used entry after this.
+    CBL_ASSERT(store.get("k1", value));
+    Date::advanceFrozenClock(DateDiff::fromHours(2));
+    CBL_ASSERT_EQ(store.totalSize(), 900);
+    // 1100 > 1000, so the size is reduced to 900 by evicting the expired entry k5 and the least recently used k0.
+    store.put("k9", string(200, 'z'));
+    CBL_ASSERT_EQ(store.totalSize(), 900);
+    CBL_ASSERT(!store.get("k0", value));
+    CBL_ASSERT(!store.get("k5", value));
+    for (const char* key : {"k1", "k2", "k8", "k9"}) {
+      CBL_ASSERT(store.get(key, value)) << key;
+    }
+  }
+};
+
+}  // namespace cbl
+
+int main() {
+  cbl::BlobStoreTest().run();
+  return 0;
+}
@@ -0,0 +1,242 @@
+#include "compressed_file.h"
+#include <sys/stat.h>
+#include <zlib.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <ios>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include "error.h"
+
+using std::string;
+using std::string_view;
+
+namespace cbl {
+
+// Size of the buffer of the FILE*, i.e. of blocks sent to the background thread.
+static constexpr int WRITER_BLOCK_SIZE = 1 << 20;
+// Maximum number of blocks waiting to be compressed.
+static constexpr int WRITER_MAX_PENDING_BLOCKS = 4;
+
+bool isCompressedFileName(string_view path) {
+  return path.ends_with(".gz");
+}
+
+string compressString(string_view value, int compressionLevel) {
+  uLongf compressedSize = compressBound(value.size());
+  string compressed(compressedSize, '\0');
+  int result = compress2(reinterpret_cast<Bytef*>(compressed.data()), &compressedSize,
+                         reinterpret_cast<const Bytef*>(value.data()), value.size(), compressionLevel);
+  if (result != Z_OK) {
+    throw InternalError("compress2() failed with code " + std::to_string(result));
+  }
+  compressed.resize(compressedSize);
+  return compressed;
+}
+
+string uncompressString(string_view compressed, int64_t size) {
+  string value(size, '\0');
+  uLongf actualSize = size;
+  int result = uncompress(reinterpret_cast<Bytef*>(value.data()), &actualSize,
+                          reinterpret_cast<const Bytef*>(compressed.data()), compressed.size());
+  if (result != Z_OK || static_cast<int64_t>(actualSize) != size) {
+    throw InternalError("Corrupted compressed data (uncompress() returned " + std::to_string(result) + ")");
+  }
+  return value;
+}
+
+CompressedFileWriter::CompressedFileWriter(const string& path, bool append, int compressionLevel) : m_path(path) {
+  if (compressionLevel < 0 || compressionLevel > 9) {
+    throw std::invalid_argument("Invalid compression level for CompressedFileWriter");
+  }
+  // gzopen() is called lazily by the background thread, always in append mode since each gzip member is written
+  // separately. Creating or truncating the file here ensures that it exists even if nothing is written.
+  FILE* file = fopen(path.c_str(), append ? "a" : "w");
+  if (file == nullptr) {
+    throw SystemError("Cannot open '" + path + "' for writing: " + getCErrorString(errno));
+  }
+  fclose(file);
+  m_gzMode = "ab" + std::to_string(compressionLevel);
+  m_file = fopencookie(this, "w", {.read = nullptr, .write = writeToQueue, .seek = nullptr, .close = nullptr});
+  if (m_file == nullptr) {
+    throw SystemError("Cannot create stream for '" + path + "'");
+  }
+  setvbuf(m_file, nullptr, _IOFBF, WRITER_BLOCK_SIZE);
+  m_thread = std::thread([this]() { runCompression(); });
+}
+
+CompressedFileWriter::~CompressedFileWriter() {
+  if (m_file != nullptr) {
+    try {
+      close();
+    } catch (const SystemError&) {
+    }
+  }
+}
+
+ssize_t CompressedFileWriter::writeToQueue(void* cookie, const char* buffer, size_t size) {
+  CompressedFileWriter* writer = static_cast<CompressedFileWriter*>(cookie);
+  writer->pushBlock({.data = string(buffer, size)});
+  std::lock_guard<std::mutex> lock(writer->m_mutex);
+  return writer->m_error ? -1 : size;
+}
+
+void CompressedFileWriter::pushBlock(Block&& block) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_queueChanged.wait(lock, [this]() { return m_pendingBlocks < WRITER_MAX_PENDING_BLOCKS; });
+  m_queue.push_back(std::move(block));
+  m_pendingBlocks++;
+  m_queueChanged.notify_all();
+}
+
+void CompressedFileWriter::waitForQueue() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_queueChanged.wait(lock, [this]() { return m_pendingBlocks == 0; });
+}
+
+int64_t CompressedFileWriter::sync() {
+  if (fflush(m_file) != 0) {
+    throw SystemError("Cannot write to '" + m_path + "'");
+  }
+  pushBlock({.endMember = true});
+  waitForQueue();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_error) {
+      throw SystemError("Cannot write to '" + m_path + "'");
+    }
+  }
+  struct stat fileStat;
+  if (stat(m_path.c_str(), &fileStat) != 0) {
+    throw SystemError("Cannot get the size of '" + m_path + "': " + getCErrorString(errno));
+  }
+  return fileStat.st_size;
+}
+
+void CompressedFileWriter::close() {
+  bool success = fclose(m_file) == 0;
+  m_file = nullptr;
+  pushBlock({.endMember = true});
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopRequested = true;
+    m_queueChanged.notify_all();
+  }
+  m_thread.join();
+  if (!success || m_error) {
+    throw SystemError("Cannot write to '" + m_path + "'");
+  }
+}
+
+void CompressedFileWriter::runCompression() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_queueChanged.wait(lock, [this]() { return !m_queue.empty() || m_stopRequested; });
+    if (m_queue.empty()) {
+      break;
+    }
+    Block block = std::move(m_queue.front());
+    m_queue.pop_front();
+    bool error = m_error;
+    lock.unlock();
+    if (!error) {
+      error = !writeBlock(block);
+    }
+    lock.lock();
+    m_error = error;
+    m_pendingBlocks--;
+    m_queueChanged.notify_all();
+  }
+}
+
+bool CompressedFileWriter::writeBlock(const Block& block) {
+  if (!block.data.empty()) {
+    if (m_gzFile == nullptr) {
+      m_gzFile = gzopen(m_path.c_str(), m_gzMode.c_str());
+      if (m_gzFile == nullptr) {
+        return false;
+      }
+      gzbuffer(m_gzFile, 1 << 17);
+    }
+    if (gzwrite(m_gzFile, block.data.data(), block.data.size()) == 0) {
+      return false;
+    }
+  }
+  return block.endMember ? endMember() : true;
+}
+
+bool CompressedFileWriter::endMember() {
+  if (m_gzFile == nullptr) {
+    return true;
+  }
+  int result = gzclose(m_gzFile);
+  m_gzFile = nullptr;
+  return result == Z_OK;
+}
+
+CompressedFileInputStream::CompressedFileInputStream(const string& path) : std::istream(nullptr), m_buffer(path) {
+  rdbuf(&m_buffer);
+  if (!m_buffer.isOpen()) {
+    setstate(std::ios_base::failbit);
+  }
+  exceptions(std::ios_base::badbit);
+}
+
+CompressedFileInputStream::Buffer::Buffer(const string& path) : m_path(path) {
+  // gzopen() reads files that are not in gzip format as is.
+  m_gzFile = gzopen(path.c_str(), "rb");
+  if (m_gzFile != nullptr) {
+    gzbuffer(m_gzFile, 1 << 17);
+  }
+}
+
+CompressedFileInputStream::Buffer::~Buffer() {
+  if (m_gzFile != nullptr) {
+    gzclose(m_gzFile);
+  }
+}
+
+CompressedFileInputStream::Buffer::int_type CompressedFileInputStream::Buffer::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  } else if (m_gzFile == nullptr) {
+    return traits_type::eof();
+  }
+  int bytesRead = gzread(m_gzFile, m_buffer, sizeof(m_buffer));
+  if (bytesRead <= 0) {
+    // gzread() returns 0 on a truncated file, so the error state must be checked in that case too.
+    int errorCode = Z_OK;
+    const char* errorMessage = gzerror(m_gzFile, &errorCode);
+    if (bytesRead < 0 || errorCode != Z_OK) {
+      throw SystemError("Cannot read '" + m_path + "': " + errorMessage);
+    }
+    return traits_type::eof();
+  }
+  setg(m_buffer, m_buffer, m_buffer + bytesRead);
+  return traits_type::to_int_type(*gptr());
+}
+
+CompressedFileInputStream::Buffer::pos_type CompressedFileInputStream::Buffer::seekoff(off_type offset,
+                                                                                       std::ios_base::seekdir direction,
+                                                                                       std::ios_base::openmode mode) {
+  if (direction != std::ios_base::beg) {
+    return pos_type(off_type(-1));
+  }
+  return seekpos(pos_type(offset), mode);
+}
+
+CompressedFileInputStream::Buffer::pos_type CompressedFileInputStream::Buffer::seekpos(pos_type position,
+                                                                                       std::ios_base::openmode mode) {
+  if (position != pos_type(0) || m_gzFile == nullptr || gzrewind(m_gzFile) != 0) {
+    return pos_type(off_type(-1));
+  }
+  setg(m_buffer, m_buffer, m_buffer);
+  return position;
+}
+
+}  // namespace cbl
@@ -0,0 +1,118 @@
+// Transparent gzip compression of large text files.
+// Writers compress files whose name ends with ".gz" (see isCompressedFileName). Readers accept both compressed and
+// plain files, so that a tool can read the output of another one without knowing how it was written.
+#ifndef CBL_COMPRESSED_FILE_H
+#define CBL_COMPRESSED_FILE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+
+struct gzFile_s;
+
+namespace cbl {
+
+// Returns true if `path` ends with ".gz".
+bool isCompressedFileName(std::string_view path);
+
+// Compresses `value` in the zlib format. Unlike gzip files, the result does not contain the size of the original data,
+// so callers must store it to pass it to uncompressString().
+// Throws: InternalError.
+std::string compressString(std::string_view value, int compressionLevel = 6);
+// Throws: InternalError if `compressed` is corrupted or does not uncompress to exactly `size` bytes.
+std::string uncompressString(std::string_view compressed, int64_t size);
+
+// Writes a gzip file through a standard FILE*, so that code using fprintf() or fwrite() works unchanged.
+// Data written to file() is compressed by a background thread. The writing thread only copies it to a queue and waits
+// only if compression falls behind by more than a few buffers.
+class CompressedFileWriter {
+public:
+  // Creates or truncates `path`. If `append` is true, data is appended to the existing file as a new gzip member,
+  // which is still a valid gzip file.
+  // Throws: SystemError.
+  explicit CompressedFileWriter(const std::string& path, bool append = false, int compressionLevel = 6);
+  // Calls close() if needed, ignoring errors.
+  ~CompressedFileWriter();
+  CompressedFileWriter(const CompressedFileWriter&) = delete;
+  CompressedFileWriter& operator=(const CompressedFileWriter&) = delete;
+
+  FILE* file() const { return m_file; }
+  // Waits until everything written so far is compressed and written, then ends the current gzip member. Returns the
+  // size of the file. Truncating the file to that size later and reopening it with `append` = true gives a valid
+  // file with the same content.
+  // Throws: SystemError.
+  int64_t sync();
+  // Flushes and closes the file. file() must not be used after that.
+  // Throws: SystemError.
+  void close();
+
+private:
+  struct Block {
+    std::string data;
+    // If true, the current gzip member is ended after writing data.
+    bool endMember = false;
+  };
+
+  static ssize_t writeToQueue(void* cookie, const char* buffer, size_t size);
+  void pushBlock(Block&& block);
+  // Waits until the background thread has processed all blocks.
+  void waitForQueue();
+  void runCompression();
+  // Functions called from the background thread. They return false on error.
+  bool writeBlock(const Block& block);
+  bool endMember();
+
+  std::string m_path;
+  std::string m_gzMode;
+  FILE* m_file = nullptr;
+  gzFile_s* m_gzFile = nullptr;
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_queueChanged;
+  std::deque<Block> m_queue;
+  // Blocks in m_queue plus the one being processed by the background thread.
+  int m_pendingBlocks = 0;
+  bool m_stopRequested = false;
+  bool m_error = false;
+};
+
+// Input stream reading a gzip file or a plain file. Like std::ifstream, the failbit is set if the file cannot be
+// opened. Seeking is only supported to the beginning of the file.
+// Read errors, including truncated or corrupted gzip data, throw SystemError. Unlike std::ifstream, the badbit is
+// enabled in exceptions(), so that a corrupted file is not mistaken for a shorter one by callers that only check for
+// the end of the stream.
+class CompressedFileInputStream : public std::istream {
+public:
+  explicit CompressedFileInputStream(const std::string& path);
+
+private:
+  class Buffer : public std::streambuf {
+  public:
+    explicit Buffer(const std::string& path);
+    ~Buffer();
+    bool isOpen() const { return m_gzFile != nullptr; }
+
+  protected:
+    int_type underflow() override;
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) override;
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode) override;
+
+  private:
+    std::string m_path;
+    gzFile_s* m_gzFile = nullptr;
+    char m_buffer[1 << 16];
+  };
+
+  Buffer m_buffer;
+};
+
+}  // namespace cbl
+
+#endif
@@ -0,0 +1,128 @@
+#include "compressed_file.h"
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <ios>
+#include <string>
+#include "error.h"
+#include "file.h"
+#include "log.h"
+#include "tempfile.h"
+#include "unittest.h"
+
+using std::string;
+
+namespace cbl {
+
+class CompressedFileTest : public cbl::Test {
+private:
+  static string readWholeStream(std::istream& stream) {
+    string content, line;
+    while (std::getline(stream, line)) {
+      content += line;
+      content += '\n';
+    }
+    return content;
+  }
+
+  CBL_TEST_CASE(isCompressedFileName) {
+    CBL_ASSERT(isCompressedFileName("/tmp/templates.dat.gz"));
+    CBL_ASSERT(!isCompressedFileName("/tmp/templates.dat"));
+    CBL_ASSERT(!isCompressedFileName("/tmp/templates.gz.delta"));
+  }
+
+  CBL_TEST_CASE(WriteAndRead) {
+    TempDir tempDir;
+    const string path = tempDir.path() + "/file.gz";
+    string expectedContent;
+    {
+      CompressedFileWriter writer(path);
+      // Large enough to go through several blocks.
+      for (int i = 0; i < 200000; i++) {
+        string line = "Line " + std::to_string(i) + "\n";
+        fputs(line.c_str(), writer.file());
+        expectedContent += line;
+      }
+      writer.close();
+    }
+    string compressedContent = readFile(path);
+    CBL_ASSERT(compressedContent.starts_with("\x1F\x8B"));
+    CBL_ASSERT(compressedContent.size() < expectedContent.size() / 2);
+    CompressedFileInputStream stream(path);
+    CBL_ASSERT(stream);
+    CBL_ASSERT_EQ(readWholeStream(stream), expectedContent);
+    // Rewinding is supported.
+    stream.clear();
+    stream.seekg(0);
+    string line;
+    CBL_ASSERT(std::getline(stream, line));
+    CBL_ASSERT_EQ(line, "Line 0");
+  }
+
+  CBL_TEST_CASE(SyncTruncateAndAppend) {
+    TempDir tempDir;
+    const string path = tempDir.path() + "/file.gz";
+    int64_t size = 0;
+    {
+      CompressedFileWriter writer(path);
+      fputs("first\n", writer.file());
+      size = writer.sync();
+      fputs("lost\n", writer.file());
+      writer.close();
+    }
+    CBL_ASSERT_EQ(truncate(path.c_str(), size), 0);
+    {
+      CompressedFileWriter writer(path, /* append = */ true);
+      fputs("second\n", writer.file());
+      writer.close();
+    }
+    CompressedFileInputStream stream(path);
+    CBL_ASSERT_EQ(readWholeStream(stream), "first\nsecond\n");
+  }
+
+  CBL_TEST_CASE(ReadPlainFile) {
+    TempDir tempDir;
+    const string path = tempDir.path() + "/file.txt";
+    writeFile(path, "a\nb\n");
+    CompressedFileInputStream stream(path);
+    CBL_ASSERT_EQ(readWholeStream(stream), "a\nb\n");
+  }
+
+  CBL_TEST_CASE(TruncatedFile) {
+    TempDir tempDir;
+    const string path = tempDir.path() + "/file.gz";
+    {
+      CompressedFileWriter writer(path);
+      for (int i = 0; i < 10000; i++) {
+        fprintf(writer.file(), "Line %i\n", i);
+      }
+      writer.close();
+    }
+    CBL_ASSERT_EQ(truncate(path.c_str(), readFile(path).size() / 2), 0);
+    CompressedFileInputStream stream(path);
+    string line;
+    int numLines = 0;
+    try {
+      while (std::getline(stream, line)) {
+        numLines++;
+      }
+      CBL_ASSERT(false) << "SystemError not thrown";
+    } catch (const SystemError&) {
+    }
+    CBL_ASSERT(numLines > 0 && numLines < 10000) << numLines;
+    CBL_ASSERT(stream.bad());
+  }
+
+  CBL_TEST_CASE(MissingFile) {
+    TempDir tempDir;
+    CompressedFileInputStream stream(tempDir.path() + "/missing.gz");
+    CBL_ASSERT(!stream);
+  }
+};
+
+}  // namespace cbl
+
+int main() {
+  cbl::CompressedFileTest().run();
+  return 0;
+}
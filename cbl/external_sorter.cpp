@@ -0,0 +1,228 @@
+#include "external_sorter.h"
+#include <unistd.h>
+#include <zlib.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "error.h"
+
+using std::string;
+using std::string_view;
+using std::unique_ptr;
+using std::vector;
+
+namespace cbl {
+namespace {
+
+uint64_t computePrefix(string_view line) {
+  uint64_t prefix = 0;
+  size_t prefixLength = std::min<size_t>(line.size(), sizeof(prefix));
+  for (size_t i = 0; i < sizeof(prefix); i++) {
+    prefix = (prefix << 8) | (i < prefixLength ? static_cast<unsigned char>(line[i]) : 0);
+  }
+  return prefix;
+}
+
+// Reads lines from a run written by ExternalSorter::writeRun.
+class RunReader {
+public:
+  explicit RunReader(const string& path) : m_path(path) {
+    m_file = gzopen(path.c_str(), "rb");
+    if (m_file == nullptr) {
+      throw SystemError("Cannot open temporary file '" + path + "'");
+    }
+    gzbuffer(m_file, 1 << 17);
+  }
+  ~RunReader() { gzclose(m_file); }
+
+  // Reads the next line into line(). Returns false at the end of the file.
+  bool next() {
+    m_lineStart = m_lineEnd;
+    size_t newLinePosition = m_buffer.find('\n', m_lineStart);
+    while (newLinePosition == string::npos) {
+      // Drop lines already read before reading more data.
+      m_buffer.erase(0, m_lineStart);
+      m_lineStart = 0;
+      size_t oldSize = m_buffer.size();
+      m_buffer.resize(oldSize + BLOCK_SIZE);
+      int bytesRead = gzread(m_file, &m_buffer[oldSize], BLOCK_SIZE);
+      if (bytesRead < 0) {
+        throw SystemError("Cannot read temporary file '" + m_path + "'");
+      }
+      m_buffer.resize(oldSize + bytesRead);
+      if (bytesRead == 0) {
+        if (!m_buffer.empty()) {
+          throw SystemError("Temporary file '" + m_path + "' is truncated");
+        }
+        return false;
+      }
+      newLinePosition = m_buffer.find('\n', oldSize);
+    }
+    m_lineEnd = newLinePosition + 1;
+    return true;
+  }
+  string_view line() const { return string_view(m_buffer).substr(m_lineStart, m_lineEnd - 1 - m_lineStart); }
+
+private:
+  static constexpr int BLOCK_SIZE = 1 << 16;
+
+  string m_path;
+  gzFile m_file = nullptr;
+  string m_buffer;
+  size_t m_lineStart = 0;
+  size_t m_lineEnd = 0;
+};
+
+}  // namespace
+
+ExternalSorter::ExternalSorter(const Params& params) : m_params(params), m_chunk(std::make_unique<Chunk>()) {
+  if (m_params.numThreads < 1 || m_params.compressionLevel < 0 || m_params.compressionLevel > 9) {
+    throw std::invalid_argument("Invalid parameters for ExternalSorter");
+  }
+  // One chunk is being filled while up to numThreads other chunks are sorted and written.
+  m_chunkMemoryLimit = std::max<int64_t>(m_params.memoryBudget / (m_params.numThreads + 1), 1);
+}
+
+ExternalSorter::~ExternalSorter() {
+  for (std::future<void>& pendingRun : m_pendingRuns) {
+    pendingRun.wait();
+  }
+  removeRuns();
+}
+
+void ExternalSorter::add(string_view line) {
+  if (m_finished) {
+    throw InvalidStateError("ExternalSorter::add() called after finish()");
+  }
+  Chunk& chunk = *m_chunk;
+  chunk.entries.push_back({.prefix = computePrefix(line), .offset = chunk.data.size(), .length = line.size()});
+  chunk.data += line;
+  if (chunk.memoryUsage() >= m_chunkMemoryLimit) {
+    flushChunk();
+  }
+}
+
+string_view ExternalSorter::getLine(const Chunk& chunk, const Entry& entry) {
+  return string_view(chunk.data).substr(entry.offset, entry.length);
+}
+
+void ExternalSorter::sortChunk(Chunk& chunk) {
+  std::sort(chunk.entries.begin(), chunk.entries.end(), [&chunk](const Entry& entry1, const Entry& entry2) {
+    if (entry1.prefix != entry2.prefix) {
+      return entry1.prefix < entry2.prefix;
+    }
+    // string_view comparison uses memcmp, so this is the byte order.
+    return getLine(chunk, entry1) < getLine(chunk, entry2);
+  });
+}
+
+void ExternalSorter::writeRun(Chunk& chunk, const string& path) const {
+  sortChunk(chunk);
+  string mode = m_params.compressionLevel == 0 ? "wbT" : "wb" + std::to_string(m_params.compressionLevel);
+  gzFile file = gzopen(path.c_str(), mode.c_str());
+  if (file == nullptr) {
+    throw SystemError("Cannot create temporary file '" + path + "'");
+  }
+  gzbuffer(file, 1 << 17);
+  bool success = true;
+  for (const Entry& entry : chunk.entries) {
+    string_view line = getLine(chunk, entry);
+    if ((!line.empty() && gzwrite(file, line.data(), line.size()) == 0) || gzputc(file, '\n') == -1) {
+      success = false;
+      break;
+    }
+  }
+  if (gzclose(file) != Z_OK || !success) {
+    throw SystemError("Cannot write temporary file '" + path + "'");
+  }
+}
+
+void ExternalSorter::flushChunk() {
+  if (static_cast<int>(m_pendingRuns.size()) >= m_params.numThreads) {
+    m_pendingRuns.front().get();
+    m_pendingRuns.pop_front();
+  }
+  string path = m_params.tempDir + "/sortXXXXXX";
+  int fd = mkstemp(&path[0]);
+  if (fd == -1) {
+    throw SystemError("Cannot create temporary file in '" + m_params.tempDir + "': " + getCErrorString(errno));
+  }
+  close(fd);
+  m_runPaths.push_back(path);
+  std::shared_ptr<Chunk> chunk(m_chunk.release());
+  m_chunk = std::make_unique<Chunk>();
+  m_pendingRuns.push_back(std::async(std::launch::async, [this, chunk, path]() { writeRun(*chunk, path); }));
+}
+
+void ExternalSorter::finish(const std::function<void(string_view)>& callback) {
+  if (m_finished) {
+    throw InvalidStateError("ExternalSorter::finish() called twice");
+  }
+  m_finished = true;
+  if (m_runPaths.empty()) {
+    sortChunk(*m_chunk);
+    for (const Entry& entry : m_chunk->entries) {
+      callback(getLine(*m_chunk, entry));
+    }
+    m_chunk.reset();
+    return;
+  }
+
+  if (!m_chunk->entries.empty()) {
+    flushChunk();
+  }
+  m_chunk.reset();
+  for (; !m_pendingRuns.empty(); m_pendingRuns.pop_front()) {
+    m_pendingRuns.front().get();
+  }
+
+  vector<unique_ptr<RunReader>> readers;
+  // Min-heap of indices of readers, ordered by their current line.
+  auto compareReaders = [&readers](int index1, int index2) {
+    return readers[index1]->line() > readers[index2]->line();
+  };
+  std::priority_queue<int, vector<int>, decltype(compareReaders)> queue(compareReaders);
+  for (const string& path : m_runPaths) {
+    readers.push_back(std::make_unique<RunReader>(path));
+    if (readers.back()->next()) {
+      queue.push(readers.size() - 1);
+    }
+  }
+  while (!queue.empty()) {
+    int index = queue.top();
+    queue.pop();
+    callback(readers[index]->line());
+    if (readers[index]->next()) {
+      queue.push(index);
+    }
+  }
+  readers.clear();
+  removeRuns();
+}
+
+void ExternalSorter::finish(FILE* file) {
+  finish([file](string_view line) {
+    if (fwrite(line.data(), 1, line.size(), file) != line.size() || putc('\n', file) == EOF) {
+      throw SystemError("Failed to write sorted lines");
+    }
+  });
+}
+
+void ExternalSorter::removeRuns() {
+  for (const string& path : m_runPaths) {
+    unlink(path.c_str());
+  }
+  m_runPaths.clear();
+}
+
+}  // namespace cbl
@@ -0,0 +1,85 @@
+// Sorting of a sequence of lines that may not fit in memory.
+// Usage:
+//   cbl::ExternalSorter sorter({.memoryBudget = 512 << 20, .numThreads = 4});
+//   for (...) {
+//     sorter.add(line);
+//   }
+//   sorter.finish([](std::string_view line) { ... });  // Lines are received in sorted order.
+//
+// Lines are sorted in byte order, which is the same as `LC_ALL=C sort`. They are buffered in memory until the budget
+// is reached. Each full buffer is then sorted by a background thread and written to a compressed temporary file (a
+// "run"), so that the caller can continue to add lines in the meantime. finish() does a k-way merge of all runs, or
+// just sorts the buffer in memory if no run was written.
+#ifndef CBL_EXTERNAL_SORTER_H
+#define CBL_EXTERNAL_SORTER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cbl {
+
+class ExternalSorter {
+public:
+  struct Params {
+    // Approximate maximum memory used to buffer lines, including the buffers being sorted in the background.
+    int64_t memoryBudget = 1 << 30;
+    // Maximum number of buffers sorted and written in parallel.
+    int numThreads = 4;
+    // Directory where runs are written.
+    std::string tempDir = "/tmp";
+    // zlib compression level for runs, from 0 (no compression) to 9.
+    int compressionLevel = 1;
+  };
+
+  ExternalSorter() : ExternalSorter(Params()) {}
+  explicit ExternalSorter(const Params& params);
+  ~ExternalSorter();
+
+  // Adds a line. It must not contain '\n'.
+  void add(std::string_view line);
+  // Calls `callback` for each line added, in sorted order. Must be called at most once.
+  // Throws: SystemError if a run cannot be written or read.
+  void finish(const std::function<void(std::string_view)>& callback);
+  // Writes all lines to `file` in sorted order, each followed by '\n'.
+  // Throws: SystemError.
+  void finish(FILE* file);
+
+private:
+  struct Entry {
+    // First bytes of the line in big-endian order, so that most comparisons are done on integers. Lines are often
+    // "key|value" with a key shared by many lines, so this does not replace a full comparison on ties.
+    uint64_t prefix;
+    size_t offset;
+    size_t length;
+  };
+  struct Chunk {
+    std::string data;
+    std::vector<Entry> entries;
+    int64_t memoryUsage() const { return data.size() + entries.size() * sizeof(Entry); }
+  };
+
+  static void sortChunk(Chunk& chunk);
+  static std::string_view getLine(const Chunk& chunk, const Entry& entry);
+  // Sorts the current chunk in a background thread and writes it to a new run.
+  void flushChunk();
+  void writeRun(Chunk& chunk, const std::string& path) const;
+  void removeRuns();
+
+  Params m_params;
+  int64_t m_chunkMemoryLimit = 0;
+  std::unique_ptr<Chunk> m_chunk;
+  std::deque<std::future<void>> m_pendingRuns;
+  std::vector<std::string> m_runPaths;
+  bool m_finished = false;
+};
+
+}  // namespace cbl
+
+#endif
@@ -0,0 +1,65 @@
+#include "external_sorter.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "log.h"
+#include "tempfile.h"
+#include "unittest.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace cbl {
+
+class ExternalSorterTest : public cbl::Test {
+private:
+  static vector<string> sortLines(const ExternalSorter::Params& params, const vector<string>& lines) {
+    ExternalSorter sorter(params);
+    for (const string& line : lines) {
+      sorter.add(line);
+    }
+    vector<string> sortedLines;
+    sorter.finish([&](string_view line) { sortedLines.emplace_back(line); });
+    return sortedLines;
+  }
+
+  static vector<string> generateLines(int count) {
+    vector<string> lines;
+    unsigned int state = 1;
+    for (int i = 0; i < count; i++) {
+      state = state * 1103515245 + 12345;
+      string line = "Template " + std::to_string(state % 97) + "|Page " + std::to_string((state >> 8) % 1000);
+      if (state % 5 == 0) line += "|\xC3\xA9t\xC3\xA9";
+      if (state % 7 == 0) line = line.substr(0, state % 3);
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+  CBL_TEST_CASE(InMemory) {
+    vector<string> lines = {"b|2", "a|1", "", "a b|3", "\xC3\xA9", "a|10", "b|2"};
+    vector<string> expectedLines = {"", "a b|3", "a|1", "a|10", "b|2", "b|2", "\xC3\xA9"};
+    CBL_ASSERT(sortLines(ExternalSorter::Params(), lines) == expectedLines);
+  }
+
+  CBL_TEST_CASE(WithRuns) {
+    TempDir tempDir;
+    vector<string> lines = generateLines(20000);
+    vector<string> expectedLines = lines;
+    std::sort(expectedLines.begin(), expectedLines.end());
+    for (int compressionLevel : {0, 1}) {
+      ExternalSorter::Params params{
+          .memoryBudget = 50000, .numThreads = 3, .tempDir = tempDir.path(), .compressionLevel = compressionLevel};
+      CBL_ASSERT(sortLines(params, lines) == expectedLines);
+    }
+  }
+};
+
+}  // namespace cbl
+
+int main() {
+  cbl::ExternalSorterTest().run();
+  return 0;
+}
@@ -0,0 +1,22 @@
+// Imports a cache directory of HTTPClientWithCache (one file per request) into a cache database.
+// Usage: http_cache_migrate --cachedir=DIR --database=FILE [--max-size-mb=N]
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "args_parser.h"
+#include "http_cache_store.h"
+
+using std::string;
+
+int main(int argc, char** argv) {
+  string cacheDir;
+  string databasePath;
+  int maxSizeMB = 0;  // 0 means no limit.
+  cbl::parseArgs(argc, argv, "--cachedir,required", &cacheDir, "--database,required", &databasePath, "--max-size-mb",
+                 &maxSizeMB);
+  cbl::HTTPCacheStore store(databasePath, {.maxSize = static_cast<int64_t>(maxSizeMB) << 20});
+  int numImported = store.importCacheDir(cacheDir);
+  std::cout << "Imported " << numImported << " files. The database now contains " << store.numEntries()
+            << " entries with a total size of " << store.totalSize() << " bytes.\n";
+  return 0;
+}
@@ -0,0 +1,42 @@
+#include "http_cache_store.h"
+#include <dirent.h>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "date.h"
+#include "error.h"
+#include "file.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace cbl {
+
+HTTPCacheStore::HTTPCacheStore(const string& path, const HTTPCacheStoreParams& params)
+    : m_store(path, {.maxSize = params.maxSize, .compress = params.compress}), m_defaultTTL(params.defaultTTL) {}
+
+int HTTPCacheStore::importCacheDir(const string& dir) {
+  vector<string> keys;
+  {
+    std::unique_ptr<DIR, int (*)(DIR*)> dirHandle(opendir(dir.c_str()), closedir);
+    if (!dirHandle) {
+      throw FileNotFoundError("Cannot open directory '" + dir + "': " + getCErrorString(errno));
+    }
+    while (const dirent* entry = readdir(dirHandle.get())) {
+      string_view name = entry->d_name;
+      if (name.size() > 4 && name.ends_with(".dat")) {
+        keys.emplace_back(name.substr(0, name.size() - 4));
+      }
+    }
+  }
+  string dirWithSlash = dir.ends_with('/') ? dir : dir + "/";
+  for (const string& key : keys) {
+    put(key, readFile(dirWithSlash + key + ".dat"));
+  }
+  return keys.size();
+}
+
+}  // namespace cbl
@@ -0,0 +1,55 @@
+// Storage of the responses cached by HTTPClientWithCache in a single SQLite database, as an alternative to one file per
+// request in a directory.
+// Usage:
+//   HTTPClientWithCache client;
+//   client.setCacheDatabase("/tmp/http-cache.sqlite", {.maxSize = 1 << 30, .defaultTTL = DateDiff::fromDays(7)});
+//   client.setCacheMode(HTTPClientWithCache::CACHE_ENABLED);
+// The database is a BlobStore.
+#ifndef CBL_HTTP_CACHE_STORE_H
+#define CBL_HTTP_CACHE_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "blob_store.h"
+#include "date.h"
+
+namespace cbl {
+
+struct HTTPCacheStoreParams {
+  // See BlobStoreParams.
+  int64_t maxSize = 0;
+  // Lifetime of new entries. Expired entries are never returned. nullDiff() means that entries never expire.
+  DateDiff defaultTTL = DateDiff::nullDiff();
+  // See BlobStoreParams.
+  bool compress = true;
+};
+
+class HTTPCacheStore {
+public:
+  explicit HTTPCacheStore(const std::string& path, const HTTPCacheStoreParams& params = {});
+
+  // If the store contains a non-expired entry for key, sets value to it and returns true.
+  bool get(const std::string& key, std::string& value) { return m_store.get(key, value); }
+  // Adds or replaces the entry for key, with the default lifetime from params.
+  void put(const std::string& key, std::string_view value) { m_store.put(key, value, m_defaultTTL); }
+  // Adds or replaces the entry for key, with a specific lifetime (nullDiff() means no expiration).
+  void put(const std::string& key, std::string_view value, DateDiff ttl) { m_store.put(key, value, ttl); }
+  void remove(const std::string& key) { m_store.remove(key); }
+
+  // Imports all files named "<key>.dat" from a cache directory of HTTPClientWithCache. Existing entries are replaced.
+  // Returns the number of imported files.
+  int importCacheDir(const std::string& dir);
+
+  int64_t numEntries() { return m_store.numEntries(); }
+  // Total size of stored responses, after compression.
+  int64_t totalSize() { return m_store.totalSize(); }
+
+private:
+  BlobStore m_store;
+  DateDiff m_defaultTTL;
+};
+
+}  // namespace cbl
+
+#endif
@@ -0,0 +1,55 @@
+#include "http_cache_store.h"
+#include <string>
+#include "date.h"
+#include "directory.h"
+#include "file.h"
+#include "log.h"
+#include "tempfile.h"
+#include "unittest.h"
+
+using std::string;
+
+namespace cbl {
+
+class HTTPCacheStoreTest : public cbl::Test {
+private:
+  void setUp() override { Date::setFrozenValueOfNow(Date::fromISO8601("2020-01-01T00:00:00Z")); }
+
+  CBL_TEST_CASE(Expiration) {
+    TempDir tempDir;
+    HTTPCacheStore store(tempDir.path() + "/cache.sqlite", {.defaultTTL = DateDiff::fromHours(2)});
+    store.put("k1", "v1");
+    store.put("k2", "v2", DateDiff::fromHours(5));
+    store.put("k3", "v3", DateDiff::nullDiff());
+    Date::advanceFrozenClock(DateDiff::fromHours(3));
+    string value;
+    CBL_ASSERT(!store.get("k1", value));
+    CBL_ASSERT(store.get("k2", value));
+    Date::advanceFrozenClock(DateDiff::fromYears(10));
+    CBL_ASSERT(!store.get("k2", value));
+    CBL_ASSERT(store.get("k3", value));
+    CBL_ASSERT_EQ(value, "v3");
+  }
+
+  CBL_TEST_CASE(ImportCacheDir) {
+    TempDir tempDir;
+    const string cacheDir = tempDir.path() + "/cache";
+    makeDir(cacheDir);
+    writeFile(cacheDir + "/0123.dat", "response 1");
+    writeFile(cacheDir + "/4567.dat", "response 2");
+    writeFile(cacheDir + "/other.txt", "ignored");
+    HTTPCacheStore store(tempDir.path() + "/cache.sqlite");
+    CBL_ASSERT_EQ(store.importCacheDir(cacheDir), 2);
+    string value;
+    CBL_ASSERT(store.get("4567", value));
+    CBL_ASSERT_EQ(value, "response 2");
+    CBL_ASSERT_EQ(store.numEntries(), 2);
+  }
+};
+
+}  // namespace cbl
+
+int main() {
+  cbl::HTTPCacheStoreTest().run();
+  return 0;
+}
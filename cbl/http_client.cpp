@@ -1,19 +1,30 @@
 #include "http_client.h"
 #include <curl/curl.h>
 #include <unistd.h>
-#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <deque>
+#include <exception>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 #include "error.h"
 #include "file.h"
+#include "http_cache_store.h"
+#include "log.h"
 #include "sha1.h"
 #include "string.h"
 
 using std::string;
 using std::string_view;
+using std::unique_ptr;
 using std::vector;
 
 namespace cbl {
@@ -90,6 +101,263 @@ private:
   curl_slist* m_slist = nullptr;
 };
 
+static void setDefaultOptions(CurlHandle& curlHandle) {
+  curlHandle.setNumOpt(CURLOPT_FOLLOWLOCATION, 1);
+  curlHandle.setNumOpt(CURLOPT_MAXREDIRS, 10);
+  curlHandle.setNumOpt(CURLOPT_TIMEOUT, 300);
+  curlHandle.setPtrOpt(CURLOPT_ACCEPT_ENCODING, "");  // All encodings supported by curl.
+}
+
+static size_t appendToString(void* ptr, size_t size, size_t nmemb, void* userdata) {
+  size_t recvSize = size * nmemb;
+  static_cast<string*>(userdata)->append(static_cast<const char*>(ptr), recvSize);
+  return recvSize;
+}
+
+static bool isSuccessfulHTTPCode(long httpCode) {
+  return httpCode == 200 || httpCode == 202;
+}
+
+// Throws an exception if the transfer failed or if the server did not return a success code.
+// Throws: HTTPForbiddenError, HTTPNotFoundError, HTTPServerError, HTTPError, NetworkError.
+static void checkTransferResult(CURL* handle, CURLcode perfCode, const string& url, const char* errorMessagePrefix) {
+  if (perfCode != CURLE_OK) {
+    throw NetworkError(string(errorMessagePrefix) + " '" + url + "': curl_easy_perform failed with code " +
+                       std::to_string(perfCode));
+  }
+  long httpCode = 0;
+  perfCode = curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &httpCode);
+  if (perfCode != CURLE_OK) {
+    throw InternalError("curl_easy_getinfo failed");
+  }
+  if (!isSuccessfulHTTPCode(httpCode)) {
+    string errorMessage =
+        string(errorMessagePrefix) + " '" + url + "': server returned HTTP error " + std::to_string(httpCode);
+    curl_off_t retryAfter = 0;
+    if (curl_easy_getinfo(handle, CURLINFO_RETRY_AFTER, &retryAfter) != CURLE_OK || retryAfter < 0) {
+      retryAfter = 0;
+    }
+    int retryAfterInt = static_cast<int>(std::min<curl_off_t>(retryAfter, INT_MAX));
+    if (httpCode == 403) {
+      throw HTTPForbiddenError(httpCode, errorMessage, retryAfterInt);
+    } else if (httpCode == 404) {
+      throw HTTPNotFoundError(httpCode, errorMessage, retryAfterInt);
+    } else if (httpCode >= 500 && httpCode < 600) {
+      throw HTTPServerError(httpCode, errorMessage, retryAfterInt);
+    } else {
+      throw HTTPError(httpCode, errorMessage, retryAfterInt);
+    }
+  }
+}
+
+// Request created by HTTPClient::getAsync() or HTTPClient::postAsync(). All parameters are copied from the client
+// so that the request can be run without accessing it.
+struct AsyncRequest {
+  string url;
+  bool isPost = false;
+  string postData;
+  string userAgent;
+  string cookies;
+  vector<string> headers;
+  std::promise<string> promise;
+
+  // Set when the request starts.
+  unique_ptr<CurlHandle> curlHandle;
+  SmartSlist headersSlist;
+  string content;
+};
+
+// Background thread running asynchronous requests with a curl multi handle.
+class CurlMultiWorker {
+public:
+  CurlMultiWorker(int maxConnections, int delayBeforeRequests)
+      : m_maxConnections(maxConnections), m_delayBeforeRequests(delayBeforeRequests) {
+    m_multiHandle = curl_multi_init();
+    if (m_multiHandle == nullptr) {
+      throw InternalError("curl_multi_init() failed");
+    }
+    curl_multi_setopt(m_multiHandle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    updateMaxConnections();
+    m_thread = std::thread([this]() { run(); });
+  }
+  CurlMultiWorker(const CurlMultiWorker&) = delete;
+  ~CurlMultiWorker() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+    }
+    curl_multi_wakeup(m_multiHandle);
+    m_thread.join();
+    for (unique_ptr<AsyncRequest>& request : m_runningRequests) {
+      curl_multi_remove_handle(m_multiHandle, request->curlHandle->handle());
+      cancelRequest(*request);
+    }
+    for (unique_ptr<AsyncRequest>& request : m_pendingRequests) {
+      cancelRequest(*request);
+    }
+    curl_multi_cleanup(m_multiHandle);
+  }
+  CurlMultiWorker& operator=(const CurlMultiWorker&) = delete;
+
+  void setMaxConnections(int value) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_maxConnections = value;
+    }
+    curl_multi_wakeup(m_multiHandle);
+  }
+  void setDelayBeforeRequests(int seconds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_delayBeforeRequests = seconds;
+  }
+  void addRequest(unique_ptr<AsyncRequest> request) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_pendingRequests.push_back(std::move(request));
+    }
+    curl_multi_wakeup(m_multiHandle);
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  static void cancelRequest(AsyncRequest& request) {
+    request.promise.set_exception(
+        std::make_exception_ptr(NetworkError("Request to '" + request.url + "' canceled by HTTPClient destruction")));
+  }
+
+  // Must be called with m_mutex locked or from the constructor.
+  void updateMaxConnections() {
+    curl_multi_setopt(m_multiHandle, CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(m_maxConnections));
+    m_appliedMaxConnections = m_maxConnections;
+  }
+
+  // Adds the request to the multi handle. The caller keeps the ownership of the request and must move it to
+  // m_runningRequests only if this function does not throw.
+  void startRequest(AsyncRequest& request) {
+    request.curlHandle = std::make_unique<CurlHandle>();
+    CurlHandle& curlHandle = *request.curlHandle;
+    setDefaultOptions(curlHandle);
+    // HTTP/2 is only negotiated over TLS. In that case, prefer waiting for an existing connection to be available for
+    // multiplexing rather than opening a new one.
+    curlHandle.setNumOpt(CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    if (request.url.starts_with("https://")) {
+      curlHandle.setNumOpt(CURLOPT_PIPEWAIT, 1);
+    }
+    if (!request.userAgent.empty()) {
+      curlHandle.setPtrOpt(CURLOPT_USERAGENT, request.userAgent.c_str());
+    }
+    if (!request.cookies.empty()) {
+      curlHandle.setPtrOpt(CURLOPT_COOKIE, request.cookies.c_str());
+    }
+    request.headersSlist = SmartSlist(request.headers);
+    if (request.isPost) {
+      request.headersSlist.append("Expect:");
+      curlHandle.setNumOpt(CURLOPT_POST, 1);
+      curlHandle.setNumOpt(CURLOPT_POSTFIELDSIZE, static_cast<long>(request.postData.size()));
+      curlHandle.setPtrOpt(CURLOPT_POSTFIELDS, request.postData.c_str());
+    }
+    curlHandle.setPtrOpt(CURLOPT_HTTPHEADER, request.headersSlist.get());
+    curlHandle.setPtrOpt(CURLOPT_WRITEFUNCTION, (const void*)appendToString);
+    curlHandle.setPtrOpt(CURLOPT_WRITEDATA, &request.content);
+    curlHandle.setPtrOpt(CURLOPT_PRIVATE, &request);
+    curlHandle.setPtrOpt(CURLOPT_URL, request.url.c_str());
+    if (curl_multi_add_handle(m_multiHandle, curlHandle.handle()) != CURLM_OK) {
+      throw InternalError("curl_multi_add_handle() failed");
+    }
+  }
+
+  void finishRequest(CURL* handle, CURLcode result) {
+    auto it = std::find_if(
+        m_runningRequests.begin(), m_runningRequests.end(),
+        [&](const unique_ptr<AsyncRequest>& request) { return request->curlHandle->handle() == handle; });
+    CBL_ASSERT(it != m_runningRequests.end());
+    unique_ptr<AsyncRequest> request = std::move(*it);
+    m_runningRequests.erase(it);
+    curl_multi_remove_handle(m_multiHandle, handle);
+    try {
+      checkTransferResult(handle, result, request->url, request->isPost ? "Failure of POST request on" : "Cannot read");
+      request->promise.set_value(std::move(request->content));
+    } catch (...) {
+      request->promise.set_exception(std::current_exception());
+    }
+  }
+
+  // Starts pending requests allowed by the limits and returns the maximum time to wait before calling it again.
+  std::chrono::milliseconds startPendingRequests() {
+    std::chrono::milliseconds timeout(1000);
+    vector<unique_ptr<AsyncRequest>> requestsToStart;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_appliedMaxConnections != m_maxConnections) {
+        updateMaxConnections();
+      }
+      while (!m_pendingRequests.empty() &&
+             static_cast<int>(m_runningRequests.size() + requestsToStart.size()) < m_maxConnections) {
+        Clock::time_point now = Clock::now();
+        if (now < m_nextRequestTime) {
+          timeout = std::min(timeout, std::chrono::ceil<std::chrono::milliseconds>(m_nextRequestTime - now));
+          break;
+        }
+        requestsToStart.push_back(std::move(m_pendingRequests.front()));
+        m_pendingRequests.pop_front();
+        if (m_delayBeforeRequests > 0) {
+          m_nextRequestTime = now + std::chrono::seconds(m_delayBeforeRequests);
+        }
+      }
+    }
+    for (unique_ptr<AsyncRequest>& request : requestsToStart) {
+      try {
+        startRequest(*request);
+      } catch (...) {
+        request->promise.set_exception(std::current_exception());
+        continue;
+      }
+      m_runningRequests.push_back(std::move(request));
+    }
+    return timeout;
+  }
+
+  void run() {
+    while (true) {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) break;
+      }
+      std::chrono::milliseconds timeout = startPendingRequests();
+      int runningHandles = 0;
+      curl_multi_perform(m_multiHandle, &runningHandles);
+      int messagesInQueue = 0;
+      bool requestFinished = false;
+      while (CURLMsg* message = curl_multi_info_read(m_multiHandle, &messagesInQueue)) {
+        if (message->msg == CURLMSG_DONE) {
+          finishRequest(message->easy_handle, message->data.result);
+          requestFinished = true;
+        }
+      }
+      if (!requestFinished) {
+        // Returns early on network activity or when curl_multi_wakeup() is called.
+        curl_multi_poll(m_multiHandle, nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+      }
+    }
+  }
+
+  CURLM* m_multiHandle = nullptr;
+  // Only accessed by the worker thread (or the destructor after the end of the thread).
+  vector<unique_ptr<AsyncRequest>> m_runningRequests;
+  Clock::time_point m_nextRequestTime;
+  int m_appliedMaxConnections = 0;
+
+  // Protected by m_mutex.
+  std::mutex m_mutex;
+  std::deque<unique_ptr<AsyncRequest>> m_pendingRequests;
+  int m_maxConnections = 0;
+  int m_delayBeforeRequests = 0;
+  bool m_stopping = false;
+
+  std::thread m_thread;
+};
+
 HTTPClient::HTTPClient() {
   m_curlGlobalState = CurlGlobalState::getInstance();
 }
@@ -99,10 +367,7 @@ HTTPClient::~HTTPClient() {}
 CurlHandle& HTTPClient::curlHandle() {
   if (!m_lazyCurlHandle) {
     m_lazyCurlHandle = std::make_unique<CurlHandle>();
-    m_lazyCurlHandle->setNumOpt(CURLOPT_FOLLOWLOCATION, 1);
-    m_lazyCurlHandle->setNumOpt(CURLOPT_MAXREDIRS, 10);
-    m_lazyCurlHandle->setNumOpt(CURLOPT_TIMEOUT, 300);
-    m_lazyCurlHandle->setPtrOpt(CURLOPT_ACCEPT_ENCODING, "");  // All encodings supported by curl.
+    setDefaultOptions(*m_lazyCurlHandle);
     if (!m_userAgent.empty()) {
       curlHandle().setPtrOpt(CURLOPT_USERAGENT, m_userAgent.c_str());
     }
@@ -119,66 +384,76 @@ void HTTPClient::resetCurlHandle() {
   m_lazyCurlHandle.reset();
 }
 
+CurlMultiWorker& HTTPClient::multiWorker() {
+  if (!m_lazyMultiWorker) {
+    m_lazyMultiWorker = std::make_unique<CurlMultiWorker>(m_maxConnections, m_delayBeforeRequests);
+  }
+  return *m_lazyMultiWorker;
+}
+
 size_t HTTPClient::callback(void* ptr, size_t size, size_t nmemb, void* userdata) {
   return ((HTTPClient*) userdata)->write(ptr, size, nmemb);
 }
 
 size_t HTTPClient::write(void* ptr, size_t size, size_t nmemb) {
-  size_t oldSize = m_buffer->size();
   size_t recvSize = size * nmemb;
-  if (recvSize != 0) {
-    m_buffer->resize(oldSize + recvSize);
-    memcpy(&(*m_buffer)[oldSize], ptr, recvSize);
+  long httpCode = 0;
+  curl_easy_getinfo(curlHandle().handle(), CURLINFO_RESPONSE_CODE, &httpCode);
+  // The body of error pages is ignored.
+  if (recvSize != 0 && isSuccessfulHTTPCode(httpCode)) {
+    try {
+      (*m_dataCallback)(string_view(static_cast<const char*>(ptr), recvSize));
+    } catch (...) {
+      // Exceptions cannot go through curl. Returning a size different from recvSize aborts the transfer, and
+      // openInternal rethrows the exception.
+      m_dataCallbackException = std::current_exception();
+      return 0;
+    }
   }
   return recvSize;
 }
 
-string HTTPClient::openInternal(const string& url, const char* errorMessagePrefix) {
+void HTTPClient::openInternal(const string& url, const char* errorMessagePrefix, const DataCallback& onData) {
   if (m_delayBeforeRequests > 0) {
     sleep(m_delayBeforeRequests);
   }
-  string content;
-  m_buffer = &content;
+  m_dataCallback = &onData;
+  m_dataCallbackException = nullptr;
   curlHandle().setPtrOpt(CURLOPT_WRITEFUNCTION, (const void*) HTTPClient::callback);
   curlHandle().setPtrOpt(CURLOPT_WRITEDATA, this);
   curlHandle().setPtrOpt(CURLOPT_URL, url.c_str());
   CURLcode perfCode = curl_easy_perform(curlHandle().handle());
-  if (perfCode != CURLE_OK) {
-    throw NetworkError(string(errorMessagePrefix) + " '" + url + "': curl_easy_perform failed with code " +
-                       std::to_string(perfCode));
+  m_dataCallback = nullptr;
+  if (m_dataCallbackException) {
+    std::exception_ptr exception = m_dataCallbackException;
+    m_dataCallbackException = nullptr;
+    std::rethrow_exception(exception);
   }
-  long httpCode = 0;
-  perfCode = curl_easy_getinfo(curlHandle().handle(), CURLINFO_RESPONSE_CODE, &httpCode);
-  if (perfCode != CURLE_OK) {
-    throw InternalError("curl_easy_getinfo failed");
-  }
-  if (httpCode != 200 && httpCode != 202) {
-    string errorMessage =
-        string(errorMessagePrefix) + " '" + url + "': server returned HTTP error " + std::to_string(httpCode);
-    if (httpCode == 403) {
-      throw HTTPForbiddenError(httpCode, errorMessage);
-    } else if (httpCode == 404) {
-      throw HTTPNotFoundError(httpCode, errorMessage);
-    } else if (httpCode >= 500 && httpCode < 600) {
-      throw HTTPServerError(httpCode, errorMessage);
-    } else {
-      throw HTTPError(httpCode, errorMessage);
-    }
-  }
-  return content;
+  checkTransferResult(curlHandle().handle(), perfCode, url, errorMessagePrefix);
 }
 
 string HTTPClient::get(const string& url) {
+  string content;
+  HTTPClient::getStreamed(url, [&](string_view chunk) { content += chunk; });
+  return content;
+}
+
+string HTTPClient::post(const string& url, const string& data) {
+  string content;
+  HTTPClient::postStreamed(url, data, [&](string_view chunk) { content += chunk; });
+  return content;
+}
+
+void HTTPClient::getStreamed(const string& url, const DataCallback& onData) {
   SmartSlist slist(m_headers);
   curlHandle().setPtrOpt(CURLOPT_HTTPHEADER, slist.get());
   RunOnDestroy cleanup([this]() {
     curlHandle().setPtrOpt(CURLOPT_HTTPHEADER, nullptr);
   });
-  return openInternal(url, "Cannot read");
+  openInternal(url, "Cannot read", onData);
 }
 
-string HTTPClient::post(const string& url, const string& data) {
-  string content;
+void HTTPClient::postStreamed(const string& url, const string& data, const DataCallback& onData) {
   SmartSlist slist(m_headers);
   slist.append("Expect:");
   curlHandle().setPtrOpt(CURLOPT_HTTPHEADER, slist.get());
@@ -189,11 +464,72 @@ string HTTPClient::post(const string& url, const string& data) {
     curlHandle().setNumOpt(CURLOPT_POST, 0);
     curlHandle().setPtrOpt(CURLOPT_HTTPHEADER, nullptr);
   });
-  return openInternal(url, "Failure of POST request on");
+  openInternal(url, "Failure of POST request on", onData);
+}
+
+std::future<string> HTTPClient::sendAsync(const string& url, const string* postData) {
+  unique_ptr<AsyncRequest> request = std::make_unique<AsyncRequest>();
+  request->url = url;
+  if (postData != nullptr) {
+    request->isPost = true;
+    request->postData = *postData;
+  }
+  request->userAgent = m_userAgent;
+  request->cookies = m_remoteCookiesEnabled ? getRemoteCookies() : m_cookies;
+  request->headers = m_headers;
+  std::future<string> future = request->promise.get_future();
+  multiWorker().addRequest(std::move(request));
+  return future;
+}
+
+std::future<string> HTTPClient::getAsync(const string& url) {
+  return sendAsync(url, nullptr);
+}
+
+std::future<string> HTTPClient::postAsync(const string& url, const string& data) {
+  return sendAsync(url, &data);
+}
+
+vector<string> HTTPClient::getMany(const vector<string>& urls) {
+  vector<std::future<string>> futures;
+  futures.reserve(urls.size());
+  for (const string& url : urls) {
+    futures.push_back(getAsync(url));
+  }
+  vector<string> responses;
+  responses.reserve(urls.size());
+  std::exception_ptr firstError;
+  for (std::future<string>& future : futures) {
+    try {
+      responses.push_back(future.get());
+    } catch (...) {
+      if (!firstError) {
+        firstError = std::current_exception();
+      }
+      responses.emplace_back();
+    }
+  }
+  if (firstError) {
+    std::rethrow_exception(firstError);
+  }
+  return responses;
 }
 
 void HTTPClient::setDelayBeforeRequests(int seconds) {
   m_delayBeforeRequests = seconds;
+  if (m_lazyMultiWorker) {
+    m_lazyMultiWorker->setDelayBeforeRequests(seconds);
+  }
+}
+
+void HTTPClient::setMaxConnections(int value) {
+  if (value < 1) {
+    throw std::invalid_argument("HTTPClient::setMaxConnections called with value < 1");
+  }
+  m_maxConnections = value;
+  if (m_lazyMultiWorker) {
+    m_lazyMultiWorker->setMaxConnections(value);
+  }
 }
 
 const string& HTTPClient::userAgent() const {
@@ -251,33 +587,36 @@ string HTTPClient::getRemoteCookies() const {
   return cookies;
 }
 
-string HTTPClientWithCache::getCacheFileForGET(const string& url) const {
-  return getCacheFile(url);
+string HTTPClientWithCache::getCacheKeyForGET(const string& url) const {
+  return getCacheKey(url);
 }
 
-string HTTPClientWithCache::getCacheFileForPOST(const string& url, const string& data) const {
-  return getCacheFile(url + '\n' + data);
+string HTTPClientWithCache::getCacheKeyForPOST(const string& url, const string& data) const {
+  return getCacheKey(url + '\n' + data);
 }
 
 string HTTPClientWithCache::get(const string& url) {
   string content;
   if (m_cacheMode & CACHE_ENABLED) {
-    m_lastCacheFile = getCacheFileForGET(url);
-    if ((m_cacheMode & CACHE_READ_ENABLED) && fileExists(m_lastCacheFile)) {
+    m_lastCacheKey = getCacheKeyForGET(url);
+    if (m_cacheMode & CACHE_READ_ENABLED) {
       try {
-        return readFile(m_lastCacheFile);
+        if (readFromCache(m_lastCacheKey, content)) {
+          return content;
+        }
       } catch (const cbl::Error& e) {
         throw cbl::InternalError("Reading " + url + " from cache failed: " + e.what());
       }
-    } else if (m_cacheMode & CACHE_OFFLINE_MODE) {
+    }
+    if (m_cacheMode & CACHE_OFFLINE_MODE) {
       throw PageNotInCacheError(url + " is not in cache");
     }
   } else {
-    m_lastCacheFile.clear();
+    m_lastCacheKey.clear();
   }
   content = HTTPClient::get(url);
   if (m_cacheMode & CACHE_WRITE_ENABLED) {
-    writeFile(m_lastCacheFile, content);
+    writeToCache(m_lastCacheKey, content);
   }
   return content;
 }
@@ -285,40 +624,126 @@ string HTTPClientWithCache::get(const string& url) {
 string HTTPClientWithCache::post(const string& url, const string& data) {
   string content;
   if (m_cacheMode & CACHE_ENABLED) {
-    m_lastCacheFile = getCacheFileForPOST(url, data);
+    m_lastCacheKey = getCacheKeyForPOST(url, data);
     if (!(m_cacheMode & CACHE_POST)) {
       throw InvalidStateError("Attempt to cache result of POST request on " + url +
                               " while the cache of POST requests is disabled");
-    } else if ((m_cacheMode & CACHE_READ_ENABLED) && fileExists(m_lastCacheFile)) {
+    }
+    if (m_cacheMode & CACHE_READ_ENABLED) {
       try {
-        return readFile(m_lastCacheFile);
+        if (readFromCache(m_lastCacheKey, content)) {
+          return content;
+        }
       } catch (const cbl::Error& e) {
         throw cbl::InternalError("Reading cached POST request to " + url + " failed: " + e.what());
       }
-    } else if (m_cacheMode & CACHE_OFFLINE_MODE) {
+    }
+    if (m_cacheMode & CACHE_OFFLINE_MODE) {
       throw PageNotInCacheError(url + " + data for POST request are not in cache");
     }
   } else {
-    m_lastCacheFile.clear();
+    m_lastCacheKey.clear();
   }
   content = HTTPClient::post(url, data);
   if (m_cacheMode & CACHE_WRITE_ENABLED) {
-    writeFile(m_lastCacheFile, content);
+    writeToCache(m_lastCacheKey, content);
   }
   return content;
 }
 
-string HTTPClientWithCache::getCacheFile(const string& request) const {
-  if (m_cacheDir.empty()) {
-    throw InvalidStateError("HTTPClientWithCache::getCacheFile() called without initializing the cache directory");
+void HTTPClientWithCache::getStreamed(const string& url, const DataCallback& onData) {
+  onData(get(url));
+}
+
+void HTTPClientWithCache::postStreamed(const string& url, const string& data, const DataCallback& onData) {
+  onData(post(url, data));
+}
+
+std::future<string> HTTPClientWithCache::sendAsyncWithCache(
+    const string& cacheKey, const string& description, const std::function<std::future<string>()>& sendRequest) {
+  std::promise<string> cachedResponse;
+  if (m_cacheMode & CACHE_READ_ENABLED) {
+    try {
+      string content;
+      if (readFromCache(cacheKey, content)) {
+        cachedResponse.set_value(std::move(content));
+        return cachedResponse.get_future();
+      }
+    } catch (const cbl::Error& e) {
+      cachedResponse.set_exception(
+          std::make_exception_ptr(InternalError("Reading " + description + " from cache failed: " + e.what())));
+      return cachedResponse.get_future();
+    }
+  }
+  if (m_cacheMode & CACHE_OFFLINE_MODE) {
+    cachedResponse.set_exception(std::make_exception_ptr(PageNotInCacheError(description + " is not in cache")));
+    return cachedResponse.get_future();
+  }
+  std::future<string> response = sendRequest();
+  if (!(m_cacheMode & CACHE_WRITE_ENABLED)) {
+    return response;
+  }
+  return std::async(std::launch::deferred, [this, response = std::move(response), cacheKey]() mutable {
+    string content = response.get();
+    writeToCache(cacheKey, content);
+    return content;
+  });
+}
+
+std::future<string> HTTPClientWithCache::getAsync(const string& url) {
+  if (!(m_cacheMode & CACHE_ENABLED)) {
+    return HTTPClient::getAsync(url);
   }
+  return sendAsyncWithCache(getCacheKeyForGET(url), url, [&]() { return HTTPClient::getAsync(url); });
+}
+
+std::future<string> HTTPClientWithCache::postAsync(const string& url, const string& data) {
+  if (!(m_cacheMode & CACHE_ENABLED)) {
+    return HTTPClient::postAsync(url, data);
+  } else if (!(m_cacheMode & CACHE_POST)) {
+    throw InvalidStateError("Attempt to cache result of POST request on " + url +
+                            " while the cache of POST requests is disabled");
+  }
+  return sendAsyncWithCache(getCacheKeyForPOST(url, data), "POST request to " + url,
+                            [&]() { return HTTPClient::postAsync(url, data); });
+}
+
+string HTTPClientWithCache::getCacheKey(const string& request) const {
+  if (m_cacheDir.empty() && !m_cacheStore) {
+    throw InvalidStateError(
+        "HTTPClientWithCache::getCacheKey() called without initializing the cache directory or database");
+  }
+  return sha1(request);
+}
+
+string HTTPClientWithCache::getCacheFile(const string& cacheKey) const {
   string cacheFile = m_cacheDir;
   if (cacheFile[cacheFile.size() - 1] != '/') cacheFile += '/';
-  cacheFile += sha1(request);
+  cacheFile += cacheKey;
   cacheFile += ".dat";
   return cacheFile;
 }
 
+bool HTTPClientWithCache::readFromCache(const string& cacheKey, string& content) {
+  if (m_cacheStore) {
+    return m_cacheStore->get(cacheKey, content);
+  }
+  string cacheFile = getCacheFile(cacheKey);
+  if (!fileExists(cacheFile)) {
+    return false;
+  }
+  content = readFile(cacheFile);
+  return true;
+}
+
+void HTTPClientWithCache::writeToCache(const string& cacheKey, const string& content) {
+  if (m_cacheStore) {
+    m_cacheStore->put(cacheKey, content);
+  } else {
+    writeFile(getCacheFile(cacheKey), content);
+  }
+}
+
 int HTTPClientWithCache::cacheMode() const {
   return m_cacheMode;
 }
@@ -343,10 +768,18 @@ void HTTPClientWithCache::setCacheDir(const string& dir) {
   m_cacheDir = dir;
 }
 
+void HTTPClientWithCache::setCacheDatabase(const string& path, const HTTPCacheStoreParams& params) {
+  m_cacheStore = std::make_unique<HTTPCacheStore>(path, params);
+}
+
 void HTTPClientWithCache::doNotCacheLastResponse() {
-  if (!m_lastCacheFile.empty()) {
-    removeFile(m_lastCacheFile, /* mustExist = */ false);
-    m_lastCacheFile.clear();
+  if (!m_lastCacheKey.empty()) {
+    if (m_cacheStore) {
+      m_cacheStore->remove(m_lastCacheKey);
+    } else {
+      removeFile(getCacheFile(m_lastCacheKey), /* mustExist = */ false);
+    }
+    m_lastCacheKey.clear();
   }
 }
 
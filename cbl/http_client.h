@@ -4,19 +4,25 @@
 //   string response = client.get("https://example.com");
 //   client.setRemoteCookiesEnabled(true);
 //   string loginResponse = client.post("https://example.com/login", "user=X&password=Y");
+//   vector<string> responses = client.getMany({"https://example.com/a", "https://example.com/b"});
 #ifndef CBL_HTTP_CLIENT_H
 #define CBL_HTTP_CLIENT_H
 
+#include <exception>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
 #include "error.h"
+#include "http_cache_store.h"
 
 namespace cbl {
 
 class CurlGlobalState;
 class CurlHandle;
+class CurlMultiWorker;
 
 // No response from an HTTP server (e.g. no Internet connection or invalid domain).
 class NetworkError : public Error {
@@ -27,11 +33,15 @@ public:
 // The HTTP server returned an HTTP error.
 class HTTPError : public Error {
 public:
-  HTTPError(int httpCode, const std::string& message) : Error(message), m_httpCode(httpCode) {}
+  HTTPError(int httpCode, const std::string& message, int retryAfter = 0)
+      : Error(message), m_httpCode(httpCode), m_retryAfter(retryAfter) {}
   int httpCode() const { return m_httpCode; }
+  // Number of seconds from the Retry-After header of the response, or 0 if there is no such header.
+  int retryAfter() const { return m_retryAfter; }
 
 private:
   int m_httpCode;
+  int m_retryAfter;
 };
 
 // HTTP error 404.
@@ -70,9 +80,32 @@ public:
   // Sends a POST request to the specified URL.
   // Throws: HTTPError and subclasses, NetworkError.
   virtual std::string post(const std::string& url, const std::string& data);
-
-  // If seconds > 0, wait the specified number of seconds before each request.
+  using DataCallback = std::function<void(std::string_view chunk)>;
+  // Variants of get() and post() that pass the response to onData chunk by chunk as it is received, so that it can be
+  // processed during the transfer without keeping it in memory. onData is not called if the server returns an HTTP
+  // error. If onData throws an exception, the transfer is aborted and the exception is rethrown.
+  // Subclasses that override get() and post() to change where responses come from must also override these functions.
+  // Throws: HTTPError and subclasses, NetworkError, exceptions thrown by onData.
+  virtual void getStreamed(const std::string& url, const DataCallback& onData);
+  virtual void postStreamed(const std::string& url, const std::string& data, const DataCallback& onData);
+  // Asynchronous variants of get() and post(). Requests are run by a background thread with curl multi, up to
+  // maxConnections() at the same time, and multiplexed on a single connection if the server supports HTTP/2.
+  // Each request uses the user agent, cookies and headers set at the time of the call. If remote cookies are enabled,
+  // cookies received so far by synchronous requests are sent, but cookies received by asynchronous requests are not
+  // kept.
+  // The future throws the same exceptions as get() and post().
+  virtual std::future<std::string> getAsync(const std::string& url);
+  virtual std::future<std::string> postAsync(const std::string& url, const std::string& data);
+  // Retrieves several URLs in parallel with getAsync() and returns the responses in the same order.
+  // If some requests fail, waits for the end of all requests and rethrows the error of the first failed one.
+  std::vector<std::string> getMany(const std::vector<std::string>& urls);
+
+  // If seconds > 0, wait the specified number of seconds before each request. For asynchronous requests, this is the
+  // minimum delay between the start of two requests.
   void setDelayBeforeRequests(int seconds);
+  int maxConnections() const { return m_maxConnections; }
+  // Maximum number of asynchronous requests running at the same time (default: 4).
+  void setMaxConnections(int value);
   const std::string& userAgent() const;
   // Sets the value of the User-Agent header. If empty, no User-Agent header is sent (this is the default).
   void setUserAgent(const std::string& value);
@@ -99,21 +132,27 @@ private:
 
   CurlHandle& curlHandle();
   void resetCurlHandle();
+  CurlMultiWorker& multiWorker();
+  std::future<std::string> sendAsync(const std::string& url, const std::string* postData);
   // Throws: HTTPForbiddenError, HTTPNotFoundError, HTTPServerError, HTTPError, NetworkError.
-  std::string openInternal(const std::string& url, const char* errorMessagePrefix);
+  void openInternal(const std::string& url, const char* errorMessagePrefix, const DataCallback& onData);
   size_t write(void* ptr, size_t size, size_t nmemb);
   void updateCookieLine();
 
-  std::unique_ptr<CurlHandle> m_lazyCurlHandle;
   std::shared_ptr<CurlGlobalState> m_curlGlobalState;
+  std::unique_ptr<CurlHandle> m_lazyCurlHandle;
+  std::unique_ptr<CurlMultiWorker> m_lazyMultiWorker;
 
   bool m_remoteCookiesEnabled = false;
   std::string m_cookies;
   std::vector<std::string> m_headers;
   int m_delayBeforeRequests = 0;
+  int m_maxConnections = 4;
   std::string m_userAgent;
 
-  std::string* m_buffer = nullptr;
+  // State of the current synchronous request.
+  const DataCallback* m_dataCallback = nullptr;
+  std::exception_ptr m_dataCallbackException;
 };
 
 // Variant of HTTPClient that can cache responses to disk.
@@ -123,6 +162,8 @@ private:
 //   client.setCacheMode(HTTPClientWithCache::CACHE_ENABLED);
 //   string response1 = client.get("https://example.com");
 //   string response2 = client.get("https://example.com");  // This is read from the cache.
+// Instead of a directory with one file per request, the cache can be stored in a single database with size-based
+// eviction and expiration of entries (see setCacheDatabase and http_cache_store.h).
 class HTTPClientWithCache : public HTTPClient {
 public:
   enum CacheFlags {
@@ -143,6 +184,12 @@ public:
   std::string get(const std::string& url) override;
   // Throws: HTTPError and subclasses, NetworkError, PageNotInCacheError (only in offline mode).
   std::string post(const std::string& url, const std::string& data) override;
+  // Responses are passed to onData as a whole, since they need to be cached.
+  void getStreamed(const std::string& url, const DataCallback& onData) override;
+  void postStreamed(const std::string& url, const std::string& data, const DataCallback& onData) override;
+  // Asynchronous variants. Cached responses are returned immediately. doNotCacheLastResponse() does not apply to them.
+  std::future<std::string> getAsync(const std::string& url) override;
+  std::future<std::string> postAsync(const std::string& url, const std::string& data) override;
 
   int cacheMode() const;
   // mode must be a bitwise combination of values from CacheFlags.
@@ -150,16 +197,26 @@ public:
   const std::string& cacheDir() const;
   // The directory must exist.
   void setCacheDir(const std::string& dir);
+  // Stores the cache in a SQLite database instead of the cache directory. The database is created if needed.
+  void setCacheDatabase(const std::string& path, const HTTPCacheStoreParams& params = {});
   void doNotCacheLastResponse();
 
 private:
-  std::string getCacheFile(const std::string& request) const;
-  std::string getCacheFileForGET(const std::string& url) const;
-  std::string getCacheFileForPOST(const std::string& url, const std::string& data) const;
+  // The cache key is the name of the cache file without extension, or the key in the database.
+  std::string getCacheKey(const std::string& request) const;
+  std::string getCacheKeyForGET(const std::string& url) const;
+  std::string getCacheKeyForPOST(const std::string& url, const std::string& data) const;
+  std::string getCacheFile(const std::string& cacheKey) const;
+  bool readFromCache(const std::string& cacheKey, std::string& content);
+  void writeToCache(const std::string& cacheKey, const std::string& content);
+  // Returns the cached response for cacheKey if possible, and otherwise the result of sendRequest().
+  std::future<std::string> sendAsyncWithCache(const std::string& cacheKey, const std::string& description,
+                                              const std::function<std::future<std::string>()>& sendRequest);
 
   std::string m_cacheDir;
+  std::unique_ptr<HTTPCacheStore> m_cacheStore;
   int m_cacheMode = CACHE_DISABLED;
-  std::string m_lastCacheFile;
+  std::string m_lastCacheKey;
 };
 
 }  // namespace cbl
@@ -0,0 +1,317 @@
+#include "http_client.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "error.h"
+#include "log.h"
+#include "tempfile.h"
+#include "unittest.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace cbl {
+
+// Minimal HTTP/1.1 server listening on the loopback interface, with one thread per connection.
+// Paths:
+//   /echo/<text>: returns <text>.
+//   /slow/<text>: same as /echo/<text>, but waits 100 ms before answering.
+//   /post: returns the body of the request.
+//   /headers: returns the headers of the request.
+//   /error/<code>: returns the HTTP error <code> with a short error page (and "Retry-After: 7" for 429 and 503).
+//   /big/<size>: returns <size> bytes.
+class LoopbackServer {
+public:
+  LoopbackServer() {
+    m_socket = socket(AF_INET, SOCK_STREAM, 0);
+    CBL_ASSERT(m_socket != -1) << getCErrorString(errno);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+    CBL_ASSERT(bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) << getCErrorString(errno);
+    CBL_ASSERT(getsockname(m_socket, reinterpret_cast<sockaddr*>(&address), &addressLength) == 0);
+    CBL_ASSERT(listen(m_socket, 64) == 0) << getCErrorString(errno);
+    m_baseURL = "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+    m_acceptThread = std::thread([this]() { acceptConnections(); });
+  }
+  ~LoopbackServer() {
+    shutdown(m_socket, SHUT_RDWR);
+    m_acceptThread.join();
+    for (std::thread& thread : m_connectionThreads) {
+      thread.join();
+    }
+    close(m_socket);
+  }
+
+  const string& baseURL() const { return m_baseURL; }
+  int maxConcurrentRequests() const { return m_maxConcurrentRequests; }
+  vector<std::chrono::steady_clock::time_point> requestTimes() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_requestTimes;
+  }
+
+private:
+  void acceptConnections() {
+    while (true) {
+      int connection = accept(m_socket, nullptr, nullptr);
+      if (connection == -1) break;
+      m_connectionThreads.emplace_back([this, connection]() {
+        handleConnection(connection);
+        close(connection);
+      });
+    }
+  }
+
+  void handleConnection(int connection) {
+    string request;
+    char buffer[4096];
+    size_t headersEnd;
+    while ((headersEnd = request.find("\r\n\r\n")) == string::npos) {
+      ssize_t size = read(connection, buffer, sizeof(buffer));
+      if (size <= 0) return;
+      request.append(buffer, size);
+    }
+    string headers = request.substr(0, headersEnd);
+    size_t contentLength = 0;
+    size_t contentLengthPosition = headers.find("Content-Length: ");
+    if (contentLengthPosition != string::npos) {
+      contentLength = std::stoul(headers.substr(contentLengthPosition + 16));
+    }
+    while (request.size() < headersEnd + 4 + contentLength) {
+      ssize_t size = read(connection, buffer, sizeof(buffer));
+      if (size <= 0) return;
+      request.append(buffer, size);
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_requestTimes.push_back(std::chrono::steady_clock::now());
+    }
+    int concurrentRequests = ++m_concurrentRequests;
+    m_maxConcurrentRequests = std::max(m_maxConcurrentRequests.load(), concurrentRequests);
+
+    string_view path = string_view(headers).substr(headers.find(' ') + 1);
+    path = path.substr(0, path.find(' '));
+    int code = 200;
+    string extraHeaders;
+    string body;
+    if (path.starts_with("/echo/")) {
+      body = path.substr(6);
+    } else if (path.starts_with("/slow/")) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      body = path.substr(6);
+    } else if (path == "/post") {
+      body = request.substr(headersEnd + 4);
+    } else if (path == "/headers") {
+      body = headers + "\r\n";
+    } else if (path.starts_with("/big/")) {
+      body.resize(std::stoi(string(path.substr(5))));
+      for (size_t i = 0; i < body.size(); i++) {
+        body[i] = 'a' + i % 26;
+      }
+    } else if (path.starts_with("/error/")) {
+      code = std::stoi(string(path.substr(7)));
+      if (code == 429 || code == 503) {
+        extraHeaders = "Retry-After: 7\r\n";
+      }
+      body = "Error page";
+    } else {
+      code = 404;
+    }
+    --m_concurrentRequests;
+    string response = "HTTP/1.1 " + std::to_string(code) + " Status\r\nContent-Length: " +
+                      std::to_string(body.size()) + "\r\nConnection: close\r\n" + extraHeaders + "\r\n" + body;
+    CBL_ASSERT_EQ(write(connection, response.data(), response.size()), static_cast<ssize_t>(response.size()));
+  }
+
+  int m_socket = -1;
+  string m_baseURL;
+  std::thread m_acceptThread;
+  vector<std::thread> m_connectionThreads;
+  std::atomic<int> m_concurrentRequests = 0;
+  std::atomic<int> m_maxConcurrentRequests = 0;
+  std::mutex m_mutex;
+  vector<std::chrono::steady_clock::time_point> m_requestTimes;
+};
+
+class HTTPClientTest : public cbl::Test {
+private:
+  CBL_TEST_CASE(GetAndPost) {
+    LoopbackServer server;
+    HTTPClient client;
+    CBL_ASSERT_EQ(client.get(server.baseURL() + "/echo/abc"), "abc");
+    CBL_ASSERT_EQ(client.post(server.baseURL() + "/post", "x=1&y=2"), "x=1&y=2");
+    std::future<string> getResponse = client.getAsync(server.baseURL() + "/echo/def");
+    std::future<string> postResponse = client.postAsync(server.baseURL() + "/post", "z=3");
+    CBL_ASSERT_EQ(getResponse.get(), "def");
+    CBL_ASSERT_EQ(postResponse.get(), "z=3");
+  }
+
+  CBL_TEST_CASE(Streamed) {
+    LoopbackServer server;
+    HTTPClient client;
+    string expectedBody = client.get(server.baseURL() + "/big/1000000");
+    CBL_ASSERT_EQ(expectedBody.size(), 1000000U);
+    string body;
+    int numChunks = 0;
+    client.getStreamed(server.baseURL() + "/big/1000000", [&](string_view chunk) {
+      body += chunk;
+      numChunks++;
+    });
+    CBL_ASSERT(body == expectedBody);
+    CBL_ASSERT(numChunks > 1);
+    body.clear();
+    client.postStreamed(server.baseURL() + "/post", "x=1", [&](string_view chunk) { body += chunk; });
+    CBL_ASSERT_EQ(body, "x=1");
+
+    // Exceptions thrown by the callback abort the transfer.
+    numChunks = 0;
+    try {
+      client.getStreamed(server.baseURL() + "/big/1000000", [&](string_view chunk) {
+        numChunks++;
+        throw ParseError("Stop");
+      });
+      CBL_ASSERT(false) << "ParseError not thrown";
+    } catch (const ParseError&) {
+    }
+    CBL_ASSERT_EQ(numChunks, 1);
+    // The client can still be used after that.
+    CBL_ASSERT_EQ(client.get(server.baseURL() + "/echo/a"), "a");
+
+    try {
+      client.getStreamed(server.baseURL() + "/error/404", [&](string_view chunk) { CBL_ASSERT(false); });
+      CBL_ASSERT(false) << "HTTPNotFoundError not thrown";
+    } catch (const HTTPNotFoundError&) {
+    }
+  }
+
+  CBL_TEST_CASE(AsyncRequestsUseClientSettings) {
+    LoopbackServer server;
+    HTTPClient client;
+    client.setUserAgent("TestAgent/1.0");
+    client.setCookies("session=42");
+    client.addHeader("X-Test: yes");
+    string headers = client.getAsync(server.baseURL() + "/headers").get();
+    CBL_ASSERT(headers.find("User-Agent: TestAgent/1.0\r\n") != string::npos) << headers;
+    CBL_ASSERT(headers.find("Cookie: session=42\r\n") != string::npos) << headers;
+    CBL_ASSERT(headers.find("X-Test: yes\r\n") != string::npos) << headers;
+  }
+
+  CBL_TEST_CASE(Errors) {
+    LoopbackServer server;
+    HTTPClient client;
+    std::future<string> notFound = client.getAsync(server.baseURL() + "/error/404");
+    std::future<string> serverError = client.postAsync(server.baseURL() + "/error/503", "");
+    try {
+      notFound.get();
+      CBL_ASSERT(false) << "HTTPNotFoundError not thrown";
+    } catch (const HTTPNotFoundError& error) {
+      CBL_ASSERT_EQ(error.httpCode(), 404);
+      CBL_ASSERT_EQ(error.retryAfter(), 0);
+    }
+    try {
+      serverError.get();
+      CBL_ASSERT(false) << "HTTPServerError not thrown";
+    } catch (const HTTPServerError& error) {
+      CBL_ASSERT_EQ(error.httpCode(), 503);
+      CBL_ASSERT_EQ(error.retryAfter(), 7);
+    }
+    try {
+      client.getMany({server.baseURL() + "/echo/a", server.baseURL() + "/error/403", server.baseURL() + "/error/404"});
+      CBL_ASSERT(false) << "HTTPForbiddenError not thrown";
+    } catch (const HTTPForbiddenError&) {
+    }
+  }
+
+  CBL_TEST_CASE(GetManyWithConnectionLimit) {
+    LoopbackServer server;
+    HTTPClient client;
+    client.setMaxConnections(3);
+    vector<string> urls;
+    vector<string> expectedResponses;
+    for (int i = 0; i < 12; i++) {
+      urls.push_back(server.baseURL() + "/slow/" + std::to_string(i));
+      expectedResponses.push_back(std::to_string(i));
+    }
+    auto start = std::chrono::steady_clock::now();
+    CBL_ASSERT(client.getMany(urls) == expectedResponses);
+    auto duration = std::chrono::steady_clock::now() - start;
+    CBL_ASSERT_EQ(server.maxConcurrentRequests(), 3);
+    // 12 requests of 100 ms each, run 3 by 3.
+    CBL_ASSERT(duration >= std::chrono::milliseconds(400));
+    CBL_ASSERT(duration < std::chrono::milliseconds(1200));
+  }
+
+  CBL_TEST_CASE(DelayBeforeRequests) {
+    LoopbackServer server;
+    HTTPClient client;
+    client.setDelayBeforeRequests(1);
+    CBL_ASSERT(client.getMany({server.baseURL() + "/echo/a", server.baseURL() + "/echo/b"}) ==
+               vector<string>({"a", "b"}));
+    vector<std::chrono::steady_clock::time_point> requestTimes = server.requestTimes();
+    CBL_ASSERT_EQ(requestTimes.size(), 2U);
+    CBL_ASSERT(requestTimes[1] - requestTimes[0] >= std::chrono::milliseconds(900));
+  }
+
+  CBL_TEST_CASE(CacheDatabase) {
+    LoopbackServer server;
+    TempDir tempDir;
+    HTTPClientWithCache client;
+    client.setCacheDatabase(tempDir.path() + "/cache.sqlite");
+    client.setCacheMode(HTTPClientWithCache::CACHE_ENABLED | HTTPClientWithCache::CACHE_POST);
+    CBL_ASSERT_EQ(client.get(server.baseURL() + "/echo/a"), "a");
+    CBL_ASSERT_EQ(client.post(server.baseURL() + "/post", "b"), "b");
+    CBL_ASSERT_EQ(client.getAsync(server.baseURL() + "/echo/c").get(), "c");
+    CBL_ASSERT_EQ(client.get(server.baseURL() + "/echo/d"), "d");
+    client.doNotCacheLastResponse();
+    CBL_ASSERT_EQ(server.requestTimes().size(), 4U);
+
+    client.setCacheMode(HTTPClientWithCache::CACHE_ENABLED | HTTPClientWithCache::CACHE_POST |
+                        HTTPClientWithCache::CACHE_OFFLINE_MODE);
+    CBL_ASSERT_EQ(client.get(server.baseURL() + "/echo/a"), "a");
+    CBL_ASSERT_EQ(client.post(server.baseURL() + "/post", "b"), "b");
+    CBL_ASSERT(client.getMany({server.baseURL() + "/echo/a", server.baseURL() + "/echo/c"}) ==
+               vector<string>({"a", "c"}));
+    try {
+      client.get(server.baseURL() + "/echo/d");
+      CBL_ASSERT(false) << "PageNotInCacheError not thrown";
+    } catch (const PageNotInCacheError&) {
+    }
+    CBL_ASSERT_EQ(server.requestTimes().size(), 4U);
+  }
+
+  CBL_TEST_CASE(PendingRequestsAtDestruction) {
+    LoopbackServer server;
+    std::future<string> response;
+    {
+      HTTPClient client;
+      client.setDelayBeforeRequests(10);
+      client.getAsync(server.baseURL() + "/echo/a");
+      response = client.getAsync(server.baseURL() + "/echo/b");
+    }
+    try {
+      response.get();
+      CBL_ASSERT(false) << "NetworkError not thrown";
+    } catch (const NetworkError&) {
+    }
+  }
+};
+
+}  // namespace cbl
+
+int main() {
+  cbl::HTTPClientTest().run();
+  return 0;
+}
@@ -649,6 +649,246 @@ Value parse(string_view s) {
   return value;
 }
 
+static bool isNumberChar(char c) {
+  return (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E';
+}
+
+static bool isKeywordChar(char c) {
+  return c >= 'a' && c <= 'z';
+}
+
+void StreamingParser::feed(string_view chunk) {
+  size_t position = 0;
+  try {
+    feedInternal(chunk, position);
+  } catch (const ParseError& error) {
+    throw ParseError(string(error.what()) + " (offset " + std::to_string(m_offset + position) + ")");
+  }
+  m_offset += chunk.size();
+}
+
+void StreamingParser::feedInternal(string_view chunk, size_t& position) {
+  if (m_tokenType != TokenType::NONE) {
+    size_t tokenEnd = findTokenEnd(chunk, 0);
+    if (tokenEnd == string_view::npos) {
+      m_pendingToken += chunk;
+      position = chunk.size();
+      return;
+    }
+    m_pendingToken += chunk.substr(0, tokenEnd);
+    processToken(m_pendingToken);
+    m_pendingToken.clear();
+    position = tokenEnd;
+  }
+  while (position < chunk.size()) {
+    char c = chunk[position];
+    if (isspace(static_cast<unsigned char>(c))) {
+      position++;
+      continue;
+    }
+    bool expectValue = m_expect == Expect::VALUE || m_expect == Expect::VALUE_OR_ARRAY_END;
+    bool expectKey = m_expect == Expect::KEY || m_expect == Expect::KEY_OR_OBJECT_END;
+    if (c == '"' && (expectValue || expectKey)) {
+      m_tokenType = TokenType::STRING;
+      m_escaped = false;
+    } else if (expectValue && ((c >= '0' && c <= '9') || c == '-')) {
+      m_tokenType = TokenType::NUMBER;
+    } else if (expectValue && isKeywordChar(c)) {
+      m_tokenType = TokenType::KEYWORD;
+    } else {
+      processChar(c);
+      position++;
+      continue;
+    }
+    size_t tokenEnd = findTokenEnd(chunk, position + 1);
+    if (tokenEnd == string_view::npos) {
+      m_pendingToken = chunk.substr(position);
+      position = chunk.size();
+      return;
+    }
+    processToken(chunk.substr(position, tokenEnd - position));
+    position = tokenEnd;
+  }
+}
+
+size_t StreamingParser::findTokenEnd(string_view chunk, size_t position) {
+  switch (m_tokenType) {
+    case TokenType::STRING: {
+      if (m_escaped) {
+        if (position >= chunk.size()) break;
+        m_escaped = false;
+        position++;
+      }
+      // Quotes preceded by an odd number of backslashes are escaped.
+      const size_t start = position;
+      auto isEscaped = [&](size_t end) {
+        size_t numBackslashes = 0;
+        for (; end > start && chunk[end - 1] == '\\'; end--) {
+          numBackslashes++;
+        }
+        return numBackslashes % 2 == 1;
+      };
+      while (position < chunk.size()) {
+        const void* quote = memchr(chunk.data() + position, '"', chunk.size() - position);
+        if (quote == nullptr) break;
+        position = static_cast<const char*>(quote) - chunk.data();
+        if (!isEscaped(position)) {
+          return position + 1;
+        }
+        position++;
+      }
+      m_escaped = isEscaped(chunk.size());
+      break;
+    }
+    case TokenType::NUMBER:
+      for (; position < chunk.size(); position++) {
+        if (!isNumberChar(chunk[position])) return position;
+      }
+      break;
+    case TokenType::KEYWORD:
+      for (; position < chunk.size(); position++) {
+        if (!isKeywordChar(chunk[position])) return position;
+      }
+      break;
+    case TokenType::NONE:
+      break;
+  }
+  return string_view::npos;
+}
+
+void StreamingParser::processToken(string_view token) {
+  TokenType tokenType = m_tokenType;
+  m_tokenType = TokenType::NONE;
+  switch (tokenType) {
+    case TokenType::STRING: {
+      string text = unquotePartial(token);
+      if (m_expect == Expect::KEY || m_expect == Expect::KEY_OR_OBJECT_END) {
+        m_key = std::move(text);
+        m_expect = Expect::COLON;
+      } else {
+        Value& value = addValue();
+        value.setType(VT_STRING);
+        *value.m_data.str = std::move(text);
+      }
+      break;
+    }
+    case TokenType::NUMBER: {
+      // Same validation as ValueParser::parseNumber.
+      if (std::count(token.begin(), token.end(), '.') > 1) {
+        throw ParseError("Invalid number");
+      }
+      Value& value = addValue();
+      value.setType(VT_NUMBER);
+      *value.m_data.str = token;
+      break;
+    }
+    case TokenType::KEYWORD:
+      if (token == "null") {
+        addValue();
+      } else if (token == "true" || token == "false") {
+        addValue().setBoolean(token == "true");
+      } else {
+        throw ParseError("Invalid keyword '" + string(token) + "'");
+      }
+      break;
+    case TokenType::NONE:
+      break;
+  }
+}
+
+void StreamingParser::processChar(char c) {
+  switch (m_expect) {
+    case Expect::VALUE:
+    case Expect::VALUE_OR_ARRAY_END:
+      if (c == '{') {
+        openContainer(VT_OBJECT);
+      } else if (c == '[') {
+        openContainer(VT_ARRAY);
+      } else if (c == ']' && m_expect == Expect::VALUE_OR_ARRAY_END) {
+        closeContainer();
+      } else {
+        throw ParseError("Unexpected character at the beginning of a value: '" + string(1, c) + "'");
+      }
+      break;
+    case Expect::KEY_OR_OBJECT_END:
+      if (c != '}') {
+        throw ParseError("Invalid object: expected string key or '}' after '{'");
+      }
+      closeContainer();
+      break;
+    case Expect::KEY:
+      throw ParseError(c == '}' ? "Invalid object: trailing commas are not allowed before '}'"
+                                : "Invalid object: expected string key after ','");
+    case Expect::COLON:
+      if (c != ':') {
+        throw ParseError("Invalid object: missing ':' after key");
+      }
+      m_expect = Expect::VALUE;
+      break;
+    case Expect::COMMA_OR_END: {
+      bool inObject = m_containers.back()->m_type == VT_OBJECT;
+      if (c == ',') {
+        m_expect = inObject ? Expect::KEY : Expect::VALUE;
+      } else if (c == (inObject ? '}' : ']')) {
+        closeContainer();
+      } else {
+        throw ParseError(inObject ? "Invalid object: missing ',' or '}' after value"
+                                  : "Invalid array: expected ',' or ']' after value");
+      }
+      break;
+    }
+    case Expect::END:
+      throw ParseError("Unexpected content after the end of the JSON string");
+  }
+}
+
+Value& StreamingParser::addValue() {
+  if (m_containers.empty()) {
+    m_expect = Expect::END;
+    return m_root;
+  }
+  m_expect = Expect::COMMA_OR_END;
+  Value& container = *m_containers.back();
+  if (container.m_type == VT_OBJECT) {
+    // Like ValueParser, the last value wins if a key is duplicated.
+    Value& value = (*container.m_data.object)[m_key];
+    value.setNull();
+    return value;
+  }
+  container.m_data.array->push_back(new Value);
+  return *container.m_data.array->back();
+}
+
+void StreamingParser::openContainer(ValueType type) {
+  Value& value = addValue();
+  value.setType(type);
+  m_containers.push_back(&value);
+  m_expect = type == VT_OBJECT ? Expect::KEY_OR_OBJECT_END : Expect::VALUE_OR_ARRAY_END;
+}
+
+void StreamingParser::closeContainer() {
+  m_containers.pop_back();
+  m_expect = m_containers.empty() ? Expect::END : Expect::COMMA_OR_END;
+}
+
+Value StreamingParser::finish() {
+  try {
+    if (m_tokenType == TokenType::STRING) {
+      throw ParseError("Invalid string: missing closing quotes");
+    } else if (m_tokenType != TokenType::NONE) {
+      processToken(m_pendingToken);
+      m_pendingToken.clear();
+    }
+    if (m_expect != Expect::END) {
+      throw ParseError(m_containers.empty() ? "Expected value but found end of string"
+                                            : "Unexpected end of string in object or array");
+    }
+  } catch (const ParseError& error) {
+    throw ParseError(string(error.what()) + " (offset " + std::to_string(m_offset) + ")");
+  }
+  return std::move(m_root);
+}
+
 std::ostream& operator<<(std::ostream& os, const Value& value) {
   return os << value.toJSON();
 }
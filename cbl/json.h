@@ -12,6 +12,12 @@
 //   results.addItem() = 3;
 //   std::cout << value.toJSON() << "\n";
 //
+// Parsing JSON received in chunks (see StreamingParser):
+//   json::StreamingParser parser;
+//   parser.feed(R"({"results": [1, )");
+//   parser.feed("2, 3]}");
+//   json::Value value = parser.finish();
+//
 // There is currently no support for floating point values. The parser can process data containing floating point
 // values, but there is no way to read them afterwards.
 #ifndef CBL_JSON_H
@@ -187,6 +193,7 @@ private:
   } m_data;
 
   friend class ValueParser;
+  friend class StreamingParser;
 };
 
 std::ostream& operator<<(std::ostream& os, const Value& value);
@@ -194,6 +201,66 @@ std::ostream& operator<<(std::ostream& os, const Value& value);
 Value parse(std::string_view s);
 Value parsePartial(std::string_view& s);
 
+// Incremental parser for JSON text received in chunks, such as an HTTP response. Each chunk is parsed as soon as it is
+// received, so the full text never needs to be kept in memory (only the current string or number if it spans several
+// chunks).
+// The result is the same as parse() on the concatenation of all chunks. Error messages contain the offset of the error
+// instead of a snippet of the text.
+class StreamingParser {
+public:
+  StreamingParser() = default;
+  StreamingParser(const StreamingParser&) = delete;
+  StreamingParser& operator=(const StreamingParser&) = delete;
+
+  // Parses the next part of the text. After an exception, the parser cannot be used anymore.
+  // Throws: cbl::ParseError.
+  void feed(std::string_view chunk);
+  // Returns the value after the last chunk has been fed. The parser cannot be used anymore after that.
+  // Throws: cbl::ParseError if the text is incomplete.
+  Value finish();
+
+private:
+  enum class Expect {
+    VALUE,
+    VALUE_OR_ARRAY_END,
+    KEY,
+    KEY_OR_OBJECT_END,
+    COLON,
+    COMMA_OR_END,
+    END,
+  };
+  enum class TokenType {
+    NONE,
+    STRING,
+    NUMBER,
+    KEYWORD,
+  };
+
+  void feedInternal(std::string_view chunk, size_t& position);
+  // Returns the position of the end of the current token in chunk, or npos if it does not end in this chunk.
+  size_t findTokenEnd(std::string_view chunk, size_t position);
+  void processToken(std::string_view token);
+  void processChar(char c);
+  // Returns the value to fill in the current container (or the root value).
+  Value& addValue();
+  void openContainer(ValueType type);
+  void closeContainer();
+
+  Value m_root;
+  // Objects and arrays that are not closed yet, from the outermost to the innermost.
+  std::vector<Value*> m_containers;
+  Expect m_expect = Expect::VALUE;
+  // Last key read in the innermost object.
+  std::string m_key;
+  // Token that started in a previous chunk and is not complete yet.
+  TokenType m_tokenType = TokenType::NONE;
+  std::string m_pendingToken;
+  // In a string token, whether the previous char is an unescaped backslash.
+  bool m_escaped = false;
+  // Number of chars fed before the current chunk.
+  size_t m_offset = 0;
+};
+
 }  // namespace json
 
 #endif
@@ -0,0 +1,112 @@
+#include "json.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include "error.h"
+#include "log.h"
+#include "unittest.h"
+
+using std::string;
+using std::string_view;
+
+namespace json {
+
+class JSONTest : public cbl::Test {
+private:
+  static constexpr const char* VALID_DOCUMENTS[] = {
+      "null",
+      " true ",
+      "false",
+      "0",
+      "-12.5e+3",
+      R"("")",
+      R"("a\"b\\c\/d\né😀")",
+      "[]",
+      "[ ]",
+      "{}",
+      "[1,2,[3,[]],{\"a\":null}]",
+      R"({"batchcomplete": true, "query": {"pages": [{"pageid": 12, "title": "Page \"1\"", "missing": false},
+          {"pageid": 13, "revisions": [{"revid": 123456789, "content": "{{Modèle|x=[1]}}\\"}]}]}})",
+      R"({"a": 1, "a": [2]})",
+      R"(["\\\\", "\\\"", "x\\", "\\\\\"\\"])",
+  };
+  static constexpr const char* INVALID_DOCUMENTS[] = {
+      "",
+      "   ",
+      "nul",
+      "truex",
+      "1.2.3",
+      "\"abc",
+      R"("\x")",
+      "[1,]",
+      "[1 2]",
+      "{\"a\" 1}",
+      "{\"a\": 1,}",
+      "{1: 2}",
+      "{\"a\": 1",
+      "[[]",
+      "[]]",
+      "{} x",
+      "@",
+  };
+
+  static Value parseInChunks(string_view text, size_t chunkSize) {
+    StreamingParser parser;
+    for (size_t i = 0; i < text.size(); i += chunkSize) {
+      parser.feed(text.substr(i, chunkSize));
+    }
+    return parser.finish();
+  }
+
+  CBL_TEST_CASE(StreamingParserValidDocuments) {
+    for (string_view document : VALID_DOCUMENTS) {
+      string expectedJSON = parse(document).toJSON();
+      for (size_t chunkSize = 1; chunkSize <= document.size(); chunkSize++) {
+        CBL_ASSERT_EQ(parseInChunks(document, chunkSize).toJSON(), expectedJSON) << document << " " << chunkSize;
+      }
+      // Split at each position, with an empty chunk in the middle.
+      for (size_t i = 0; i <= document.size(); i++) {
+        StreamingParser parser;
+        parser.feed(document.substr(0, i));
+        parser.feed("");
+        parser.feed(document.substr(i));
+        CBL_ASSERT_EQ(parser.finish().toJSON(), expectedJSON) << document << " " << i;
+      }
+    }
+  }
+
+  CBL_TEST_CASE(StreamingParserInvalidDocuments) {
+    for (string_view document : INVALID_DOCUMENTS) {
+      try {
+        parse(document);
+        CBL_ASSERT(false) << "parse() did not fail on " << document;
+      } catch (const cbl::ParseError&) {
+      }
+      for (size_t chunkSize = 1; chunkSize <= std::max<size_t>(document.size(), 1); chunkSize++) {
+        try {
+          parseInChunks(document, chunkSize);
+          CBL_ASSERT(false) << "StreamingParser did not fail on " << document << " " << chunkSize;
+        } catch (const cbl::ParseError&) {
+        }
+      }
+    }
+  }
+
+  CBL_TEST_CASE(StreamingParserErrorOffset) {
+    StreamingParser parser;
+    parser.feed("[1, 2, ");
+    try {
+      parser.feed("3 4]");
+      CBL_ASSERT(false);
+    } catch (const cbl::ParseError& error) {
+      CBL_ASSERT_EQ(string(error.what()), "Invalid array: expected ',' or ']' after value (offset 9)");
+    }
+  }
+};
+
+}  // namespace json
+
+int main() {
+  json::JSONTest().run();
+  return 0;
+}
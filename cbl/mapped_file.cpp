@@ -0,0 +1,44 @@
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <string>
+#include "error.h"
+
+using std::string;
+
+namespace cbl {
+
+MappedFile::MappedFile(const string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    if (errno == ENOENT) {
+      throw FileNotFoundError("File '" + path + "' does not exist");
+    }
+    throw SystemError("Cannot open '" + path + "': " + getCErrorString(errno));
+  }
+  RunOnDestroy closeFile([fd]() { close(fd); });
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0) {
+    throw SystemError("Cannot stat '" + path + "': " + getCErrorString(errno));
+  }
+  if (fileStat.st_size == 0) {
+    return;  // mmap() does not support empty mappings.
+  }
+  void* mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    throw SystemError("Cannot map '" + path + "' in memory: " + getCErrorString(errno));
+  }
+  m_data = static_cast<const char*>(mapping);
+  m_size = fileStat.st_size;
+}
+
+MappedFile::~MappedFile() {
+  if (m_data != nullptr) {
+    munmap(const_cast<char*>(m_data), m_size);
+  }
+}
+
+}  // namespace cbl
@@ -0,0 +1,33 @@
+// Read-only mapping of a whole file in memory.
+#ifndef CBL_MAPPED_FILE_H
+#define CBL_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace cbl {
+
+class MappedFile {
+public:
+  // Maps the file at `path`. The content is read lazily by the system, so this is almost instantaneous even for large
+  // files. The file must not be modified while it is mapped.
+  // Throws: FileNotFoundError, SystemError.
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Null if the file is empty.
+  const char* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  std::string_view content() const { return std::string_view(m_data, m_size); }
+
+private:
+  const char* m_data = nullptr;
+  size_t m_size = 0;
+};
+
+}  // namespace cbl
+
+#endif
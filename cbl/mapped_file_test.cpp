@@ -0,0 +1,48 @@
+#include "mapped_file.h"
+#include <string>
+#include "error.h"
+#include "file.h"
+#include "log.h"
+#include "tempfile.h"
+#include "unittest.h"
+
+using std::string;
+
+namespace cbl {
+
+class MappedFileTest : public cbl::Test {
+private:
+  CBL_TEST_CASE(Map) {
+    TempDir tempDir;
+    const string path = tempDir.path() + "/file";
+    writeFile(path, "content");
+    MappedFile file(path);
+    CBL_ASSERT_EQ(file.size(), 7u);
+    CBL_ASSERT_EQ(file.content(), "content");
+  }
+
+  CBL_TEST_CASE(EmptyFile) {
+    TempDir tempDir;
+    const string path = tempDir.path() + "/file";
+    writeFile(path, "");
+    MappedFile file(path);
+    CBL_ASSERT(file.data() == nullptr);
+    CBL_ASSERT_EQ(file.size(), 0u);
+  }
+
+  CBL_TEST_CASE(MissingFile) {
+    TempDir tempDir;
+    try {
+      MappedFile file(tempDir.path() + "/missing");
+      CBL_ASSERT(false) << "FileNotFoundError not thrown";
+    } catch (const FileNotFoundError&) {
+    }
+  }
+};
+
+}  // namespace cbl
+
+int main() {
+  cbl::MappedFileTest().run();
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "multi_pattern_matcher.h"
+#include <re2/re2.h>
+#include <re2/set.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "error.h"
+#include "log.h"
+#include "string.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace cbl {
+
+static re2::RE2::Options getDefaultOptions() {
+  re2::RE2::Options options;
+  // The DFA of the set is larger than the DFA of each pattern, so give it more room than the default (8 MB) to avoid
+  // falling back to the slow path.
+  options.set_max_mem(64 << 20);
+  options.set_log_errors(false);
+  return options;
+}
+
+MultiPatternMatcher::MultiPatternMatcher()
+    : m_options(getDefaultOptions()), m_set(m_options, re2::RE2::UNANCHORED) {}
+
+MultiPatternMatcher::~MultiPatternMatcher() {}
+
+int MultiPatternMatcher::add(string_view pattern) {
+  if (m_compiled) {
+    throw InvalidStateError("MultiPatternMatcher::add() called after compile()");
+  } else if (m_patterns.size() >= MAX_PATTERNS) {
+    throw InvalidStateError(concat("Cannot add more than ", std::to_string(MAX_PATTERNS), " patterns"));
+  }
+  string error;
+  int index = m_set.Add(re2::StringPiece(pattern.data(), pattern.size()), &error);
+  if (index < 0) {
+    throw ParseError(concat("Invalid regular expression '", pattern, "': ", error));
+  }
+  CBL_ASSERT_EQ(index, static_cast<int>(m_patterns.size()));
+  m_patterns.emplace_back(new re2::RE2(re2::StringPiece(pattern.data(), pattern.size()), m_options));
+  return index;
+}
+
+void MultiPatternMatcher::compile() {
+  if (m_compiled) {
+    throw InvalidStateError("MultiPatternMatcher::compile() called twice");
+  } else if (!m_set.Compile()) {
+    throw InternalError("Failed to compile the set of regular expressions (out of memory)");
+  }
+  m_compiled = true;
+}
+
+MultiPatternMatcher::Result MultiPatternMatcher::match(string_view text) const {
+  if (!m_compiled) {
+    throw InvalidStateError("MultiPatternMatcher::match() called before compile()");
+  }
+  Result result;
+  re2::StringPiece textPiece(text.data(), text.size());
+  vector<int> matchingPatterns;
+  re2::RE2::Set::ErrorInfo errorInfo;
+  if (m_set.Match(textPiece, &matchingPatterns, &errorInfo)) {
+    for (int index : matchingPatterns) {
+      result.set(index);
+    }
+  } else if (errorInfo.kind != re2::RE2::Set::kNoError) {
+    for (size_t i = 0; i < m_patterns.size(); i++) {
+      if (re2::RE2::PartialMatch(textPiece, *m_patterns[i])) {
+        result.set(i);
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace cbl
@@ -0,0 +1,53 @@
+// Matches a text against multiple regular expressions in a single pass.
+// Usage:
+//   cbl::MultiPatternMatcher matcher;
+//   int reStub = matcher.add(R"(\{\{\s*[ÉEée]bauche\s*[|}])");
+//   int reCategory = matcher.add(R"((?i:\[\[\s*(Catégorie|Category)\s*:))");
+//   matcher.compile();
+//   cbl::MultiPatternMatcher::Result result = matcher.match(code);
+//   if (result.test(reStub)) { ... }
+#ifndef CBL_MULTI_PATTERN_MATCHER_H
+#define CBL_MULTI_PATTERN_MATCHER_H
+
+#include <re2/re2.h>
+#include <re2/set.h>
+#include <bitset>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace cbl {
+
+class MultiPatternMatcher {
+public:
+  static constexpr int MAX_PATTERNS = 64;
+  // Bit i is set if the pattern with index i matches somewhere in the text.
+  using Result = std::bitset<MAX_PATTERNS>;
+
+  MultiPatternMatcher();
+  ~MultiPatternMatcher();
+
+  // Adds a pattern with the RE2 syntax and returns its index. Patterns are unanchored, i.e. they can match anywhere
+  // in the text, like with RE2::PartialMatch.
+  // Must not be called after compile().
+  // Throws: ParseError if the pattern is invalid, InvalidStateError if too many patterns are added.
+  int add(std::string_view pattern);
+  // Must be called once after all patterns have been added and before calling match().
+  // Throws: InternalError.
+  void compile();
+  // Returns the set of patterns that match `text`.
+  // If the DFA runs out of memory on some pathological input, falls back to matching patterns one by one, so the
+  // result is always the same as calling RE2::PartialMatch for each pattern.
+  Result match(std::string_view text) const;
+
+private:
+  re2::RE2::Options m_options;
+  re2::RE2::Set m_set;
+  // Used only as a fallback if the set cannot be matched.
+  std::vector<std::unique_ptr<re2::RE2>> m_patterns;
+  bool m_compiled = false;
+};
+
+}  // namespace cbl
+
+#endif
@@ -0,0 +1,61 @@
+#include "multi_pattern_matcher.h"
+#include "error.h"
+#include "log.h"
+#include "unittest.h"
+
+namespace cbl {
+
+class MultiPatternMatcherTest : public cbl::Test {
+  CBL_TEST_CASE(match) {
+    MultiPatternMatcher matcher;
+    CBL_ASSERT_EQ(matcher.add("abc"), 0);
+    CBL_ASSERT_EQ(matcher.add("b+c"), 1);
+    CBL_ASSERT_EQ(matcher.add("^x"), 2);
+    CBL_ASSERT_EQ(matcher.add(R"((?i:[ée]bauche))"), 3);
+    matcher.compile();
+    CBL_ASSERT_EQ(matcher.match("").to_ulong(), 0b0000U);
+    CBL_ASSERT_EQ(matcher.match("abc").to_ulong(), 0b0011U);
+    CBL_ASSERT_EQ(matcher.match("bbbc").to_ulong(), 0b0010U);
+    CBL_ASSERT_EQ(matcher.match("xabc").to_ulong(), 0b0111U);
+    CBL_ASSERT_EQ(matcher.match("ax").to_ulong(), 0b0000U);
+    CBL_ASSERT_EQ(matcher.match("{{Ébauche}} bc").to_ulong(), 0b1010U);
+  }
+
+  CBL_TEST_CASE(invalidPattern) {
+    MultiPatternMatcher matcher;
+    bool exceptionThrown = false;
+    try {
+      matcher.add("(");
+    } catch (const ParseError&) {
+      exceptionThrown = true;
+    }
+    CBL_ASSERT(exceptionThrown);
+  }
+
+  CBL_TEST_CASE(invalidState) {
+    MultiPatternMatcher matcher;
+    matcher.add("a");
+    bool exceptionThrown = false;
+    try {
+      matcher.match("a");
+    } catch (const InvalidStateError&) {
+      exceptionThrown = true;
+    }
+    CBL_ASSERT(exceptionThrown);
+    matcher.compile();
+    exceptionThrown = false;
+    try {
+      matcher.add("b");
+    } catch (const InvalidStateError&) {
+      exceptionThrown = true;
+    }
+    CBL_ASSERT(exceptionThrown);
+  }
+};
+
+}  // namespace cbl
+
+int main() {
+  cbl::MultiPatternMatcherTest().run();
+  return 0;
+}
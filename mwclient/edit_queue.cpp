@@ -0,0 +1,53 @@
+#include "edit_queue.h"
+#include <utility>
+#include "cbl/log.h"
+#include "wiki.h"
+#include "wiki_defs.h"
+
+namespace mwc {
+
+EditQueue::EditQueue(Wiki& wiki) : m_wiki(wiki) {}
+
+EditQueue::~EditQueue() {
+  for (const QueuedEdit& edit : m_edits) {
+    CBL_ERROR << "Edit of '" << edit.title << "' discarded because the queue was destroyed before being flushed";
+  }
+}
+
+void EditQueue::add(QueuedEdit edit) {
+  m_edits.push_back(std::move(edit));
+  sendReadyEdits();
+}
+
+void EditQueue::sendReadyEdits() {
+  while (!m_edits.empty() && (m_wiki.delayBeforeEdit() == 0 || (m_maxSize > 0 && size() > m_maxSize))) {
+    sendFirstEdit();
+  }
+}
+
+void EditQueue::flush() {
+  while (!m_edits.empty()) {
+    sendFirstEdit();
+  }
+}
+
+void EditQueue::sendFirstEdit() {
+  // The edit is removed before sending it, so that it is not sent again if an exception is propagated.
+  QueuedEdit edit = std::move(m_edits.front());
+  m_edits.pop_front();
+  try {
+    m_wiki.writePage(edit.title, edit.content, edit.writeToken, edit.summary, edit.flags);
+  } catch (const WikiError& error) {
+    if (edit.onDone) {
+      edit.onDone(edit, &error);
+    } else {
+      CBL_ERROR << "Cannot write page '" << edit.title << "': " << error.what();
+    }
+    return;
+  }
+  if (edit.onDone) {
+    edit.onDone(edit, nullptr);
+  }
+}
+
+}  // namespace mwc
@@ -0,0 +1,81 @@
+// Queue of edits that are sent at the rate allowed by the delay between edits, so that a bot can keep reading and
+// preparing the next pages instead of sleeping before each edit.
+// Wiki is not thread-safe, so edits are not sent from a background thread. Instead, add() and sendReadyEdits() send the
+// queued edits that do not require waiting, and flush() sends the remaining ones, waiting as needed. A bot that calls
+// add() for each page it processes and flush() at the end thus spends most of the delay between edits reading pages.
+// Example:
+//   EditQueue editQueue(wiki);
+//   editQueue.setMaxSize(1);
+//   for (const string& title : titles) {
+//     WriteToken writeToken;
+//     string content = wiki.readPageContent(title, &writeToken);
+//     editQueue.add({.title = title, .content = transform(content), .writeToken = writeToken, .summary = "..."});
+//   }
+//   editQueue.flush();
+// Reading a page that has a queued edit returns its content before the edit. Queuing two edits of the same page with
+// tokens from the same revision causes an edit conflict for the second one.
+#ifndef MWC_EDIT_QUEUE_H
+#define MWC_EDIT_QUEUE_H
+
+#include <deque>
+#include <functional>
+#include <string>
+#include "wiki.h"
+#include "wiki_defs.h"
+
+namespace mwc {
+
+struct QueuedEdit;
+
+// Called after sending an edit. `error` is null if the edit succeeded. Otherwise, it is the WikiError thrown by
+// writePage (e.g. EditConflictError or BotExclusionError).
+using QueuedEditCallback = std::function<void(const QueuedEdit& edit, const WikiError* error)>;
+
+// Parameters of Wiki::writePage.
+struct QueuedEdit {
+  std::string title;
+  std::string content;
+  WriteToken writeToken;
+  std::string summary;
+  int flags = 0;  // From EditPageFlags.
+  // If not set, errors are logged.
+  QueuedEditCallback onDone;
+};
+
+class EditQueue {
+public:
+  explicit EditQueue(Wiki& wiki);
+  EditQueue(const EditQueue&) = delete;
+  // Edits still in the queue are discarded with an error message. Call flush() before to send them.
+  ~EditQueue();
+  EditQueue& operator=(const EditQueue&) = delete;
+
+  // Adds an edit at the end of the queue, then calls sendReadyEdits().
+  // Throws: exceptions other than WikiError thrown by writePage or by callbacks.
+  void add(QueuedEdit edit);
+  // Sends edits from the front of the queue as long as no wait is needed before the next one. If the queue still has
+  // more than maxSize() edits, sends edits, waiting as needed, until it has maxSize() edits.
+  // Throws: same as add().
+  void sendReadyEdits();
+  // Sends all edits, waiting between them as needed.
+  // Throws: same as add().
+  void flush();
+  int size() const { return m_edits.size(); }
+  // Maximum number of edits kept in the queue by sendReadyEdits(). 0 means no limit (this is the default).
+  // The write token of a queued edit gets older while the next pages are read, which makes edit conflicts more likely.
+  // Reading more than about one page ahead does not make edits faster since their rate is limited anyway.
+  int maxSize() const { return m_maxSize; }
+  void setMaxSize(int maxSize) { m_maxSize = maxSize; }
+  bool empty() const { return m_edits.empty(); }
+
+private:
+  void sendFirstEdit();
+
+  Wiki& m_wiki;
+  std::deque<QueuedEdit> m_edits;
+  int m_maxSize = 0;
+};
+
+}  // namespace mwc
+
+#endif
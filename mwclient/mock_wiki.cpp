@@ -174,6 +174,8 @@ void MockWiki::readRevisions(int properties, vector<Revision>& revisions) {
   }
 }
 
+void MockWiki::prefetchPages(const vector<string>& titles, int properties) {}
+
 vector<Revision> MockWiki::getHistory(const HistoryParams& params) {
   CBL_ASSERT(params.startId == 0 || params.direction == NEWEST_FIRST);
   CBL_ASSERT(params.endId == 0);
@@ -291,6 +293,39 @@ vector<string> MockWiki::getAllPages(const AllPagesParams& params) {
   return pages;
 }
 
+void MockWiki::enumTransclusions(const TransclusionsParams& params, const EnumCallback<string>& callback,
+                                 int enumFlags) {
+  callback(getTransclusions(params.title));
+}
+
+void MockWiki::enumAllPages(const AllPagesParams& params, const EnumCallback<string>& callback, int enumFlags) {
+  callback(getAllPages(params));
+}
+
+void MockWiki::readPagesFromGenerator(const GeneratorParams& params, int properties,
+                                      const EnumCallback<Revision>& callback, int enumFlags) {
+  vector<string> titles;
+  switch (params.type) {
+    case GEN_TRANSCLUSIONS:
+      titles = getTransclusions(params.title);
+      break;
+    case GEN_ALL_PAGES:
+      titles = getAllPages(
+          {.prefix = params.prefix, .filterRedir = params.filterRedir, .namespace_ = params.namespace_});
+      break;
+    default:
+      CBL_FATAL << "Generator " << params.type << " not supported by MockWiki";
+  }
+  vector<Revision> revisions(titles.size());
+  for (size_t i = 0; i < titles.size(); i++) {
+    revisions[i].title = titles[i];
+  }
+  readPages(properties | RP_TITLE, revisions);
+  if (!revisions.empty()) {
+    callback(revisions);
+  }
+}
+
 void MockWiki::writePageInternal(string_view title, string_view content, const WriteToken& writeToken,
                                  string_view summary, int flags) {
   Page& page = getMutablePage(title);
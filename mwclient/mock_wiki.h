@@ -25,12 +25,22 @@ public:
   void readPages(int properties, std::vector<Revision>& revisions, int flags = 0) override;
   Revision readRevision(revid_t revid, int properties) override;
   void readRevisions(int properties, std::vector<Revision>& revisions) override;
+  // Does nothing, since reading pages does not send any request.
+  void prefetchPages(const std::vector<std::string>& titles, int properties) override;
 
   std::vector<Revision> getHistory(const HistoryParams& params) override;
   std::unordered_map<std::string, std::vector<PageProtection>> getPagesProtections(
       const std::vector<std::string>& titles) override;
   std::vector<std::string> getTransclusions(const std::string& title) override;
   std::vector<std::string> getAllPages(const AllPagesParams& params) override;
+  // Pass all results in a single batch. enumTransclusions ignores params.namespaceList, like getTransclusions.
+  void enumTransclusions(const TransclusionsParams& params, const EnumCallback<std::string>& callback,
+                         int enumFlags = 0) override;
+  void enumAllPages(const AllPagesParams& params, const EnumCallback<std::string>& callback,
+                    int enumFlags = 0) override;
+  // Supports GEN_TRANSCLUSIONS and GEN_ALL_PAGES, with the same limitations as getTransclusions and getAllPages.
+  void readPagesFromGenerator(const GeneratorParams& params, int properties, const EnumCallback<Revision>& callback,
+                              int enumFlags = 0) override;
 
   void setPageProtection(const std::string& title, const std::vector<PageProtection>& protections,
                          const std::string& reason = std::string()) override;
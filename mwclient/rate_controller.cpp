@@ -0,0 +1,96 @@
+#include "rate_controller.h"
+#include <algorithm>
+#include <cstdint>
+#include "cbl/date.h"
+#include "cbl/log.h"
+#include "cbl/random.h"
+
+using cbl::Date;
+
+namespace mwc {
+
+// Weight of the last request in averageLatency().
+static constexpr double LATENCY_SMOOTHING = 0.2;
+
+void RateController::setInterval(Budget budget, int seconds) {
+  CBL_ASSERT(seconds >= 0) << seconds;
+  m_buckets[budget].interval = seconds;
+}
+
+void RateController::setBurst(Budget budget, int burst) {
+  CBL_ASSERT(burst >= 1) << burst;
+  m_buckets[budget].burst = burst;
+}
+
+int RateController::effectiveInterval(Budget budget) const {
+  return m_buckets[budget].interval + (budget == REQUEST_BUDGET ? m_lagPenalty : 0);
+}
+
+int RateController::reserve(Budget budget) {
+  return takeToken(budget, /* evenIfWaitNeeded = */ true);
+}
+
+bool RateController::tryReserve(Budget budget) {
+  return takeToken(budget, /* evenIfWaitNeeded = */ false) == 0;
+}
+
+int RateController::delayBeforeReserve(Budget budget) const {
+  const Bucket& bucket = m_buckets[budget];
+  const int64_t now = Date::now().toTimeT();
+  int64_t fullTime = bucket.fullTime;
+  if (now < bucket.lastReserveTime) {
+    fullTime -= bucket.lastReserveTime - now;
+  }
+  return std::max<int64_t>(fullTime - (bucket.burst - 1) * effectiveInterval(budget) - now, 0);
+}
+
+int RateController::takeToken(Budget budget, bool evenIfWaitNeeded) {
+  Bucket& bucket = m_buckets[budget];
+  const int64_t interval = effectiveInterval(budget);
+  const int64_t now = Date::now().toTimeT();
+  // Do not assume that the clock always moves forward.
+  if (now < bucket.lastReserveTime) {
+    bucket.fullTime -= bucket.lastReserveTime - now;
+  }
+  bucket.lastReserveTime = now;
+  int64_t sendTime = std::max(now, bucket.fullTime - (bucket.burst - 1) * interval);
+  if (sendTime == now || evenIfWaitNeeded) {
+    bucket.fullTime = std::max(bucket.fullTime, now) + interval;
+  }
+  return sendTime - now;
+}
+
+void RateController::drain(Budget budget) {
+  Bucket& bucket = m_buckets[budget];
+  bucket.lastReserveTime = Date::now().toTimeT();
+  bucket.fullTime = bucket.lastReserveTime + bucket.burst * effectiveInterval(budget);
+}
+
+void RateController::recordSuccess(const Date& start) {
+  double latency = std::max<int64_t>((Date::now() - start).seconds(), 0);
+  if (m_latencyInitialized) {
+    m_averageLatency += LATENCY_SMOOTHING * (latency - m_averageLatency);
+  } else {
+    m_averageLatency = latency;
+    m_latencyInitialized = true;
+  }
+  if (m_lagPenalty > 0) {
+    m_lagPenalty--;
+  }
+}
+
+void RateController::recordServerLag() {
+  m_lagPenalty = std::clamp(m_lagPenalty * 2, 1, MAX_LAG_PENALTY);
+}
+
+int RateController::retryDelay(int retryIndex, int serverDelay) const {
+  int delay = MAX_RETRY_DELAY;
+  if (retryIndex >= 0 && retryIndex < 16) {
+    delay = std::min(BASE_RETRY_DELAY << retryIndex, MAX_RETRY_DELAY);
+  }
+  // Jitter prevents clients that failed at the same time from retrying at the same time.
+  delay = delay / 2 + cbl::randomInt(delay / 2 + 1);
+  return std::max(delay, serverDelay);
+}
+
+}  // namespace mwc
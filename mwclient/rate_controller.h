@@ -0,0 +1,89 @@
+// Scheduling of the requests sent by WikiBase to the API.
+// Each budget is a token bucket: a request can be sent immediately if a token is available, otherwise the caller waits
+// until the next token is generated. Waiting times are computed from the time at which the previous request was sent,
+// so if the interval is 5 seconds and the previous request took 3 seconds, the next request only waits 2 seconds.
+// When a request fails, the delay before retrying grows exponentially with some random jitter, and is never shorter than
+// what the server asked for (Retry-After). Replication lag reported by maxlag errors also slows down later requests
+// until the server recovers.
+// All times are read from cbl::Date::now(), so that tests can use Date::setFrozenValueOfNow.
+#ifndef MWC_RATE_CONTROLLER_H
+#define MWC_RATE_CONTROLLER_H
+
+#include <cstdint>
+#include "cbl/date.h"
+
+namespace mwc {
+
+class RateController {
+public:
+  enum Budget {
+    // All API requests, including edits. The interval is LoginParams::delayBeforeRequests.
+    REQUEST_BUDGET,
+    // Edits and other mutating requests. The interval is LoginParams::delayBetweenEdits.
+    EDIT_BUDGET,
+    BUDGET_COUNT,
+  };
+
+  // Average number of seconds between two requests using `budget`. 0 disables the limit.
+  int interval(Budget budget) const { return m_buckets[budget].interval; }
+  void setInterval(Budget budget, int seconds);
+  // Number of requests that can be sent without waiting after an idle period. The default is 1, i.e. two consecutive
+  // requests are always separated by the interval.
+  int burst(Budget budget) const { return m_buckets[budget].burst; }
+  void setBurst(Budget budget, int burst);
+
+  // Takes a token from `budget` and returns the number of seconds to wait before sending the request. The token is
+  // taken immediately, so the caller must actually wait before sending the request.
+  int reserve(Budget budget);
+  // Takes a token from `budget` and returns true if a request can be sent immediately. Otherwise, returns false and
+  // leaves the budget unchanged.
+  bool tryReserve(Budget budget);
+  // Returns the number of seconds that reserve() would return now, without taking a token.
+  int delayBeforeReserve(Budget budget) const;
+  // Takes all tokens from `budget`, as if requests had just been sent. The next request will wait the full interval.
+  void drain(Budget budget);
+
+  // Records a request that was sent at `start` and succeeded just now.
+  void recordSuccess(const cbl::Date& start);
+  // Records that the server rejected a request because its replication lag exceeded maxlag. Until enough requests
+  // succeed, an additional delay is applied to REQUEST_BUDGET. It is doubled for each lag error.
+  void recordServerLag();
+  // Returns the number of seconds to wait before retrying a request that failed `retryIndex` times before (0 for the
+  // first retry). The result is randomly chosen in [d / 2, d], where d = BASE_RETRY_DELAY * 2^retryIndex (capped at
+  // MAX_RETRY_DELAY). If the server indicated when to retry, the result is at least `serverDelay`.
+  int retryDelay(int retryIndex, int serverDelay = 0) const;
+
+  // Exponential moving average of the duration of successful requests, in seconds.
+  double averageLatency() const { return m_averageLatency; }
+  // Additional interval currently applied to REQUEST_BUDGET because of replication lag.
+  int lagPenalty() const { return m_lagPenalty; }
+
+  static constexpr int BASE_RETRY_DELAY = 30;
+  static constexpr int MAX_RETRY_DELAY = 600;
+  static constexpr int MAX_LAG_PENALTY = 60;
+
+private:
+  struct Bucket {
+    int interval = 0;
+    int burst = 1;
+    // Time at which the bucket will be full again if no other request is sent. Tokens are generated at a rate of one
+    // per interval and the bucket holds up to `burst` tokens, so a request can be sent immediately if this is not later
+    // than now + (burst - 1) * interval.
+    int64_t fullTime = 0;
+    int64_t lastReserveTime = 0;
+  };
+
+  int effectiveInterval(Budget budget) const;
+  // Returns the number of seconds to wait before sending a request. The token is taken if this is 0 or if
+  // evenIfWaitNeeded is true.
+  int takeToken(Budget budget, bool evenIfWaitNeeded);
+
+  Bucket m_buckets[BUDGET_COUNT];
+  double m_averageLatency = 0;
+  bool m_latencyInitialized = false;
+  int m_lagPenalty = 0;
+};
+
+}  // namespace mwc
+
+#endif
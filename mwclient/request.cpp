@@ -1,6 +1,7 @@
 #include "request.h"
 #include <algorithm>
 #include <functional>
+#include <iterator>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -10,6 +11,7 @@
 #include "cbl/json.h"
 #include "cbl/log.h"
 #include "cbl/string.h"
+#include "request_memo.h"
 #include "wiki_base.h"
 #include "wiki_defs.h"
 
@@ -127,8 +129,65 @@ string WikiRequest::getRequestString() const {
   return request;
 }
 
+// Actions whose effects are limited to the pages passed in the "title" or "titles" parameter, from the point of view of
+// RequestMemo.
+static const char* const TITLE_SCOPED_WRITE_ACTIONS[] = {"edit", "delete", "undelete", "protect", "purge", "rollback"};
+
+bool WikiRequest::isMemoizable() const {
+  if (m_method != METHOD_GET && m_method != METHOD_POST_NO_SIDE_EFFECT) {
+    return false;
+  }
+  const string& action = getParam("action");
+  // Tokens must be requested again each time they are needed.
+  return action == "parse" || (action == "query" && getParam("meta").find("tokens") == string::npos);
+}
+
+vector<string> WikiRequest::getTitlesForMemo() const {
+  vector<string> titles;
+  if (m_method == METHOD_GET || m_method == METHOD_POST_NO_SIDE_EFFECT) {
+    for (const char* param : {"list", "generator", "redirects", "pageids", "revids"}) {
+      if (m_fields.count(param) != 0) {
+        return titles;
+      }
+    }
+  } else if (std::find(std::begin(TITLE_SCOPED_WRITE_ACTIONS), std::end(TITLE_SCOPED_WRITE_ACTIONS),
+                       getParam("action")) == std::end(TITLE_SCOPED_WRITE_ACTIONS)) {
+    return titles;
+  }
+  for (const char* param : {"title", "titles", "page"}) {
+    auto fieldIt = m_fields.find(param);
+    if (fieldIt != m_fields.end()) {
+      for (string_view title : cbl::split(fieldIt->second, '|')) {
+        titles.emplace_back(title);
+      }
+    }
+  }
+  return titles;
+}
+
+const string& WikiRequest::getParam(const string& param) const {
+  static const string emptyString;
+  auto fieldIt = m_fields.find(param);
+  return fieldIt != m_fields.end() ? fieldIt->second : emptyString;
+}
+
 json::Value WikiRequest::run(WikiBase& wiki) {
   string request = getRequestString();
+  RequestMemo* memo = wiki.requestMemo();
+  if (memo != nullptr && isMemoizable()) {
+    json::Value answer;
+    if (!memo->get(request, answer)) {
+      answer = runUncached(wiki, request);
+      memo->put(request, getTitlesForMemo(), answer);
+    }
+    return answer;
+  } else if (m_method != METHOD_GET && m_method != METHOD_POST_NO_SIDE_EFFECT) {
+    wiki.invalidateCachedPages(getTitlesForMemo());
+  }
+  return runUncached(wiki, request);
+}
+
+json::Value WikiRequest::runUncached(WikiBase& wiki, const string& request) {
   switch (m_method) {
     case METHOD_GET:
       return wiki.apiGetRequest(request);
@@ -212,7 +271,11 @@ void WikiPager::runPager(WikiBase& wiki, const std::function<int(const json::Val
       throw InvalidParameterError("Failed to pass the continue parameter as JSON: '" + m_queryContinue + "'");
     }
   }
-  int apiLimit = wiki.apiLimit();
+  int apiLimit = m_batchSize > 0 ? m_batchSize : wiki.apiLimit();
+  // The request string does not change between iterations if there is no limit, so the next request can be sent before
+  // processing the current answer.
+  const bool pipelined = m_pipelined && m_limit == PAGER_ALL && method() == METHOD_GET;
+  AsyncAPIRequest nextRequest;
   unordered_set<string> m_previousRequests;
   for (int leftToRead = m_limit; leftToRead != 0;) {
     if (m_limitParam != NO_LIMIT_PARAM) {
@@ -224,24 +287,36 @@ void WikiPager::runPager(WikiBase& wiki, const std::function<int(const json::Val
     }
     m_previousRequests.insert(request);
     // LOG(INFO, "Pager request: " << request);
-    json::Value answer = run(wiki);
+    json::Value answer = nextRequest.request == request ? wiki.waitForAsyncAPIRequest(nextRequest) : run(wiki);
     // LOG(INFO, "Answer: " + answer.toJSON());
-    int numItemsRead = callback(answer);
-    if (leftToRead != PAGER_ALL) {
-      leftToRead = std::max(leftToRead - numItemsRead, 0);
-    }
-    if (!answer.has("continue")) {
+    if (answer.has("continue")) {
+      m_queryContinue = answer["continue"].toJSON();
+      setContinue(answer["continue"]);
+      if (pipelined) {
+        nextRequest = wiki.startAsyncAPIGetRequest(getRequestString());
+      }
+    } else {
       m_queryContinue.clear();
+    }
+    int numItemsRead = callback(answer);
+    if (numItemsRead == PAGER_STOP) {
       break;
+    } else if (m_queryContinue.empty()) {
+      break;
+    } else if (leftToRead != PAGER_ALL) {
+      leftToRead = std::max(leftToRead - numItemsRead, 0);
     }
-    m_queryContinue = answer["continue"].toJSON();
-    setContinue(answer["continue"]);
   }
 }
 
 void WikiPager::setContinue(const json::Value& value) {
+  for (const string& continueName : m_continueParams) {
+    clearParam(continueName);
+  }
+  m_continueParams.clear();
   for (const auto& [continueName, continueValue] : value) {
     setParam(continueName, continueValue.str());
+    m_continueParams.push_back(continueName);
   }
 }
 
@@ -45,6 +45,7 @@ public:
   };
   explicit WikiRequest(std::string_view action);
   virtual ~WikiRequest() {}
+  Method method() const { return m_method; }
   void setMethod(Method method);
   void setParam(std::string_view param, std::string_view value);
   void setParam(std::string_view param, int value);
@@ -68,12 +69,20 @@ public:
   // Returns all parameters encoded as a query string. This is normally called by run(), but also exposed for debugging
   // purposes.
   std::string getRequestString() const;
-  // Runs the request and returns its result.
+  // Runs the request and returns its result. If the request memo of `wiki` is enabled, read-only requests may be served
+  // from it. Other requests invalidate data cached by `wiki` about the pages that they change.
   // Throws: APIError, LowLevelError.
   json::Value run(WikiBase& wiki);
 
 private:
   static std::string convertFlagsToString(int flags, const FlagDef* begin, const FlagDef* end, const char* extraFlags);
+  // Returns the value of `param`, or an empty string if it is not set.
+  const std::string& getParam(const std::string& param) const;
+  bool isMemoizable() const;
+  // Pages whose content is read (for read-only requests) or changed (for other requests), or an empty vector if the
+  // request may depend on or change other pages.
+  std::vector<std::string> getTitlesForMemo() const;
+  json::Value runUncached(WikiBase& wiki, const std::string& request);
 
   std::map<std::string, std::string> m_fields;
   Method m_method = METHOD_GET;
@@ -91,6 +100,8 @@ private:
 };
 
 constexpr char NO_LIMIT_PARAM[] = "";
+// Value that the callback of WikiPager::runPager can return to stop the enumeration.
+constexpr int PAGER_STOP = -1;
 
 // Subclass for requests that may need to be repeated until all results are read.
 // Should not be used directly. Use WikiPropPager or WikiListPager instead.
@@ -102,14 +113,29 @@ public:
   // Opaque string to get the next results of the same request, in case a finite limit was set.
   const std::string& queryContinue() const;
   void setQueryContinue(const std::string& value);
+  // Maximum number of results per request. 0 means wiki.apiLimit(), which is the default.
+  void setBatchSize(int batchSize) { m_batchSize = batchSize; }
+  // If enabled, the next batch is requested in the background while the callback of runPager processes the current
+  // one. This only applies to GET requests without a limit. If the enumeration is stopped early, the last background
+  // request is wasted.
+  void setPipelined(bool pipelined) { m_pipelined = pipelined; }
+  // Sends requests until all results are read and calls `callback` on each answer. The callback returns the number of
+  // results in the answer, or PAGER_STOP to stop the enumeration. In that case, queryContinue() can be used to resume
+  // it.
   void runPager(WikiBase& wiki, const std::function<int(const json::Value& answer)>& callback);
 
 private:
+  // Replaces the parameters set by the previous call with those in `value`. Continuation values always apply to the
+  // original request. For instance, when a generator moves to the next batch, the continuation of the revisions of the
+  // previous batch must be dropped.
   void setContinue(const json::Value& value);
 
   std::string m_limitParam;
   int m_limit = PAGER_ALL;
+  int m_batchSize = 0;
   std::string m_queryContinue;
+  std::vector<std::string> m_continueParams;
+  bool m_pipelined = false;
 };
 
 // Subclass for requests of the form action=query&prop=...
@@ -126,23 +152,39 @@ public:
   template <class T, class Callback>
   std::vector<T> runListPager(WikiBase& wiki, Callback callback) {
     std::vector<T> results;
+    runPager(wiki, [&](const json::Value& answer) { return appendResults(answer, callback, results); });
+    return results;
+  }
+
+  // Variant of runListPager that passes the results of each request to `batchCallback` instead of accumulating them.
+  // If batchCallback returns false, the enumeration stops.
+  template <class T, class Callback>
+  void runListPagerByBatch(WikiBase& wiki, Callback callback,
+                           const std::function<bool(const std::vector<T>& batch)>& batchCallback) {
+    std::vector<T> batch;
     runPager(wiki, [&](const json::Value& answer) {
-      const json::Value& resultsNode = answer["query"][m_list];
-      if (!resultsNode.isArray()) {
-        throw UnexpectedAPIResponseError("Unexpected API response: 'query." + m_list + "' is not an array");
-      }
-      int oldSize = results.size();
-      int numResults = resultsNode.array().size();
-      results.resize(oldSize + numResults);
-      for (int i = 0; i < numResults; i++) {
-        callback(resultsNode[i], results[oldSize + i]);
-      }
-      return numResults;
+      batch.clear();
+      int numResults = appendResults(answer, callback, batch);
+      return batchCallback(batch) ? numResults : PAGER_STOP;
     });
-    return results;
   }
 
 private:
+  template <class T, class Callback>
+  int appendResults(const json::Value& answer, Callback& callback, std::vector<T>& results) {
+    const json::Value& resultsNode = answer["query"][m_list];
+    if (!resultsNode.isArray()) {
+      throw UnexpectedAPIResponseError("Unexpected API response: 'query." + m_list + "' is not an array");
+    }
+    int oldSize = results.size();
+    int numResults = resultsNode.array().size();
+    results.resize(oldSize + numResults);
+    for (int i = 0; i < numResults; i++) {
+      callback(resultsNode[i], results[oldSize + i]);
+    }
+    return numResults;
+  }
+
   std::string m_list;
 };
 
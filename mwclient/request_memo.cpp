@@ -0,0 +1,91 @@
+#include "request_memo.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cbl/date.h"
+#include "cbl/json.h"
+#include "cbl/string.h"
+#include "cbl/unicode_fr.h"
+
+using cbl::Date;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace mwc {
+
+string getLooseTitleKey(string_view title) {
+  // Aliases of namespaces cannot be resolved here, so the namespace is dropped.
+  size_t colonPosition = title.find(':');
+  if (colonPosition != string_view::npos) {
+    title.remove_prefix(colonPosition + 1);
+  }
+  string key = unicode_fr::toLowerCase(title);
+  std::replace(key.begin(), key.end(), '_', ' ');
+  return cbl::trimAndCollapseSpace(key);
+}
+
+RequestMemo::RequestMemo(cbl::DateDiff lifetime, int maxEntries) : m_lifetime(lifetime), m_maxEntries(maxEntries) {}
+
+bool RequestMemo::get(const string& request, json::Value& answer) {
+  auto entryIt = m_entries.find(request);
+  if (entryIt == m_entries.end() || entryIt->second.expiration <= Date::now()) {
+    m_misses++;
+    return false;
+  }
+  m_hits++;
+  answer = entryIt->second.answer.copy();
+  return true;
+}
+
+void RequestMemo::put(const string& request, const vector<string>& titles, const json::Value& answer) {
+  if (static_cast<int>(m_entries.size()) >= m_maxEntries) {
+    removeExpiredEntries();
+    if (static_cast<int>(m_entries.size()) >= m_maxEntries) {
+      m_entries.clear();
+    }
+  }
+  Entry& entry = m_entries[request];
+  entry.answer = answer.copy();
+  entry.expiration = Date::now() + m_lifetime;
+  entry.titleKeys.clear();
+  for (const string& title : titles) {
+    entry.titleKeys.push_back(getLooseTitleKey(title));
+  }
+}
+
+void RequestMemo::invalidate(const vector<string>& titles) {
+  if (titles.empty()) {
+    m_invalidations += m_entries.size();
+    m_entries.clear();
+    return;
+  }
+  vector<string> titleKeys;
+  for (const string& title : titles) {
+    titleKeys.push_back(getLooseTitleKey(title));
+  }
+  for (auto entryIt = m_entries.begin(); entryIt != m_entries.end();) {
+    const vector<string>& entryTitleKeys = entryIt->second.titleKeys;
+    bool affected = entryTitleKeys.empty() || std::any_of(titleKeys.begin(), titleKeys.end(), [&](const string& key) {
+                      return std::find(entryTitleKeys.begin(), entryTitleKeys.end(), key) != entryTitleKeys.end();
+                    });
+    if (affected) {
+      entryIt = m_entries.erase(entryIt);
+      m_invalidations++;
+    } else {
+      ++entryIt;
+    }
+  }
+}
+
+void RequestMemo::clear() {
+  m_entries.clear();
+}
+
+void RequestMemo::removeExpiredEntries() {
+  Date now = Date::now();
+  std::erase_if(m_entries, [&](const auto& entry) { return entry.second.expiration <= now; });
+}
+
+}  // namespace mwc
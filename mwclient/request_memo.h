@@ -0,0 +1,68 @@
+// Short-lived memoization of read-only API requests, enabled with WikiBase::enableRequestMemo().
+// Entries are keyed on WikiRequest::getRequestString(), so two requests hit the same entry only if all their parameters
+// are equal (including continuation parameters for pagers).
+// Each entry is invalidated after a fixed lifetime, since other users may change the wiki, and when this client writes
+// to a page that may affect it:
+// - Entries of requests on explicit pages (e.g. action=query&prop=revisions&titles=A|B) are invalidated by writes to
+//   these pages. Titles are compared loosely (case, namespace prefix and underscores are ignored), so some writes may
+//   invalidate more entries than necessary.
+// - Other entries (lists, generators, requests by page id, requests following redirects) are invalidated by all writes.
+// Changes that do not come from a write to the page itself (e.g. categories added by a template) are only taken into
+// account when the entry expires.
+#ifndef MWC_REQUEST_MEMO_H
+#define MWC_REQUEST_MEMO_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "cbl/date.h"
+#include "cbl/json.h"
+
+namespace mwc {
+
+// Key used to compare titles when invalidating cached data. Different variants of a title (case, namespace alias,
+// underscores) have the same key, but some unrelated titles may also have the same key.
+std::string getLooseTitleKey(std::string_view title);
+
+class RequestMemo {
+public:
+  explicit RequestMemo(cbl::DateDiff lifetime, int maxEntries = 1000);
+
+  // If there is a non-expired entry for `request`, sets `answer` to a copy of it and returns true.
+  bool get(const std::string& request, json::Value& answer);
+  // Stores a copy of `answer`. `titles` are the pages on which the answer depends, or an empty vector if they are not
+  // known.
+  void put(const std::string& request, const std::vector<std::string>& titles, const json::Value& answer);
+  // Removes entries that may be affected by a write to `titles`. If `titles` is empty, removes all entries.
+  void invalidate(const std::vector<std::string>& titles);
+  void clear();
+
+  int size() const { return m_entries.size(); }
+  int64_t hits() const { return m_hits; }
+  int64_t misses() const { return m_misses; }
+  // Number of entries removed by invalidate().
+  int64_t invalidations() const { return m_invalidations; }
+
+private:
+  struct Entry {
+    json::Value answer;
+    cbl::Date expiration;
+    // Empty if the pages are not known.
+    std::vector<std::string> titleKeys;
+  };
+
+  void removeExpiredEntries();
+
+  cbl::DateDiff m_lifetime;
+  int m_maxEntries;
+  std::unordered_map<std::string, Entry> m_entries;
+  int64_t m_hits = 0;
+  int64_t m_misses = 0;
+  int64_t m_invalidations = 0;
+};
+
+}  // namespace mwc
+
+#endif
@@ -0,0 +1,148 @@
+#include "request_metrics.h"
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include "cbl/file.h"
+#include "cbl/json.h"
+#include "cbl/string.h"
+
+using std::string;
+using std::string_view;
+
+namespace mwc {
+
+string getAPIModuleOfRequest(string_view request, string_view data) {
+  std::map<string_view, string> params;
+  for (string_view paramsString : {request, data}) {
+    for (string_view param : cbl::split(paramsString, '&')) {
+      size_t equalPosition = param.find('=');
+      if (equalPosition == string_view::npos) continue;
+      string_view name = param.substr(0, equalPosition);
+      if (name == "action" || name == "generator" || name == "list" || name == "meta" || name == "prop") {
+        params[name] = cbl::decodeURIComponent(param.substr(equalPosition + 1));
+      }
+    }
+  }
+  string module = params["action"];
+  for (string_view name : {"generator", "list", "meta", "prop"}) {
+    for (string_view subModule : cbl::split(params[name], '|')) {
+      if (!subModule.empty()) {
+        module += '+';
+        module += subModule;
+      }
+    }
+  }
+  return module;
+}
+
+void RequestMetrics::recordAttempt(const string& module, double latency, int64_t responseBytes, double parseTime) {
+  ModuleMetrics& metrics = m_modules[module];
+  metrics.requests++;
+  metrics.responseBytes += responseBytes;
+  metrics.totalLatency += latency;
+  metrics.totalParseTime += parseTime;
+  int bucket = 0;
+  while (bucket < NUM_LATENCY_BUCKETS - 1 && latency > LATENCY_BUCKETS[bucket]) {
+    bucket++;
+  }
+  metrics.latencyHistogram[bucket]++;
+}
+
+void RequestMetrics::recordRetry(const string& module) {
+  m_modules[module].retries++;
+}
+
+void RequestMetrics::recordMaxLagError(const string& module) {
+  m_modules[module].maxLagErrors++;
+}
+
+static string formatBucketBound(int bucket) {
+  if (bucket == RequestMetrics::NUM_LATENCY_BUCKETS - 1) {
+    return "+Inf";
+  }
+  std::ostringstream oss;
+  oss << RequestMetrics::LATENCY_BUCKETS[bucket];
+  return oss.str();
+}
+
+json::Value RequestMetrics::toJSON() const {
+  json::Value value;
+  value.setToEmptyObject();
+  for (const auto& [module, metrics] : m_modules) {
+    json::Value& moduleValue = value.getMutable(module);
+    moduleValue.getMutable("requests") = metrics.requests;
+    moduleValue.getMutable("retries") = metrics.retries;
+    moduleValue.getMutable("maxLagErrors") = metrics.maxLagErrors;
+    moduleValue.getMutable("responseBytes") = metrics.responseBytes;
+    // JSON values in this library are integers, so durations are rounded to milliseconds.
+    moduleValue.getMutable("totalLatencyMs") = static_cast<int64_t>(metrics.totalLatency * 1000 + 0.5);
+    moduleValue.getMutable("totalParseTimeMs") = static_cast<int64_t>(metrics.totalParseTime * 1000 + 0.5);
+    json::Value& histogram = moduleValue.getMutable("latencyHistogram");
+    for (int bucket = 0; bucket < NUM_LATENCY_BUCKETS; bucket++) {
+      histogram.getMutable(formatBucketBound(bucket)) = metrics.latencyHistogram[bucket];
+    }
+  }
+  return value;
+}
+
+static string escapeLabelValue(string_view value) {
+  string escapedValue;
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escapedValue += '\\';
+      escapedValue += c;
+    } else if (c == '\n') {
+      escapedValue += "\\n";
+    } else {
+      escapedValue += c;
+    }
+  }
+  return escapedValue;
+}
+
+string RequestMetrics::toPrometheusText() const {
+  std::ostringstream oss;
+  auto writeCounter = [&](const char* name, const char* help, auto getValue) {
+    oss << "# HELP " << name << " " << help << "\n# TYPE " << name << " counter\n";
+    for (const auto& [module, metrics] : m_modules) {
+      oss << name << "{module=\"" << escapeLabelValue(module) << "\"} " << getValue(metrics) << "\n";
+    }
+  };
+  writeCounter("mwclient_requests_total", "API requests sent, including retries.",
+               [](const ModuleMetrics& metrics) { return metrics.requests; });
+  writeCounter("mwclient_request_retries_total", "API requests retried after a transient error.",
+               [](const ModuleMetrics& metrics) { return metrics.retries; });
+  writeCounter("mwclient_maxlag_errors_total", "API requests rejected because of replication lag.",
+               [](const ModuleMetrics& metrics) { return metrics.maxLagErrors; });
+  writeCounter("mwclient_response_bytes_total", "Bytes received in API responses.",
+               [](const ModuleMetrics& metrics) { return metrics.responseBytes; });
+  writeCounter("mwclient_json_parse_seconds_total", "Time spent parsing API responses.",
+               [](const ModuleMetrics& metrics) { return metrics.totalParseTime; });
+
+  const char* histogramName = "mwclient_request_duration_seconds";
+  oss << "# HELP " << histogramName << " Duration of API requests.\n# TYPE " << histogramName << " histogram\n";
+  for (const auto& [module, metrics] : m_modules) {
+    string moduleLabel = "module=\"" + escapeLabelValue(module) + "\"";
+    int64_t cumulativeCount = 0;
+    for (int bucket = 0; bucket < NUM_LATENCY_BUCKETS; bucket++) {
+      cumulativeCount += metrics.latencyHistogram[bucket];
+      oss << histogramName << "_bucket{" << moduleLabel << ",le=\"" << formatBucketBound(bucket) << "\"} "
+          << cumulativeCount << "\n";
+    }
+    oss << histogramName << "_sum{" << moduleLabel << "} " << metrics.totalLatency << "\n";
+    oss << histogramName << "_count{" << moduleLabel << "} " << cumulativeCount << "\n";
+  }
+  return oss.str();
+}
+
+void JSONFileMetricsSink::write(const RequestMetrics& metrics) {
+  cbl::writeFileAtomically(m_path, metrics.toJSON().toJSON(json::INDENTED) + "\n");
+}
+
+void PrometheusTextfileMetricsSink::write(const RequestMetrics& metrics) {
+  cbl::writeFileAtomically(m_path, metrics.toPrometheusText());
+}
+
+}  // namespace mwc
@@ -0,0 +1,89 @@
+// Metrics about the requests sent by WikiBase::apiRequest, grouped by API module, to find out what a bot spends its
+// request budget on.
+// Metrics are always collected. To export them, set a sink with WikiBase::setRequestMetricsSink(). The sink is called
+// when the WikiBase object is destroyed, normally at the end of the program, or explicitly with
+// WikiBase::flushRequestMetrics().
+#ifndef MWC_REQUEST_METRICS_H
+#define MWC_REQUEST_METRICS_H
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include "cbl/json.h"
+
+namespace mwc {
+
+// Returns the API module of a request from its parameters, e.g. "edit", "query+revisions" or
+// "query+allpages+categories" for a generator. `request` and `data` are URL-encoded parameters as passed to
+// WikiBase::apiRequest.
+std::string getAPIModuleOfRequest(std::string_view request, std::string_view data);
+
+class RequestMetrics {
+public:
+  // Upper bounds of the latency histogram buckets, in seconds. The last bucket, for longer requests, is implicit.
+  static constexpr double LATENCY_BUCKETS[] = {0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30};
+  static constexpr int NUM_LATENCY_BUCKETS = std::size(LATENCY_BUCKETS) + 1;
+
+  struct ModuleMetrics {
+    // Number of attempts, including retries.
+    int64_t requests = 0;
+    int64_t retries = 0;
+    int64_t maxLagErrors = 0;
+    int64_t responseBytes = 0;
+    // Time between sending the request and receiving the full response, including JSON parsing.
+    double totalLatency = 0;
+    // Time spent parsing JSON. It overlaps with the download since responses are parsed while they are received.
+    double totalParseTime = 0;
+    // Number of attempts in each bucket of LATENCY_BUCKETS.
+    int64_t latencyHistogram[NUM_LATENCY_BUCKETS] = {};
+  };
+
+  // Records one attempt to send a request. Attempts that fail because of network errors are also recorded, with the
+  // bytes received so far.
+  void recordAttempt(const std::string& module, double latency, int64_t responseBytes, double parseTime);
+  void recordRetry(const std::string& module);
+  void recordMaxLagError(const std::string& module);
+  void clear() { m_modules.clear(); }
+
+  const std::map<std::string, ModuleMetrics>& modules() const { return m_modules; }
+  // {"<module>": {"requests": ..., "latencyHistogram": {"0.05": ..., ..., "+Inf": ...}}, ...}
+  json::Value toJSON() const;
+  // Text exposition format of Prometheus, e.g. for the textfile collector of node_exporter. All metrics have a
+  // "module" label. Latencies are exported as a histogram named mwclient_request_duration_seconds.
+  std::string toPrometheusText() const;
+
+private:
+  std::map<std::string, ModuleMetrics> m_modules;
+};
+
+class RequestMetricsSink {
+public:
+  virtual ~RequestMetricsSink() = default;
+  virtual void write(const RequestMetrics& metrics) = 0;
+};
+
+// Writes RequestMetrics::toJSON() to a file (replaced atomically).
+class JSONFileMetricsSink : public RequestMetricsSink {
+public:
+  explicit JSONFileMetricsSink(const std::string& path) : m_path(path) {}
+  void write(const RequestMetrics& metrics) override;
+
+private:
+  std::string m_path;
+};
+
+// Writes RequestMetrics::toPrometheusText() to a file (replaced atomically).
+class PrometheusTextfileMetricsSink : public RequestMetricsSink {
+public:
+  explicit PrometheusTextfileMetricsSink(const std::string& path) : m_path(path) {}
+  void write(const RequestMetrics& metrics) override;
+
+private:
+  std::string m_path;
+};
+
+}  // namespace mwc
+
+#endif
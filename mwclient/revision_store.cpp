@@ -0,0 +1,11 @@
+#include "revision_store.h"
+#include <string>
+
+using std::string;
+
+namespace mwc {
+
+RevisionStore::RevisionStore(const string& path, const RevisionStoreParams& params)
+    : m_store(path, {.maxSize = params.maxSize}) {}
+
+}  // namespace mwc
@@ -0,0 +1,43 @@
+// Persistent storage of the content of revisions, keyed by revid, in a SQLite database.
+// The content of a revision never changes, so it can be kept across runs of a bot. When a store is set with
+// Wiki::setRevisionStore(), Wiki::readRevisions() and Wiki::readRevisionContent() only download the content of
+// revisions that are not in the store yet.
+// Revisions whose content is later hidden by revision deletion may still be returned from the store.
+// The database is a cbl::BlobStore keyed by revid.
+#ifndef MWC_REVISION_STORE_H
+#define MWC_REVISION_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "cbl/blob_store.h"
+#include "wiki_defs.h"
+
+namespace mwc {
+
+struct RevisionStoreParams {
+  // Maximum total size of stored content, after compression. When it is exceeded, the least recently used revisions
+  // are evicted until the size goes down to 90% of the maximum. 0 means no limit.
+  int64_t maxSize = 0;
+};
+
+class RevisionStore {
+public:
+  explicit RevisionStore(const std::string& path, const RevisionStoreParams& params = {});
+
+  // If the store contains `revid`, sets `content` to its content and returns true.
+  bool getContent(revid_t revid, std::string& content) { return m_store.get(std::to_string(revid), content); }
+  // Adds the content of `revid`. If it is already in the store, does nothing.
+  void putContent(revid_t revid, std::string_view content) { m_store.putIfAbsent(std::to_string(revid), content); }
+
+  int64_t numEntries() { return m_store.numEntries(); }
+  // Total size of stored content, after compression.
+  int64_t totalSize() { return m_store.totalSize(); }
+
+private:
+  cbl::BlobStore m_store;
+};
+
+}  // namespace mwc
+
+#endif
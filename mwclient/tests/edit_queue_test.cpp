@@ -0,0 +1,124 @@
+#include "mwclient/edit_queue.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cbl/date.h"
+#include "cbl/log.h"
+#include "cbl/string.h"
+#include "cbl/unittest.h"
+#include "mwclient/mock_wiki.h"
+#include "mwclient/wiki_defs.h"
+
+using cbl::Date;
+using cbl::DateDiff;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace mwc {
+
+// MockWiki that waits between edits like Wiki and detects edit conflicts.
+class ThrottledMockWiki : public MockWiki {
+public:
+  void sleep(int seconds) override {
+    m_totalSleepTime += seconds;
+    Date::advanceFrozenClock(DateDiff::fromSeconds(seconds));
+  }
+  int totalSleepTime() const { return m_totalSleepTime; }
+
+protected:
+  void writePageInternal(string_view title, string_view content, const WriteToken& writeToken, string_view summary,
+                         int flags) override {
+    waitBeforeEdit();
+    if (writeToken.type() == WriteToken::EDIT && readPage(title, RP_REVID).revid != writeToken.revid()) {
+      throw EditConflictError("Edit conflict");
+    }
+    MockWiki::writePageInternal(title, content, writeToken, summary, flags);
+  }
+
+private:
+  int m_totalSleepTime = 0;
+};
+
+class EditQueueTest : public cbl::Test {
+private:
+  void setUp() override { Date::setFrozenValueOfNow(Date::fromISO8601("2020-01-01T00:00:00Z")); }
+
+  QueuedEdit prepareEdit(Wiki& wiki, const string& title, const string& content, vector<string>* log) {
+    QueuedEdit edit;
+    edit.title = title;
+    wiki.readPageContentIfExists(title, &edit.writeToken);
+    edit.content = content;
+    edit.onDone = [log](const QueuedEdit& edit, const WikiError* error) {
+      log->push_back(edit.title + (error != nullptr ? " failed" : " ok"));
+    };
+    return edit;
+  }
+
+  CBL_TEST_CASE(EditsAreSentWhenAllowed) {
+    ThrottledMockWiki wiki;
+    wiki.setDelayBetweenEdits(10);
+    vector<string> log;
+    EditQueue editQueue(wiki);
+    editQueue.add(prepareEdit(wiki, "A", "a", &log));
+    editQueue.add(prepareEdit(wiki, "B", "b", &log));
+    editQueue.add(prepareEdit(wiki, "C", "c", &log));
+    // Only the first edit can be sent immediately.
+    CBL_ASSERT_EQ(cbl::join(log, ","), "A ok");
+    CBL_ASSERT_EQ(editQueue.size(), 2);
+
+    // Time spent reading other pages counts in the delay between edits.
+    Date::advanceFrozenClock(DateDiff::fromSeconds(10));
+    editQueue.sendReadyEdits();
+    CBL_ASSERT_EQ(cbl::join(log, ","), "A ok,B ok");
+    CBL_ASSERT_EQ(wiki.totalSleepTime(), 0);
+
+    editQueue.flush();
+    CBL_ASSERT_EQ(cbl::join(log, ","), "A ok,B ok,C ok");
+    CBL_ASSERT_EQ(wiki.totalSleepTime(), 10);
+    CBL_ASSERT(editQueue.empty());
+    CBL_ASSERT_EQ(wiki.readPageContent("C"), "c");
+  }
+
+  CBL_TEST_CASE(MaxSize) {
+    ThrottledMockWiki wiki;
+    wiki.setDelayBetweenEdits(10);
+    vector<string> log;
+    EditQueue editQueue(wiki);
+    editQueue.setMaxSize(1);
+    editQueue.add(prepareEdit(wiki, "A", "a", &log));
+    editQueue.add(prepareEdit(wiki, "B", "b", &log));
+    CBL_ASSERT_EQ(cbl::join(log, ","), "A ok");
+    CBL_ASSERT_EQ(editQueue.size(), 1);
+    // Adding a third edit sends the second one, waiting for the delay between edits.
+    editQueue.add(prepareEdit(wiki, "C", "c", &log));
+    CBL_ASSERT_EQ(cbl::join(log, ","), "A ok,B ok");
+    CBL_ASSERT_EQ(editQueue.size(), 1);
+    CBL_ASSERT_EQ(wiki.totalSleepTime(), 10);
+    editQueue.flush();
+    CBL_ASSERT_EQ(cbl::join(log, ","), "A ok,B ok,C ok");
+  }
+
+  CBL_TEST_CASE(EditConflict) {
+    ThrottledMockWiki wiki;
+    wiki.setDelayBetweenEdits(10);
+    wiki.setPageContent("B", "old");
+    vector<string> log;
+    EditQueue editQueue(wiki);
+    editQueue.add(prepareEdit(wiki, "A", "a", &log));
+    editQueue.add(prepareEdit(wiki, "B", "b", &log));
+    editQueue.add(prepareEdit(wiki, "C", "c", &log));
+    // Someone else edits B while the edit is queued.
+    wiki.setPageContent("B", "other");
+    editQueue.flush();
+    CBL_ASSERT_EQ(cbl::join(log, ","), "A ok,B failed,C ok");
+    CBL_ASSERT_EQ(wiki.readPageContent("B"), "other");
+  }
+};
+
+}  // namespace mwc
+
+int main() {
+  mwc::EditQueueTest().run();
+  return 0;
+}
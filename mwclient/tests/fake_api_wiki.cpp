@@ -0,0 +1,87 @@
+#include "fake_api_wiki.h"
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "cbl/date.h"
+#include "cbl/http_client.h"
+#include "cbl/log.h"
+#include "cbl/string.h"
+
+using cbl::Date;
+using cbl::DateDiff;
+using std::string;
+using std::string_view;
+
+namespace mwc {
+
+static std::future<string> makeReadyFuture(string value) {
+  std::promise<string> promise;
+  promise.set_value(std::move(value));
+  return promise.get_future();
+}
+
+void FakeAPIClient::getStreamed(const string& url, const DataCallback& onData) {
+  m_numSyncRequests++;
+  onData(answer(url));
+}
+
+void FakeAPIClient::postStreamed(const string& url, const string& data, const DataCallback& onData) {
+  m_numSyncRequests++;
+  onData(answer(url + "&" + data));
+}
+
+std::future<string> FakeAPIClient::getAsync(const string& url) {
+  m_numAsyncRequests++;
+  return makeReadyFuture(answer(url));
+}
+
+std::future<string> FakeAPIClient::postAsync(const string& url, const string& data) {
+  m_numAsyncRequests++;
+  return makeReadyFuture(answer(url + "&" + data));
+}
+
+string FakeAPIClient::answer(const string& request) {
+  m_requests.push_back(request);
+  m_requestDates.push_back(Date::now());
+  if (!m_answers.empty()) {
+    string answer = std::move(m_answers.front());
+    m_answers.pop_front();
+    if (answer == "503") {
+      throw cbl::HTTPServerError(503, "Service unavailable", 120);
+    }
+    return answer;
+  }
+  CBL_ASSERT(m_handler) << "Unexpected request: " << request;
+  Params params;
+  size_t questionMarkPosition = request.find('?');
+  string_view paramsStr = questionMarkPosition == string::npos ? string_view(request)
+                                                              : string_view(request).substr(questionMarkPosition + 1);
+  for (string_view param : cbl::split(paramsStr, '&')) {
+    if (param.empty()) continue;
+    size_t equalPosition = param.find('=');
+    string value = equalPosition == string_view::npos ? "" : cbl::decodeURIComponent(param.substr(equalPosition + 1));
+    params[string(param.substr(0, equalPosition))] = std::move(value);
+  }
+  return m_handler(params);
+}
+
+FakeAPIWiki::FakeAPIWiki() {
+  auto httpClient = std::make_unique<FakeAPIClient>();
+  m_client = httpClient.get();
+  setHTTPClient(std::move(httpClient));
+  m_wikiURL = "https://wiki.test/w";
+}
+
+void FakeAPIWiki::sleep(int seconds) {
+  m_totalSleep += seconds;
+  Date::advanceFrozenClock(DateDiff::fromSeconds(seconds));
+}
+
+void FakeAPIWiki::setAPILimits(int apiLimit, int apiTitlesLimit) {
+  m_apiLimit = apiLimit;
+  m_apiTitlesLimit = apiTitlesLimit;
+}
+
+}  // namespace mwc
@@ -0,0 +1,72 @@
+#ifndef MWC_FAKE_API_WIKI_H
+#define MWC_FAKE_API_WIKI_H
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+#include "cbl/date.h"
+#include "cbl/http_client.h"
+#include "mwclient/rate_controller.h"
+#include "mwclient/wiki.h"
+#include "mwclient/wiki_defs.h"
+
+namespace mwc {
+
+// HTTP client answering API requests without network access, for tests.
+// Answers added with addAnswer() are returned first, in order. The answer "503" throws HTTPServerError instead, with a
+// Retry-After delay of 120 seconds. When there are no such answers, requests are passed to the handler.
+class FakeAPIClient : public cbl::HTTPClient {
+public:
+  // Parameters of the URL and POST data, decoded.
+  using Params = std::map<std::string, std::string>;
+  using Handler = std::function<std::string(const Params& params)>;
+
+  void addAnswer(const std::string& answer) { m_answers.push_back(answer); }
+  void setHandler(const Handler& handler) { m_handler = handler; }
+
+  // Requests sent so far, as the URL followed by '&' and the POST data if any.
+  const std::vector<std::string>& requests() const { return m_requests; }
+  const std::vector<cbl::Date>& requestDates() const { return m_requestDates; }
+  int numSyncRequests() const { return m_numSyncRequests; }
+  int numAsyncRequests() const { return m_numAsyncRequests; }
+
+  void getStreamed(const std::string& url, const DataCallback& onData) override;
+  void postStreamed(const std::string& url, const std::string& data, const DataCallback& onData) override;
+  std::future<std::string> getAsync(const std::string& url) override;
+  std::future<std::string> postAsync(const std::string& url, const std::string& data) override;
+
+private:
+  std::string answer(const std::string& request);
+
+  std::deque<std::string> m_answers;
+  Handler m_handler;
+  std::vector<std::string> m_requests;
+  std::vector<cbl::Date> m_requestDates;
+  int m_numSyncRequests = 0;
+  int m_numAsyncRequests = 0;
+};
+
+// Wiki sending its requests to a FakeAPIClient. Tokens are constant and sleep() advances the frozen clock instead of
+// sleeping.
+class FakeAPIWiki : public Wiki {
+public:
+  FakeAPIWiki();
+  FakeAPIClient& client() { return *m_client; }
+  const FakeAPIClient& client() const { return *m_client; }
+  std::string getToken(TokenType tokenType) override { return "+\\"; }
+  void sleep(int seconds) override;
+  int totalSleep() const { return m_totalSleep; }
+  void setAPILimits(int apiLimit, int apiTitlesLimit);
+  RateController& rateController() { return m_rateController; }
+
+private:
+  FakeAPIClient* m_client = nullptr;
+  int m_totalSleep = 0;
+};
+
+}  // namespace mwc
+
+#endif
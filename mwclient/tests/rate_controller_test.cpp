@@ -0,0 +1,155 @@
+#include "mwclient/rate_controller.h"
+#include <string>
+#include <vector>
+#include "cbl/date.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
+#include "cbl/unittest.h"
+#include "mwclient/tests/fake_api_wiki.h"
+#include "mwclient/wiki_defs.h"
+
+using cbl::Date;
+using cbl::DateDiff;
+using std::string;
+
+namespace mwc {
+
+class RateControllerTest : public cbl::Test {
+private:
+  void setUp() override { Date::setFrozenValueOfNow(Date::fromISO8601("2020-01-01T00:00:00Z")); }
+
+  CBL_TEST_CASE(OnlyRemainingBudgetIsWaited) {
+    RateController controller;
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 0);
+    controller.setInterval(RateController::REQUEST_BUDGET, 5);
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 0);
+    // The previous request took 3 seconds.
+    Date::advanceFrozenClock(DateDiff::fromSeconds(3));
+    CBL_ASSERT_EQ(controller.delayBeforeReserve(RateController::REQUEST_BUDGET), 2);
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 2);
+    Date::advanceFrozenClock(DateDiff::fromSeconds(2));
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 5);
+    Date::advanceFrozenClock(DateDiff::fromSeconds(60));
+    CBL_ASSERT(controller.tryReserve(RateController::REQUEST_BUDGET));
+    CBL_ASSERT(!controller.tryReserve(RateController::REQUEST_BUDGET));
+    Date::advanceFrozenClock(DateDiff::fromSeconds(1));
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 4);
+  }
+
+  CBL_TEST_CASE(Burst) {
+    RateController controller;
+    controller.setInterval(RateController::REQUEST_BUDGET, 10);
+    controller.setBurst(RateController::REQUEST_BUDGET, 3);
+    for (int i = 0; i < 3; i++) {
+      CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 0) << i;
+    }
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 10);
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 20);
+    // The last request is sent after 20 seconds. 20 seconds later, 2 tokens have been generated again.
+    Date::advanceFrozenClock(DateDiff::fromSeconds(40));
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 0);
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 0);
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 10);
+  }
+
+  CBL_TEST_CASE(SeparateBudgets) {
+    RateController controller;
+    controller.setInterval(RateController::REQUEST_BUDGET, 1);
+    controller.setInterval(RateController::EDIT_BUDGET, 12);
+    controller.drain(RateController::EDIT_BUDGET);
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 0);
+    CBL_ASSERT_EQ(controller.reserve(RateController::EDIT_BUDGET), 12);
+    Date::advanceFrozenClock(DateDiff::fromSeconds(15));
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 0);
+    CBL_ASSERT_EQ(controller.reserve(RateController::EDIT_BUDGET), 9);
+  }
+
+  CBL_TEST_CASE(ClockGoingBackward) {
+    RateController controller;
+    controller.setInterval(RateController::EDIT_BUDGET, 12);
+    CBL_ASSERT_EQ(controller.reserve(RateController::EDIT_BUDGET), 0);
+    Date::advanceFrozenClock(DateDiff::fromSeconds(-3600));
+    CBL_ASSERT_EQ(controller.reserve(RateController::EDIT_BUDGET), 12);
+  }
+
+  CBL_TEST_CASE(RetryDelay) {
+    RateController controller;
+    for (int retryIndex = 0; retryIndex < 40; retryIndex++) {
+      int maxDelay = retryIndex < 5 ? RateController::BASE_RETRY_DELAY << retryIndex : RateController::MAX_RETRY_DELAY;
+      int delay = controller.retryDelay(retryIndex);
+      CBL_ASSERT(delay >= maxDelay / 2 && delay <= maxDelay) << retryIndex << " " << delay;
+      CBL_ASSERT_EQ(controller.retryDelay(retryIndex, 1000), 1000);
+    }
+  }
+
+  CBL_TEST_CASE(LagPenaltyAndLatency) {
+    RateController controller;
+    controller.recordServerLag();
+    controller.recordServerLag();
+    controller.recordServerLag();
+    CBL_ASSERT_EQ(controller.lagPenalty(), 4);
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 0);
+    CBL_ASSERT_EQ(controller.reserve(RateController::REQUEST_BUDGET), 4);
+    CBL_ASSERT_EQ(controller.reserve(RateController::EDIT_BUDGET), 0);
+    Date start = Date::now();
+    Date::advanceFrozenClock(DateDiff::fromSeconds(10));
+    controller.recordSuccess(start);
+    CBL_ASSERT_EQ(controller.lagPenalty(), 3);
+    CBL_ASSERT_EQ(controller.averageLatency(), 10.0);
+    controller.recordSuccess(Date::now());
+    CBL_ASSERT_EQ(controller.averageLatency(), 8.0);
+  }
+
+  CBL_TEST_CASE(WikiBaseRetries) {
+    FakeAPIWiki wiki;
+    wiki.rateController().setInterval(RateController::REQUEST_BUDGET, 5);
+    FakeAPIClient& httpClient = wiki.client();
+    httpClient.addAnswer(R"({"error": {"code": "maxlag", "info": "Waiting for db: 8 seconds lagged", "lag": 8}})");
+    httpClient.addAnswer("503");
+    httpClient.addAnswer(R"({"query": {"x": 1}})");
+    Date start = Date::now();
+    json::Value answer = wiki.apiGetRequest("action=query");
+    CBL_ASSERT_EQ(answer["query"]["x"].numberAsInt(), 1);
+    const std::vector<Date>& requestDates = httpClient.requestDates();
+    CBL_ASSERT_EQ(requestDates.size(), 3u);
+    // First retry: between 15 and 30 seconds.
+    DateDiff firstDelay = requestDates[1] - requestDates[0];
+    CBL_ASSERT(firstDelay >= DateDiff::fromSeconds(15) && firstDelay <= DateDiff::fromSeconds(30))
+        << firstDelay.seconds();
+    // Second retry: the server asked to wait 120 seconds, which is more than the random delay in [30, 60].
+    CBL_ASSERT(requestDates[2] - requestDates[1] == DateDiff::fromSeconds(120));
+    CBL_ASSERT_EQ(wiki.totalSleep(), (Date::now() - start).seconds());
+
+    // The request budget is respected between successful requests. The previous request was sent while the penalty for
+    // the maxlag error was 1 second.
+    httpClient.addAnswer("{}");
+    wiki.apiGetRequest("action=query");
+    CBL_ASSERT_EQ((httpClient.requestDates()[3] - requestDates[2]).seconds(), 6);
+    CBL_ASSERT_EQ(wiki.rateController().lagPenalty(), 0);
+
+    httpClient.addAnswer(R"({"error": {"code": "readonly", "info": "Read only"}})");
+    try {
+      wiki.apiRequest("action=edit", "title=A", false);
+      CBL_ASSERT(false);
+    } catch (const LowLevelError& error) {
+      CBL_ASSERT_EQ(error.type(), LowLevelError::READ_ONLY_WIKI);
+    }
+  }
+
+  CBL_TEST_CASE(WaitBeforeEdit) {
+    FakeAPIWiki wiki;
+    wiki.rateController().drain(RateController::EDIT_BUDGET);
+    Date::advanceFrozenClock(DateDiff::fromSeconds(5));
+    wiki.waitBeforeEdit();
+    CBL_ASSERT_EQ(wiki.totalSleep(), 7);
+    wiki.waitBeforeEdit();
+    CBL_ASSERT_EQ(wiki.totalSleep(), 19);
+  }
+};
+
+}  // namespace mwc
+
+int main() {
+  mwc::RateControllerTest().run();
+  return 0;
+}
@@ -0,0 +1,91 @@
+// Runs a bot on a recording of its HTTP traffic and reports the resources that it used (see replay_http_client.h).
+// Usage: replay_benchmark --recording=FILE [--latency-ms=N] [--max-requests=N] -- BOT [BOT_ARGS...]
+// If --max-requests is set and the bot sends more requests, the exit code is 1, so that regressions in the number of
+// requests can be caught by scripts.
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cbl/args_parser.h"
+#include "cbl/error.h"
+#include "cbl/file.h"
+#include "cbl/json.h"
+#include "cbl/tempfile.h"
+
+using std::string;
+using std::vector;
+
+static double timevalToSeconds(const timeval& value) {
+  return value.tv_sec + value.tv_usec / 1e6;
+}
+
+int main(int argc, char** argv) {
+  string recordingFile;
+  int latencyMs = 0;
+  int maxRequests = 0;  // 0 means no limit.
+  vector<string> command;
+  cbl::parseArgs(argc, argv, "--recording,required", &recordingFile, "--latency-ms", &latencyMs, "--max-requests",
+                 &maxRequests, "command", &command);
+  if (command.empty()) {
+    std::cerr << "Missing command of the bot to run\n";
+    return 2;
+  }
+
+  cbl::TempDir tempDir;
+  string statsFile = tempDir.path() + "/stats.json";
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid == -1) {
+    throw cbl::SystemError("fork() failed: " + cbl::getCErrorString(errno));
+  } else if (pid == 0) {
+    setenv("MWCLIENT_REPLAY_FILE", recordingFile.c_str(), 1);
+    setenv("MWCLIENT_REPLAY_LATENCY_MS", std::to_string(latencyMs).c_str(), 1);
+    setenv("MWCLIENT_REPLAY_STATS_FILE", statsFile.c_str(), 1);
+    unsetenv("MWCLIENT_RECORD_FILE");
+    vector<char*> args;
+    for (string& arg : command) {
+      args.push_back(arg.data());
+    }
+    args.push_back(nullptr);
+    execvp(args[0], args.data());
+    perror("execvp");
+    _exit(127);
+  }
+  int status = 0;
+  rusage usage{};
+  if (wait4(pid, &status, 0, &usage) == -1) {
+    throw cbl::SystemError("wait4() failed: " + cbl::getCErrorString(errno));
+  }
+  std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - start;
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::cerr << "The bot did not exit normally (status " << status << ")\n";
+    return 2;
+  } else if (!cbl::fileExists(statsFile)) {
+    std::cerr << "The bot did not write replay stats. Does it initialize its Wiki object with initWikiFromFlags()?\n";
+    return 2;
+  }
+  json::Value stats = json::parse(cbl::readFile(statsFile));
+  int64_t numRequests = stats["numRequests"].numberAsInt64();
+  std::cout << "Requests: " << numRequests << " (" << stats["numMissingRequests"].numberAsInt64()
+            << " not in the recording, " << stats["numAssembledRequests"].numberAsInt64()
+            << " assembled from recorded pages)\n"
+            << "Bytes sent: " << stats["bytesSent"].numberAsInt64() << "\n"
+            << "Bytes received: " << stats["bytesReceived"].numberAsInt64() << "\n"
+            << "Simulated latency: " << stats["simulatedLatencyMs"].numberAsInt64() / 1000.0 << " s\n"
+            << "CPU time: " << timevalToSeconds(usage.ru_utime) + timevalToSeconds(usage.ru_stime) << " s (user "
+            << timevalToSeconds(usage.ru_utime) << " s, system " << timevalToSeconds(usage.ru_stime) << " s)\n"
+            << "Wall time: " << wallTime.count() << " s\n";
+  if (maxRequests > 0 && numRequests > maxRequests) {
+    std::cerr << "The bot sent " << numRequests << " requests, more than the limit of " << maxRequests << "\n";
+    return 1;
+  }
+  return 0;
+}
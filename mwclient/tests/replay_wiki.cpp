@@ -32,6 +32,11 @@ class RecordHTTPClient : public cbl::HTTPClient {
 public:
   virtual void startTestCase(const string& name) = 0;
   virtual void endTestCase() = 0;
+  // Responses are recorded and replayed as a whole.
+  void getStreamed(const string& url, const DataCallback& onData) override { onData(get(url)); }
+  void postStreamed(const string& url, const string& data, const DataCallback& onData) override {
+    onData(post(url, data));
+  }
 };
 
 class RecordWriterHTTPClient : public RecordHTTPClient {
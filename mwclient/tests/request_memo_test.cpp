@@ -0,0 +1,139 @@
+#include "mwclient/request_memo.h"
+#include <string>
+#include "cbl/date.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
+#include "cbl/unittest.h"
+#include "mwclient/request.h"
+#include "mwclient/tests/fake_api_wiki.h"
+#include "mwclient/wiki_base.h"
+#include "mwclient/wiki_defs.h"
+
+using cbl::Date;
+using cbl::DateDiff;
+using std::string;
+
+namespace mwc {
+
+// Answers all requests with {"n": <number of requests sent so far>}.
+class CountingWiki : public FakeAPIWiki {
+public:
+  CountingWiki() {
+    setDelayBetweenEdits(0);
+    client().setHandler([this](const FakeAPIClient::Params& params) {
+      json::Value answer;
+      answer.getMutable("n") = static_cast<int>(client().requests().size());
+      return answer.toJSON();
+    });
+  }
+  int numRequests() { return client().requests().size(); }
+};
+
+class RequestMemoTest : public cbl::Test {
+private:
+  void setUp() override { Date::setFrozenValueOfNow(Date::fromISO8601("2020-01-01T00:00:00Z")); }
+
+  static int readPage(WikiBase& wiki, const string& title) {
+    WikiPropPager request("revisions", "rvlimit");
+    request.setParam("titles", title);
+    request.setParam("rvprop", "content");
+    return request.run(wiki)["n"].numberAsInt();
+  }
+
+  static int readContribs(WikiBase& wiki, const string& user) {
+    WikiListPager request("usercontribs", "uclimit");
+    request.setParam("ucuser", user);
+    request.setParam("uclimit", 1);
+    return request.run(wiki)["n"].numberAsInt();
+  }
+
+  static void edit(WikiBase& wiki, const string& title) {
+    WikiWriteRequest request("edit", TOK_CSRF);
+    request.setParam("title", title);
+    request.setParam("text", "x");
+    request.setTokenAndRun(wiki);
+  }
+
+  CBL_TEST_CASE(DisabledByDefault) {
+    CountingWiki wiki;
+    CBL_ASSERT(wiki.requestMemo() == nullptr);
+    CBL_ASSERT_EQ(readPage(wiki, "A"), 1);
+    CBL_ASSERT_EQ(readPage(wiki, "A"), 2);
+  }
+
+  CBL_TEST_CASE(HitsAndMisses) {
+    CountingWiki wiki;
+    wiki.enableRequestMemo(DateDiff::fromMinutes(1));
+    CBL_ASSERT_EQ(readPage(wiki, "A"), 1);
+    CBL_ASSERT_EQ(readPage(wiki, "B"), 2);
+    CBL_ASSERT_EQ(readPage(wiki, "A"), 1);
+    CBL_ASSERT_EQ(readContribs(wiki, "U"), 3);
+    CBL_ASSERT_EQ(readContribs(wiki, "U"), 3);
+    CBL_ASSERT_EQ(wiki.requestMemo()->hits(), 2);
+    CBL_ASSERT_EQ(wiki.requestMemo()->misses(), 3);
+    CBL_ASSERT_EQ(wiki.numRequests(), 3);
+
+    // Tokens are never memoized.
+    for (int i = 0; i < 2; i++) {
+      WikiRequest request("query");
+      request.setParam("meta", "tokens");
+      request.run(wiki);
+    }
+    CBL_ASSERT_EQ(wiki.numRequests(), 5);
+
+    Date::advanceFrozenClock(DateDiff::fromSeconds(61));
+    CBL_ASSERT_EQ(readPage(wiki, "A"), 6);
+  }
+
+  CBL_TEST_CASE(InvalidationByWrites) {
+    CountingWiki wiki;
+    wiki.enableRequestMemo(DateDiff::fromMinutes(1));
+    CBL_ASSERT_EQ(readPage(wiki, "Talk:A"), 1);
+    CBL_ASSERT_EQ(readPage(wiki, "B"), 2);
+    CBL_ASSERT_EQ(readContribs(wiki, "U"), 3);
+    // The write to "Discussion:a" may affect "Talk:A" and lists, but not "B".
+    edit(wiki, "Discussion:a");
+    CBL_ASSERT_EQ(wiki.requestMemo()->invalidations(), 2);
+    CBL_ASSERT_EQ(readPage(wiki, "Talk:A"), 5);
+    CBL_ASSERT_EQ(readPage(wiki, "B"), 2);
+    CBL_ASSERT_EQ(readContribs(wiki, "U"), 6);
+
+    // A move may affect talk pages and subpages, so it invalidates everything.
+    WikiWriteRequest request("move", TOK_CSRF);
+    request.setParam("from", "C");
+    request.setParam("to", "D");
+    request.setTokenAndRun(wiki);
+    CBL_ASSERT_EQ(wiki.requestMemo()->size(), 0);
+    CBL_ASSERT_EQ(readPage(wiki, "B"), 8);
+  }
+
+  CBL_TEST_CASE(MaxEntries) {
+    RequestMemo memo(DateDiff::fromMinutes(1), 3);
+    json::Value answer;
+    for (int i = 0; i < 3; i++) {
+      memo.put("r" + std::to_string(i), {}, answer);
+    }
+    Date::advanceFrozenClock(DateDiff::fromSeconds(30));
+    // No entry has expired, so all entries are removed.
+    memo.put("r3", {"A"}, answer);
+    CBL_ASSERT_EQ(memo.size(), 1);
+    memo.put("r4", {"A"}, answer);
+    Date::advanceFrozenClock(DateDiff::fromSeconds(40));
+    memo.put("r5", {"A"}, answer);
+    CBL_ASSERT_EQ(memo.size(), 3);
+    // r3 and r4 have expired and are removed first.
+    Date::advanceFrozenClock(DateDiff::fromSeconds(25));
+    memo.put("r6", {"A"}, answer);
+    CBL_ASSERT_EQ(memo.size(), 2);
+    CBL_ASSERT(!memo.get("r3", answer));
+    CBL_ASSERT(memo.get("r5", answer));
+    CBL_ASSERT(memo.get("r6", answer));
+  }
+};
+
+}  // namespace mwc
+
+int main() {
+  mwc::RequestMemoTest().run();
+  return 0;
+}
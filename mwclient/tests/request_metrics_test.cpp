@@ -0,0 +1,96 @@
+#include "mwclient/request_metrics.h"
+#include <memory>
+#include <string>
+#include "cbl/date.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
+#include "cbl/unittest.h"
+#include "mwclient/tests/fake_api_wiki.h"
+
+using cbl::Date;
+using std::string;
+
+namespace mwc {
+
+class RecordingSink : public RequestMetricsSink {
+public:
+  explicit RecordingSink(string* output) : m_output(output) {}
+  void write(const RequestMetrics& metrics) override { *m_output = metrics.toJSON().toJSON(); }
+
+private:
+  string* m_output;
+};
+
+class RequestMetricsTest : public cbl::Test {
+private:
+  void setUp() override { Date::setFrozenValueOfNow(Date::fromISO8601("2020-01-01T00:00:00Z")); }
+
+  CBL_TEST_CASE(GetAPIModuleOfRequest) {
+    CBL_ASSERT_EQ(getAPIModuleOfRequest("action=query&prop=revisions%7Cinfo&titles=A", ""), "query+revisions+info");
+    CBL_ASSERT_EQ(getAPIModuleOfRequest("action=query&list=recentchanges&rclimit=10", ""), "query+recentchanges");
+    CBL_ASSERT_EQ(getAPIModuleOfRequest("action=query&generator=allpages&prop=categories", ""),
+                  "query+allpages+categories");
+    CBL_ASSERT_EQ(getAPIModuleOfRequest("", "action=edit&title=A&text=B"), "edit");
+  }
+
+  CBL_TEST_CASE(Histogram) {
+    RequestMetrics metrics;
+    metrics.recordAttempt("parse", 0.01, 100, 0.001);
+    metrics.recordAttempt("parse", 0.3, 200, 0.002);
+    metrics.recordAttempt("parse", 100, 0, 0);
+    metrics.recordRetry("parse");
+    const RequestMetrics::ModuleMetrics& parseMetrics = metrics.modules().at("parse");
+    CBL_ASSERT_EQ(parseMetrics.requests, 3);
+    CBL_ASSERT_EQ(parseMetrics.responseBytes, 300);
+    CBL_ASSERT_EQ(parseMetrics.latencyHistogram[0], 1);
+    CBL_ASSERT_EQ(parseMetrics.latencyHistogram[3], 1);
+    CBL_ASSERT_EQ(parseMetrics.latencyHistogram[RequestMetrics::NUM_LATENCY_BUCKETS - 1], 1);
+
+    json::Value value = metrics.toJSON();
+    CBL_ASSERT_EQ(value["parse"]["retries"].numberAsInt(), 1);
+    CBL_ASSERT_EQ(value["parse"]["totalLatencyMs"].numberAsInt(), 100310);
+    CBL_ASSERT_EQ(value["parse"]["latencyHistogram"]["+Inf"].numberAsInt(), 1);
+
+    string text = metrics.toPrometheusText();
+    CBL_ASSERT(text.find("mwclient_requests_total{module=\"parse\"} 3\n") != string::npos) << text;
+    CBL_ASSERT(text.find("mwclient_request_duration_seconds_bucket{module=\"parse\",le=\"0.5\"} 2\n") !=
+               string::npos)
+        << text;
+    CBL_ASSERT(text.find("mwclient_request_duration_seconds_bucket{module=\"parse\",le=\"+Inf\"} 3\n") !=
+               string::npos)
+        << text;
+    CBL_ASSERT(text.find("mwclient_request_duration_seconds_count{module=\"parse\"} 3\n") != string::npos) << text;
+  }
+
+  CBL_TEST_CASE(APIRequests) {
+    string sinkOutput;
+    {
+      FakeAPIWiki wiki;
+      wiki.setRequestMetricsSink(std::make_unique<RecordingSink>(&sinkOutput));
+      FakeAPIClient& client = wiki.client();
+      client.addAnswer(R"({"error":{"code":"maxlag","info":"Waiting for a database server"}})");
+      client.addAnswer(R"({"query":{}})");
+      client.addAnswer(R"({"edit":{"result":"Success"}})");
+      wiki.apiRequest("action=query&list=allpages", "", true);
+      wiki.apiRequest("", "action=edit&title=A", false);
+
+      const RequestMetrics::ModuleMetrics& queryMetrics = wiki.requestMetrics().modules().at("query+allpages");
+      CBL_ASSERT_EQ(queryMetrics.requests, 2);
+      CBL_ASSERT_EQ(queryMetrics.retries, 1);
+      CBL_ASSERT_EQ(queryMetrics.maxLagErrors, 1);
+      CBL_ASSERT_EQ(queryMetrics.responseBytes, 78);
+      CBL_ASSERT_EQ(wiki.requestMetrics().modules().at("edit").requests, 1);
+      CBL_ASSERT_EQ(sinkOutput, "");
+    }
+    // The sink is called when the wiki is destroyed.
+    json::Value value = json::parse(sinkOutput);
+    CBL_ASSERT_EQ(value["edit"]["requests"].numberAsInt(), 1);
+  }
+};
+
+}  // namespace mwc
+
+int main() {
+  mwc::RequestMetricsTest().run();
+  return 0;
+}
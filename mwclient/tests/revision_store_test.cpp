@@ -0,0 +1,162 @@
+#include "mwclient/revision_store.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cbl/date.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
+#include "cbl/string.h"
+#include "cbl/tempfile.h"
+#include "cbl/unittest.h"
+#include "mwclient/tests/fake_api_wiki.h"
+#include "mwclient/wiki.h"
+#include "mwclient/wiki_defs.h"
+
+using cbl::Date;
+using cbl::DateDiff;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace mwc {
+
+// Answers action=query&prop=revisions&revids=... requests. The content of revision N is "Content N". Revisions above
+// 1000 do not exist.
+class RevisionStoreTestWiki : public FakeAPIWiki {
+public:
+  RevisionStoreTestWiki() {
+    client().setHandler([this](const FakeAPIClient::Params& params) { return answer(params); });
+  }
+  int numRequests() const { return client().requests().size(); }
+  const string& lastRequest() const { return client().requests().back(); }
+  const string& lastRevids() const { return m_lastRevids; }
+
+private:
+  string answer(const FakeAPIClient::Params& params) {
+    bool withContent = params.at("rvprop").find("content") != string::npos;
+    json::Value answer;
+    json::Value& query = answer.getMutable("query");
+    m_lastRevids = params.at("revids");
+    for (string_view revidView : cbl::split(m_lastRevids, '|')) {
+      string revidStr(revidView);
+      int revid = cbl::parseInt(revidStr);
+      if (revid > 1000) {
+        query.getMutable("badrevids").getMutable(revidStr).getMutable("revid") = revid;
+        continue;
+      }
+      json::Value& page = query.getMutable("pages").getMutable(revidStr);
+      page.getMutable("title") = "Page";
+      json::Value& revision = page.getMutable("revisions").addItem();
+      revision.getMutable("revid") = revid;
+      revision.getMutable("user") = "User" + revidStr;
+      if (withContent) {
+        revision.getMutable("slots").getMutable("main").getMutable("*") = "Content " + revidStr;
+      }
+    }
+    return answer.toJSON();
+  }
+
+  string m_lastRevids;
+};
+
+class RevisionStoreTest : public cbl::Test {
+private:
+  void setUp() override { Date::setFrozenValueOfNow(Date::fromISO8601("2020-01-01T00:00:00Z")); }
+
+  // Returns 30 bytes that zlib cannot compress.
+  static string incompressibleContent(int seed) {
+    string content;
+    for (int i = 0; i < 30; i++) {
+      content += static_cast<char>('a' + (i * i * 7 + seed) % 26);
+    }
+    return content;
+  }
+
+  CBL_TEST_CASE(GetPut) {
+    cbl::TempDir tempDir;
+    string content;
+    {
+      RevisionStore store(tempDir.path() + "/revisions.sqlite");
+      CBL_ASSERT(!store.getContent(1, content));
+      store.putContent(1, "short");
+      store.putContent(2, string(10000, 'x'));
+      store.putContent(3, "");
+      // Revisions are immutable, so the first content is kept.
+      store.putContent(1, "other content");
+      CBL_ASSERT(store.getContent(1, content));
+      CBL_ASSERT_EQ(content, "short");
+      CBL_ASSERT(store.getContent(3, content));
+      CBL_ASSERT_EQ(content, "");
+      CBL_ASSERT_EQ(store.numEntries(), 3);
+      CBL_ASSERT(store.totalSize() > 5 && store.totalSize() < 200) << store.totalSize();
+    }
+    // The data is persistent.
+    RevisionStore store(tempDir.path() + "/revisions.sqlite");
+    CBL_ASSERT(store.getContent(2, content));
+    CBL_ASSERT_EQ(content, string(10000, 'x'));
+  }
+
+  CBL_TEST_CASE(Eviction) {
+    cbl::TempDir tempDir;
+    RevisionStore store(tempDir.path() + "/revisions.sqlite", {.maxSize = 100});
+    string content;
+    for (int revid = 1; revid <= 3; revid++) {
+      store.putContent(revid, incompressibleContent(revid));
+      Date::advanceFrozenClock(DateDiff::fromDays(2));
+    }
+    // Reading revision 1 makes revision 2 the least recently used one.
+    CBL_ASSERT(store.getContent(1, content));
+    store.putContent(4, incompressibleContent(4));
+    CBL_ASSERT_EQ(store.numEntries(), 3);
+    CBL_ASSERT(store.totalSize() <= 90) << store.totalSize();
+    CBL_ASSERT(store.getContent(1, content));
+    CBL_ASSERT(!store.getContent(2, content));
+    CBL_ASSERT(store.getContent(4, content));
+  }
+
+  CBL_TEST_CASE(ReadRevisionsWithStore) {
+    cbl::TempDir tempDir;
+    RevisionStoreTestWiki wiki;
+    wiki.setRevisionStore(std::make_unique<RevisionStore>(tempDir.path() + "/revisions.sqlite"));
+
+    vector<Revision> revisions(3);
+    revisions[0].revid = 10;
+    revisions[1].revid = 20;
+    revisions[2].revid = 2000;
+    wiki.readRevisions(RP_CONTENT, revisions);
+    CBL_ASSERT_EQ(wiki.numRequests(), 1);
+    CBL_ASSERT_EQ(revisions[0].content, "Content 10");
+    CBL_ASSERT_EQ(revisions[2].title, INVALID_TITLE);
+    CBL_ASSERT_EQ(wiki.revisionStore()->numEntries(), 2);
+
+    // Only the content of revision 30 is downloaded.
+    revisions.resize(2);
+    revisions[0].revid = 20;
+    revisions[1].revid = 30;
+    wiki.readRevisions(RP_CONTENT, revisions);
+    CBL_ASSERT_EQ(wiki.numRequests(), 2);
+    CBL_ASSERT_EQ(wiki.lastRevids(), "30");
+    CBL_ASSERT_EQ(revisions[0].content, "Content 20");
+    CBL_ASSERT_EQ(revisions[1].content, "Content 30");
+
+    // Other properties of stored revisions are requested without the content.
+    revisions.resize(1);
+    revisions[0].revid = 10;
+    wiki.readRevisions(RP_CONTENT | RP_USER, revisions);
+    CBL_ASSERT_EQ(wiki.numRequests(), 3);
+    CBL_ASSERT(wiki.lastRequest().find("content") == string::npos) << wiki.lastRequest();
+    CBL_ASSERT_EQ(revisions[0].user, "User10");
+    CBL_ASSERT_EQ(revisions[0].content, "Content 10");
+
+    CBL_ASSERT_EQ(wiki.readRevisionContent(30), "Content 30");
+    CBL_ASSERT_EQ(wiki.numRequests(), 3);
+  }
+};
+
+}  // namespace mwc
+
+int main() {
+  mwc::RevisionStoreTest().run();
+  return 0;
+}
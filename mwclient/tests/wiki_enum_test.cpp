@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "cbl/date.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
+#include "cbl/string.h"
+#include "cbl/unittest.h"
+#include "mwclient/tests/fake_api_wiki.h"
+#include "mwclient/wiki.h"
+#include "mwclient/wiki_defs.h"
+
+using cbl::Date;
+using std::map;
+using std::string;
+using std::vector;
+
+namespace mwc {
+
+// Answers action=query&list=allpages and action=query&generator=allpages&prop=revisions requests from a sorted list of
+// titles. With the generator, revisions are returned for at most 2 pages per request, like MediaWiki does for content
+// when too many pages are requested.
+class EnumTestWiki : public FakeAPIWiki {
+public:
+  explicit EnumTestWiki(const vector<string>& titles) : m_titles(titles) {
+    setAPILimits(2, BASIC_API_TITLES_LIMIT);
+    client().setHandler([this](const FakeAPIClient::Params& params) { return answer(params); });
+  }
+
+private:
+  string answer(FakeAPIClient::Params params) {
+    if (params["generator"] == "allpages") {
+      return generatorAnswer(params);
+    }
+    CBL_ASSERT_EQ(params["list"], "allpages");
+    int limit = std::stoi(params["aplimit"]);
+    auto titleIt = std::lower_bound(m_titles.begin(), m_titles.end(), params["apcontinue"]);
+    json::Value answer;
+    json::Value& pages = answer.getMutable("query").getMutable("allpages");
+    pages.setToEmptyArray();
+    for (int i = 0; i < limit && titleIt != m_titles.end(); i++, ++titleIt) {
+      pages.addItem().getMutable("title") = *titleIt;
+    }
+    if (titleIt != m_titles.end()) {
+      json::Value& continueValue = answer.getMutable("continue");
+      continueValue.getMutable("apcontinue") = *titleIt;
+      continueValue.getMutable("continue") = "-||";
+    }
+    return answer.toJSON();
+  }
+
+  string generatorAnswer(map<string, string>& params) {
+    CBL_ASSERT_EQ(params["prop"], "revisions");
+    int limit = std::stoi(params["gaplimit"]);
+    auto titleIt = std::lower_bound(m_titles.begin(), m_titles.end(), params["gapcontinue"]);
+    // rvcontinue must be dropped when the generator moves to the next batch.
+    CBL_ASSERT(params["rvcontinue"].empty() || params["rvcontinue"] > params["gapcontinue"]) << params["rvcontinue"];
+    json::Value answer;
+    json::Value& pages = answer.getMutable("query").getMutable("pages");
+    int numRevisions = 0;
+    string rvcontinue;
+    for (int i = 0; i < limit && titleIt != m_titles.end(); i++, ++titleIt) {
+      int pageIndex = titleIt - m_titles.begin();
+      json::Value& page = pages.getMutable(std::to_string(pageIndex + 1));
+      page.getMutable("title") = *titleIt;
+      if (*titleIt < params["rvcontinue"]) {
+        continue;
+      } else if (numRevisions == 2) {
+        if (rvcontinue.empty()) rvcontinue = *titleIt;
+        continue;
+      }
+      page.getMutable("revisions").addItem().getMutable("revid") = 100 + pageIndex;
+      numRevisions++;
+    }
+    if (!rvcontinue.empty()) {
+      json::Value& continueValue = answer.getMutable("continue");
+      continueValue.getMutable("rvcontinue") = rvcontinue;
+      continueValue.getMutable("continue") = "gapcontinue||";
+    } else if (titleIt != m_titles.end()) {
+      json::Value& continueValue = answer.getMutable("continue");
+      continueValue.getMutable("gapcontinue") = *titleIt;
+      continueValue.getMutable("continue") = "-||";
+    }
+    return answer.toJSON();
+  }
+
+  vector<string> m_titles;
+};
+
+class WikiEnumTest : public cbl::Test {
+private:
+  void setUp() override { Date::setFrozenValueOfNow(Date::fromISO8601("2020-01-01T00:00:00Z")); }
+
+  // Enumerates all pages and returns the batches, joined with ',' and separated by ' '.
+  string enumAllPages(Wiki& wiki, int enumFlags, int maxBatches = 100) {
+    string result;
+    int numBatches = 0;
+    wiki.enumAllPages(
+        AllPagesParams(),
+        [&](const vector<string>& titles) {
+          result += (result.empty() ? "" : " ") + cbl::join(titles, ",");
+          numBatches++;
+          return numBatches < maxBatches;
+        },
+        enumFlags);
+    return result;
+  }
+
+  CBL_TEST_CASE(Batches) {
+    EnumTestWiki wiki({"A", "B", "C", "D", "E"});
+    CBL_ASSERT_EQ(enumAllPages(wiki, 0), "A,B C,D E");
+    CBL_ASSERT_EQ(wiki.client().numSyncRequests(), 3);
+    CBL_ASSERT_EQ(wiki.client().numAsyncRequests(), 0);
+    CBL_ASSERT_EQ(cbl::join(wiki.getAllPages(AllPagesParams()), ","), "A,B,C,D,E");
+  }
+
+  CBL_TEST_CASE(EarlyStop) {
+    EnumTestWiki wiki({"A", "B", "C", "D", "E"});
+    CBL_ASSERT_EQ(enumAllPages(wiki, 0, 2), "A,B C,D");
+    CBL_ASSERT_EQ(wiki.client().numSyncRequests(), 2);
+  }
+
+  CBL_TEST_CASE(Pipelined) {
+    EnumTestWiki wiki({"A", "B", "C", "D", "E"});
+    CBL_ASSERT_EQ(enumAllPages(wiki, ENUM_PIPELINED), "A,B C,D E");
+    CBL_ASSERT_EQ(wiki.client().numSyncRequests(), 1);
+    CBL_ASSERT_EQ(wiki.client().numAsyncRequests(), 2);
+    // The next batch is already requested when the callback stops the enumeration.
+    CBL_ASSERT_EQ(enumAllPages(wiki, ENUM_PIPELINED, 1), "A,B");
+    CBL_ASSERT_EQ(wiki.client().numSyncRequests(), 2);
+    CBL_ASSERT_EQ(wiki.client().numAsyncRequests(), 3);
+    // Background requests follow the delay before requests.
+    wiki.setDelayBeforeRequests(5);
+    CBL_ASSERT_EQ(enumAllPages(wiki, ENUM_PIPELINED), "A,B C,D E");
+    CBL_ASSERT_EQ(wiki.client().numAsyncRequests(), 3);
+  }
+
+  CBL_TEST_CASE(ReadPagesFromGenerator) {
+    EnumTestWiki wiki({"A", "B", "C", "D", "E"});
+    wiki.setAPILimits(3, 3);
+    vector<string> batches;
+    wiki.readPagesFromGenerator({.type = GEN_ALL_PAGES}, RP_REVID, [&](const vector<Revision>& revisions) {
+      vector<string> batch;
+      for (const Revision& revision : revisions) {
+        batch.push_back(revision.title + "=" + std::to_string(revision.revid));
+      }
+      batches.push_back(cbl::join(batch, ","));
+      return true;
+    });
+    // The first batch of pages from the generator (A, B, C) is returned in two requests because of the limit on
+    // revisions.
+    CBL_ASSERT_EQ(cbl::join(batches, " "), "A=100,B=101 C=102 D=103,E=104");
+    CBL_ASSERT_EQ(wiki.client().numSyncRequests(), 3);
+  }
+};
+
+}  // namespace mwc
+
+int main() {
+  mwc::WikiEnumTest().run();
+  return 0;
+}
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <map>
+#include <string>
+#include <string_view>
+#include "cbl/date.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
+#include "cbl/string.h"
+#include "cbl/unittest.h"
+#include "mwclient/tests/fake_api_wiki.h"
+#include "mwclient/wiki.h"
+#include "mwclient/wiki_defs.h"
+
+using cbl::Date;
+using cbl::DateDiff;
+using std::map;
+using std::string;
+using std::string_view;
+
+namespace mwc {
+
+// Answers action=query&prop=revisions requests from an in-memory set of pages. Like MediaWiki, underscores in
+// requested titles are normalized to spaces.
+class PrefetchTestWiki : public FakeAPIWiki {
+public:
+  PrefetchTestWiki() {
+    setAPILimits(BASIC_API_LIMIT, 2);
+    client().setHandler([this](const FakeAPIClient::Params& params) { return answer(params); });
+  }
+  void setPage(const string& title, const string& content) { m_pages[title] = content; }
+
+private:
+  string answer(const FakeAPIClient::Params& params) {
+    CBL_ASSERT_EQ(params.at("prop"), "revisions");
+    json::Value answer;
+    json::Value& pages = answer.getMutable("query").getMutable("pages");
+    int missingPageId = -1;
+    for (string_view requestedTitle : cbl::split(params.at("titles"), '|')) {
+      string title(requestedTitle);
+      std::replace(title.begin(), title.end(), '_', ' ');
+      if (title != requestedTitle) {
+        json::Value& normalization = answer.getMutable("query").getMutable("normalized").addItem();
+        normalization.getMutable("from") = requestedTitle;
+        normalization.getMutable("to") = title;
+      }
+      auto pageIt = m_pages.find(title);
+      json::Value& page = pages.getMutable(pageIt == m_pages.end() ? std::to_string(missingPageId--)
+                                                                   : std::to_string(m_revid));
+      page.getMutable("title") = title;
+      if (pageIt == m_pages.end()) {
+        page.getMutable("missing") = "";
+      } else {
+        json::Value& revision = page.getMutable("revisions").addItem();
+        revision.getMutable("revid") = m_revid++;
+        revision.getMutable("slots").getMutable("main").getMutable("*") = pageIt->second;
+      }
+    }
+    return answer.toJSON();
+  }
+
+  map<string, string> m_pages;
+  int m_revid = 100;
+};
+
+class WikiPrefetchTest : public cbl::Test {
+private:
+  void setUp() override { Date::setFrozenValueOfNow(Date::fromISO8601("2020-01-01T00:00:00Z")); }
+
+  CBL_TEST_CASE(ReadPrefetchedPages) {
+    PrefetchTestWiki wiki;
+    FakeAPIClient& client = wiki.client();
+    wiki.setPage("A", "Content of A");
+    wiki.setPage("B", "Content of B");
+    wiki.setPage("C", "Content of C");
+    wiki.prefetchPages({"A", "B", "C", "Missing", "A"}, RP_CONTENT);
+    CBL_ASSERT_EQ(client.numAsyncRequests(), 2);
+    CBL_ASSERT_EQ(wiki.readPageContent("C"), "Content of C");
+    CBL_ASSERT_EQ(wiki.readPageContent("A"), "Content of A");
+    WriteToken writeToken;
+    CBL_ASSERT_EQ(wiki.readPageContent("B", &writeToken), "Content of B");
+    CBL_ASSERT_EQ(writeToken.revid(), 101);
+    CBL_ASSERT_EQ(wiki.readPageContentIfExists("Missing"), "");
+    CBL_ASSERT_EQ(client.numSyncRequests(), 0);
+
+    // Properties that were not prefetched.
+    wiki.readPage("A", RP_USER);
+    CBL_ASSERT_EQ(client.numSyncRequests(), 1);
+    // Pages that were not prefetched.
+    CBL_ASSERT_EQ(wiki.readPageContentIfExists("D"), "");
+    CBL_ASSERT_EQ(client.numSyncRequests(), 2);
+    // Pages already prefetched are not requested again.
+    wiki.prefetchPages({"A", "B"}, RP_CONTENT);
+    CBL_ASSERT_EQ(client.numAsyncRequests(), 2);
+  }
+
+  CBL_TEST_CASE(Titles) {
+    PrefetchTestWiki wiki;
+    FakeAPIClient& client = wiki.client();
+    wiki.setPage("Foo bar", "Content of Foo bar");
+    wiki.setPage("A", "Content of A");
+    wiki.prefetchPages({"Foo_bar", "A", "Missing_page"}, RP_CONTENT);
+    CBL_ASSERT_EQ(client.numAsyncRequests(), 2);
+    // Pages are found with the title passed to prefetchPages and the revision contains the normalized title, like
+    // when reading the page directly.
+    Revision revision = wiki.readPage("Foo_bar", RP_CONTENT | RP_TITLE);
+    CBL_ASSERT_EQ(revision.title, "Foo bar");
+    CBL_ASSERT_EQ(revision.content, "Content of Foo bar");
+    CBL_ASSERT_EQ(wiki.readPage("A", RP_CONTENT | RP_TITLE).title, "A");
+    CBL_ASSERT_EQ(wiki.readPage("A", RP_CONTENT).title, "");
+    try {
+      wiki.readPage("Missing_page", RP_CONTENT);
+      CBL_ASSERT(false) << "PageNotFoundError not thrown";
+    } catch (const PageNotFoundError&) {
+    }
+    CBL_ASSERT_EQ(client.numSyncRequests(), 0);
+    // The normalized title was not requested, so it is read from the wiki.
+    CBL_ASSERT_EQ(wiki.readPage("Foo bar", RP_CONTENT | RP_TITLE).title, "Foo bar");
+    CBL_ASSERT_EQ(client.numSyncRequests(), 1);
+  }
+
+  CBL_TEST_CASE(Invalidation) {
+    PrefetchTestWiki wiki;
+    FakeAPIClient& client = wiki.client();
+    wiki.setPage("A", "Old A");
+    wiki.setPage("B", "Old B");
+    wiki.setPage("C", "Old C");
+    wiki.prefetchPages({"A", "B", "C"}, RP_CONTENT);
+    wiki.setPage("A", "New A");
+    wiki.setPage("B", "New B");
+    wiki.setPage("C", "New C");
+    // Invalidated after the end of the batch.
+    CBL_ASSERT_EQ(wiki.readPageContent("A"), "Old A");
+    wiki.invalidateCachedPages({"a"});
+    CBL_ASSERT_EQ(wiki.readPageContent("A"), "New A");
+    // Invalidated before the end of the batch.
+    wiki.invalidateCachedPages({"C"});
+    CBL_ASSERT_EQ(wiki.readPageContent("C"), "New C");
+    CBL_ASSERT_EQ(client.numSyncRequests(), 2);
+
+    // Old content can be returned, unless the caller intends to edit the page and the content is too old.
+    Date::advanceFrozenClock(wiki.prefetchFreshness() + DateDiff::fromSeconds(1));
+    CBL_ASSERT_EQ(wiki.readPageContent("B"), "Old B");
+    WriteToken writeToken;
+    CBL_ASSERT_EQ(wiki.readPageContent("B", &writeToken), "New B");
+    CBL_ASSERT_EQ(client.numSyncRequests(), 3);
+
+    wiki.prefetchPages({"A"}, RP_CONTENT);
+    wiki.clearPrefetchedPages();
+    CBL_ASSERT_EQ(wiki.readPageContent("A"), "New A");
+    CBL_ASSERT_EQ(client.numSyncRequests(), 4);
+  }
+
+  CBL_TEST_CASE(DelayBeforeRequests) {
+    PrefetchTestWiki wiki;
+    wiki.setDelayBeforeRequests(5);
+    FakeAPIClient& client = wiki.client();
+    for (const char* title : {"A", "B", "C", "D", "E"}) {
+      wiki.setPage(title, string("Content of ") + title);
+    }
+    wiki.prefetchPages({"A", "B", "C", "D", "E"}, RP_CONTENT);
+    // Only the first batch can be sent immediately.
+    CBL_ASSERT_EQ(client.numAsyncRequests(), 1);
+    CBL_ASSERT_EQ(wiki.readPageContent("D"), "Content of D");
+    CBL_ASSERT_EQ(wiki.readPageContent("C"), "Content of C");
+    CBL_ASSERT_EQ(wiki.readPageContent("A"), "Content of A");
+    CBL_ASSERT_EQ(client.numSyncRequests(), 1);
+  }
+
+  CBL_TEST_CASE(ServerLag) {
+    PrefetchTestWiki wiki;
+    FakeAPIClient& client = wiki.client();
+    wiki.setPage("A", "Content of A");
+    client.addAnswer(R"({"error": {"code": "maxlag", "info": "Waiting for a server: 6 seconds lagged"}})");
+    wiki.prefetchPages({"A"}, RP_CONTENT);
+    CBL_ASSERT_EQ(client.numAsyncRequests(), 1);
+    // The failed background request is sent again like any other request.
+    CBL_ASSERT_EQ(wiki.readPageContent("A"), "Content of A");
+    CBL_ASSERT_EQ(client.numSyncRequests(), 1);
+    const RequestMetrics::ModuleMetrics& metrics = wiki.requestMetrics().modules().at("query+revisions");
+    CBL_ASSERT_EQ(metrics.requests, 2);
+    CBL_ASSERT_EQ(metrics.maxLagErrors, 1);
+  }
+};
+
+}  // namespace mwc
+
+int main() {
+  mwc::WikiPrefetchTest().run();
+  return 0;
+}
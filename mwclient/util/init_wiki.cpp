@@ -1,6 +1,8 @@
 #include "init_wiki.h"
 #include <climits>
+#include <cstdint>
 #include <cstdlib>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -9,7 +11,10 @@
 #include "cbl/log.h"
 #include "cbl/path.h"
 #include "cbl/string.h"
+#include "mwclient/request_metrics.h"
+#include "mwclient/revision_store.h"
 #include "mwclient/wiki.h"
+#include "replay_http_client.h"
 
 using std::string;
 using std::string_view;
@@ -17,6 +22,19 @@ using std::string_view;
 namespace mwc {
 
 constexpr const char* MWCLIENT_ID_DIR_VARIABLE = "LIBMWCLIENT_ID_DIR";
+// See replay_http_client.h.
+constexpr const char* RECORD_FILE_VARIABLE = "MWCLIENT_RECORD_FILE";
+constexpr const char* REPLAY_FILE_VARIABLE = "MWCLIENT_REPLAY_FILE";
+constexpr const char* REPLAY_LATENCY_MS_VARIABLE = "MWCLIENT_REPLAY_LATENCY_MS";
+constexpr const char* REPLAY_STATS_FILE_VARIABLE = "MWCLIENT_REPLAY_STATS_FILE";
+// See request_metrics.h.
+constexpr const char* METRICS_JSON_FILE_VARIABLE = "MWCLIENT_METRICS_JSON_FILE";
+constexpr const char* METRICS_PROMETHEUS_FILE_VARIABLE = "MWCLIENT_METRICS_PROMETHEUS_FILE";
+
+static string getEnvVariable(const char* name) {
+  const char* value = getenv(name);
+  return value ? value : "";
+}
 
 static const char* getLoginFileFromConfig(StandardWikiConfig config) {
   switch (config) {
@@ -97,6 +115,8 @@ void initWikiFromFlags(const WikiFlags& flags, Wiki& wiki) {
   }
 
   LoginParams loginParams;
+  string revisionStorePath;
+  RevisionStoreParams revisionStoreParams;
   string loginFileContent = cbl::readFile(resolvedLoginFile);
   for (string_view line : cbl::splitLines(loginFileContent)) {
     size_t equalPosition = line.find('=');
@@ -133,11 +153,42 @@ void initWikiFromFlags(const WikiFlags& flags, Wiki& wiki) {
       if (loginParams.maxLag == -1) {
         throw LoginConfigParseError("Cannot parse 'maxLag' param in '" + resolvedLoginFile + "'");
       }
+    } else if (param == "revisionStore") {
+      revisionStorePath = value;
+    } else if (param == "revisionStoreMaxSizeMB") {
+      int maxSizeMB = cbl::parseIntInRange(cbl::legacyStringConv(value), 0, INT_MAX, -1);
+      if (maxSizeMB == -1) {
+        throw LoginConfigParseError("Cannot parse 'revisionStoreMaxSizeMB' param in '" + resolvedLoginFile + "'");
+      }
+      revisionStoreParams.maxSize = static_cast<int64_t>(maxSizeMB) << 20;
     } else {
       throw LoginConfigParseError("Invalid parameter '" + string(param) + "' in '" + resolvedLoginFile + "'");
     }
   }
 
+  string recordFile = getEnvVariable(RECORD_FILE_VARIABLE);
+  string replayFile = getEnvVariable(REPLAY_FILE_VARIABLE);
+  if (!replayFile.empty()) {
+    int latencyMs = cbl::parseIntInRange(getEnvVariable(REPLAY_LATENCY_MS_VARIABLE), 0, INT_MAX, 0);
+    auto replayClient = std::make_unique<ReplayHTTPClient>(replayFile, latencyMs);
+    replayClient->setStatsFile(getEnvVariable(REPLAY_STATS_FILE_VARIABLE));
+    wiki.setHTTPClient(std::move(replayClient));
+    // Delays are only useful to protect the real server.
+    wiki.setDelayBeforeRequests(0);
+    wiki.setDelayBetweenEdits(0);
+  } else if (!recordFile.empty()) {
+    wiki.setHTTPClient(std::make_unique<RecordingHTTPClient>(recordFile));
+  }
+  string metricsJSONFile = getEnvVariable(METRICS_JSON_FILE_VARIABLE);
+  string metricsPrometheusFile = getEnvVariable(METRICS_PROMETHEUS_FILE_VARIABLE);
+  if (!metricsJSONFile.empty()) {
+    wiki.setRequestMetricsSink(std::make_unique<JSONFileMetricsSink>(metricsJSONFile));
+  } else if (!metricsPrometheusFile.empty()) {
+    wiki.setRequestMetricsSink(std::make_unique<PrometheusTextfileMetricsSink>(metricsPrometheusFile));
+  }
+  if (!revisionStorePath.empty()) {
+    wiki.setRevisionStore(std::make_unique<RevisionStore>(revisionStorePath, revisionStoreParams));
+  }
   wiki.logIn(loginParams, resolvedSessionFile);
 }
 
@@ -10,6 +10,14 @@
 //   userAgent=UserNameOnWiki (http://en.wikipedia.org/wiki/User:UserNameOnWiki)
 //   delayBeforeRequests=1
 //
+// Two additional parameters enable the revision store of the Wiki object (see mwclient/revision_store.h):
+//   revisionStore=/path/to/revisions.sqlite
+//   revisionStoreMaxSizeMB=1024
+//
+// The environment variables MWCLIENT_RECORD_FILE and MWCLIENT_REPLAY_FILE record the HTTP traffic of the Wiki object or
+// replay a previous recording (see mwclient/util/replay_http_client.h). MWCLIENT_METRICS_JSON_FILE or
+// MWCLIENT_METRICS_PROMETHEUS_FILE write request metrics at the end of the program (see mwclient/request_metrics.h).
+//
 // Typical use:
 //   mwc::WikiFlags wikiFlags(mwc::FRENCH_WIKIPEDIA_BOT);
 //   cbl::parseArgs(argc, argv, &wikiFlags, /* more command line flags if needed */);
@@ -0,0 +1,397 @@
+#include "replay_http_client.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "cbl/date.h"
+#include "cbl/error.h"
+#include "cbl/file.h"
+#include "cbl/http_client.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
+#include "cbl/string.h"
+
+using cbl::Date;
+using cbl::DateDiff;
+using std::map;
+using std::set;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace mwc {
+
+static bool isSecretParam(string_view name) {
+  return name == "lgpassword" || name == "password" || name.ends_with("token");
+}
+
+// Parameters whose value is a list of items that can be sent in any order.
+static bool isUnorderedListParam(string_view name) {
+  return name == "titles" || name == "pageids" || name == "revids";
+}
+
+// Normalizes URL-encoded parameters ("a=1&b=2"), so that requests that differ only by the order of their parameters
+// have the same key and secrets are not written to recordings.
+static string normalizeParams(string_view params) {
+  vector<string> normalizedParams;
+  for (string_view param : cbl::split(params, '&')) {
+    if (param.empty()) continue;
+    size_t equalPosition = param.find('=');
+    string_view name = param.substr(0, equalPosition);
+    if (equalPosition == string_view::npos) {
+      normalizedParams.emplace_back(name);
+    } else if (isSecretParam(name)) {
+      normalizedParams.push_back(cbl::concat(name, "=REDACTED"));
+    } else if (isUnorderedListParam(name)) {
+      string value = cbl::decodeURIComponent(param.substr(equalPosition + 1));
+      vector<string_view> items = cbl::splitAsVector(value, '|');
+      std::sort(items.begin(), items.end());
+      normalizedParams.push_back(cbl::concat(name, "=", cbl::encodeURIComponent(cbl::join(items, "|"))));
+    } else {
+      normalizedParams.emplace_back(param);
+    }
+  }
+  std::sort(normalizedParams.begin(), normalizedParams.end());
+  return cbl::join(normalizedParams, "&");
+}
+
+static string normalizeURL(string_view url) {
+  size_t questionMarkPosition = url.find('?');
+  if (questionMarkPosition == string_view::npos) {
+    return string(url);
+  }
+  return cbl::concat(url.substr(0, questionMarkPosition + 1), normalizeParams(url.substr(questionMarkPosition + 1)));
+}
+
+static string getRequestKey(string_view method, string_view url, string_view data) {
+  return cbl::concat(method, "\n", normalizeURL(url), "\n", normalizeParams(data));
+}
+
+// Parses a request that reads the last revision of pages by title (action=query&prop=revisions&titles=...).
+// `otherParamsKey` is set to a string that identifies the URL and all parameters except "titles" and "rvprop", so that
+// GET and POST requests have the same key. Returns false if the request has another form.
+static bool parsePagesQuery(string_view url, string_view data, string& otherParamsKey, vector<string>& titles,
+                            vector<string>& revisionProps) {
+  size_t questionMarkPosition = url.find('?');
+  string_view urlParams = questionMarkPosition == string_view::npos ? "" : url.substr(questionMarkPosition + 1);
+  map<string, string> params;
+  for (string_view encodedParams : {urlParams, data}) {
+    for (string_view param : cbl::split(encodedParams, '&')) {
+      if (param.empty()) continue;
+      size_t equalPosition = param.find('=');
+      string_view name = param.substr(0, equalPosition);
+      if (name.ends_with("continue")) {
+        // Continuation of a request that may have returned partial pages.
+        return false;
+      }
+      params[string(name)] =
+          equalPosition == string_view::npos ? "" : cbl::decodeURIComponent(param.substr(equalPosition + 1));
+    }
+  }
+  auto titlesIt = params.find("titles");
+  if (params["action"] != "query" || params["prop"] != "revisions" || titlesIt == params.end() ||
+      params.count("generator") != 0 || params.count("list") != 0 || params.count("rvlimit") != 0) {
+    return false;
+  }
+  titles.clear();
+  for (string_view title : cbl::split(titlesIt->second, '|')) {
+    titles.emplace_back(title);
+  }
+  revisionProps.clear();
+  for (string_view prop : cbl::split(params["rvprop"], '|')) {
+    revisionProps.emplace_back(prop);
+  }
+  std::sort(revisionProps.begin(), revisionProps.end());
+  otherParamsKey = url.substr(0, questionMarkPosition);
+  for (const auto& [name, value] : params) {
+    if (name != "titles" && name != "rvprop") {
+      cbl::append(otherParamsKey, "&", name, "=", value);
+    }
+  }
+  return true;
+}
+
+static std::future<string> makeReadyFuture(string value) {
+  std::promise<string> promise;
+  promise.set_value(std::move(value));
+  return promise.get_future();
+}
+
+RecordingHTTPClient::RecordingHTTPClient(const string& path) : m_stream(path) {
+  if (!m_stream) {
+    throw cbl::SystemError("Cannot open '" + path + "' for writing");
+  }
+  json::Value header;
+  header.getMutable("start") = Date::now().toISO8601();
+  m_stream << header.toJSON() << "\n";
+}
+
+string RecordingHTTPClient::get(const string& url) {
+  string response = HTTPClient::get(url);
+  record("GET", url, "", response);
+  return response;
+}
+
+string RecordingHTTPClient::post(const string& url, const string& data) {
+  string response = HTTPClient::post(url, data);
+  record("POST", url, data, response);
+  return response;
+}
+
+void RecordingHTTPClient::getStreamed(const string& url, const DataCallback& onData) {
+  string response;
+  HTTPClient::getStreamed(url, [&](string_view chunk) {
+    response += chunk;
+    onData(chunk);
+  });
+  record("GET", url, "", response);
+}
+
+void RecordingHTTPClient::postStreamed(const string& url, const string& data, const DataCallback& onData) {
+  string response;
+  HTTPClient::postStreamed(url, data, [&](string_view chunk) {
+    response += chunk;
+    onData(chunk);
+  });
+  record("POST", url, data, response);
+}
+
+std::future<string> RecordingHTTPClient::getAsync(const string& url) {
+  return makeReadyFuture(get(url));
+}
+
+std::future<string> RecordingHTTPClient::postAsync(const string& url, const string& data) {
+  return makeReadyFuture(post(url, data));
+}
+
+void RecordingHTTPClient::record(string_view method, const string& url, const string& data, const string& response) {
+  json::Value entry;
+  entry.getMutable("method") = method;
+  entry.getMutable("url") = normalizeURL(url);
+  entry.getMutable("data") = normalizeParams(data);
+  entry.getMutable("response") = response;
+  m_stream << entry.toJSON() << "\n";
+  m_stream.flush();
+}
+
+json::Value ReplayStats::toJSON() const {
+  json::Value value;
+  value.getMutable("numRequests") = numRequests;
+  value.getMutable("numMissingRequests") = numMissingRequests;
+  value.getMutable("numAssembledRequests") = numAssembledRequests;
+  value.getMutable("bytesSent") = bytesSent;
+  value.getMutable("bytesReceived") = bytesReceived;
+  value.getMutable("simulatedLatencyMs") = simulatedLatencyMs;
+  return value;
+}
+
+ReplayHTTPClient::ReplayHTTPClient(const string& recordingPath, int latencyMs) : m_latencyMs(latencyMs) {
+  string recording = cbl::readFile(recordingPath);
+  bool firstLine = true;
+  for (string_view line : cbl::splitLines(recording)) {
+    if (line.empty()) continue;
+    json::Value entry = json::parse(line);
+    if (firstLine) {
+      Date::setFrozenValueOfNow(Date::fromISO8601(entry["start"].str()));
+      firstLine = false;
+      continue;
+    }
+    m_responsesByRequest[getRequestKey(entry["method"].str(), entry["url"].str(), entry["data"].str())]
+        .responses.push_back(entry["response"].str());
+    indexRecordedPages(entry["url"].str(), entry["data"].str(), entry["response"].str());
+  }
+}
+
+ReplayHTTPClient::~ReplayHTTPClient() {
+  if (!m_statsFile.empty()) {
+    try {
+      cbl::writeFile(m_statsFile, stats().toJSON().toJSON() + "\n");
+    } catch (const cbl::SystemError& error) {
+      CBL_ERROR << error.what();
+    }
+  }
+}
+
+ReplayStats ReplayHTTPClient::stats() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+string ReplayHTTPClient::get(const string& url) {
+  simulateLatency();
+  return findResponse("GET", url, "");
+}
+
+string ReplayHTTPClient::post(const string& url, const string& data) {
+  simulateLatency();
+  return findResponse("POST", url, data);
+}
+
+void ReplayHTTPClient::getStreamed(const string& url, const DataCallback& onData) {
+  onData(get(url));
+}
+
+void ReplayHTTPClient::postStreamed(const string& url, const string& data, const DataCallback& onData) {
+  onData(post(url, data));
+}
+
+std::future<string> ReplayHTTPClient::getAsync(const string& url) {
+  return std::async(std::launch::async, [this, url]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(m_latencyMs));
+    return findResponse("GET", url, "");
+  });
+}
+
+std::future<string> ReplayHTTPClient::postAsync(const string& url, const string& data) {
+  return std::async(std::launch::async, [this, url, data]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(m_latencyMs));
+    return findResponse("POST", url, data);
+  });
+}
+
+void ReplayHTTPClient::indexRecordedPages(const string& url, const string& data, const string& response) {
+  string otherParamsKey;
+  vector<string> titles;
+  vector<string> revisionProps;
+  if (!parsePagesQuery(url, data, otherParamsKey, titles, revisionProps)) {
+    return;
+  }
+  json::Value answer;
+  try {
+    answer = json::parse(response);
+  } catch (const cbl::ParseError&) {
+    return;
+  }
+  if (answer.has("error")) {
+    return;
+  }
+  const json::Value& query = answer["query"];
+  map<string, string> normalizedTitles;
+  for (const json::Value& normalization : query["normalized"].array()) {
+    normalizedTitles[normalization["from"].str()] = normalization["to"].str();
+  }
+  map<string, const json::Value*> redirects;
+  for (const json::Value& redirect : query["redirects"].array()) {
+    redirects[redirect["from"].str()] = &redirect;
+  }
+  map<string, const std::pair<const string, json::Value>*> pagesByTitle;
+  for (const std::pair<const string, json::Value>& keyAndPage : query["pages"].object()) {
+    pagesByTitle[keyAndPage.second["title"].str()] = &keyAndPage;
+  }
+
+  for (const string& title : titles) {
+    RecordedPage recordedPage;
+    string resolvedTitle = title;
+    if (auto normalizationIt = normalizedTitles.find(title); normalizationIt != normalizedTitles.end()) {
+      recordedPage.normalizedTitle = normalizationIt->second;
+      resolvedTitle = normalizationIt->second;
+    }
+    if (auto redirectIt = redirects.find(resolvedTitle); redirectIt != redirects.end()) {
+      recordedPage.redirect = redirectIt->second->copy();
+      resolvedTitle = recordedPage.redirect["to"].str();
+    }
+    auto pageIt = pagesByTitle.find(resolvedTitle);
+    if (pageIt == pagesByTitle.end()) continue;
+    const json::Value& page = pageIt->second->second;
+    // In responses with a continuation, some pages may not have their revision yet.
+    if (!page.has("missing") && !page.has("invalid") && !page.has("revisions")) continue;
+    recordedPage.pageKey = pageIt->second->first;
+    recordedPage.page = page.copy();
+    recordedPage.revisionProps = revisionProps;
+    m_recordedPages[cbl::concat(otherParamsKey, "\n", title)].push_back(std::move(recordedPage));
+  }
+}
+
+bool ReplayHTTPClient::assemblePagesResponse(const string& url, const string& data, string& response) const {
+  string otherParamsKey;
+  vector<string> titles;
+  vector<string> revisionProps;
+  if (!parsePagesQuery(url, data, otherParamsKey, titles, revisionProps)) {
+    return false;
+  }
+  json::Value answer;
+  answer.getMutable("batchcomplete") = "";
+  json::Value& query = answer.getMutable("query");
+  json::Value& pages = query.getMutable("pages");
+  set<string> processedTitles;
+  set<string> redirectSources;
+  set<string> pageTitles;
+  int missingPageKey = -1;
+  for (const string& title : titles) {
+    if (!processedTitles.insert(title).second) continue;
+    auto recordedPagesIt = m_recordedPages.find(cbl::concat(otherParamsKey, "\n", title));
+    if (recordedPagesIt == m_recordedPages.end()) {
+      return false;
+    }
+    // Like for exact matches, the first recorded version of the page is preferred.
+    const vector<RecordedPage>& recordedPages = recordedPagesIt->second;
+    auto recordedPageIt = std::find_if(recordedPages.begin(), recordedPages.end(), [&](const RecordedPage& page) {
+      return std::includes(page.revisionProps.begin(), page.revisionProps.end(), revisionProps.begin(),
+                           revisionProps.end());
+    });
+    if (recordedPageIt == recordedPages.end()) {
+      return false;
+    }
+    const RecordedPage& recordedPage = *recordedPageIt;
+    if (!recordedPage.normalizedTitle.empty()) {
+      json::Value& normalization = query.getMutable("normalized").addItem();
+      normalization.getMutable("from") = title;
+      normalization.getMutable("to") = recordedPage.normalizedTitle;
+    }
+    if (!recordedPage.redirect.isNull() && redirectSources.insert(recordedPage.redirect["from"].str()).second) {
+      query.getMutable("redirects").addItem() = recordedPage.redirect.copy();
+    }
+    if (pageTitles.insert(recordedPage.page["title"].str()).second) {
+      // Keys of missing pages are negative numbers that must be unique in the response.
+      string pageKey =
+          recordedPage.pageKey.starts_with("-") ? std::to_string(missingPageKey--) : recordedPage.pageKey;
+      pages.getMutable(pageKey) = recordedPage.page.copy();
+    }
+  }
+  response = answer.toJSON();
+  return true;
+}
+
+string ReplayHTTPClient::findResponse(string_view method, const string& url, const string& data) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats.numRequests++;
+  m_stats.bytesSent += url.size() + data.size();
+  m_stats.simulatedLatencyMs += m_latencyMs;
+  auto responsesIt = m_responsesByRequest.find(getRequestKey(method, url, data));
+  if (responsesIt == m_responsesByRequest.end()) {
+    string response;
+    if (assemblePagesResponse(url, data, response)) {
+      m_stats.numAssembledRequests++;
+      m_stats.bytesReceived += response.size();
+      return response;
+    }
+    m_stats.numMissingRequests++;
+    throw cbl::PageNotInCacheError(cbl::concat("Request not found in the recording: ", method, " ", url, " ", data));
+  }
+  RecordedResponses& recordedResponses = responsesIt->second;
+  const string& response = recordedResponses.responses[recordedResponses.nextIndex];
+  if (recordedResponses.nextIndex + 1 < recordedResponses.responses.size()) {
+    recordedResponses.nextIndex++;
+  }
+  m_stats.bytesReceived += response.size();
+  return response;
+}
+
+void ReplayHTTPClient::simulateLatency() {
+  std::this_thread::sleep_for(std::chrono::milliseconds(m_latencyMs));
+  m_pendingClockAdvanceMs += m_latencyMs;
+  if (m_pendingClockAdvanceMs >= 1000) {
+    Date::advanceFrozenClock(DateDiff::fromSeconds(m_pendingClockAdvanceMs / 1000));
+    m_pendingClockAdvanceMs %= 1000;
+  }
+}
+
+}  // namespace mwc
@@ -0,0 +1,137 @@
+// Recording and replay of the HTTP traffic of a whole bot run, to measure the effect of changes to a bot or to mwclient
+// offline.
+// Usage:
+//   1. Run the bot with the environment variable MWCLIENT_RECORD_FILE=/tmp/session.jsonl. initWikiFromFlags() then
+//      installs a RecordingHTTPClient. The bot works normally and all its exchanges with the wiki are written to the
+//      file.
+//   2. Run the bot through mwclient/tests/replay_benchmark:
+//        replay_benchmark --recording=/tmp/session.jsonl --latency-ms=100 -- ./lost_messages --dryrun ...
+//      The bot is started with MWCLIENT_REPLAY_FILE set, so that initWikiFromFlags() installs a ReplayHTTPClient that
+//      serves responses from the recording without any network access. replay_benchmark then reports the number of
+//      requests, the bytes transferred, the CPU time and the wall time of the run.
+// Responses are matched on the method, URL parameters and POST parameters of requests, not on the order of requests.
+// Parameters are compared regardless of their order, as well as the items of "titles", "pageids" and "revids".
+// Therefore, a version of the bot that sends fewer requests or sends them in a different order can be replayed, as long
+// as it sends the same requests. Requests that read the last revision of pages by title (action=query&prop=revisions
+// &titles=...) can also batch pages differently (e.g. because of prefetching or a different batch size): the response
+// is then assembled from the pages found in any recorded response to such a request, with the same other parameters
+// and at least the requested "rvprop" fields. A request that is not in the recording throws PageNotInCacheError.
+// Passwords and tokens are replaced with "REDACTED" in the recording and ignored when matching requests. Responses are
+// recorded as is.
+// During replay, the clock is frozen at the start time of the recording and only advanced by the simulated latency, so
+// that parameters computed from the current time (e.g. the start of a list of recent changes) match the recording.
+#ifndef MWC_UTIL_REPLAY_HTTP_CLIENT_H
+#define MWC_UTIL_REPLAY_HTTP_CLIENT_H
+
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "cbl/http_client.h"
+#include "cbl/json.h"
+
+namespace mwc {
+
+// Writes all requests and responses to a file, one JSON object per line. The first line contains the start time of
+// the recording.
+// Asynchronous requests are run synchronously, so that the recording has a well-defined order.
+class RecordingHTTPClient : public cbl::HTTPClient {
+public:
+  // Creates or truncates `path`.
+  // Throws: SystemError.
+  explicit RecordingHTTPClient(const std::string& path);
+
+  std::string get(const std::string& url) override;
+  std::string post(const std::string& url, const std::string& data) override;
+  void getStreamed(const std::string& url, const DataCallback& onData) override;
+  void postStreamed(const std::string& url, const std::string& data, const DataCallback& onData) override;
+  std::future<std::string> getAsync(const std::string& url) override;
+  std::future<std::string> postAsync(const std::string& url, const std::string& data) override;
+
+private:
+  void record(std::string_view method, const std::string& url, const std::string& data, const std::string& response);
+
+  std::ofstream m_stream;
+};
+
+struct ReplayStats {
+  int64_t numRequests = 0;
+  // Requests that were not in the recording.
+  int64_t numMissingRequests = 0;
+  // Requests answered by assembling pages from several recorded responses.
+  int64_t numAssembledRequests = 0;
+  // Size of URLs and POST data.
+  int64_t bytesSent = 0;
+  int64_t bytesReceived = 0;
+  int64_t simulatedLatencyMs = 0;
+
+  json::Value toJSON() const;
+};
+
+// Serves responses from a file written by RecordingHTTPClient.
+class ReplayHTTPClient : public cbl::HTTPClient {
+public:
+  // Loads the recording and freezes the clock at its start time. `latencyMs` is waited before returning each response.
+  // Asynchronous requests wait in parallel, like real requests.
+  // Throws: FileNotFoundError, ParseError.
+  ReplayHTTPClient(const std::string& recordingPath, int latencyMs);
+  // Writes the stats to the file set by setStatsFile(), if any.
+  ~ReplayHTTPClient() override;
+
+  void setStatsFile(const std::string& path) { m_statsFile = path; }
+  ReplayStats stats();
+
+  std::string get(const std::string& url) override;
+  std::string post(const std::string& url, const std::string& data) override;
+  void getStreamed(const std::string& url, const DataCallback& onData) override;
+  void postStreamed(const std::string& url, const std::string& data, const DataCallback& onData) override;
+  std::future<std::string> getAsync(const std::string& url) override;
+  std::future<std::string> postAsync(const std::string& url, const std::string& data) override;
+
+private:
+  struct RecordedResponses {
+    std::vector<std::string> responses;
+    // Index of the next response to return. If a request is sent more times than in the recording, the last response
+    // is returned again.
+    size_t nextIndex = 0;
+  };
+
+  // Page extracted from a recorded response to action=query&prop=revisions&titles=..., indexed by requested title.
+  struct RecordedPage {
+    // Title after normalization, if different from the requested title.
+    std::string normalizedTitle;
+    // Item of query.redirects for the normalized title, if the request followed redirects and the page is one.
+    json::Value redirect;
+    std::string pageKey;
+    json::Value page;
+    // Sorted items of the "rvprop" parameter of the request.
+    std::vector<std::string> revisionProps;
+  };
+
+  void indexRecordedPages(const std::string& url, const std::string& data, const std::string& response);
+  // Builds the response to action=query&prop=revisions&titles=... from recorded pages. Returns false if the request
+  // has another form or if some title is not in the recording.
+  bool assemblePagesResponse(const std::string& url, const std::string& data, std::string& response) const;
+  // Returns the response to a request, without waiting or changing the clock. Thread-safe.
+  std::string findResponse(std::string_view method, const std::string& url, const std::string& data);
+  // Waits for the simulated latency and moves the frozen clock forward.
+  void simulateLatency();
+
+  int m_latencyMs;
+  std::string m_statsFile;
+  std::mutex m_mutex;
+  std::unordered_map<std::string, RecordedResponses> m_responsesByRequest;
+  // Key: other parameters of the request + "\n" + requested title.
+  std::unordered_map<std::string, std::vector<RecordedPage>> m_recordedPages;
+  ReplayStats m_stats;
+  // Simulated latency not yet added to the frozen clock, which has a granularity of one second.
+  int64_t m_pendingClockAdvanceMs = 0;
+};
+
+}  // namespace mwc
+
+#endif
@@ -0,0 +1,150 @@
+#include "replay_http_client.h"
+#include <string>
+#include "cbl/date.h"
+#include "cbl/file.h"
+#include "cbl/http_client.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
+#include "cbl/tempfile.h"
+#include "cbl/unittest.h"
+
+using cbl::Date;
+using std::string;
+
+namespace mwc {
+
+class ReplayHTTPClientTest : public cbl::Test {
+private:
+  CBL_TEST_CASE(Replay) {
+    cbl::TempDir tempDir;
+    string recordingFile = tempDir.path() + "/recording.jsonl";
+    cbl::writeFile(recordingFile,
+                   R"({"start":"2020-01-01T00:00:00Z"})"
+                   "\n"
+                   R"({"method":"GET","url":"https://a.test/?x=1","data":"","response":"first"})"
+                   "\n"
+                   R"({"method":"POST","url":"https://a.test/","data":"y=2","response":"post"})"
+                   "\n"
+                   R"({"method":"GET","url":"https://a.test/?x=1","data":"","response":"second"})"
+                   "\n");
+    string statsFile = tempDir.path() + "/stats.json";
+    {
+      ReplayHTTPClient client(recordingFile, 500);
+      client.setStatsFile(statsFile);
+      CBL_ASSERT_EQ(Date::now(), Date::fromISO8601("2020-01-01T00:00:00Z"));
+      // Requests are matched by content, not by order.
+      CBL_ASSERT_EQ(client.post("https://a.test/", "y=2"), "post");
+      CBL_ASSERT_EQ(client.get("https://a.test/?x=1"), "first");
+      CBL_ASSERT_EQ(client.getAsync("https://a.test/?x=1").get(), "second");
+      // The last response is reused if a request is sent more times than in the recording.
+      CBL_ASSERT_EQ(client.get("https://a.test/?x=1"), "second");
+      try {
+        client.get("https://a.test/?x=2");
+        CBL_ASSERT(false) << "PageNotInCacheError not thrown";
+      } catch (const cbl::PageNotInCacheError&) {
+      }
+      // Only synchronous requests move the clock.
+      CBL_ASSERT_EQ(Date::now(), Date::fromISO8601("2020-01-01T00:00:02Z"));
+
+      ReplayStats stats = client.stats();
+      CBL_ASSERT_EQ(stats.numRequests, 5);
+      CBL_ASSERT_EQ(stats.numMissingRequests, 1);
+      CBL_ASSERT_EQ(stats.bytesReceived, 21);
+      CBL_ASSERT_EQ(stats.simulatedLatencyMs, 2500);
+    }
+    json::Value stats = json::parse(cbl::readFile(statsFile));
+    CBL_ASSERT_EQ(stats["numRequests"].numberAsInt64(), 5);
+  }
+
+  CBL_TEST_CASE(RequestNormalization) {
+    cbl::TempDir tempDir;
+    string recordingFile = tempDir.path() + "/recording.jsonl";
+    cbl::writeFile(recordingFile,
+                   R"({"start":"2020-01-01T00:00:00Z"})"
+                   "\n"
+                   R"({"method":"GET","url":"https://a.test/?action=query&titles=A%7CB%7CC","data":"",)"
+                   R"("response":"pages"})"
+                   "\n"
+                   R"({"method":"POST","url":"https://a.test/","data":"action=edit&title=A&token=REDACTED",)"
+                   R"("response":"edit"})"
+                   "\n");
+    ReplayHTTPClient client(recordingFile, 0);
+    // Parameters and titles can be in any order.
+    CBL_ASSERT_EQ(client.get("https://a.test/?titles=C%7CA%7CB&action=query"), "pages");
+    // Tokens are ignored.
+    CBL_ASSERT_EQ(client.post("https://a.test/", "title=A&action=edit&token=abc%2B%5C"), "edit");
+    // Different batches are not matched if the request does not read revisions.
+    try {
+      client.get("https://a.test/?action=query&titles=A%7CB");
+      CBL_ASSERT(false) << "PageNotInCacheError not thrown";
+    } catch (const cbl::PageNotInCacheError&) {
+    }
+  }
+
+  CBL_TEST_CASE(AssembledPages) {
+    cbl::TempDir tempDir;
+    string recordingFile = tempDir.path() + "/recording.jsonl";
+    cbl::writeFile(
+        recordingFile,
+        R"({"start":"2020-01-01T00:00:00Z"})"
+        "\n"
+        R"({"method":"GET","url":"https://a.test/api.php?action=query&format=json&prop=revisions&rvprop=content%7Cids)"
+        R"(&rvslots=main&titles=A","data":"","response":"{\"batchcomplete\":\"\",\"query\":{\"pages\":{\"1\":)"
+        R"({\"pageid\":1,\"title\":\"A\",\"revisions\":[{\"revid\":10,\"slots\":{\"main\":)"
+        R"({\"*\":\"Content of A\"}}}]}}}}"})"
+        "\n"
+        R"({"method":"POST","url":"https://a.test/api.php?format=json","data":"action=query&prop=revisions)"
+        R"(&rvprop=content%7Cids%7Ctimestamp&rvslots=main&titles=Foo_bar%7CMissing","response":"{\"query\":)"
+        R"({\"normalized\":[{\"from\":\"Foo_bar\",\"to\":\"Foo bar\"}],\"pages\":{\"-1\":)"
+        R"({\"title\":\"Missing\",\"missing\":\"\"},\"2\":{\"pageid\":2,\"title\":\"Foo bar\",)"
+        R"(\"revisions\":[{\"revid\":20,\"timestamp\":\"2019-01-01T00:00:00Z\",\"slots\":{\"main\":)"
+        R"({\"*\":\"Content of Foo bar\"}}}]}}}}"})"
+        "\n"
+        R"({"method":"GET","url":"https://a.test/api.php?action=query&format=json&prop=revisions&rvprop=ids)"
+        R"(&rvslots=main&titles=B","data":"","response":"{\"query\":{\"pages\":{\"3\":{\"pageid\":3,)"
+        R"(\"title\":\"B\",\"revisions\":[{\"revid\":30}]}}}}"})"
+        "\n");
+    ReplayHTTPClient client(recordingFile, 0);
+    json::Value answer = json::parse(
+        client.post("https://a.test/api.php?format=json",
+                    "action=query&prop=revisions&rvprop=ids%7Ccontent&rvslots=main&titles=Missing%7CFoo_bar%7CA"));
+    const json::Value& query = answer["query"];
+    CBL_ASSERT_EQ(query["normalized"].array().size(), 1);
+    CBL_ASSERT_EQ(query["normalized"][0]["from"].str(), "Foo_bar");
+    CBL_ASSERT_EQ(query["normalized"][0]["to"].str(), "Foo bar");
+    CBL_ASSERT_EQ(query["pages"].object().size(), 3);
+    CBL_ASSERT_EQ(query["pages"]["1"]["revisions"][0]["slots"]["main"]["*"].str(), "Content of A");
+    CBL_ASSERT_EQ(query["pages"]["2"]["title"].str(), "Foo bar");
+    CBL_ASSERT(query["pages"]["-1"].has("missing"));
+
+    // Pages recorded with more properties than requested can be reused, but not pages recorded with fewer properties.
+    answer = json::parse(client.get("https://a.test/api.php?action=query&format=json&prop=revisions&rvprop=ids"
+                                    "&rvslots=main&titles=A%7CB"));
+    CBL_ASSERT_EQ(answer["query"]["pages"]["3"]["revisions"][0]["revid"].numberAsInt(), 30);
+    CBL_ASSERT_EQ(answer["query"]["pages"]["1"]["revisions"][0]["revid"].numberAsInt(), 10);
+    try {
+      client.get("https://a.test/api.php?action=query&format=json&prop=revisions&rvprop=content%7Cids"
+                 "&rvslots=main&titles=A%7CB");
+      CBL_ASSERT(false) << "PageNotInCacheError not thrown";
+    } catch (const cbl::PageNotInCacheError&) {
+    }
+    // Other parameters must match.
+    try {
+      client.get("https://a.test/api.php?action=query&format=json&prop=revisions&rvprop=ids&titles=A%7CB");
+      CBL_ASSERT(false) << "PageNotInCacheError not thrown";
+    } catch (const cbl::PageNotInCacheError&) {
+    }
+
+    ReplayStats stats = client.stats();
+    CBL_ASSERT_EQ(stats.numRequests, 4);
+    CBL_ASSERT_EQ(stats.numAssembledRequests, 2);
+    CBL_ASSERT_EQ(stats.numMissingRequests, 2);
+  }
+};
+
+}  // namespace mwc
+
+int main() {
+  mwc::ReplayHTTPClientTest().run();
+  return 0;
+}
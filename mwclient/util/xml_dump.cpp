@@ -1,4 +1,6 @@
 #include "xml_dump.h"
+#include <algorithm>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -55,10 +57,44 @@ PagesDump::~PagesDump() {
   }
 }
 
+bool PagesDump::readLine() {
+  ssize_t lineLength = getline(&m_buffer, &m_length, m_inputFile);
+  if (lineLength == -1) {
+    return false;
+  }
+  m_position += lineLength;
+  return true;
+}
+
+bool PagesDump::skipTo(int64_t position) {
+  if (position < m_position) {
+    return false;
+  } else if (fseeko(m_inputFile, 0, SEEK_END) == 0) {
+    // Seeking beyond the end of a file succeeds, so the size must be checked first.
+    int64_t size = ftello(m_inputFile);
+    if (size < position || fseeko(m_inputFile, position, SEEK_SET) != 0) {
+      m_position = size;
+      return false;
+    }
+    m_position = position;
+  } else {
+    char buffer[0x10000];
+    while (m_position < position) {
+      size_t bytesRead = fread(buffer, 1, std::min<int64_t>(sizeof(buffer), position - m_position), m_inputFile);
+      if (bytesRead == 0) {
+        return false;
+      }
+      m_position += bytesRead;
+    }
+  }
+  m_state = 2;
+  return true;
+}
+
 char* PagesDump::getTag(const char* tag) {
   char* pStart;
   do {
-    if (getline(&m_buffer, &m_length, m_inputFile) == -1) {
+    if (!readLine()) {
       return nullptr;
     }
     pStart = strstr(m_buffer, tag);
@@ -87,14 +123,14 @@ bool PagesDump::getLine() {
   if (m_state == 2) {
     return false;
   } else if (m_state != 0) {
-    if (getline(&m_buffer, &m_length, m_inputFile) == -1) {
+    if (!readLine()) {
       return false;
     }
     m_line = m_buffer;
   } else {
     char* pStart;
     do {
-      if (getline(&m_buffer, &m_length, m_inputFile) == -1) {
+      if (!readLine()) {
         return false;
       }
       if (strstr(m_buffer, "</page>")) {
@@ -124,4 +160,13 @@ void PagesDump::getContent(string& wcode) {
   }
 }
 
+void PagesDump::skipContent() {
+  // '<' is escaped in the content, so "</page>" cannot appear before the real end of the page.
+  while (m_state != 2 && readLine()) {
+    if (strstr(m_buffer, "</page>")) {
+      m_state = 2;
+    }
+  }
+}
+
 }  // namespace mwc
@@ -18,13 +18,24 @@ public:
   ~PagesDump();
   bool getArticle();
   void getContent(std::string& wcode);
+  // Moves to the end of the current page without decoding its content. This is much faster than getContent() when
+  // the content is not needed.
+  void skipContent();
   const std::string& title() const { return m_title; }
   int64_t pageid() const { return m_pageid; }
   cbl::Date timestamp() const { return m_timestamp; }
+  // Number of bytes consumed from the input so far. After getContent(), this is a valid position to resume reading
+  // from with skipTo().
+  int64_t position() const { return m_position; }
+  // Moves forward to `position`, which must be a value previously returned by position() on the same input.
+  // Seeks if the input supports it, otherwise reads and discards data (e.g. when reading from a pipe).
+  // Returns false if `position` is before the current position or if the end of the input is reached before it.
+  bool skipTo(int64_t position);
 
 private:
   char* getTag(const char* tag);
   bool getLine();
+  bool readLine();
 
   FILE* m_inputFile = nullptr;
   std::string m_title;
@@ -34,6 +45,7 @@ private:
   char* m_buffer = nullptr;
   size_t m_length = 0;
   int m_state = 0;
+  int64_t m_position = 0;
 };
 
 }  // namespace mwc
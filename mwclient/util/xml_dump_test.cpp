@@ -0,0 +1,135 @@
+#include "xml_dump.h"
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "cbl/file.h"
+#include "cbl/log.h"
+#include "cbl/tempfile.h"
+#include "cbl/unittest.h"
+
+using std::string;
+
+namespace mwc {
+
+static string getPageXML(const string& title, int pageid, const string& code) {
+  return "  <page>\n    <title>" + title + "</title>\n    <id>" + std::to_string(pageid) +
+         "</id>\n    <revision>\n      <timestamp>2000-01-01T00:00:00Z</timestamp>\n"
+         "      <text bytes=\"123\" xml:space=\"preserve\">" +
+         code + "</text>\n    </revision>\n  </page>\n";
+}
+
+static const string DUMP_XML = "<mediawiki>\n" + getPageXML("A", 1, "Line 1\nLine 2") + getPageXML("B", 2, "B") +
+                               getPageXML("C", 3, "C &amp; C") + "</mediawiki>\n";
+
+// Returns a stream that reads `content` from a pipe, and thus does not support seeking.
+static FILE* openPipeWithContent(const string& content) {
+  int fds[2];
+  CBL_ASSERT_EQ(pipe(fds), 0);
+  // The content fits in the buffer of the pipe, so this does not block.
+  CBL_ASSERT_EQ(write(fds[1], content.data(), content.size()), static_cast<ssize_t>(content.size()));
+  CBL_ASSERT_EQ(close(fds[1]), 0);
+  FILE* file = fdopen(fds[0], "r");
+  CBL_ASSERT(file != nullptr);
+  return file;
+}
+
+class PagesDumpTest : public cbl::Test {
+private:
+  void setUp() override { m_dumpPath = m_tempDir.path() + "/dump.xml"; }
+
+  // Returns the position after the content of page A.
+  int64_t getPositionAfterFirstPage() {
+    FILE* file = fopen(m_dumpPath.c_str(), "r");
+    CBL_ASSERT(file != nullptr);
+    PagesDump dump(file);
+    CBL_ASSERT(dump.getArticle());
+    string content;
+    dump.getContent(content);
+    CBL_ASSERT_EQ(content, "Line 1\nLine 2");
+    int64_t position = dump.position();
+    fclose(file);
+    return position;
+  }
+
+  void checkRemainingPages(PagesDump& dump) {
+    string content;
+    CBL_ASSERT(dump.getArticle());
+    CBL_ASSERT_EQ(dump.title(), "B");
+    dump.getContent(content);
+    CBL_ASSERT_EQ(content, "B");
+    CBL_ASSERT(dump.getArticle());
+    CBL_ASSERT_EQ(dump.title(), "C");
+    CBL_ASSERT_EQ(dump.pageid(), 3);
+    dump.getContent(content);
+    CBL_ASSERT_EQ(content, "C & C");
+    CBL_ASSERT(!dump.getArticle());
+  }
+
+  CBL_TEST_CASE(SkipToSeekable) {
+    cbl::writeFile(m_dumpPath, DUMP_XML);
+    int64_t position = getPositionAfterFirstPage();
+    FILE* file = fopen(m_dumpPath.c_str(), "r");
+    CBL_ASSERT(file != nullptr);
+    PagesDump dump(file);
+    CBL_ASSERT(dump.skipTo(position));
+    CBL_ASSERT_EQ(dump.position(), position);
+    checkRemainingPages(dump);
+    fclose(file);
+  }
+
+  CBL_TEST_CASE(SkipToNonSeekable) {
+    cbl::writeFile(m_dumpPath, DUMP_XML);
+    int64_t position = getPositionAfterFirstPage();
+    FILE* file = openPipeWithContent(DUMP_XML);
+    PagesDump dump(file);
+    CBL_ASSERT(dump.skipTo(position));
+    CBL_ASSERT_EQ(dump.position(), position);
+    checkRemainingPages(dump);
+    fclose(file);
+  }
+
+  CBL_TEST_CASE(SkipToBeyondEnd) {
+    cbl::writeFile(m_dumpPath, DUMP_XML);
+    int64_t position = getPositionAfterFirstPage();
+    const string truncatedXML = DUMP_XML.substr(0, position - 1);
+    cbl::writeFile(m_dumpPath, truncatedXML);
+    FILE* file = fopen(m_dumpPath.c_str(), "r");
+    CBL_ASSERT(file != nullptr);
+    PagesDump seekableDump(file);
+    CBL_ASSERT(!seekableDump.skipTo(position));
+    fclose(file);
+
+    file = openPipeWithContent(truncatedXML);
+    PagesDump nonSeekableDump(file);
+    CBL_ASSERT(!nonSeekableDump.skipTo(position));
+    fclose(file);
+  }
+
+  CBL_TEST_CASE(SkipToPreviousPosition) {
+    cbl::writeFile(m_dumpPath, DUMP_XML);
+    int64_t position = getPositionAfterFirstPage();
+    FILE* file = fopen(m_dumpPath.c_str(), "r");
+    CBL_ASSERT(file != nullptr);
+    PagesDump dump(file);
+    CBL_ASSERT(dump.skipTo(position));
+    CBL_ASSERT(dump.getArticle());
+    string content;
+    dump.getContent(content);
+    CBL_ASSERT(!dump.skipTo(position));
+    // The dump can still be read after the failed call.
+    CBL_ASSERT(dump.getArticle());
+    CBL_ASSERT_EQ(dump.title(), "C");
+    fclose(file);
+  }
+
+  cbl::TempDir m_tempDir;
+  string m_dumpPath;
+};
+
+}  // namespace mwc
+
+int main() {
+  mwc::PagesDumpTest().run();
+  return 0;
+}
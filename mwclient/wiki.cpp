@@ -9,6 +9,7 @@
 #include <vector>
 #include "cbl/http_client.h"
 #include "cbl/unicode_fr.h"
+#include "rate_controller.h"
 #include "site_info.h"
 #include "titles_util.h"
 #include "wiki_defs.h"
@@ -57,12 +58,12 @@ void Wiki::setHTTPClient(unique_ptr<cbl::HTTPClient> httpClient) {
 }
 
 void Wiki::setDelayBeforeRequests(int delay) {
-  m_httpClient->setDelayBeforeRequests(delay);
+  m_rateController.setInterval(RateController::REQUEST_BUDGET, delay);
   m_delayBeforeRequestsOverridden = true;
 }
 
 void Wiki::setDelayBetweenEdits(int delay) {
-  m_delayBetweenEdits = delay;
+  m_rateController.setInterval(RateController::EDIT_BUDGET, delay);
   m_delayBetweenEditsOverridden = true;
 }
 
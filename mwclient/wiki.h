@@ -11,6 +11,7 @@
 #include <utility>
 #include <vector>
 #include "cbl/date.h"
+#include "revision_store.h"
 #include "site_info.h"
 #include "titles_util.h"
 #include "wiki_base.h"
@@ -40,8 +41,9 @@ struct LoginParams {
 
   // On Wikimedia wikis, should follow the guidelines from https://meta.wikimedia.org/wiki/User-Agent_policy.
   std::string userAgent;
-  // Number of seconds to wait before every HTTP request. This can be 0 on Wikimedia wikis, as long as requests are done
-  // sequentially (see https://www.mediawiki.org/wiki/API:Etiquette).
+  // Minimum number of seconds between the start of two API requests. The time spent in the previous request counts, so
+  // this is not a fixed sleep. This can be 0 on Wikimedia wikis, as long as requests are done sequentially (see
+  // https://www.mediawiki.org/wiki/API:Etiquette).
   int delayBeforeRequests = 0;
   // Number of seconds to wait between edits. Since this has a user-visible impact, each wiki may have different rules.
   // For instance, https://en.wikipedia.org/wiki/Wikipedia:Bot_policy suggests 10 seconds between edits for non-urgent
@@ -189,8 +191,36 @@ struct RenderParams {
   bool disableEditSection = false;
 };
 
+enum GeneratorType {
+  // Pages that transclude `title` (generator=embeddedin).
+  GEN_TRANSCLUSIONS,
+  // Members of the category `title` (generator=categorymembers).
+  GEN_CATEGORY_MEMBERS,
+  // Pages that link to `title` (generator=backlinks).
+  GEN_BACKLINKS,
+  // Pages of `namespace_` starting with `prefix` (generator=allpages).
+  GEN_ALL_PAGES,
+};
+
+struct GeneratorParams {
+  GeneratorType type = GEN_TRANSCLUSIONS;
+  // Title including the namespace, e.g. "Template:Infobox" or "Category:Physics". Not used by GEN_ALL_PAGES.
+  std::string title;
+  // Not used by GEN_ALL_PAGES.
+  NamespaceList namespaceList;
+  // Only used by GEN_BACKLINKS and GEN_ALL_PAGES.
+  FilterRedirMode filterRedir = FR_ALL;
+  // Only used by GEN_ALL_PAGES.
+  std::string prefix;
+  int namespace_ = NS_MAIN;
+};
+
 using EmergencyStopTest = std::function<bool()>;
 using WriteHook = std::function<void(std::string_view title, std::string& content, std::string& summary)>;
+// Receives one batch of results of an enumeration function such as Wiki::enumAllPages. Returning false stops the
+// enumeration.
+template <class T>
+using EnumCallback = std::function<bool(const std::vector<T>& batch)>;
 
 // Client class for MediaWiki API.
 class Wiki : public WikiBase {
@@ -273,6 +303,24 @@ public:
   // NOTE: As with readPages, RP_CONTENT may generate a very large output.
   virtual void readRevisions(int properties, std::vector<Revision>& revisions);
 
+  // Sets a store of revision content used by readRevisions and readRevisionContent. Content found in the store is not
+  // downloaded again and downloaded content is added to the store (see revision_store.h). Null disables the store.
+  void setRevisionStore(std::unique_ptr<RevisionStore> revisionStore) { m_revisionStore = std::move(revisionStore); }
+  // Returns null if there is no store.
+  RevisionStore* revisionStore() { return m_revisionStore.get(); }
+
+  // Starts reading the current revision of `titles` in the background, in batches of apiTitlesLimit() pages, so that
+  // later calls to readPage/readPageContent on these titles (with a subset of `properties`) can be served without
+  // sending a request. Prefetched pages are discarded when they are modified through this object. Otherwise, they are
+  // kept until clearPrefetchedPages() is called, except that readPage with a non-null writeToken reads the page again
+  // if it was prefetched more than prefetchFreshness() ago.
+  // Batches are only sent in the background if the delay before requests allows it. Otherwise, each batch is read
+  // when one of its pages is needed. If a batch fails, its pages are read again individually.
+  virtual void prefetchPages(const std::vector<std::string>& titles, int properties);
+  void clearPrefetchedPages();
+  cbl::DateDiff prefetchFreshness() const { return m_prefetchFreshness; }
+  void setPrefetchFreshness(cbl::DateDiff freshness) { m_prefetchFreshness = freshness; }
+
   // Returns true if a page exists, false otherwise.
   // Throws InvalidParameterError if `title` is an invalid title, a special page or an interwiki.
   virtual bool pageExists(const std::string& title);
@@ -321,6 +369,27 @@ public:
   virtual std::vector<std::string> getAllPages(const AllPagesParams& params);
   virtual std::vector<std::string> getPagesByPrefix(const std::string& prefix);
 
+  // Variants of getCategoryMembers, getBacklinks, getTransclusions and getAllPages that pass results to `callback`
+  // batch by batch as they are received, instead of returning all of them at the end. On large sets, this saves memory
+  // and lets the caller start processing results immediately.
+  // `enumFlags` is a combination of values from EnumFlags. The output parameters of CategoryMembersParams are ignored.
+  virtual void enumCategoryMembers(const CategoryMembersParams& params, const EnumCallback<CategoryMember>& callback,
+                                   int enumFlags = 0);
+  virtual void enumBacklinks(const BacklinksParams& params, const EnumCallback<std::string>& callback,
+                             int enumFlags = 0);
+  virtual void enumTransclusions(const TransclusionsParams& params, const EnumCallback<std::string>& callback,
+                                 int enumFlags = 0);
+  virtual void enumAllPages(const AllPagesParams& params, const EnumCallback<std::string>& callback, int enumFlags = 0);
+
+  // Enumerates pages with a generator and reads their current revision in the same requests, which saves one request
+  // per batch compared to enumerating pages and then calling readPages.
+  // Revisions are passed to `callback` in batches, in no particular order. The fields requested in `properties`
+  // (combination of values from RevProp) are filled, as well as the title, which is always requested. If RP_CONTENT is
+  // requested, batches have at most apiTitlesLimit() pages. The enumeration stops if the callback returns false.
+  // `enumFlags` is a combination of values from EnumFlags.
+  virtual void readPagesFromGenerator(const GeneratorParams& params, int properties,
+                                      const EnumCallback<Revision>& callback, int enumFlags = 0);
+
   virtual void getUsersInfo(int properties, std::vector<UserInfo>& users);
   virtual std::vector<Revision> getUserContribs(const UserContribsParams& params);
   virtual std::vector<std::string> getUsersInGroup(UserGroup userGroup);
@@ -402,8 +471,8 @@ public:
   cbl::HTTPClient& httpClient() override;
   // Cannot be called after logIn().
   void setHTTPClient(std::unique_ptr<cbl::HTTPClient> httpClient);
-  // Sets the number of seconds to wait before each HTTP request. If this function is called before logIn, logIn will
-  // ignore the value defined in LoginParams.
+  // Sets the minimum number of seconds between the start of two API requests. If this function is called before logIn,
+  // logIn will ignore the value defined in LoginParams.
   void setDelayBeforeRequests(int delay);
   // Sets the number of seconds to wait between edits, or other mutating requests. If this function is called before
   // logIn, logIn will ignore the value defined in LoginParams.
@@ -441,6 +510,8 @@ public:
   // redirect, if they are not null.
   bool readRedirect(std::string_view code, std::string* target, std::string* anchor) const;
 
+  void invalidateCachedPages(const std::vector<std::string>& titles) override;
+
 protected:
   void setInternalUserName(std::string_view userName);
   // The core part of writePage after calling hooks and doing some validation. This can be overloaded in subclasses.
@@ -470,6 +541,24 @@ private:
   // Throws: WikiError.
   void loginInternal(std::string userName, const std::string& password, bool clientLogin);
 
+  // == Prefetching ==
+  struct PrefetchedPage {
+    // revid is -1 if the page does not exist.
+    Revision revision;
+    int properties = 0;
+    cbl::Date fetchDate;
+  };
+  struct PrefetchBatch {
+    std::vector<std::string> titles;
+    int properties = 0;
+    // The answer is invalid if the batch is read synchronously when needed.
+    AsyncAPIRequest request;
+  };
+  // If `title` is in a pending batch, waits for the end of this batch and adds its pages to m_prefetchedPages.
+  void completePrefetchBatch(const std::string& title);
+  // Returns the prefetched page `title` if it contains `properties`, or null.
+  const PrefetchedPage* getPrefetchedPage(const std::string& title, int properties);
+
   // == Write API ==
   std::string getTokenUncached(TokenType tokenType);
 
@@ -484,6 +573,11 @@ private:
   std::string m_tokenCache[TOK_MAX];
   EmergencyStopTest m_emergencyStopTest;
   std::vector<WriteHook> m_writeHooks;
+  std::unordered_map<std::string, PrefetchedPage> m_prefetchedPages;
+  // Pending batch of each title that is being prefetched.
+  std::unordered_map<std::string, std::shared_ptr<PrefetchBatch>> m_prefetchBatches;
+  cbl::DateDiff m_prefetchFreshness = cbl::DateDiff::fromMinutes(5);
+  std::unique_ptr<RevisionStore> m_revisionStore;
 };
 
 enum class AccountType {
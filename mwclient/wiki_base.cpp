@@ -1,42 +1,85 @@
 #include "wiki_base.h"
 #include <unistd.h>
 #include <algorithm>
-#include <ctime>
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "cbl/date.h"
 #include "cbl/error.h"
 #include "cbl/http_client.h"
 #include "cbl/json.h"
 #include "cbl/log.h"
+#include "request_memo.h"
+#include "request_metrics.h"
 #include "wiki_defs.h"
 
 using cbl::Date;
 using std::string;
+using Clock = std::chrono::steady_clock;
 
 namespace mwc {
 
+static double toSeconds(Clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
 static bool isProtectedPageError(const string& errorCode) {
   return errorCode == "protectedpage" || errorCode == "protectednamespace-interface" ||
          errorCode == "protectednamespace" || errorCode == "customcssjsprotected" || errorCode == "cascadeprotected";
 }
 
+WikiBase::WikiBase() {
+  m_rateController.setInterval(RateController::EDIT_BUDGET, 12);
+}
+
+WikiBase::~WikiBase() {
+  try {
+    flushRequestMetrics();
+  } catch (const cbl::Error& error) {
+    CBL_ERROR << "Cannot write request metrics: " << error.what();
+  }
+}
+
 void WikiBase::sleep(int seconds) {
   ::sleep(seconds);
 }
 
 void WikiBase::waitBeforeEdit() {
-  time_t now = Date::now().toTimeT();
-  m_lastEdit = std::min(m_lastEdit, now);  // Do not assume that the clock always moves forward.
-  time_t minWriteTime = m_lastEdit + m_delayBetweenEdits;
-  if (now < minWriteTime) {
-    sleep(minWriteTime - now);
-    now = minWriteTime;
+  int delay = m_rateController.reserve(RateController::EDIT_BUDGET);
+  if (delay > 0) {
+    sleep(delay);
   }
-  m_lastEdit = now;
 }
 
-json::Value WikiBase::apiRequest(const string& request, const string& data, bool canRetry) {
+void WikiBase::enableRequestMemo(cbl::DateDiff lifetime) {
+  m_requestMemo = std::make_unique<RequestMemo>(lifetime);
+}
+
+void WikiBase::disableRequestMemo() {
+  m_requestMemo.reset();
+}
+
+void WikiBase::invalidateCachedPages(const std::vector<std::string>& titles) {
+  if (m_requestMemo) {
+    m_requestMemo->invalidate(titles);
+  }
+}
+
+void WikiBase::setRequestMetricsSink(std::unique_ptr<RequestMetricsSink> sink) {
+  m_requestMetricsSink = std::move(sink);
+}
+
+void WikiBase::flushRequestMetrics() {
+  if (m_requestMetricsSink) {
+    m_requestMetricsSink->write(m_requestMetrics);
+  }
+}
+
+string WikiBase::getAPIURL(const string& request) const {
   if (m_wikiURL.empty()) {
     throw InvalidStateError("Not connected to a wiki");
   }
@@ -52,29 +95,63 @@ json::Value WikiBase::apiRequest(const string& request, const string& data, bool
   if (!internalUserName().empty()) {
     url += "&assert=user";
   }
+  return url;
+}
+
+json::Value WikiBase::apiRequest(const string& request, const string& data, bool canRetry) {
+  string url = getAPIURL(request);
+  const string module = getAPIModuleOfRequest(request, data);
 
   constexpr int MAX_ATTEMPTS = 5;
   int remainingAttempts = canRetry ? MAX_ATTEMPTS : 1;
-  int retryTime = 30;
+  int retryIndex = 0;
+  // Minimum delay before the next attempt requested by the server, or -1 to retry immediately.
+  int serverDelay = 0;
   bool logInRetried = false;
   bool postRequest = !data.empty();
 
   std::function<json::Value()> doOneAttempt = [&]() {
-    string rawAnswer;
+    int delay = m_rateController.reserve(RateController::REQUEST_BUDGET);
+    if (delay > 0) {
+      sleep(delay);
+    }
+    Date start = Date::now();
+    Clock::time_point attemptStart = Clock::now();
+    int64_t responseBytes = 0;
+    Clock::duration parseTime = Clock::duration::zero();
+    cbl::RunOnDestroy recordAttempt([&]() {
+      m_requestMetrics.recordAttempt(module, toSeconds(Clock::now() - attemptStart), responseBytes,
+                                     toSeconds(parseTime));
+    });
+    // The answer is parsed while it is downloaded, without keeping the raw text in memory.
+    json::StreamingParser parser;
+    auto onData = [&](std::string_view chunk) {
+      responseBytes += chunk.size();
+      Clock::time_point parseStart = Clock::now();
+      parser.feed(chunk);
+      parseTime += Clock::now() - parseStart;
+    };
+    json::Value answer;
     try {
       if (postRequest) {
-        rawAnswer = httpClient().post(url, data);
+        httpClient().postStreamed(url, data, onData);
       } else {
-        rawAnswer = httpClient().get(url);
+        httpClient().getStreamed(url, onData);
       }
+      Clock::time_point parseStart = Clock::now();
+      answer = parser.finish();
+      parseTime += Clock::now() - parseStart;
     } catch (const cbl::NetworkError& error) {
       throw LowLevelError(LowLevelError::NETWORK, error.what());
     } catch (const cbl::HTTPServerError& error) {
+      serverDelay = error.retryAfter();
+      throw LowLevelError(LowLevelError::HTTP, error.what());
+    } catch (const cbl::HTTPError& error) {
+      if (error.httpCode() != 429) {  // Too Many Requests
+        throw;
+      }
+      serverDelay = error.retryAfter();
       throw LowLevelError(LowLevelError::HTTP, error.what());
-    }
-    json::Value answer;
-    try {
-      answer = json::parse(rawAnswer);
     } catch (const cbl::ParseError& error) {
       throw LowLevelError(LowLevelError::JSON_PARSING, string("Cannot parse JSON: ") + error.what());
     }
@@ -94,11 +171,15 @@ json::Value WikiBase::apiRequest(const string& request, const string& data, bool
       }
       if (errorCode == "maxlag") {
         remainingAttempts++;
+        m_rateController.recordServerLag();
+        m_requestMetrics.recordMaxLagError(module);
+        // This is the value of the Retry-After header that MediaWiki sends with maxlag errors.
+        serverDelay = std::max(m_maxLag, 5);
         throw LowLevelError(LowLevelError::UNSPECIFIED, "Server lagged");
       } else if (errorCode == "assertuserfailed") {
         if (!logInRetried && retryToLogIn()) {
           remainingAttempts++;
-          retryTime = 0;
+          serverDelay = -1;
           logInRetried = true;
           throw LowLevelError(LowLevelError::UNSPECIFIED, description);
         }
@@ -122,6 +203,7 @@ json::Value WikiBase::apiRequest(const string& request, const string& data, bool
     if (answer.has("warnings")) {
       CBL_WARNING << answer["warnings"];
     }
+    m_rateController.recordSuccess(start);
     return answer;
   };
 
@@ -133,11 +215,14 @@ json::Value WikiBase::apiRequest(const string& request, const string& data, bool
       if (remainingAttempts <= 0) {
         throw;
       }
-      if (retryTime > 0) {
-        CBL_WARNING << error.what() << " (will try again in " << retryTime << " seconds)";
-        sleep(retryTime);
+      m_requestMetrics.recordRetry(module);
+      if (serverDelay >= 0) {
+        int retryDelay = m_rateController.retryDelay(retryIndex, serverDelay);
+        CBL_WARNING << error.what() << " (will try again in " << retryDelay << " seconds)";
+        sleep(retryDelay);
+        retryIndex++;
       }
-      retryTime = std::min(retryTime + 30, 600);
+      serverDelay = 0;
     }
   }
 }
@@ -146,4 +231,52 @@ json::Value WikiBase::apiGetRequest(const std::string& request) {
   return apiRequest(request, "", true);
 }
 
+AsyncAPIRequest WikiBase::startAsyncAPIRequest(const string& request, const string& data) {
+  AsyncAPIRequest asyncRequest;
+  asyncRequest.request = request;
+  asyncRequest.data = data;
+  if (m_rateController.tryReserve(RateController::REQUEST_BUDGET)) {
+    asyncRequest.startTime = Clock::now();
+    if (data.empty()) {
+      asyncRequest.answer = httpClient().getAsync(getAPIURL(request));
+    } else {
+      asyncRequest.answer = httpClient().postAsync(getAPIURL(request), data);
+    }
+  }
+  return asyncRequest;
+}
+
+AsyncAPIRequest WikiBase::startAsyncAPIGetRequest(const string& request) {
+  return startAsyncAPIRequest(request, "");
+}
+
+json::Value WikiBase::waitForAsyncAPIRequest(AsyncAPIRequest& asyncRequest) {
+  if (asyncRequest.answer.valid()) {
+    const string module = getAPIModuleOfRequest(asyncRequest.request, asyncRequest.data);
+    try {
+      string answerString = asyncRequest.answer.get();
+      Clock::time_point parseStart = Clock::now();
+      json::Value answer = json::parse(answerString);
+      // The latency includes the time during which the answer was available but not read yet.
+      m_requestMetrics.recordAttempt(module, toSeconds(Clock::now() - asyncRequest.startTime), answerString.size(),
+                                     toSeconds(Clock::now() - parseStart));
+      if (!answer.has("error")) {
+        if (answer.has("warnings")) {
+          CBL_WARNING << answer["warnings"];
+        }
+        return answer;
+      }
+      const string& errorCode = answer["error"]["code"].str();
+      if (errorCode == "maxlag") {
+        m_rateController.recordServerLag();
+        m_requestMetrics.recordMaxLagError(module);
+      }
+      CBL_WARNING << "Background request failed with API error '" << errorCode << "', sending it again";
+    } catch (const cbl::Error& error) {
+      CBL_WARNING << "Background request failed, sending it again: " << error.what();
+    }
+  }
+  return apiRequest(asyncRequest.request, asyncRequest.data, true);
+}
+
 }  // namespace mwc
@@ -1,10 +1,17 @@
 #ifndef MWC_WIKI_BASE_H
 #define MWC_WIKI_BASE_H
 
+#include <chrono>
 #include <climits>
-#include <ctime>
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
+#include "cbl/date.h"
 #include "cbl/json.h"
+#include "rate_controller.h"
+#include "request_memo.h"
+#include "request_metrics.h"
 
 namespace cbl {
 class HTTPClient;
@@ -25,6 +32,16 @@ enum TokenType {
   TOK_MAX,
 };
 
+// Read-only request started by WikiBase::startAsyncAPIRequest().
+struct AsyncAPIRequest {
+  std::string request;
+  // Empty for a GET request.
+  std::string data;
+  // Invalid if the request was not started.
+  std::future<std::string> answer;
+  std::chrono::steady_clock::time_point startTime;
+};
+
 // Base class of Wiki containing the low-level functions to send arbitrary requests as strings to the MediaWiki API.
 // This corresponds to the subset of functions that WikiRequest has access to.
 // The two main functions, apiRequest and its wrapper apiGetRequest wrapper, are implemented directly in wiki_base.cpp.
@@ -34,9 +51,10 @@ enum TokenType {
 // the session).
 class WikiBase {
 public:
-  WikiBase() = default;
+  WikiBase();
   WikiBase(const WikiBase&) = delete;
-  virtual ~WikiBase() = default;
+  // Writes request metrics to the sink, if any.
+  virtual ~WikiBase();
   WikiBase& operator=(const WikiBase&) = delete;
 
   int apiLimit() const { return m_apiLimit; }
@@ -45,25 +63,57 @@ public:
   virtual std::string getToken(TokenType tokenType) = 0;
   virtual void clearTokenCache() = 0;
   virtual void sleep(int seconds);
-  // Waits until m_delayBetweenEdits seconds have elapsed since m_lastEdit.
+  // Waits until the next edit is allowed by the EDIT_BUDGET of m_rateController.
   virtual void waitBeforeEdit();
+  // Returns the number of seconds that waitBeforeEdit() would wait if it was called now.
+  int delayBeforeEdit() const { return m_rateController.delayBeforeReserve(RateController::EDIT_BUDGET); }
   virtual bool isEmergencyStopTriggered() = 0;
   // Throws: WikiError and subclasses.
   virtual json::Value apiRequest(const std::string& request, const std::string& data, bool canRetry);
   virtual json::Value apiGetRequest(const std::string& request);
   virtual bool retryToLogIn() = 0;
+  // Starts sending `request` in the background if the delay before requests allows it, so that the caller can do
+  // something else in the meantime. The request must be read-only. If `data` is not empty, it is sent with POST.
+  AsyncAPIRequest startAsyncAPIRequest(const std::string& request, const std::string& data);
+  AsyncAPIRequest startAsyncAPIGetRequest(const std::string& request);
+  // Returns the answer to a request created by startAsyncAPIRequest(). If it was not started or if it failed, it is
+  // sent again with apiRequest(), which handles retries and errors. A maxlag error is reported to the rate controller
+  // before that.
+  // Throws: same as apiRequest().
+  json::Value waitForAsyncAPIRequest(AsyncAPIRequest& asyncRequest);
+
+  // Enables the memoization of read-only requests for `lifetime` (see request_memo.h). If the memo was already enabled,
+  // its content is cleared.
+  void enableRequestMemo(cbl::DateDiff lifetime);
+  void disableRequestMemo();
+  // Returns null if the memo is disabled.
+  RequestMemo* requestMemo() { return m_requestMemo.get(); }
+  // Metrics about the requests sent by apiRequest (see request_metrics.h).
+  const RequestMetrics& requestMetrics() const { return m_requestMetrics; }
+  // Sets the sink to which metrics are written by flushRequestMetrics() and by the destructor. Null disables it.
+  void setRequestMetricsSink(std::unique_ptr<RequestMetricsSink> sink);
+  void flushRequestMetrics();
+  // Called before sending a request that may change `titles` (or any page if `titles` is empty), so that data cached
+  // about these pages is discarded.
+  virtual void invalidateCachedPages(const std::vector<std::string>& titles);
 
 protected:
   virtual cbl::HTTPClient& httpClient() = 0;
+  // Returns the URL of api.php with the parameters in `request` and those added to all requests.
+  // Throws: InvalidStateError if not connected to a wiki.
+  std::string getAPIURL(const std::string& request) const;
 
   // Location of api.php and index.php. Example: "https://en.wikipedia.org/w".
   // This must be set to a non-empty value before using apiRequest/apiGetRequest.
   std::string m_wikiURL;
   int m_maxLag = 5;
-  int m_delayBetweenEdits = 12;
   int m_apiLimit = BASIC_API_LIMIT;
   int m_apiTitlesLimit = BASIC_API_TITLES_LIMIT;
-  time_t m_lastEdit = 0;
+  // Delays before requests, edits and retries.
+  RateController m_rateController;
+  std::unique_ptr<RequestMemo> m_requestMemo;
+  RequestMetrics m_requestMetrics;
+  std::unique_ptr<RequestMetricsSink> m_requestMetricsSink;
 };
 
 }  // namespace mwc
@@ -1,6 +1,7 @@
 #include "wiki_defs.h"
 #include <cstdlib>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -33,6 +34,18 @@ revid_t revidOfString(const string& s) {
   return atoll(s.c_str());
 }
 
+const char* getStringOfFilterRedirMode(FilterRedirMode mode) {
+  switch (mode) {
+    case FR_ALL:
+      return "all";
+    case FR_REDIRECTS:
+      return "redirects";
+    case FR_NONREDIRECTS:
+      return "nonredirects";
+  }
+  throw std::invalid_argument("getStringOfFilterRedirMode called with invalid mode " + std::to_string(mode));
+}
+
 string NamespaceList::toString() const {
   string buffer;
   for (int namespace_ : m_namespaces) {
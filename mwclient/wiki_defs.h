@@ -290,6 +290,11 @@ enum ReadPageFlags {
   READ_RESOLVE_REDIRECTS = 1,
 };
 
+enum EnumFlags {
+  // Requests the next batch of results in the background while the callback processes the current one.
+  ENUM_PIPELINED = 1,
+};
+
 enum EditPageFlags {
   EDIT_MINOR = 1,
   EDIT_OMIT_BOT_FLAG = 2,
@@ -325,6 +330,9 @@ struct PageProtection {
 
 enum FilterRedirMode { FR_ALL, FR_REDIRECTS, FR_NONREDIRECTS };
 
+// Returns the value of the filterredir parameter of API modules for `mode`.
+const char* getStringOfFilterRedirMode(FilterRedirMode mode);
+
 struct ImageSize {
   int width = 0;
   int height = 0;
@@ -103,18 +103,6 @@ constexpr FlagDef USER_INFO_PROPS[] = {
     {UIP_GROUPS, "groups"},
 };
 
-static const char* getStringOfFilterRedirMode(FilterRedirMode mode) {
-  switch (mode) {
-    case FR_ALL:
-      return "all";
-    case FR_REDIRECTS:
-      return "redirects";
-    case FR_NONREDIRECTS:
-      return "nonredirects";
-  }
-  throw std::invalid_argument("getStringOfFilterRedirMode called with invalid mode " + std::to_string(mode));
-}
-
 static const char* getStringOfUserGroup(UserGroup userGroup) {
   switch (userGroup) {
     case UG_SYSOP:
@@ -319,7 +307,7 @@ vector<LogEvent> Wiki::getLogEvents(const LogEventsParams& params) {
   }
 }
 
-void Wiki::getCategoryMembers(const CategoryMembersParams& params) {
+static WikiListPager createCategoryMembersPager(const CategoryMembersParams& params) {
   WikiListPager pager("categorymembers", "cmlimit");
   pager.setParam("cmtitle", params.title);
   pager.setFlagsParam("cmprop", params.prop, CATEGORY_MEMBERS_PROPS, "title");
@@ -328,6 +316,11 @@ void Wiki::getCategoryMembers(const CategoryMembersParams& params) {
   pager.setParam("cmstart", params.start);
   pager.setParam("cmend", params.end);
   pager.setLimit(params.limit);
+  return pager;
+}
+
+void Wiki::getCategoryMembers(const CategoryMembersParams& params) {
+  WikiListPager pager = createCategoryMembersPager(params);
   // Parameters for the simultaneous size request, if requested.
   pager.setOrClearParam("titles", params.title, params.sizeEstimate != nullptr);
   pager.setOrClearParam("prop", "categoryinfo", params.sizeEstimate != nullptr);
@@ -386,6 +379,25 @@ void Wiki::getCategoryMembers(const CategoryMembersParams& params) {
   }
 }
 
+void Wiki::enumCategoryMembers(const CategoryMembersParams& params, const EnumCallback<CategoryMember>& callback,
+                               int enumFlags) {
+  WikiListPager pager = createCategoryMembersPager(params);
+  pager.setPipelined(enumFlags & ENUM_PIPELINED);
+  try {
+    pager.runListPagerByBatch<CategoryMember>(
+        *this,
+        [](const json::Value& value, CategoryMember& member) {
+          member.title = value["title"].str();
+          member.sortkeyPrefix = value["sortkeyprefix"].str();
+          member.timestamp = parseAPITimestamp(value["timestamp"].str());
+        },
+        callback);
+  } catch (WikiError& error) {
+    error.addContext("Cannot enumerate members of '" + params.title + "'");
+    throw;
+  }
+}
+
 vector<string> Wiki::getCategoryMembers(const string& category) {
   vector<string> members;
   CategoryMembersParams params;
@@ -399,13 +411,17 @@ static void convertJSONToTitle(const json::Value& value, string& title) {
   title = value["title"].str();
 }
 
-vector<string> Wiki::getBacklinks(const BacklinksParams& params) {
+static WikiListPager createBacklinksPager(const BacklinksParams& params) {
   WikiListPager pager("backlinks", "bllimit");
   pager.setParam("bltitle", params.title);
   pager.setOrClearParam("blfilterredir", getStringOfFilterRedirMode(params.filterRedir), params.filterRedir != FR_ALL);
   pager.setParamWithEmptyDefault("blnamespace", params.namespaceList.toString());
   pager.setLimit(params.limit);
+  return pager;
+}
 
+vector<string> Wiki::getBacklinks(const BacklinksParams& params) {
+  WikiListPager pager = createBacklinksPager(params);
   try {
     return pager.runListPager<string>(*this, convertJSONToTitle);
   } catch (WikiError& error) {
@@ -414,6 +430,17 @@ vector<string> Wiki::getBacklinks(const BacklinksParams& params) {
   }
 }
 
+void Wiki::enumBacklinks(const BacklinksParams& params, const EnumCallback<string>& callback, int enumFlags) {
+  WikiListPager pager = createBacklinksPager(params);
+  pager.setPipelined(enumFlags & ENUM_PIPELINED);
+  try {
+    pager.runListPagerByBatch<string>(*this, convertJSONToTitle, callback);
+  } catch (WikiError& error) {
+    error.addContext("Cannot enumerate backlinks of '" + params.title + "'");
+    throw;
+  }
+}
+
 vector<string> Wiki::getBacklinks(const string& title) {
   BacklinksParams params;
   params.title = title;
@@ -427,11 +454,15 @@ vector<string> Wiki::getRedirects(const string& title) {
   return getBacklinks(params);
 }
 
-vector<string> Wiki::getTransclusions(const TransclusionsParams& params) {
+static WikiListPager createTransclusionsPager(const TransclusionsParams& params) {
   WikiListPager pager("embeddedin", "eilimit");
   pager.setParam("eititle", params.title);
   pager.setParamWithEmptyDefault("einamespace", params.namespaceList.toString());
+  return pager;
+}
 
+vector<string> Wiki::getTransclusions(const TransclusionsParams& params) {
+  WikiListPager pager = createTransclusionsPager(params);
   try {
     return pager.runListPager<string>(*this, convertJSONToTitle);
   } catch (WikiError& error) {
@@ -440,13 +471,24 @@ vector<string> Wiki::getTransclusions(const TransclusionsParams& params) {
   }
 }
 
+void Wiki::enumTransclusions(const TransclusionsParams& params, const EnumCallback<string>& callback, int enumFlags) {
+  WikiListPager pager = createTransclusionsPager(params);
+  pager.setPipelined(enumFlags & ENUM_PIPELINED);
+  try {
+    pager.runListPagerByBatch<string>(*this, convertJSONToTitle, callback);
+  } catch (WikiError& error) {
+    error.addContext("Cannot enumerate transclusions of '" + params.title + "'");
+    throw;
+  }
+}
+
 vector<string> Wiki::getTransclusions(const string& title) {
   TransclusionsParams params;
   params.title = title;
   return getTransclusions(params);
 }
 
-vector<string> Wiki::getAllPages(const AllPagesParams& params) {
+static WikiListPager createAllPagesPager(const AllPagesParams& params) {
   WikiListPager pager("allpages", "aplimit");
   pager.setParam("apprefix", params.prefix);
   pager.setOrClearParam("apfilterredir", getStringOfFilterRedirMode(params.filterRedir), params.filterRedir != FR_ALL);
@@ -454,7 +496,11 @@ vector<string> Wiki::getAllPages(const AllPagesParams& params) {
   pager.setFlagsParam("apprlevel", params.protectLevel, PROTECTION_LEVELS);
   pager.setParam("apnamespace", params.namespace_);
   pager.setLimit(params.limit);
+  return pager;
+}
 
+vector<string> Wiki::getAllPages(const AllPagesParams& params) {
+  WikiListPager pager = createAllPagesPager(params);
   try {
     return pager.runListPager<string>(*this, convertJSONToTitle);
   } catch (WikiError& error) {
@@ -463,6 +509,17 @@ vector<string> Wiki::getAllPages(const AllPagesParams& params) {
   }
 }
 
+void Wiki::enumAllPages(const AllPagesParams& params, const EnumCallback<string>& callback, int enumFlags) {
+  WikiListPager pager = createAllPagesPager(params);
+  pager.setPipelined(enumFlags & ENUM_PIPELINED);
+  try {
+    pager.runListPagerByBatch<string>(*this, convertJSONToTitle, callback);
+  } catch (WikiError& error) {
+    error.addContext("Cannot read the list of pages");
+    throw;
+  }
+}
+
 vector<string> Wiki::getPagesByPrefix(const string& prefix) {
   TitleParts titleParts = parseTitle(prefix);
   if (!titleParts.anchor().empty()) {
@@ -1,18 +1,23 @@
 // IMPLEMENTS: wiki.h
 #include <functional>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include "cbl/date.h"
+#include "cbl/error.h"
 #include "cbl/json.h"
 #include "cbl/log.h"
 #include "cbl/string.h"
 #include "bot_exclusion.h"
 #include "request.h"
+#include "request_memo.h"
+#include "revision_store.h"
 #include "wiki.h"
 #include "wiki_base.h"
 #include "wiki_defs.h"
@@ -24,6 +29,7 @@ using std::string;
 using std::string_view;
 using std::unordered_map;
 using std::unordered_multimap;
+using std::unordered_set;
 using std::vector;
 
 namespace mwc {
@@ -137,6 +143,45 @@ const string* followTitleMapping(const TitleMap& titleMap, const string* title)
   return resolvedTitle;
 }
 
+// Calls pageCallback for each valid page in an answer to a request with titles=<titlesRange>, passing the title as it
+// appears in titlesRange.
+static void processPagesAnswer(const json::Value& answer, StringRange titlesRange, const PageCallback& pageCallback) {
+  const json::Value& query = answer["query"];
+  const json::Value& pages = query["pages"];
+  if (!pages.isObject()) {
+    if (query.has("interwiki")) {
+      // All titles are interwikis.
+      return;
+    }
+    throw UnexpectedAPIResponseError("Both 'query.pages' and 'query.interwiki' are missing in server answer");
+  }
+
+  unordered_multimap<string, string> reverseTitleMapping;
+  TitleMap normalizationMap = parseTitleMap(query["normalized"]);
+  TitleMap redirectionMap = parseTitleMap(query["redirects"]);
+  for (const string* title = titlesRange.first; title != titlesRange.second; title++) {
+    const string* normalizedTitle = followTitleMapping(normalizationMap, title);
+    const string* fullyResolvedTitle = followTitleMapping(redirectionMap, normalizedTitle);
+    reverseTitleMapping.emplace(*fullyResolvedTitle, *title);
+  }
+
+  for (const pair<const string, json::Value>& keyAndPage : pages) {
+    const json::Value& page = keyAndPage.second;
+    const string& title = page["title"].str();
+    using TitleIt = unordered_multimap<string, string>::iterator;
+    pair<TitleIt, TitleIt> originalTitles = reverseTitleMapping.equal_range(title);
+    if (originalTitles.first == originalTitles.second) {
+      throw UnexpectedAPIResponseError("Page info is given for a title that was not requested: '" + title + "'");
+    }
+    if (page.has("invalid")) {
+      continue;
+    }
+    for (TitleIt titleIt = originalTitles.first; titleIt != originalTitles.second; ++titleIt) {
+      pageCallback(titleIt->second, page);
+    }
+  }
+}
+
 static void readPagesPropertiesOneRequest(WikiBase& wiki, const WikiPropPager& pager, StringRange titlesRange,
                                           const PageCallback& pageCallback) {
   CBL_ASSERT(titlesRange.first < titlesRange.second);
@@ -145,40 +190,7 @@ static void readPagesPropertiesOneRequest(WikiBase& wiki, const WikiPropPager& p
   pagerCopy.setParam("titles", cbl::join(titlesRange.first, titlesRange.second, "|"));
   pagerCopy.setLimit(PAGER_ALL);
   pagerCopy.runPager(wiki, [&](const json::Value& answer) {
-    const json::Value& query = answer["query"];
-    const json::Value& pages = query["pages"];
-    if (!pages.isObject()) {
-      if (query.has("interwiki")) {
-        // All titles are interwikis.
-        return 0;
-      }
-      throw UnexpectedAPIResponseError("Both 'query.pages' and 'query.interwiki' are missing in server answer");
-    }
-
-    unordered_multimap<string, string> reverseTitleMapping;
-    TitleMap normalizationMap = parseTitleMap(query["normalized"]);
-    TitleMap redirectionMap = parseTitleMap(query["redirects"]);
-    for (const string* title = titlesRange.first; title != titlesRange.second; title++) {
-      const string* normalizedTitle = followTitleMapping(normalizationMap, title);
-      const string* fullyResolvedTitle = followTitleMapping(redirectionMap, normalizedTitle);
-      reverseTitleMapping.emplace(*fullyResolvedTitle, *title);
-    }
-
-    for (const pair<const string, json::Value>& keyAndPage : pages) {
-      const json::Value& page = keyAndPage.second;
-      const string& title = page["title"].str();
-      using TitleIt = unordered_multimap<string, string>::iterator;
-      pair<TitleIt, TitleIt> originalTitles = reverseTitleMapping.equal_range(title);
-      if (originalTitles.first == originalTitles.second) {
-        throw UnexpectedAPIResponseError("Page info is given for a title that was not requested: '" + title + "'");
-      }
-      if (page.has("invalid")) {
-        continue;
-      }
-      for (TitleIt titleIt = originalTitles.first; titleIt != originalTitles.second; ++titleIt) {
-        pageCallback(titleIt->second, page);
-      }
-    }
+    processPagesAnswer(answer, titlesRange, pageCallback);
     return 0;  // The limit is PAGER_ALL so there is no need to return the exact number of items read.
   });
 }
@@ -274,6 +286,23 @@ static void readRevisionsOneRequest(WikiBase& wiki, int properties, StringRange
 }
 
 Revision Wiki::readPage(string_view title, int properties) {
+  if (!m_prefetchedPages.empty() || !m_prefetchBatches.empty()) {
+    string titleStr(title);
+    completePrefetchBatch(titleStr);
+    if (const PrefetchedPage* prefetchedPage = getPrefetchedPage(titleStr, properties)) {
+      if (prefetchedPage->revision.revid == -1) {
+        PageNotFoundError error("The page does not exist");
+        error.addContext(cbl::concat("Cannot read page '", title, "'"));
+        throw error;
+      }
+      Revision revision = prefetchedPage->revision;
+      if (!(properties & RP_TITLE)) {
+        revision.title.clear();
+      }
+      return revision;
+    }
+  }
+
   WikiRequest request("query");
   request.setParam("prop", "revisions");
   request.setParam("rvslots", "main");
@@ -291,6 +320,14 @@ Revision Wiki::readPage(string_view title, int properties) {
 }
 
 Revision Wiki::readPage(string_view title, int properties, WriteToken* writeToken) {
+  if (writeToken != nullptr) {
+    // The page may be modified based on the content returned, so do not use an old version.
+    auto prefetchedPageIt = m_prefetchedPages.find(string(title));
+    if (prefetchedPageIt != m_prefetchedPages.end() &&
+        prefetchedPageIt->second.fetchDate + m_prefetchFreshness < Date::now()) {
+      m_prefetchedPages.erase(prefetchedPageIt);
+    }
+  }
   int extraProperties = writeToken != nullptr ? (RP_CONTENT | RP_REVID) : 0;
   Revision revision = readPage(title, properties | extraProperties);
   if (writeToken != nullptr) {
@@ -339,16 +376,43 @@ Revision Wiki::readRevision(revid_t revid, int properties) {
 }
 
 string Wiki::readRevisionContent(revid_t revid) {
-  return readRevision(revid, RP_CONTENT).content;
+  string content;
+  if (m_revisionStore && m_revisionStore->getContent(revid, content)) {
+    return content;
+  }
+  Revision revision = readRevision(revid, RP_CONTENT);
+  if (m_revisionStore && !revision.contentHidden) {
+    m_revisionStore->putContent(revid, revision.content);
+  }
+  return revision.content;
 }
 
-void Wiki::readPages(int properties, std::vector<Revision>& revisions, int readPageFlags) {
-  WikiPropPager pager("revisions", NO_LIMIT_PARAM);
+static WikiPropPager createReadPagesPager(int properties, int readPageFlags,
+                                          string_view limitParam = NO_LIMIT_PARAM) {
+  WikiPropPager pager("revisions", limitParam);
   pager.setParam("rvslots", "main");
   pager.setFlagsParam("rvprop", filterRevisionProps(properties), REVISION_PROPS);
   if (readPageFlags & READ_RESOLVE_REDIRECTS) {
     pager.setParam("redirects", "1");
   }
+  return pager;
+}
+
+// Fills `revision` from a page returned by a request created with createReadPagesPager.
+static void convertPageJSONToCurrentRevision(const json::Value& page, int properties, Revision& revision) {
+  if (page.has("missing")) {
+    revision.revid = -1;
+  } else {
+    revision.revid = 0;
+    convertJSONToRevision(page["revisions"][0], /* extractTitle = */ false, revision);
+  }
+  if (properties & RP_TITLE) {
+    revision.title = page["title"].str();  // This is the normalized title.
+  }
+}
+
+void Wiki::readPages(int properties, std::vector<Revision>& revisions, int readPageFlags) {
+  WikiPropPager pager = createReadPagesPager(properties, readPageFlags);
 
   vector<string> titles;
   unordered_multimap<string, Revision*> revisionsByTitle;
@@ -367,34 +431,89 @@ void Wiki::readPages(int properties, std::vector<Revision>& revisions, int readP
     using RevisionsIt = unordered_multimap<string, Revision*>::iterator;
     pair<RevisionsIt, RevisionsIt> revisions = revisionsByTitle.equal_range(title);
     for (RevisionsIt it = revisions.first; it != revisions.second; ++it) {
-      Revision* revision = it->second;
-      if (page.has("missing")) {
-        revision->revid = -1;
-      } else {
-        revision->revid = 0;
-        convertJSONToRevision(page["revisions"][0], /* extractTitle = */ false, *revision);
-      }
-      if (properties & RP_TITLE) {
-        revision->title = page["title"].str();  // This is the normalized title.
-      }
+      convertPageJSONToCurrentRevision(page, properties, *it->second);
     }
   };
   readPagesProperties(*this, pager, titles, callback);
 }
 
-void Wiki::readRevisions(int properties, std::vector<Revision>& revisions) {
+void Wiki::readPagesFromGenerator(const GeneratorParams& params, int properties,
+                                  const EnumCallback<Revision>& callback, int enumFlags) {
+  properties |= RP_TITLE;
+  string generator;
+  string paramPrefix;
+  switch (params.type) {
+    case GEN_TRANSCLUSIONS:
+      generator = "embeddedin";
+      paramPrefix = "gei";
+      break;
+    case GEN_CATEGORY_MEMBERS:
+      generator = "categorymembers";
+      paramPrefix = "gcm";
+      break;
+    case GEN_BACKLINKS:
+      generator = "backlinks";
+      paramPrefix = "gbl";
+      break;
+    case GEN_ALL_PAGES:
+      generator = "allpages";
+      paramPrefix = "gap";
+      break;
+  }
+  WikiPropPager pager = createReadPagesPager(properties, 0, paramPrefix + "limit");
+  pager.setParam("generator", generator);
+  if (params.type == GEN_ALL_PAGES) {
+    pager.setParam("gapprefix", params.prefix);
+    pager.setParam("gapnamespace", params.namespace_);
+  } else {
+    pager.setParam(paramPrefix + "title", params.title);
+    pager.setParamWithEmptyDefault(paramPrefix + "namespace", params.namespaceList.toString());
+  }
+  if (params.type == GEN_BACKLINKS || params.type == GEN_ALL_PAGES) {
+    pager.setOrClearParam(paramPrefix + "filterredir", getStringOfFilterRedirMode(params.filterRedir),
+                          params.filterRedir != FR_ALL);
+  }
+  // MediaWiki returns the content of at most apiTitlesLimit() pages per request. Asking for more pages would only
+  // cause additional requests to continue the revisions of the same batch.
+  if (properties & RP_CONTENT) {
+    pager.setBatchSize(m_apiTitlesLimit);
+  }
+  pager.setPipelined(enumFlags & ENUM_PIPELINED);
+
+  vector<Revision> revisions;
+  try {
+    pager.runPager(*this, [&](const json::Value& answer) {
+      revisions.clear();
+      for (const auto& [pageId, page] : answer["query"]["pages"]) {
+        // Pages without revisions are repeated from a previous request or will be completed by the next one.
+        if (page.has("revisions")) {
+          convertPageJSONToCurrentRevision(page, properties, revisions.emplace_back());
+        }
+      }
+      // When continuing the revisions of a batch, the generator returns the same pages again, so the number of pages
+      // does not count for the limit. There is no limit anyway.
+      return revisions.empty() || callback(revisions) ? static_cast<int>(revisions.size()) : PAGER_STOP;
+    });
+  } catch (WikiError& error) {
+    error.addContext(params.type == GEN_ALL_PAGES ? "Cannot read the list of pages"
+                                                  : "Cannot read pages generated from '" + params.title + "'");
+    throw;
+  }
+}
+
+static void readRevisionsFromAPI(WikiBase& wiki, int properties, const vector<Revision*>& revisions) {
   unordered_multimap<revid_t, Revision*> revisionsByRevid;
   vector<string> revids;
-  for (Revision& revision : revisions) {
-    if (revisionsByRevid.find(revision.revid) == revisionsByRevid.end()) {
-      revids.push_back(std::to_string(revision.revid));
+  for (Revision* revision : revisions) {
+    if (revisionsByRevid.find(revision->revid) == revisionsByRevid.end()) {
+      revids.push_back(std::to_string(revision->revid));
     }
-    revisionsByRevid.emplace(revision.revid, &revision);
-    revision.title = INVALID_TITLE;
+    revisionsByRevid.emplace(revision->revid, revision);
+    revision->title = INVALID_TITLE;
   }
-  for (StringRange revidsRange : splitVectorIntoRanges(revids, m_apiTitlesLimit)) {
+  for (StringRange revidsRange : splitVectorIntoRanges(revids, wiki.apiTitlesLimit())) {
     try {
-      readRevisionsOneRequest(*this, properties, revidsRange, revisionsByRevid);
+      readRevisionsOneRequest(wiki, properties, revidsRange, revisionsByRevid);
     } catch (WikiError& error) {
       error.addContext("Cannot read revisions " + cbl::join(revidsRange.first, revidsRange.second, ", "));
       throw;
@@ -402,6 +521,164 @@ void Wiki::readRevisions(int properties, std::vector<Revision>& revisions) {
   };
 }
 
+void Wiki::readRevisions(int properties, std::vector<Revision>& revisions) {
+  vector<Revision*> revisionsToDownload;
+  if (!m_revisionStore || !(properties & RP_CONTENT)) {
+    for (Revision& revision : revisions) {
+      revisionsToDownload.push_back(&revision);
+    }
+    readRevisionsFromAPI(*this, properties, revisionsToDownload);
+    return;
+  }
+
+  unordered_map<revid_t, string> storedContents;
+  vector<Revision*> storedRevisions;
+  for (Revision& revision : revisions) {
+    string content;
+    if (storedContents.count(revision.revid) != 0 || m_revisionStore->getContent(revision.revid, content)) {
+      storedContents.emplace(revision.revid, std::move(content));
+      storedRevisions.push_back(&revision);
+    } else {
+      revisionsToDownload.push_back(&revision);
+    }
+  }
+  // Other properties of stored revisions are still read from the API, but not their content.
+  if (!storedRevisions.empty()) {
+    const int otherProperties = properties & ~RP_CONTENT;
+    if (otherProperties & ~RP_REVID) {
+      readRevisionsFromAPI(*this, otherProperties, storedRevisions);
+    } else {
+      for (Revision* revision : storedRevisions) {
+        revision->title.clear();
+      }
+    }
+    for (Revision* revision : storedRevisions) {
+      revision->content = storedContents.at(revision->revid);
+      revision->contentHidden = false;
+    }
+  }
+  if (!revisionsToDownload.empty()) {
+    readRevisionsFromAPI(*this, properties, revisionsToDownload);
+    for (const Revision* revision : revisionsToDownload) {
+      if (revision->title != INVALID_TITLE && !revision->contentHidden) {
+        m_revisionStore->putContent(revision->revid, revision->content);
+      }
+    }
+  }
+}
+
+void Wiki::prefetchPages(const vector<string>& titles, int properties) {
+  // The revid is needed to know if the page exists and the normalized title is kept in case it is requested later.
+  properties |= RP_REVID | RP_TITLE;
+  vector<string> titlesToFetch;
+  unordered_set<string> titlesToFetchSet;
+  for (const string& title : titles) {
+    // Same filter as readPages.
+    if (title.empty() || title.find('|') != string::npos || m_prefetchBatches.count(title) != 0 ||
+        getPrefetchedPage(title, properties) != nullptr || !titlesToFetchSet.insert(title).second) {
+      continue;
+    }
+    titlesToFetch.push_back(title);
+  }
+  for (StringRange titlesRange : splitVectorIntoRanges(titlesToFetch, m_apiTitlesLimit)) {
+    auto batch = std::make_shared<PrefetchBatch>();
+    batch->titles.assign(titlesRange.first, titlesRange.second);
+    batch->properties = properties;
+    WikiPropPager pager = createReadPagesPager(properties, 0);
+    pager.setParam("titles", cbl::join(titlesRange.first, titlesRange.second, "|"));
+    batch->request = startAsyncAPIRequest("", pager.getRequestString());
+    for (const string& title : batch->titles) {
+      m_prefetchBatches[title] = batch;
+    }
+  }
+}
+
+void Wiki::clearPrefetchedPages() {
+  m_prefetchedPages.clear();
+  m_prefetchBatches.clear();
+}
+
+void Wiki::completePrefetchBatch(const string& title) {
+  auto batchIt = m_prefetchBatches.find(title);
+  if (batchIt == m_prefetchBatches.end()) {
+    return;
+  }
+  std::shared_ptr<PrefetchBatch> batch = batchIt->second;
+  // Titles modified since the start of the batch are no longer associated with it.
+  vector<string> requestedTitles;
+  vector<Revision> revisions;
+  for (const string& batchTitle : batch->titles) {
+    auto titleIt = m_prefetchBatches.find(batchTitle);
+    if (titleIt != m_prefetchBatches.end() && titleIt->second == batch) {
+      requestedTitles.push_back(batchTitle);
+      revisions.emplace_back().title = batchTitle;
+      m_prefetchBatches.erase(titleIt);
+    }
+  }
+  Date fetchDate = Date::now();
+  try {
+    if (batch->request.answer.valid()) {
+      json::Value answer = waitForAsyncAPIRequest(batch->request);
+      unordered_map<string, Revision*> revisionsByTitle;
+      for (Revision& revision : revisions) {
+        revisionsByTitle.emplace(revision.title, &revision);
+        revision.revid = -2;
+      }
+      processPagesAnswer(answer, StringRange(&batch->titles.front(), &batch->titles.back() + 1),
+                         [&](const string& title, const json::Value& page) {
+                           auto revisionIt = revisionsByTitle.find(title);
+                           // If the answer is too large, some pages are returned without revisions.
+                           if (revisionIt != revisionsByTitle.end() && (page.has("missing") || page.has("revisions"))) {
+                             convertPageJSONToCurrentRevision(page, batch->properties, *revisionIt->second);
+                           }
+                         });
+    } else {
+      readPages(batch->properties, revisions);
+    }
+  } catch (const WikiError& error) {
+    CBL_WARNING << "Cannot prefetch pages: " << error.what();
+    return;
+  } catch (const cbl::Error& error) {
+    CBL_WARNING << "Cannot prefetch pages: " << error.what();
+    return;
+  }
+  // Pages are found by the title passed to prefetchPages, while the revision contains the normalized title.
+  for (size_t i = 0; i < revisions.size(); i++) {
+    Revision& revision = revisions[i];
+    if (revision.revid != -2) {
+      PrefetchedPage& prefetchedPage = m_prefetchedPages[requestedTitles[i]];
+      prefetchedPage.revision = std::move(revision);
+      prefetchedPage.properties = batch->properties;
+      prefetchedPage.fetchDate = fetchDate;
+    }
+  }
+}
+
+const Wiki::PrefetchedPage* Wiki::getPrefetchedPage(const string& title, int properties) {
+  auto pageIt = m_prefetchedPages.find(title);
+  if (pageIt == m_prefetchedPages.end() || (properties & ~pageIt->second.properties) != 0) {
+    return nullptr;
+  }
+  return &pageIt->second;
+}
+
+void Wiki::invalidateCachedPages(const vector<string>& titles) {
+  WikiBase::invalidateCachedPages(titles);
+  if (titles.empty()) {
+    clearPrefetchedPages();
+    return;
+  }
+  unordered_set<string> titleKeys;
+  for (const string& title : titles) {
+    titleKeys.insert(getLooseTitleKey(title));
+  }
+  auto isModified = [&](const auto& titleAndValue) {
+    return titleKeys.count(getLooseTitleKey(titleAndValue.first)) != 0;
+  };
+  std::erase_if(m_prefetchedPages, isModified);
+  std::erase_if(m_prefetchBatches, isModified);
+}
+
 bool Wiki::pageExists(const string& title) {
   try {
     readPage(title, RP_TIMESTAMP);
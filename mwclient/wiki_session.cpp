@@ -4,20 +4,19 @@
 #include <string>
 #include <string_view>
 #include <utility>
-#include "cbl/date.h"
 #include "cbl/error.h"
 #include "cbl/file.h"
 #include "cbl/http_client.h"
 #include "cbl/json.h"
 #include "cbl/log.h"
 #include "cbl/string.h"
+#include "rate_controller.h"
 #include "request.h"
 #include "site_info.h"
 #include "wiki.h"
 #include "wiki_base.h"
 #include "wiki_defs.h"
 
-using cbl::Date;
 using std::string;
 using std::string_view;
 
@@ -41,6 +40,10 @@ void Wiki::clearSession() {
   m_httpClient->clearCookies();
   m_sessionFile.clear();
   clearTokenCache();
+  clearPrefetchedPages();
+  if (m_requestMemo) {
+    m_requestMemo->clear();
+  }
 }
 
 string Wiki::sessionToString() const {
@@ -195,13 +198,13 @@ void Wiki::logIn(const LoginParams& loginParams, const string& sessionFile) {
     m_httpClient->setUserAgent(loginParams.userAgent);
   }
   if (loginParams.delayBeforeRequests != -1 && !m_delayBeforeRequestsOverridden) {
-    m_httpClient->setDelayBeforeRequests(loginParams.delayBeforeRequests);
+    m_rateController.setInterval(RateController::REQUEST_BUDGET, loginParams.delayBeforeRequests);
   }
   if (loginParams.delayBetweenEdits != -1 && !m_delayBetweenEditsOverridden) {
-    m_delayBetweenEdits = loginParams.delayBetweenEdits;
+    m_rateController.setInterval(RateController::EDIT_BUDGET, loginParams.delayBetweenEdits);
   }
   m_maxLag = loginParams.maxLag;
-  m_lastEdit = Date::now().toTimeT();
+  m_rateController.drain(RateController::EDIT_BUDGET);
 
   string url = loginParams.url;
   if (url.ends_with("/")) {
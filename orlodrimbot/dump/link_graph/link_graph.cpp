@@ -0,0 +1,205 @@
+#include "link_graph.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cbl/error.h"
+#include "cbl/mapped_file.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace link_graph {
+
+static const char NODES_FILE_MAGIC[8] = {'L', 'N', 'K', 'N', 'O', 'D', 'E', '1'};
+static const char ADJACENCY_FILE_MAGIC[8] = {'L', 'N', 'K', 'G', 'R', 'P', 'H', '1'};
+
+struct NodesFileHeader {
+  char magic[8];
+  uint64_t numNodes;
+  uint64_t titlesSize;
+};
+
+struct AdjacencyFileHeader {
+  char magic[8];
+  uint64_t numNodes;
+  uint64_t numEdges;
+  uint64_t dataSize;
+};
+
+template <class T>
+static string_view asBytes(const T* data, size_t count) {
+  return string_view(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+// Writes the concatenation of `parts` to `path`.
+static void writeBinaryFile(const string& path, std::initializer_list<string_view> parts) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    throw cbl::SystemError("Cannot open '" + path + "' for writing: " + cbl::getCErrorString(errno));
+  }
+  bool success = true;
+  for (string_view part : parts) {
+    success = success && fwrite(part.data(), 1, part.size(), file) == part.size();
+  }
+  if (fclose(file) != 0 || !success) {
+    throw cbl::SystemError("Cannot write '" + path + "'");
+  }
+}
+
+void writeNodesFile(const string& path, const vector<int64_t>& pageids, const vector<string>& titles) {
+  if (pageids.size() != titles.size() || titles.size() >= NodesFile::NOT_FOUND) {
+    throw std::invalid_argument("Invalid number of nodes in writeNodesFile");
+  }
+  const NodeId numNodes = titles.size();
+  vector<uint64_t> titleOffsets;
+  titleOffsets.reserve(numNodes + 1);
+  string concatenatedTitles;
+  for (const string& title : titles) {
+    titleOffsets.push_back(concatenatedTitles.size());
+    concatenatedTitles += title;
+  }
+  titleOffsets.push_back(concatenatedTitles.size());
+  vector<NodeId> sortedNodes(numNodes);
+  for (NodeId node = 0; node < numNodes; node++) {
+    sortedNodes[node] = node;
+  }
+  std::sort(sortedNodes.begin(), sortedNodes.end(),
+            [&](NodeId node1, NodeId node2) { return titles[node1] < titles[node2]; });
+
+  NodesFileHeader header;
+  memcpy(header.magic, NODES_FILE_MAGIC, sizeof(header.magic));
+  header.numNodes = numNodes;
+  header.titlesSize = concatenatedTitles.size();
+  writeBinaryFile(path, {asBytes(&header, 1), asBytes(pageids.data(), pageids.size()),
+                         asBytes(titleOffsets.data(), titleOffsets.size()),
+                         asBytes(sortedNodes.data(), sortedNodes.size()), concatenatedTitles});
+}
+
+NodesFile::NodesFile(const string& path) : m_file(path) {
+  if (m_file.size() < sizeof(NodesFileHeader)) {
+    throw cbl::ParseError("File '" + path + "' is too short to be a nodes file");
+  }
+  const NodesFileHeader* header = reinterpret_cast<const NodesFileHeader*>(m_file.data());
+  uint64_t expectedSize = 0;
+  if (memcmp(header->magic, NODES_FILE_MAGIC, sizeof(header->magic)) == 0 && header->numNodes < NOT_FOUND) {
+    expectedSize = sizeof(NodesFileHeader) + header->numNodes * (sizeof(int64_t) + sizeof(uint64_t) + sizeof(NodeId)) +
+                   sizeof(uint64_t) + header->titlesSize;
+  }
+  if (expectedSize != m_file.size()) {
+    throw cbl::ParseError("File '" + path + "' is not a valid nodes file");
+  }
+  m_numNodes = header->numNodes;
+  m_pageids = reinterpret_cast<const int64_t*>(header + 1);
+  m_titleOffsets = reinterpret_cast<const uint64_t*>(m_pageids + m_numNodes);
+  m_sortedNodes = reinterpret_cast<const NodeId*>(m_titleOffsets + m_numNodes + 1);
+  m_titles = reinterpret_cast<const char*>(m_sortedNodes + m_numNodes);
+  if (m_titleOffsets[m_numNodes] != header->titlesSize) {
+    throw cbl::ParseError("File '" + path + "' is not a valid nodes file");
+  }
+}
+
+NodeId NodesFile::findNode(string_view title) const {
+  const NodeId* sortedNodesEnd = m_sortedNodes + m_numNodes;
+  const NodeId* it = std::lower_bound(m_sortedNodes, sortedNodesEnd, title,
+                                      [this](NodeId node, string_view value) { return this->title(node) < value; });
+  return it != sortedNodesEnd && this->title(*it) == title ? *it : NOT_FOUND;
+}
+
+static void appendVarint(string& buffer, uint32_t value) {
+  while (value >= 0x80) {
+    buffer += static_cast<char>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  buffer += static_cast<char>(value);
+}
+
+void writeAdjacencyFile(const string& path, const vector<uint64_t>& rowStart, const vector<NodeId>& neighbors) {
+  if (rowStart.empty() || rowStart.back() != neighbors.size()) {
+    throw std::invalid_argument("Inconsistent rowStart and neighbors in writeAdjacencyFile");
+  }
+  uint64_t numNodes = rowStart.size() - 1;
+  vector<uint64_t> offsets;
+  offsets.reserve(numNodes + 1);
+  string data;
+  for (uint64_t node = 0; node < numNodes; node++) {
+    offsets.push_back(data.size());
+    NodeId previous = 0;
+    for (uint64_t i = rowStart[node]; i < rowStart[node + 1]; i++) {
+      // The first neighbor is stored as is, next ones as the difference with the previous one.
+      appendVarint(data, neighbors[i] - previous);
+      previous = neighbors[i];
+    }
+  }
+  offsets.push_back(data.size());
+
+  AdjacencyFileHeader header;
+  memcpy(header.magic, ADJACENCY_FILE_MAGIC, sizeof(header.magic));
+  header.numNodes = numNodes;
+  header.numEdges = neighbors.size();
+  header.dataSize = data.size();
+  writeBinaryFile(path, {asBytes(&header, 1), asBytes(offsets.data(), offsets.size()), data});
+}
+
+AdjacencyFile::AdjacencyFile(const string& path) : m_file(path) {
+  if (m_file.size() < sizeof(AdjacencyFileHeader)) {
+    throw cbl::ParseError("File '" + path + "' is too short to be an adjacency file");
+  }
+  const AdjacencyFileHeader* header = reinterpret_cast<const AdjacencyFileHeader*>(m_file.data());
+  uint64_t expectedSize = 0;
+  if (memcmp(header->magic, ADJACENCY_FILE_MAGIC, sizeof(header->magic)) == 0 && header->numNodes < UINT32_MAX) {
+    expectedSize = sizeof(AdjacencyFileHeader) + (header->numNodes + 1) * sizeof(uint64_t) + header->dataSize;
+  }
+  if (expectedSize != m_file.size()) {
+    throw cbl::ParseError("File '" + path + "' is not a valid adjacency file");
+  }
+  m_numNodes = header->numNodes;
+  m_numEdges = header->numEdges;
+  m_offsets = reinterpret_cast<const uint64_t*>(header + 1);
+  m_data = reinterpret_cast<const uint8_t*>(m_offsets + m_numNodes + 1);
+}
+
+void AdjacencyFile::getNeighbors(NodeId node, vector<NodeId>& neighbors) const {
+  neighbors.clear();
+  const uint8_t* p = m_data + m_offsets[node];
+  const uint8_t* end = m_data + m_offsets[node + 1];
+  NodeId previous = 0;
+  while (p < end) {
+    uint32_t delta = 0;
+    for (int shift = 0; p < end; shift += 7) {
+      uint8_t byte = *p++;
+      delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) break;
+    }
+    previous += delta;
+    neighbors.push_back(previous);
+  }
+}
+
+LinkGraph::LinkGraph(const string& prefix)
+    : m_nodes(prefix + ".nodes"), m_forward(prefix + ".forward"), m_backward(prefix + ".backward") {
+  if (m_nodes.numNodes() != m_forward.numNodes() || m_nodes.numNodes() != m_backward.numNodes()) {
+    throw cbl::ParseError("Inconsistent number of nodes in the files of graph '" + prefix + "'");
+  }
+}
+
+vector<NodeId> LinkGraph::getLinks(NodeId node) const {
+  vector<NodeId> links;
+  m_forward.getNeighbors(node, links);
+  return links;
+}
+
+vector<NodeId> LinkGraph::getBacklinks(NodeId node) const {
+  vector<NodeId> backlinks;
+  m_backward.getNeighbors(node, backlinks);
+  return backlinks;
+}
+
+}  // namespace link_graph
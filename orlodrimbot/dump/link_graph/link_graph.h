@@ -0,0 +1,116 @@
+// Graph of internal links between pages, as produced by the "links" dump process.
+//
+// The graph is stored in three files sharing a prefix:
+//   <prefix>.nodes: the page id and title of each node (nodes file).
+//   <prefix>.forward: for each node, the nodes it links to (adjacency file).
+//   <prefix>.backward: for each node, the nodes linking to it (adjacency file).
+// Nodes files contain a header, the array of page ids, an array of numNodes + 1 offsets of titles, the array of nodes
+// sorted by title (used for lookups by binary search) and finally the concatenated titles.
+// Adjacency files use the compressed sparse row format: a header, then an array of numNodes + 1 offsets and finally
+// the lists of neighbors. Each list is sorted, delta-encoded and stored as varints.
+// All files are mapped in memory and used as is, so loading a graph takes constant time, whatever its size, and only
+// the parts actually queried are read from disk.
+#ifndef LINK_GRAPH_H
+#define LINK_GRAPH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cbl/mapped_file.h"
+
+namespace link_graph {
+
+using NodeId = uint32_t;
+
+// Writes an adjacency file. The neighbors of node i are neighbors[rowStart[i]] to neighbors[rowStart[i + 1] - 1] and
+// must be sorted without duplicates. rowStart must have numNodes + 1 elements.
+// Throws: SystemError.
+void writeAdjacencyFile(const std::string& path, const std::vector<uint64_t>& rowStart,
+                        const std::vector<NodeId>& neighbors);
+
+// Writes a nodes file. Node i has page id pageids[i] and title titles[i]. Titles must be distinct.
+// Throws: SystemError.
+void writeNodesFile(const std::string& path, const std::vector<int64_t>& pageids,
+                    const std::vector<std::string>& titles);
+
+// Read-only view of a nodes file mapped in memory.
+class NodesFile {
+public:
+  static constexpr NodeId NOT_FOUND = static_cast<NodeId>(-1);
+
+  // Throws: FileNotFoundError, SystemError, ParseError if the file is not a valid nodes file.
+  explicit NodesFile(const std::string& path);
+  NodesFile(const NodesFile&) = delete;
+  NodesFile& operator=(const NodesFile&) = delete;
+
+  NodeId numNodes() const { return m_numNodes; }
+  int64_t pageid(NodeId node) const { return m_pageids[node]; }
+  std::string_view title(NodeId node) const {
+    return std::string_view(m_titles + m_titleOffsets[node], m_titleOffsets[node + 1] - m_titleOffsets[node]);
+  }
+  // Returns the node with this title, or NOT_FOUND.
+  NodeId findNode(std::string_view title) const;
+
+private:
+  cbl::MappedFile m_file;
+  NodeId m_numNodes = 0;
+  const int64_t* m_pageids = nullptr;
+  const uint64_t* m_titleOffsets = nullptr;
+  const NodeId* m_sortedNodes = nullptr;
+  const char* m_titles = nullptr;
+};
+
+// Read-only view of an adjacency file mapped in memory.
+class AdjacencyFile {
+public:
+  // Throws: FileNotFoundError, SystemError, ParseError if the file is not a valid adjacency file.
+  explicit AdjacencyFile(const std::string& path);
+  AdjacencyFile(const AdjacencyFile&) = delete;
+  AdjacencyFile& operator=(const AdjacencyFile&) = delete;
+
+  NodeId numNodes() const { return m_numNodes; }
+  uint64_t numEdges() const { return m_numEdges; }
+  bool hasNeighbors(NodeId node) const { return m_offsets[node] != m_offsets[node + 1]; }
+  // Replaces the content of `neighbors` with the neighbors of `node`, in increasing order.
+  void getNeighbors(NodeId node, std::vector<NodeId>& neighbors) const;
+
+private:
+  cbl::MappedFile m_file;
+  NodeId m_numNodes = 0;
+  uint64_t m_numEdges = 0;
+  const uint64_t* m_offsets = nullptr;
+  const uint8_t* m_data = nullptr;
+};
+
+class LinkGraph {
+public:
+  static constexpr NodeId NOT_FOUND = NodesFile::NOT_FOUND;
+
+  // Loads the graph from files <prefix>.nodes, <prefix>.forward and <prefix>.backward.
+  // Throws: FileNotFoundError, SystemError, ParseError.
+  explicit LinkGraph(const std::string& prefix);
+
+  NodeId numNodes() const { return m_nodes.numNodes(); }
+  uint64_t numLinks() const { return m_forward.numEdges(); }
+  std::string_view title(NodeId node) const { return m_nodes.title(node); }
+  int64_t pageid(NodeId node) const { return m_nodes.pageid(node); }
+  // Returns the node of a page from its normalized title, or NOT_FOUND.
+  NodeId findNode(std::string_view title) const { return m_nodes.findNode(title); }
+
+  // Pages that `node` links to. Links to redirects are resolved to their final target.
+  std::vector<NodeId> getLinks(NodeId node) const;
+  // Pages that link to `node`, directly or through redirects.
+  std::vector<NodeId> getBacklinks(NodeId node) const;
+  bool hasLinks(NodeId node) const { return m_forward.hasNeighbors(node); }
+  bool hasBacklinks(NodeId node) const { return m_backward.hasNeighbors(node); }
+
+private:
+  NodesFile m_nodes;
+  AdjacencyFile m_forward;
+  AdjacencyFile m_backward;
+};
+
+}  // namespace link_graph
+
+#endif
@@ -0,0 +1,107 @@
+#include "link_graph.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "cbl/error.h"
+#include "cbl/file.h"
+#include "cbl/log.h"
+#include "cbl/tempfile.h"
+#include "cbl/unittest.h"
+
+using std::string;
+using std::vector;
+
+namespace link_graph {
+
+class LinkGraphTest : public cbl::Test {
+private:
+  CBL_TEST_CASE(AdjacencyFile) {
+    cbl::TempDir tempDir;
+    const string path = tempDir.path() + "/graph.forward";
+    // Large gaps between neighbors test varints of several bytes.
+    vector<uint64_t> rowStart = {0, 3, 3, 4, 7};
+    vector<NodeId> neighbors = {1, 2, 3, 0, 0, 200, 0x7FFFFFFF};
+    writeAdjacencyFile(path, rowStart, neighbors);
+
+    AdjacencyFile adjacencyFile(path);
+    CBL_ASSERT_EQ(adjacencyFile.numNodes(), 4u);
+    CBL_ASSERT_EQ(adjacencyFile.numEdges(), 7u);
+    CBL_ASSERT(adjacencyFile.hasNeighbors(0));
+    CBL_ASSERT(!adjacencyFile.hasNeighbors(1));
+    vector<NodeId> result = {42};
+    adjacencyFile.getNeighbors(0, result);
+    CBL_ASSERT(result == vector<NodeId>({1, 2, 3}));
+    adjacencyFile.getNeighbors(1, result);
+    CBL_ASSERT(result.empty());
+    adjacencyFile.getNeighbors(3, result);
+    CBL_ASSERT(result == vector<NodeId>({0, 200, 0x7FFFFFFF}));
+  }
+
+  CBL_TEST_CASE(InvalidFile) {
+    cbl::TempDir tempDir;
+    const string path = tempDir.path() + "/graph.forward";
+    cbl::writeFile(path, "not a graph");
+    try {
+      AdjacencyFile adjacencyFile(path);
+      CBL_ASSERT(false) << "ParseError not thrown";
+    } catch (const cbl::ParseError&) {
+    }
+  }
+
+  CBL_TEST_CASE(NodesFile) {
+    cbl::TempDir tempDir;
+    const string path = tempDir.path() + "/graph.nodes";
+    writeNodesFile(path, {5, 3, 8, 1}, {"Paris", "", "Lyon", "Évian-les-Bains"});
+    class NodesFile nodesFile(path);
+    CBL_ASSERT_EQ(nodesFile.numNodes(), 4u);
+    CBL_ASSERT_EQ(nodesFile.title(0), "Paris");
+    CBL_ASSERT_EQ(nodesFile.title(1), "");
+    CBL_ASSERT_EQ(nodesFile.pageid(3), 1);
+    CBL_ASSERT_EQ(nodesFile.findNode("Paris"), 0u);
+    CBL_ASSERT_EQ(nodesFile.findNode(""), 1u);
+    CBL_ASSERT_EQ(nodesFile.findNode("Lyon"), 2u);
+    CBL_ASSERT_EQ(nodesFile.findNode("Évian-les-Bains"), 3u);
+    CBL_ASSERT_EQ(nodesFile.findNode("Marseille"), NodesFile::NOT_FOUND);
+    CBL_ASSERT_EQ(nodesFile.findNode("Zurich"), NodesFile::NOT_FOUND);
+
+    writeNodesFile(path, {}, {});
+    class NodesFile emptyNodesFile(path);
+    CBL_ASSERT_EQ(emptyNodesFile.numNodes(), 0u);
+    CBL_ASSERT_EQ(emptyNodesFile.findNode("Paris"), NodesFile::NOT_FOUND);
+
+    cbl::writeFile(path, "10|A\n11|B\n");
+    try {
+      class NodesFile invalidNodesFile(path);
+      CBL_ASSERT(false) << "ParseError not thrown";
+    } catch (const cbl::ParseError&) {
+    }
+  }
+
+  CBL_TEST_CASE(LinkGraph) {
+    cbl::TempDir tempDir;
+    const string prefix = tempDir.path() + "/graph";
+    writeNodesFile(prefix + ".nodes", {10, 11, 15}, {"A", "B", "C"});
+    writeAdjacencyFile(prefix + ".forward", {0, 2, 3, 3}, {1, 2, 2});
+    writeAdjacencyFile(prefix + ".backward", {0, 0, 1, 3}, {0, 0, 1});
+
+    class LinkGraph graph(prefix);
+    CBL_ASSERT_EQ(graph.numNodes(), 3u);
+    CBL_ASSERT_EQ(graph.numLinks(), 3u);
+    NodeId nodeB = graph.findNode("B");
+    CBL_ASSERT_EQ(nodeB, 1u);
+    CBL_ASSERT_EQ(graph.title(nodeB), "B");
+    CBL_ASSERT_EQ(graph.pageid(nodeB), 11);
+    CBL_ASSERT_EQ(graph.findNode("D"), LinkGraph::NOT_FOUND);
+    CBL_ASSERT(graph.getLinks(0) == vector<NodeId>({1, 2}));
+    CBL_ASSERT(graph.getBacklinks(2) == vector<NodeId>({0, 1}));
+    CBL_ASSERT(!graph.hasLinks(2));
+    CBL_ASSERT(!graph.hasBacklinks(0));
+  }
+};
+
+}  // namespace link_graph
+
+int main() {
+  link_graph::LinkGraphTest().run();
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include "output_patcher.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "cbl/compressed_file.h"
+#include "cbl/error.h"
+#include "cbl/file.h"
+#include "cbl/log.h"
+#include "orlodrimbot/dump/processing/processes/process.h"
+
+using std::string;
+using std::unordered_set;
+using std::vector;
+
+namespace dump_processing {
+namespace {
+
+struct Record {
+  string title;
+  // Full text of the record, including the final '\n'.
+  string text;
+};
+
+class RecordReader {
+public:
+  RecordReader(OutputRecordFormat format, const string& path) : m_format(format), m_path(path), m_stream(path) {
+    CBL_ASSERT(format != OutputRecordFormat::NONE);
+    if (!m_stream) {
+      throw cbl::FileNotFoundError("Cannot open '" + path + "'");
+    }
+    readLine();
+  }
+
+  bool next(Record& record) {
+    if (!m_hasLine) {
+      return false;
+    }
+    if (m_format == OutputRecordFormat::TITLE_LINE) {
+      size_t pipePosition = m_line.find('|');
+      CBL_ASSERT(pipePosition != string::npos) << "Invalid line in '" << m_path << "': " << m_line;
+      record.title = m_line.substr(0, pipePosition);
+      record.text = m_line + '\n';
+      readLine();
+    } else {
+      CBL_ASSERT(!m_line.starts_with(" ")) << "Invalid simple dump '" << m_path << "'";
+      record.title = m_line;
+      record.text = m_line + '\n';
+      while (readLine() && m_line.starts_with(" ")) {
+        record.text += m_line;
+        record.text += '\n';
+      }
+    }
+    return true;
+  }
+
+private:
+  bool readLine() {
+    m_hasLine = static_cast<bool>(std::getline(m_stream, m_line));
+    return m_hasLine;
+  }
+
+  OutputRecordFormat m_format;
+  string m_path;
+  cbl::CompressedFileInputStream m_stream;
+  string m_line;
+  bool m_hasLine = false;
+};
+
+void writeRecord(FILE* file, const Record& record, const string& path) {
+  if (fwrite(record.text.data(), 1, record.text.size(), file) != record.text.size()) {
+    throw cbl::SystemError("Cannot write to '" + path + "'");
+  }
+}
+
+}  // namespace
+
+void patchOutputFile(OutputRecordFormat format, const string& oldPath, const string& deltaPath,
+                     const unordered_set<string>& removedTitles, const string& newPath) {
+  vector<Record> deltaRecords;
+  unordered_set<string> deltaTitles;
+  {
+    RecordReader deltaReader(format, deltaPath);
+    Record record;
+    while (deltaReader.next(record)) {
+      deltaTitles.insert(record.title);
+      deltaRecords.push_back(std::move(record));
+    }
+  }
+  std::sort(deltaRecords.begin(), deltaRecords.end(),
+            [](const Record& record1, const Record& record2) { return record1.text < record2.text; });
+
+  // The output keeps the compression of the old file. newPath may not have the same extension (e.g. "file.gz.new").
+  std::unique_ptr<cbl::CompressedFileWriter> compressedWriter;
+  FILE* newFile = nullptr;
+  if (cbl::isCompressedFileName(oldPath)) {
+    compressedWriter = std::make_unique<cbl::CompressedFileWriter>(newPath);
+    newFile = compressedWriter->file();
+  } else {
+    newFile = fopen(newPath.c_str(), "w");
+    if (newFile == nullptr) {
+      throw cbl::SystemError("Cannot write to '" + newPath + "'");
+    }
+  }
+  try {
+    vector<Record>::const_iterator deltaIt = deltaRecords.begin();
+    RecordReader oldReader(format, oldPath);
+    Record record;
+    while (oldReader.next(record)) {
+      if (removedTitles.count(record.title) != 0 || deltaTitles.count(record.title) != 0) {
+        continue;
+      }
+      for (; deltaIt != deltaRecords.end() && deltaIt->text < record.text; ++deltaIt) {
+        writeRecord(newFile, *deltaIt, newPath);
+      }
+      writeRecord(newFile, record, newPath);
+    }
+    for (; deltaIt != deltaRecords.end(); ++deltaIt) {
+      writeRecord(newFile, *deltaIt, newPath);
+    }
+  } catch (...) {
+    // A read error must not leave a partial file that could be mistaken for a complete one.
+    if (compressedWriter) {
+      compressedWriter.reset();
+    } else {
+      fclose(newFile);
+    }
+    cbl::removeFile(newPath, /* mustExist = */ false);
+    throw;
+  }
+  if (compressedWriter) {
+    compressedWriter->close();
+  } else if (fclose(newFile) != 0) {
+    throw cbl::SystemError("Cannot close '" + newPath + "'");
+  }
+}
+
+}  // namespace dump_processing
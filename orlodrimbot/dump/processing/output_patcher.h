@@ -0,0 +1,23 @@
+#ifndef OUTPUT_PATCHER_H
+#define OUTPUT_PATCHER_H
+
+#include <string>
+#include <unordered_set>
+#include "orlodrimbot/dump/processing/processes/process.h"
+
+namespace dump_processing {
+
+// Writes to `newPath` the records of `oldPath`, except those whose title is in `removedTitles`, plus all records of
+// `deltaPath`. Records of `oldPath` are kept in the same order. Records of `deltaPath` are sorted and each one is
+// inserted before the first record of `oldPath` that is greater, so that the result is sorted if `oldPath` is.
+// Titles of records in `deltaPath` are automatically added to `removedTitles`.
+// Input files may be compressed. `newPath` is compressed if `oldPath` is (see cbl/compressed_file.h).
+// `format` must not be OutputRecordFormat::NONE.
+// Throws: FileNotFoundError, SystemError (including read errors of truncated compressed files). In that case,
+// `newPath` is removed.
+void patchOutputFile(OutputRecordFormat format, const std::string& oldPath, const std::string& deltaPath,
+                     const std::unordered_set<std::string>& removedTitles, const std::string& newPath);
+
+}  // namespace dump_processing
+
+#endif
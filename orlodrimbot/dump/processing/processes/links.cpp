@@ -0,0 +1,128 @@
+#include "links.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cbl/log.h"
+#include "mwclient/parser.h"
+#include "mwclient/titles_util.h"
+#include "mwclient/wiki.h"
+#include "orlodrimbot/dump/link_graph/link_graph.h"
+#include "process.h"
+
+using std::string;
+using std::vector;
+
+namespace dump_processing {
+
+uint32_t Links::getTitleId(const string& title) {
+  auto [it, inserted] = m_titleIds.emplace(title, m_nodeOfTitle.size());
+  if (inserted) {
+    m_nodeOfTitle.push_back(NO_NODE);
+  }
+  return it->second;
+}
+
+void Links::processPage(Page& page) {
+  mwc::Wiki& wiki = environment().wiki();
+  uint32_t node = m_titles.size();
+  uint32_t titleId = getTitleId(page.title());
+  if (m_nodeOfTitle[titleId] != NO_NODE) {
+    CBL_WARNING << "Page '" << page.title() << "' appears twice in the dump";
+  }
+  m_nodeOfTitle[titleId] = node;
+  m_titles.push_back(page.title());
+  m_pageids.push_back(page.pageid());
+  m_linksStart.push_back(m_links.size());
+  string redirectTarget;
+  if (wiki.readRedirect(page.code(), &redirectTarget, nullptr)) {
+    m_redirectTargets.push_back(getTitleId(wiki.parseTitle(redirectTarget, mwc::NS_MAIN, mwc::PTF_LINK_TARGET).title));
+    // Redirects are not counted as backlinks of their target.
+    return;
+  }
+  m_redirectTargets.push_back(NO_NODE);
+  for (const wikicode::Link* link : page.links()) {
+    mwc::TitleParts titleParts = wiki.parseTitle(link->target(), mwc::NS_MAIN, mwc::PTF_LINK_TARGET);
+    int namespace_ = titleParts.namespaceNumber;
+    if (namespace_ < 0 || ((namespace_ == mwc::NS_CATEGORY || namespace_ == mwc::NS_FILE) &&
+                           !link->targetStartsWithColon())) {
+      // Interwikis, special pages, media links, categories and images are not links to pages.
+      continue;
+    }
+    titleParts.clearAnchor();
+    if (titleParts.title.empty()) {
+      continue;  // Link to a section of the same page.
+    }
+    m_links.push_back(getTitleId(titleParts.title));
+  }
+}
+
+uint32_t Links::resolveTitle(uint32_t titleId) const {
+  // Following more redirects than MediaWiki does allows to resolve double redirects, which bots fix quickly anyway.
+  // The limit also protects against cycles.
+  static constexpr int MAX_REDIRECTS = 5;
+  for (int i = 0; i <= MAX_REDIRECTS; i++) {
+    uint32_t node = m_nodeOfTitle[titleId];
+    if (node == NO_NODE || m_redirectTargets[node] == NO_NODE) {
+      return node;
+    }
+    titleId = m_redirectTargets[node];
+  }
+  return NO_NODE;
+}
+
+void Links::finalize() {
+  Process::finalize();
+  m_linksStart.push_back(m_links.size());
+  const uint32_t numNodes = m_titles.size();
+  const string outputPrefix = getAbsolutePath(getParameter("output"));
+
+  link_graph::writeNodesFile(outputPrefix + ".nodes", m_pageids, m_titles);
+
+  vector<uint32_t> resolvedTitles(m_nodeOfTitle.size());
+  for (uint32_t titleId = 0; titleId < resolvedTitles.size(); titleId++) {
+    resolvedTitles[titleId] = resolveTitle(titleId);
+  }
+  m_titleIds.clear();
+
+  // Replace title ids with resolved nodes in place, removing duplicates, self-links and missing targets.
+  vector<uint64_t> rowStart(numNodes + 1);
+  uint64_t numEdges = 0;
+  for (uint32_t node = 0; node < numNodes; node++) {
+    rowStart[node] = numEdges;
+    for (uint64_t i = m_linksStart[node]; i < m_linksStart[node + 1]; i++) {
+      uint32_t target = resolvedTitles[m_links[i]];
+      if (target != NO_NODE && target != node) {
+        m_links[numEdges++] = target;
+      }
+    }
+    std::sort(m_links.begin() + rowStart[node], m_links.begin() + numEdges);
+    numEdges = std::unique(m_links.begin() + rowStart[node], m_links.begin() + numEdges) - m_links.begin();
+  }
+  rowStart[numNodes] = numEdges;
+  m_links.resize(numEdges);
+  m_links.shrink_to_fit();
+  link_graph::writeAdjacencyFile(outputPrefix + ".forward", rowStart, m_links);
+
+  // Transpose. Sources are enumerated in increasing order, so each list of backlinks is sorted.
+  vector<uint64_t> reverseRowStart(numNodes + 1, 0);
+  for (uint32_t target : m_links) {
+    reverseRowStart[target + 1]++;
+  }
+  for (uint32_t node = 0; node < numNodes; node++) {
+    reverseRowStart[node + 1] += reverseRowStart[node];
+  }
+  vector<uint64_t> nextPosition(reverseRowStart.begin(), reverseRowStart.end() - 1);
+  vector<uint32_t> backlinks(numEdges);
+  for (uint32_t node = 0; node < numNodes; node++) {
+    for (uint64_t i = rowStart[node]; i < rowStart[node + 1]; i++) {
+      backlinks[nextPosition[m_links[i]]++] = node;
+    }
+  }
+  link_graph::writeAdjacencyFile(outputPrefix + ".backward", reverseRowStart, backlinks);
+  std::cerr << "Link graph: " << numNodes << " pages, " << numEdges << " links" << std::endl;
+}
+
+}  // namespace dump_processing
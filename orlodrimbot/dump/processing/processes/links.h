@@ -0,0 +1,47 @@
+#ifndef LINKS_H
+#define LINKS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "process.h"
+
+namespace dump_processing {
+
+// Builds the graph of internal links between pages (see orlodrimbot/dump/link_graph/link_graph.h for the format).
+// Parameter "output" is the prefix of the output files.
+// Links are resolved at the end of the dump, once all titles and redirects are known. Links to missing pages are
+// dropped and links to redirects are replaced with links to their final target. Redirects themselves have no links, so
+// they do not appear among the backlinks of their target.
+class Links : public Process {
+public:
+  Links() : Process({"output"}) {}
+  void processPage(Page& page) override;
+  void finalize() override;
+  // The graph is kept in memory until the end and is too large to be saved at each checkpoint.
+  bool isResumable() const override { return false; }
+
+private:
+  static constexpr uint32_t NO_NODE = static_cast<uint32_t>(-1);
+
+  // Returns a unique id for a normalized title, whether it exists as a page or not.
+  uint32_t getTitleId(const std::string& title);
+  // Returns the node of the page that `titleId` leads to after following redirects, or NO_NODE.
+  uint32_t resolveTitle(uint32_t titleId) const;
+
+  std::unordered_map<std::string, uint32_t> m_titleIds;
+  // For each title id, the corresponding node if the page exists, NO_NODE otherwise.
+  std::vector<uint32_t> m_nodeOfTitle;
+  // For each node (i.e. page in the dump).
+  std::vector<std::string> m_titles;
+  std::vector<int64_t> m_pageids;
+  std::vector<uint32_t> m_redirectTargets;  // Title id of the target for redirects, NO_NODE otherwise.
+  std::vector<uint64_t> m_linksStart;
+  // Title ids of link targets of all nodes, in the order of nodes.
+  std::vector<uint32_t> m_links;
+};
+
+}  // namespace dump_processing
+
+#endif
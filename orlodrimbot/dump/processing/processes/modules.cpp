@@ -1,13 +1,18 @@
 #include "modules.h"
+#include <string>
 #include "process.h"
 
+using std::string;
+
 namespace dump_processing {
 
-void Modules::processPage(Page& page) {
+bool Modules::wantsPage(int namespace_, const string& title) const {
   const int NS_MODULE = 828;
-  if (page.namespace_() == NS_MODULE) {
-    writePageToSimpleDump(page);
-  }
+  return namespace_ == NS_MODULE;
+}
+
+void Modules::processPage(Page& page) {
+  writePageToSimpleDump(page);
 }
 
 }  // namespace dump_processing
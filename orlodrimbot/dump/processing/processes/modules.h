@@ -1,12 +1,14 @@
 #ifndef MODULES_H
 #define MODULES_H
 
+#include <string>
 #include "process.h"
 
 namespace dump_processing {
 
 class Modules : public ProcessWithSingleOutputFile {
 public:
+  bool wantsPage(int namespace_, const std::string& title) const override;
   void processPage(Page& page) override;
 };
 
@@ -1,11 +1,16 @@
 #include "process.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
+#include "cbl/compressed_file.h"
 #include "cbl/date.h"
 #include "cbl/log.h"
 #include "cbl/string.h"
@@ -61,12 +66,20 @@ void Page::resetInternal() {
 
 const wikicode::List& Page::parsedCode() {
   if (!(m_knownProperties & PKP_PARSEDCODE)) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     m_parsedCode = wikicode::parse(m_code);
+    m_parsingTime += std::chrono::steady_clock::now() - start;
     m_knownProperties |= PKP_PARSEDCODE;
   }
   return m_parsedCode;
 }
 
+std::chrono::steady_clock::duration Page::takeParsingTime() {
+  std::chrono::steady_clock::duration parsingTime = m_parsingTime;
+  m_parsingTime = std::chrono::steady_clock::duration::zero();
+  return parsingTime;
+}
+
 const vector<const wikicode::Link*>& Page::links() {
   if (!(m_knownProperties & PKP_LINKS)) {
     m_links.clear();
@@ -100,12 +113,37 @@ Process::~Process() {}
 void Process::prepare() {}
 
 void Process::finalize() {
-  if (m_mainOutputFile != nullptr) {
+  if (m_compressedOutput) {
+    m_compressedOutput->close();
+    m_compressedOutput.reset();
+    m_mainOutputFile = nullptr;
+  } else if (m_mainOutputFile != nullptr) {
     CBL_ASSERT_EQ(fclose(m_mainOutputFile), 0) << "Failed to close the output file of process " << m_name;
     m_mainOutputFile = nullptr;
   }
 }
 
+int64_t Process::flushOutput() {
+  if (m_mainOutputFile == nullptr) {
+    return -1;
+  } else if (m_compressedOutput) {
+    // The position is the size of the compressed file, which is also where the file is truncated when resuming.
+    return m_compressedOutput->sync();
+  }
+  CBL_ASSERT_EQ(fflush(m_mainOutputFile), 0) << "Failed to flush the output file of process " << m_name;
+  int64_t position = ftello(m_mainOutputFile);
+  CBL_ASSERT(position >= 0) << "Cannot get the position in the output file of process " << m_name;
+  return position;
+}
+
+string Process::saveState() const {
+  return string();
+}
+
+void Process::restoreState(const string& state) {
+  CBL_ASSERT(state.empty()) << "Process " << m_name << " cannot restore a non-empty state";
+}
+
 void Process::setName(const string& name) {
   m_name = name;
 }
@@ -114,6 +152,14 @@ void Process::setEnvironment(Environment* environment) {
   m_environment = environment;
 }
 
+void Process::setOutputPositionForResume(int64_t position) {
+  m_outputPositionForResume = position;
+}
+
+void Process::setOutputPathSuffix(const string& suffix) {
+  m_outputPathSuffix = suffix;
+}
+
 void Process::setParameters(const string& parameters) {
   for (string_view keyAndValue : cbl::split(parameters, ',', /* ignoreLastFieldIfEmpty = */ true)) {
     size_t colonPosition = keyAndValue.find(':');
@@ -150,9 +196,31 @@ string Process::getAbsolutePath(const string& fileName) {
 
 void Process::openMainOutputFileFromParam(const string& key) {
   CBL_ASSERT(m_mainOutputFile == nullptr);
-  string fullPath = getAbsolutePath(getParameter(key));
-  m_mainOutputFile = fopen(fullPath.c_str(), "w");
-  CBL_ASSERT(m_mainOutputFile != nullptr) << "Cannot write to '" << fullPath << "'";
+  m_mainOutputPath = getAbsolutePath(getParameter(key));
+  string fullPath = m_mainOutputPath + m_outputPathSuffix;
+  if (cbl::isCompressedFileName(m_mainOutputPath)) {
+    bool resume = m_outputPositionForResume >= 0;
+    if (resume) {
+      struct stat fileStat;
+      CBL_ASSERT(stat(fullPath.c_str(), &fileStat) == 0 && fileStat.st_size >= m_outputPositionForResume)
+          << "'" << fullPath << "' is missing or shorter than its size in the checkpoint";
+      CBL_ASSERT_EQ(truncate(fullPath.c_str(), m_outputPositionForResume), 0) << "Cannot truncate '" << fullPath << "'";
+    }
+    m_compressedOutput = std::make_unique<cbl::CompressedFileWriter>(fullPath, /* append = */ resume);
+    m_mainOutputFile = m_compressedOutput->file();
+  } else if (m_outputPositionForResume >= 0) {
+    m_mainOutputFile = fopen(fullPath.c_str(), "r+");
+    CBL_ASSERT(m_mainOutputFile != nullptr) << "Cannot reopen '" << fullPath << "' to resume processing";
+    CBL_ASSERT(fseeko(m_mainOutputFile, 0, SEEK_END) == 0 && ftello(m_mainOutputFile) >= m_outputPositionForResume)
+        << "'" << fullPath << "' is shorter than its size in the checkpoint";
+    CBL_ASSERT_EQ(ftruncate(fileno(m_mainOutputFile), m_outputPositionForResume), 0)
+        << "Cannot truncate '" << fullPath << "'";
+    CBL_ASSERT_EQ(fseeko(m_mainOutputFile, m_outputPositionForResume, SEEK_SET), 0)
+        << "Cannot seek in '" << fullPath << "'";
+  } else {
+    m_mainOutputFile = fopen(fullPath.c_str(), "w");
+    CBL_ASSERT(m_mainOutputFile != nullptr) << "Cannot write to '" << fullPath << "'";
+  }
 }
 
 void Process::writePageToSimpleDump(const Page& page) const {
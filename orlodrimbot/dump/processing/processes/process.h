@@ -1,11 +1,14 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "cbl/compressed_file.h"
 #include "cbl/date.h"
 #include "mwclient/parser.h"
 #include "mwclient/util/xml_dump.h"
@@ -40,6 +43,9 @@ public:
   const wikicode::List& parsedCode();
   const std::vector<const wikicode::Link*>& links();
   const std::vector<const wikicode::Template*>& templates();
+  // Returns the time spent in parsing since the last call and resets it. This allows to attribute parsing time to the
+  // first process that calls parsedCode().
+  std::chrono::steady_clock::duration takeParsingTime();
 
 private:
   void resetInternal();
@@ -54,27 +60,63 @@ private:
   cbl::Date m_timestamp;
   std::string m_code;
   wikicode::List m_parsedCode;
+  std::chrono::steady_clock::duration m_parsingTime{};
   std::vector<const wikicode::Link*> m_links;
   std::vector<const wikicode::Template*> m_templates;
 };
 
+// Describes how the main output file of a process is split into per-page records. This allows to update the output of
+// a previous run for a subset of pages.
+enum class OutputRecordFormat {
+  // The output cannot be updated incrementally.
+  NONE,
+  // One line per page, starting with the title followed by '|'.
+  TITLE_LINE,
+  // Output of writePageToSimpleDump(): a line with the title followed by lines of content starting with a space.
+  SIMPLE_DUMP,
+};
+
 class Process {
 public:
   explicit Process(const std::vector<std::string>& validParameters = {});
   virtual ~Process();
+  const std::string& name() const { return m_name; }
   void setName(const std::string& name);
   void setEnvironment(Environment* environment);
   void setParameters(const std::string& parameters);
+  // When resuming from a checkpoint, must be called before prepare() with the value that flushOutput() returned when
+  // the checkpoint was created. The main output file is then truncated to that size instead of being overwritten.
+  void setOutputPositionForResume(int64_t position);
+  // If called before prepare(), `suffix` is appended to the path of the main output file. This is used to write the
+  // output for changed pages next to the output of a previous run.
+  void setOutputPathSuffix(const std::string& suffix);
+  // Path of the main output file, without the suffix set by setOutputPathSuffix(). Empty if there is none.
+  const std::string& mainOutputPath() const { return m_mainOutputPath; }
+  virtual OutputRecordFormat outputRecordFormat() const { return OutputRecordFormat::NONE; }
+  // Returns whether processPage() should be called for a page. This is checked before reading the content, which is
+  // not decoded at all if no process wants the page, so processes that only look at a few pages should override it.
+  virtual bool wantsPage(int namespace_, const std::string& title) const { return true; }
   virtual void prepare();
   // Overrides must call the base version.
   virtual void finalize();
   virtual void processPage(Page& page) = 0;
+  // Flushes the main output file and returns its size, or -1 if the process has no main output file.
+  int64_t flushOutput();
+  // Processes that aggregate data in memory must override these two functions so that runs can be resumed from a
+  // checkpoint. saveState() returns an opaque representation of everything processed since prepare(), which must be
+  // a valid UTF-8 string. restoreState() is called after prepare() with that value.
+  // Processes whose state is too large to be saved must override isResumable() instead. Checkpoints are then not
+  // written for runs that include them.
+  virtual bool isResumable() const { return true; }
+  virtual std::string saveState() const;
+  virtual void restoreState(const std::string& state);
 
 protected:
   Environment& environment() { return *m_environment; }
   bool hasParameter(const std::string& key) const;
   const std::string& getParameter(const std::string& key) const;
   std::string getAbsolutePath(const std::string& fileName);
+  // If the file name ends with ".gz", the output is compressed in a background thread.
   void openMainOutputFileFromParam(const std::string& key);
   FILE* mainOutputFile() const { return m_mainOutputFile; }
   void writePageToSimpleDump(const Page& page) const;
@@ -83,6 +125,11 @@ private:
   std::string m_name;
   Environment* m_environment = nullptr;
   FILE* m_mainOutputFile = nullptr;
+  // Set if the main output file is compressed. m_mainOutputFile is then owned by it.
+  std::unique_ptr<cbl::CompressedFileWriter> m_compressedOutput;
+  int64_t m_outputPositionForResume = -1;
+  std::string m_mainOutputPath;
+  std::string m_outputPathSuffix;
   std::unordered_map<std::string, std::string> m_parameters;
 };
 
@@ -90,6 +137,8 @@ class ProcessWithSingleOutputFile : public Process {
 public:
   ProcessWithSingleOutputFile() : Process({"output"}) {}
   void prepare() override { openMainOutputFileFromParam("output"); }
+  // Subclasses are expected to write their output with writePageToSimpleDump().
+  OutputRecordFormat outputRecordFormat() const override { return OutputRecordFormat::SIMPLE_DUMP; }
 };
 
 }  // namespace dump_processing
@@ -0,0 +1,50 @@
+#include "redirects.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cbl/compressed_file.h"
+#include "cbl/log.h"
+#include "mwclient/titles_util.h"
+#include "mwclient/wiki.h"
+#include "orlodrimbot/dump/redirect_table/redirect_table.h"
+#include "process.h"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace dump_processing {
+
+void Redirects::prepare() {
+  openMainOutputFileFromParam("output");
+}
+
+void Redirects::processPage(Page& page) {
+  mwc::Wiki& wiki = environment().wiki();
+  string target;
+  if (wiki.readRedirect(page.code(), &target, nullptr)) {
+    mwc::TitleParts titleParts = wiki.parseTitle(target, mwc::NS_MAIN, mwc::PTF_LINK_TARGET);
+    titleParts.clearAnchor();
+    fprintf(mainOutputFile(), "%s|%s\n", page.title().c_str(), titleParts.title.c_str());
+  }
+}
+
+void Redirects::finalize() {
+  Process::finalize();
+  vector<pair<string, string>> redirects;
+  cbl::CompressedFileInputStream outputStream(mainOutputPath());
+  CBL_ASSERT(outputStream) << "Cannot read '" << mainOutputPath() << "'";
+  string line;
+  while (std::getline(outputStream, line)) {
+    size_t pipePosition = line.find('|');
+    CBL_ASSERT(pipePosition != string::npos) << "Invalid line in '" << mainOutputPath() << "': " << line;
+    redirects.emplace_back(line.substr(0, pipePosition), line.substr(pipePosition + 1));
+  }
+  size_t numRedirects = redirects.size();
+  redirect_table::writeRedirectTable(getAbsolutePath(getParameter("table")), std::move(redirects));
+  std::cerr << "Redirect table: " << numRedirects << " redirects" << std::endl;
+}
+
+}  // namespace dump_processing
@@ -0,0 +1,24 @@
+#ifndef REDIRECTS_H
+#define REDIRECTS_H
+
+#include <string>
+#include "process.h"
+
+namespace dump_processing {
+
+// Lists redirects of the dump.
+// Parameters:
+//   output: text file with one line "<title>|<target>" per redirect, where the target is normalized and has no anchor.
+//   table: binary redirect table with chains collapsed (see orlodrimbot/dump/redirect_table/redirect_table.h). It is
+//     built from the text file at the end of the run, so that it also works when resuming from a checkpoint.
+class Redirects : public Process {
+public:
+  Redirects() : Process({"output", "table"}) {}
+  void prepare() override;
+  void processPage(Page& page) override;
+  void finalize() override;
+};
+
+}  // namespace dump_processing
+
+#endif
@@ -1,13 +1,18 @@
 #include "templates.h"
+#include <string>
 #include "mwclient/wiki.h"
 #include "process.h"
 
+using std::string;
+
 namespace dump_processing {
 
+bool Templates::wantsPage(int namespace_, const string& title) const {
+  return namespace_ == mwc::NS_TEMPLATE;
+}
+
 void Templates::processPage(Page& page) {
-  if (page.namespace_() == mwc::NS_TEMPLATE) {
-    writePageToSimpleDump(page);
-  }
+  writePageToSimpleDump(page);
 }
 
 }  // namespace dump_processing
@@ -1,12 +1,14 @@
 #ifndef TEMPLATES_H
 #define TEMPLATES_H
 
+#include <string>
 #include "process.h"
 
 namespace dump_processing {
 
 class Templates : public ProcessWithSingleOutputFile {
 public:
+  bool wantsPage(int namespace_, const std::string& title) const override;
   void processPage(Page& page) override;
 };
 
@@ -1,10 +1,10 @@
 #include "titles.h"
-#include <re2/re2.h>
 #include <cstdio>
 #include <cstring>
 #include <string>
 #include "cbl/file.h"
 #include "cbl/log.h"
+#include "cbl/multi_pattern_matcher.h"
 #include "mwclient/titles_util.h"
 #include "mwclient/wiki.h"
 #include "process.h"
@@ -16,29 +16,32 @@ namespace dump_processing {
 void Titles::prepare() {
   string disambigRegexp = cbl::readFile(getAbsolutePath(getParameter("input_disambigregexp")));
   CBL_ASSERT(disambigRegexp.find('\n') == string::npos);
-  m_reDisambiguation.reset(new re2::RE2(disambigRegexp));
+  m_reDisambiguation = m_matcher.add(disambigRegexp);
+  m_reStub = m_matcher.add(R"(\{\{\s*[ÉEée]bauche\s*[|}])");
+  m_rePortal = m_matcher.add(R"(\{\{\s*[Pp]ortail(\s|\|))");
+  m_reCategory = m_matcher.add(R"((?i:\[\[\s*(Catégorie|Category)\s*:))");
+  m_reEvaluation = m_matcher.add(R"(\{\{\s*[Ww]ikiprojet\s*[|}])");
+  m_reNonEmptyTodo = m_matcher.add(R"(\{\{(\s|\n)*([Àà] +faire|[Tt]odo|[Tt]ODO)(\s|\n)*\|(\s|\n)*[^\s\n\}])");
+  m_reEmptyTodo = m_matcher.add(R"(\{\{(\s|\n)*([Àà] +faire|[Tt]odo|[Tt]ODO)(\s|\n)*(\|(\s|\n)*)?\}\})");
+  m_matcher.compile();
   openMainOutputFileFromParam("output");
 }
 
 void Titles::processPage(Page& page) {
-  static const re2::RE2 rePortal(R"(\{\{\s*[Pp]ortail(\s|\|))");
-  static const re2::RE2 reStub(R"(\{\{\s*[ÉEée]bauche\s*[|}])");
-  static const re2::RE2 reCategory(R"((?i:\[\[\s*(Catégorie|Category)\s*:))");
-  static const re2::RE2 reEvaluation(R"(\{\{\s*[Ww]ikiprojet\s*[|}])");
-  static const re2::RE2 reNonEmptyTodo(R"(\{\{(\s|\n)*([Àà] +faire|[Tt]odo|[Tt]ODO)(\s|\n)*\|(\s|\n)*[^\s\n\}])");
-  static const re2::RE2 reEmptyTodo(R"(\{\{(\s|\n)*([Àà] +faire|[Tt]odo|[Tt]ODO)(\s|\n)*(\|(\s|\n)*)?\}\})");
-
   const string& code = page.code();
   int namespace_ = page.namespace_();
   string redirTarget, redirAnchor;
+  // readRedirect only looks at the beginning of the page, so it does not need to be part of the scan.
   bool isRedirect = environment().wiki().readRedirect(code, &redirTarget, &redirAnchor);
-  bool isDisambiguation = RE2::PartialMatch(code, *m_reDisambiguation);
-  bool isStub = RE2::PartialMatch(code, reStub);
-  bool hasPortal = namespace_ == mwc::NS_MAIN && RE2::PartialMatch(code, rePortal);
-  bool hasCat = RE2::PartialMatch(code, reCategory);
-  bool hasEval = namespace_ == mwc::NS_TALK && RE2::PartialMatch(code, reEvaluation);
-  bool hasNonEmptyTodo = namespace_ == mwc::NS_TALK && RE2::PartialMatch(code, reNonEmptyTodo);
-  bool hasEmptyTodo = namespace_ == mwc::NS_TALK && RE2::PartialMatch(code, reEmptyTodo);
+  // Patterns that are only relevant for some namespaces are matched anyway. This is cheaper than a second scan.
+  cbl::MultiPatternMatcher::Result matches = m_matcher.match(code);
+  bool isDisambiguation = matches.test(m_reDisambiguation);
+  bool isStub = matches.test(m_reStub);
+  bool hasPortal = namespace_ == mwc::NS_MAIN && matches.test(m_rePortal);
+  bool hasCat = matches.test(m_reCategory);
+  bool hasEval = namespace_ == mwc::NS_TALK && matches.test(m_reEvaluation);
+  bool hasNonEmptyTodo = namespace_ == mwc::NS_TALK && matches.test(m_reNonEmptyTodo);
+  bool hasEmptyTodo = namespace_ == mwc::NS_TALK && matches.test(m_reEmptyTodo);
 
   string properties;
   properties.reserve(strlen("|RHPCEtT||") + redirTarget.size() + redirAnchor.size());
@@ -1,8 +1,7 @@
 #ifndef TITLES_H
 #define TITLES_H
 
-#include <re2/re2.h>
-#include <memory>
+#include "cbl/multi_pattern_matcher.h"
 #include "process.h"
 
 namespace dump_processing {
@@ -12,9 +11,18 @@ public:
   Titles() : Process({"input_disambigregexp", "output"}) {}
   void prepare() override;
   void processPage(Page& page) override;
+  OutputRecordFormat outputRecordFormat() const override { return OutputRecordFormat::TITLE_LINE; }
 
 private:
-  std::unique_ptr<re2::RE2> m_reDisambiguation;
+  // All properties are detected with a single scan of the code of each page.
+  cbl::MultiPatternMatcher m_matcher;
+  int m_reDisambiguation = -1;
+  int m_reStub = -1;
+  int m_rePortal = -1;
+  int m_reCategory = -1;
+  int m_reEvaluation = -1;
+  int m_reNonEmptyTodo = -1;
+  int m_reEmptyTodo = -1;
 };
 
 }  // namespace dump_processing
@@ -8,11 +8,14 @@
 #include <unordered_map>
 #include <vector>
 #include "cbl/args_parser.h"
+#include "cbl/date.h"
+#include "cbl/file.h"
 #include "cbl/string.h"
 #include "mwclient/util/init_wiki.h"
 #include "mwclient/util/xml_dump.h"
 #include "mwclient/wiki.h"
 #include "orlodrimbot/dump/processing/processes/process.h"
+#include "orlodrimbot/live_replication/recent_changes_reader.h"
 #include "processing_lib.h"
 
 using std::string;
@@ -37,7 +40,15 @@ int main(int argc, char** argv) {
   mwc::WikiFlags wikiFlags(mwc::FRENCH_WIKIPEDIA_BOT);
   string dataDir;
   string processesNamesStr;
-  argsParser.addArgs(&wikiFlags, "--datadir,required", &dataDir, "--processes,required", &processesNamesStr);
+  int checkpointInterval = 100000;
+  bool resume = false;
+  string statsFile;
+  // Incremental mode: instead of reading a dump, update outputs of a previous run with pages changed since then.
+  string rcDatabase;
+  string incrementalStart;
+  argsParser.addArgs(&wikiFlags, "--datadir,required", &dataDir, "--processes,required", &processesNamesStr,
+                     "--checkpoint-interval", &checkpointInterval, "--resume", &resume, "--stats-file", &statsFile,
+                     "--rcdatabase", &rcDatabase, "--incremental-start", &incrementalStart);
   argsParser.run(argc, argv);
   vector<string> processesNames;
   for (string_view processName : cbl::split(processesNamesStr, ',')) {
@@ -60,7 +71,40 @@ int main(int argc, char** argv) {
     processGroup.addProcessByName(processName, processParamsByName.at(processName).flagValue);
   }
 
+  if (!rcDatabase.empty()) {
+    // The token is saved after each successful run, so that the next one starts where this one stopped.
+    string continueTokenFile = dataDir + "processing_incremental_token.txt";
+    string continueToken = cbl::fileExists(continueTokenFile) ? cbl::readFile(continueTokenFile) : "";
+    if (continueToken.empty() && incrementalStart.empty()) {
+      std::cerr << "--incremental-start=<date of the dump> is required for the first incremental update\n";
+      exit(1);
+    }
+    live_replication::RecentChangesReader recentChangesReader(rcDatabase);
+    live_replication::RecentlyUpdatedPagesOptions options;
+    if (continueToken.empty()) {
+      options.start = cbl::Date::fromISO8601(incrementalStart);
+    }
+    options.continueToken = &continueToken;
+    processGroup.runOnChangedPages(recentChangesReader.getRecentlyUpdatedPages(options));
+    cbl::writeFileAtomically(continueTokenFile, continueToken);
+    return 0;
+  }
+
+  if (resume && !processGroup.isResumable()) {
+    std::cerr << "--resume is not supported with the selected processes\n";
+    exit(1);
+  }
+  if (checkpointInterval > 0 || resume) {
+    // The checkpoint is written periodically and allows to resume a run that crashed with --resume, passing the same
+    // dump as input and the same processes.
+    processGroup.setCheckpoint(dataDir + "processing_checkpoint.json", checkpointInterval);
+  }
+
+  if (!statsFile.empty()) {
+    processGroup.setStatsFile(statsFile);
+  }
+
   mwc::PagesDump dump;
-  processGroup.runOnDump(dump);
+  processGroup.runOnDump(dump, resume);
   return 0;
 }
@@ -1,31 +1,57 @@
 #include "processing_lib.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
+#include "cbl/error.h"
+#include "cbl/file.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
 #include "mwclient/util/xml_dump.h"
 #include "mwclient/wiki.h"
+#include "orlodrimbot/dump/processing/processes/links.h"
 #include "orlodrimbot/dump/processing/processes/modules.h"
 #include "orlodrimbot/dump/processing/processes/process.h"
+#include "orlodrimbot/dump/processing/processes/redirects.h"
 #include "orlodrimbot/dump/processing/processes/templates.h"
 #include "orlodrimbot/dump/processing/processes/titles.h"
+#include "output_patcher.h"
 
 using std::string;
 using std::unique_ptr;
+using std::unordered_set;
 using std::vector;
+using steady_clock = std::chrono::steady_clock;
 
 namespace dump_processing {
 
+static int64_t durationToMilliseconds(steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+static int64_t getPeakRSSInKilobytes() {
+  struct rusage usage;
+  return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : -1;
+}
+
 struct ProcessDef {
   const char* name;
   std::function<Process*()> factory;
 };
 
 static const ProcessDef PROCESS_DEFS[] = {
+    {"links", []() { return new Links; }},
     {"modules", []() { return new Modules; }},
+    {"redirects", []() { return new Redirects; }},
     {"templates", []() { return new Templates; }},
     {"titles", []() { return new Titles; }},
 };
@@ -40,6 +66,7 @@ void ProcessGroup::addProcessByName(const std::string& name, const std::string&
       process->setParameters(parameters);
       process->setEnvironment(m_environment);
       m_processes.push_back(std::move(process));
+      m_processesStats.emplace_back();
       return;
     }
   }
@@ -58,17 +85,161 @@ void ProcessGroup::finalizeProcesses() {
   }
 }
 
-void ProcessGroup::runOnDump(mwc::PagesDump& dump) {
+bool ProcessGroup::anyProcessWantsPage(int namespace_, const string& title) const {
+  for (const unique_ptr<Process>& process : m_processes) {
+    if (process->wantsPage(namespace_, title)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ProcessGroup::runProcessesOnPage(Page& page) {
+  for (size_t i = 0; i < m_processes.size(); i++) {
+    if (!m_processes[i]->wantsPage(page.namespace_(), page.title())) {
+      continue;
+    }
+    ProcessStats& stats = m_processesStats[i];
+    steady_clock::time_point start = steady_clock::now();
+    m_processes[i]->processPage(page);
+    stats.processingTime += steady_clock::now() - start;
+    stats.parsingTime += page.takeParsingTime();
+    stats.pages++;
+    stats.bytes += page.code().size();
+  }
+}
+
+json::Value ProcessGroup::getStats() const {
+  json::Value stats;
+  stats.getMutable("wall_time_ms") = durationToMilliseconds(steady_clock::now() - m_startTime);
+  stats.getMutable("reading_time_ms") = durationToMilliseconds(m_readingTime);
+  stats.getMutable("skipped_pages") = m_skippedPages;
+  stats.getMutable("peak_rss_kb") = getPeakRSSInKilobytes();
+  json::Value& processesStats = stats.getMutable("processes");
+  for (size_t i = 0; i < m_processes.size(); i++) {
+    const ProcessStats& processStats = m_processesStats[i];
+    json::Value& processStatsValue = processesStats.getMutable(m_processes[i]->name());
+    processStatsValue.getMutable("processing_time_ms") = durationToMilliseconds(processStats.processingTime);
+    processStatsValue.getMutable("parsing_time_ms") = durationToMilliseconds(processStats.parsingTime);
+    processStatsValue.getMutable("pages") = processStats.pages;
+    processStatsValue.getMutable("bytes") = processStats.bytes;
+  }
+  return stats;
+}
+
+void ProcessGroup::printStats(int64_t pagesRead) const {
+  std::cerr << pagesRead << " pages read (" << m_skippedPages << " skipped, reading: "
+            << durationToMilliseconds(m_readingTime) / 1000 << "s";
+  for (size_t i = 0; i < m_processes.size(); i++) {
+    const ProcessStats& processStats = m_processesStats[i];
+    std::cerr << ", " << m_processes[i]->name() << ": " << durationToMilliseconds(processStats.processingTime) / 1000
+              << "s";
+    if (processStats.parsingTime != steady_clock::duration::zero()) {
+      std::cerr << " incl. parsing " << durationToMilliseconds(processStats.parsingTime) / 1000 << "s";
+    }
+  }
+  std::cerr << ", peak RSS: " << getPeakRSSInKilobytes() / 1024 << " MB)" << std::endl;
+}
+
+void ProcessGroup::setStatsFile(const string& path) {
+  m_statsPath = path;
+}
+
+void ProcessGroup::setCheckpoint(const string& path, int interval) {
+  m_checkpointPath = path;
+  m_checkpointInterval = interval;
+}
+
+bool ProcessGroup::isResumable() const {
+  for (const unique_ptr<Process>& process : m_processes) {
+    if (!process->isResumable()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ProcessGroup::writeCheckpoint(const mwc::PagesDump& dump, int64_t pagesRead) {
+  json::Value checkpoint;
+  checkpoint.getMutable("dump_position") = dump.position();
+  checkpoint.getMutable("pages_read") = pagesRead;
+  json::Value& processes = checkpoint.getMutable("processes");
+  processes.setToEmptyArray();
+  for (const unique_ptr<Process>& process : m_processes) {
+    json::Value& processCheckpoint = processes.addItem();
+    processCheckpoint.getMutable("name") = process->name();
+    processCheckpoint.getMutable("output_position") = process->flushOutput();
+    processCheckpoint.getMutable("state") = process->saveState();
+  }
+  cbl::writeFileAtomically(m_checkpointPath, checkpoint.toJSON(json::INDENTED));
+}
+
+int64_t ProcessGroup::resumeFromCheckpoint(mwc::PagesDump& dump) {
+  CBL_ASSERT(!m_checkpointPath.empty()) << "Cannot resume without a checkpoint file";
+  json::Value checkpoint = json::parse(cbl::readFile(m_checkpointPath));
+  const json::Value& processes = checkpoint["processes"];
+  if (processes.array().size() != static_cast<int>(m_processes.size())) {
+    throw cbl::InvalidStateError("The checkpoint was created with a different number of processes");
+  }
+  for (size_t i = 0; i < m_processes.size(); i++) {
+    const json::Value& processCheckpoint = processes[i];
+    if (processCheckpoint["name"].str() != m_processes[i]->name()) {
+      throw cbl::InvalidStateError("The checkpoint was created with different processes");
+    }
+    m_processes[i]->setOutputPositionForResume(processCheckpoint["output_position"].numberAsInt64());
+  }
   initializeProcesses();
-  Page page(m_environment->wiki());
-  for (int iPage = 1; dump.getArticle(); iPage++) {
-    if (iPage % 10000 == 0) std::cerr << iPage << " pages read" << std::endl;
-    page.reset(dump);
-    for (const unique_ptr<Process>& process : m_processes) {
-      process->processPage(page);
+  for (size_t i = 0; i < m_processes.size(); i++) {
+    m_processes[i]->restoreState(processes[i]["state"].str());
+  }
+  if (!dump.skipTo(checkpoint["dump_position"].numberAsInt64())) {
+    throw cbl::InvalidStateError("The dump is shorter than the position in the checkpoint");
+  }
+  return checkpoint["pages_read"].numberAsInt64();
+}
+
+void ProcessGroup::runOnDump(mwc::PagesDump& dump, bool resume) {
+  if (resume && !isResumable()) {
+    throw std::invalid_argument("Cannot resume a run including processes that do not support checkpoints");
+  }
+  m_startTime = steady_clock::now();
+  const int checkpointInterval = isResumable() ? m_checkpointInterval : 0;
+  int64_t iPage = 1;
+  if (resume) {
+    iPage += resumeFromCheckpoint(dump);
+    std::cerr << "Resuming after " << iPage - 1 << " pages" << std::endl;
+  } else {
+    initializeProcesses();
+  }
+  mwc::Wiki& wiki = m_environment->wiki();
+  Page page(wiki);
+  for (;; iPage++) {
+    steady_clock::time_point readingStart = steady_clock::now();
+    if (!dump.getArticle()) break;
+    bool wanted = anyProcessWantsPage(wiki.getTitleNamespace(dump.title()), dump.title());
+    if (wanted) {
+      page.reset(dump);
+    } else {
+      dump.skipContent();
+      m_skippedPages++;
+    }
+    m_readingTime += steady_clock::now() - readingStart;
+    if (wanted) {
+      runProcessesOnPage(page);
+    }
+    if (iPage % 10000 == 0) printStats(iPage);
+    if (checkpointInterval > 0 && iPage % checkpointInterval == 0) {
+      writeCheckpoint(dump, iPage);
     }
   }
   finalizeProcesses();
+  printStats(iPage - 1);
+  if (!m_statsPath.empty()) {
+    cbl::writeFile(m_statsPath, getStats().toJSON(json::INDENTED));
+  }
+  if (!m_checkpointPath.empty()) {
+    cbl::removeFile(m_checkpointPath, /* mustExist = */ false);
+  }
 }
 
 void ProcessGroup::runOnPagesForTest(const vector<mwc::Revision>& revisions) {
@@ -76,11 +247,60 @@ void ProcessGroup::runOnPagesForTest(const vector<mwc::Revision>& revisions) {
   Page page(m_environment->wiki());
   for (const mwc::Revision& revision : revisions) {
     page.reset(revision.title, 1, revision.timestamp, revision.content);
-    for (const unique_ptr<Process>& process : m_processes) {
-      process->processPage(page);
+    runProcessesOnPage(page);
+  }
+  finalizeProcesses();
+}
+
+void ProcessGroup::runOnChangedPages(const unordered_set<string>& changedTitles) {
+  // Pages are read with their content, so requests must be smaller than for other properties.
+  static constexpr int BATCH_SIZE = 50;
+  static const string DELTA_SUFFIX = ".delta";
+  static const string NEW_SUFFIX = ".new";
+
+  for (const unique_ptr<Process>& process : m_processes) {
+    if (process->outputRecordFormat() == OutputRecordFormat::NONE) {
+      throw std::invalid_argument("Process '" + process->name() + "' does not support incremental updates");
     }
+    process->setOutputPathSuffix(DELTA_SUFFIX);
+  }
+  initializeProcesses();
+  vector<string> sortedTitles(changedTitles.begin(), changedTitles.end());
+  std::sort(sortedTitles.begin(), sortedTitles.end());
+  unordered_set<string> removedTitles = changedTitles;
+  Page page(m_environment->wiki());
+  vector<mwc::Revision> revisions;
+  for (size_t batchStart = 0; batchStart < sortedTitles.size(); batchStart += BATCH_SIZE) {
+    size_t batchEnd = std::min(batchStart + BATCH_SIZE, sortedTitles.size());
+    revisions.clear();
+    revisions.resize(batchEnd - batchStart);
+    for (size_t i = batchStart; i < batchEnd; i++) {
+      revisions[i - batchStart].title = sortedTitles[i];
+    }
+    m_environment->wiki().readPages(mwc::RP_TITLE | mwc::RP_TIMESTAMP | mwc::RP_CONTENT, revisions);
+    for (const mwc::Revision& revision : revisions) {
+      if (revision.revid == -2) {
+        continue;  // Invalid title.
+      }
+      // The title may have been normalized.
+      removedTitles.insert(revision.title);
+      if (revision.revid != -1) {  // -1 means that the page does not exist.
+        // The page id is not known, but no process needs it.
+        page.reset(revision.title, 0, revision.timestamp, revision.content);
+        runProcessesOnPage(page);
+      }
+    }
+    std::cerr << batchEnd << "/" << sortedTitles.size() << " changed pages read" << std::endl;
   }
   finalizeProcesses();
+
+  for (const unique_ptr<Process>& process : m_processes) {
+    const string& path = process->mainOutputPath();
+    if (path.empty()) continue;
+    patchOutputFile(process->outputRecordFormat(), path, path + DELTA_SUFFIX, removedTitles, path + NEW_SUFFIX);
+    CBL_ASSERT_EQ(rename((path + NEW_SUFFIX).c_str(), path.c_str()), 0) << "Cannot replace '" << path << "'";
+    cbl::removeFile(path + DELTA_SUFFIX, /* mustExist = */ true);
+  }
 }
 
 vector<string> getValidProcessNames() {
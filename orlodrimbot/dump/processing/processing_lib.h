@@ -1,9 +1,13 @@
 #ifndef PROCESSING_LIB_H
 #define PROCESSING_LIB_H
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
+#include "cbl/json.h"
 #include "mwclient/util/xml_dump.h"
 #include "mwclient/wiki.h"
 #include "orlodrimbot/dump/processing/processes/process.h"
@@ -14,15 +18,58 @@ class ProcessGroup {
 public:
   explicit ProcessGroup(Environment* environment);
   void addProcessByName(const std::string& name, const std::string& parameters);
-  void runOnDump(mwc::PagesDump& dump);
+  // Enables checkpoints in runOnDump(). Every `interval` pages, output files are flushed and the state of the run is
+  // written to `path`. The file is removed when the run completes.
+  void setCheckpoint(const std::string& path, int interval);
+  // Returns false if some process does not support checkpoints. runOnDump() does not write checkpoints in that case.
+  bool isResumable() const;
+  // If `resume` is true, continues the run interrupted after the last checkpoint. Pages processed before it are
+  // skipped and output files are truncated to their size at that time. Processes must be the same as in the
+  // interrupted run.
+  // Throws: std::invalid_argument if `resume` is true and isResumable() is false.
+  void runOnDump(mwc::PagesDump& dump, bool resume = false);
   void runOnPagesForTest(const std::vector<mwc::Revision>& revisions);
+  // Updates the outputs of a previous run for pages in `changedTitles` (typically, pages edited since the dump).
+  // These pages are read from the wiki and their records in output files are replaced with the new ones, or removed if
+  // the page no longer exists. All processes must support incremental updates (see OutputRecordFormat).
+  void runOnChangedPages(const std::unordered_set<std::string>& changedTitles);
+  // If set, runOnDump() writes timing and throughput statistics to this file in JSON format at the end of the run.
+  void setStatsFile(const std::string& path);
 
 private:
+  struct ProcessStats {
+    // Time spent in processPage(), including parsing.
+    std::chrono::steady_clock::duration processingTime{};
+    // Part of processingTime spent in Page::parsedCode().
+    std::chrono::steady_clock::duration parsingTime{};
+    int64_t pages = 0;
+    int64_t bytes = 0;
+  };
+
   void initializeProcesses();
   void finalizeProcesses();
+  bool anyProcessWantsPage(int namespace_, const std::string& title) const;
+  // Calls processPage() on processes that want the page.
+  void runProcessesOnPage(Page& page);
+  json::Value getStats() const;
+  void printStats(int64_t pagesRead) const;
+  void writeCheckpoint(const mwc::PagesDump& dump, int64_t pagesRead);
+  // Initializes processes from the checkpoint and moves the dump to the corresponding position.
+  // Returns the number of pages read before the checkpoint.
+  int64_t resumeFromCheckpoint(mwc::PagesDump& dump);
 
   Environment* m_environment = nullptr;
   std::vector<std::unique_ptr<Process>> m_processes;
+  std::vector<ProcessStats> m_processesStats;
+  // Time spent in reading and unescaping the dump, including the time waiting for the decompression if the dump is
+  // read from a pipe.
+  std::chrono::steady_clock::duration m_readingTime{};
+  // Pages of the dump whose content was skipped because no process wanted them.
+  int64_t m_skippedPages = 0;
+  std::chrono::steady_clock::time_point m_startTime;
+  std::string m_statsPath;
+  std::string m_checkpointPath;
+  int m_checkpointInterval = 0;
 };
 
 std::vector<std::string> getValidProcessNames();
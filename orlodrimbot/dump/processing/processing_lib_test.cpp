@@ -0,0 +1,386 @@
+#include "processing_lib.h"
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "cbl/compressed_file.h"
+#include "cbl/directory.h"
+#include "cbl/error.h"
+#include "cbl/file.h"
+#include "cbl/json.h"
+#include "cbl/log.h"
+#include "cbl/tempfile.h"
+#include "cbl/unittest.h"
+#include "mwclient/mock_wiki.h"
+#include "mwclient/util/xml_dump.h"
+#include "mwclient/wiki.h"
+#include "orlodrimbot/dump/link_graph/link_graph.h"
+#include "orlodrimbot/dump/processing/processes/process.h"
+#include "orlodrimbot/dump/redirect_table/redirect_table.h"
+
+using std::string;
+using std::vector;
+
+namespace dump_processing {
+
+struct DumpPage {
+  string title;
+  int pageid;
+  string code;  // Escaped for XML.
+};
+
+static void writeDump(const string& path, const vector<DumpPage>& pages) {
+  string xml = "<mediawiki>\n";
+  for (const DumpPage& page : pages) {
+    xml += "  <page>\n    <title>" + page.title + "</title>\n    <id>" + std::to_string(page.pageid) +
+           "</id>\n    <revision>\n      <timestamp>2000-01-01T00:00:00Z</timestamp>\n"
+           "      <text bytes=\"123\" xml:space=\"preserve\">" +
+           page.code + "</text>\n    </revision>\n  </page>\n";
+  }
+  xml += "</mediawiki>\n";
+  cbl::writeFile(path, xml);
+}
+
+class ProcessingLibTest : public cbl::Test {
+private:
+  CBL_TEST_CASE(runOnChangedPages) {
+    cbl::TempDir tempDir;
+    const string dataDir = tempDir.path() + "/";
+    mwc::MockWiki wiki;
+    Environment environment(wiki, dataDir);
+    cbl::writeFile(dataDir + "disambig.txt", R"(\{\{[Hh]omonymie\}\})");
+
+    wiki.setPageContent("Modèle:A", "Old A");
+    wiki.setPageContent("Modèle:B", "B");
+    wiki.setPageContent("Modèle:C", "Old C\nline 2");
+    wiki.setPageContent("Modèle:D", "D");
+    wiki.setPageContent("Page", "{{Homonymie}}");
+    {
+      ProcessGroup processGroup(&environment);
+      processGroup.addProcessByName("templates", "output:templates.dat");
+      processGroup.addProcessByName("titles", "input_disambigregexp:disambig.txt,output:titles.dat");
+      vector<mwc::Revision> revisions(5);
+      revisions[0].title = "Modèle:A";
+      revisions[1].title = "Modèle:B";
+      revisions[2].title = "Modèle:C";
+      revisions[3].title = "Modèle:D";
+      revisions[4].title = "Page";
+      wiki.readPages(mwc::RP_TITLE | mwc::RP_TIMESTAMP | mwc::RP_CONTENT, revisions);
+      processGroup.runOnPagesForTest(revisions);
+    }
+    CBL_ASSERT_EQ(cbl::readFile(dataDir + "titles.dat"),
+                  "Modèle:A|5\nModèle:B|1\nModèle:C|12\nModèle:D|1\nPage|13|H\n");
+
+    wiki.setPageContent("Modèle:A", "New A");
+    wiki.setPageContent("Modèle:C", "New C");
+    wiki.deletePage("Modèle:D");
+    wiki.setPageContent("Modèle:E", "#REDIRECTION [[Modèle:A]]");
+    {
+      ProcessGroup processGroup(&environment);
+      processGroup.addProcessByName("templates", "output:templates.dat");
+      processGroup.addProcessByName("titles", "input_disambigregexp:disambig.txt,output:titles.dat");
+      processGroup.runOnChangedPages({"Modèle:A", "Modèle:C", "Modèle:D", "Modèle:E", "Modèle:Not existing"});
+    }
+    CBL_ASSERT_EQ(cbl::readFile(dataDir + "templates.dat"),
+                  "Modèle:A\n New A\nModèle:B\n B\nModèle:C\n New C\nModèle:E\n #REDIRECTION [[Modèle:A]]\n");
+    CBL_ASSERT_EQ(cbl::readFile(dataDir + "titles.dat"),
+                  "Modèle:A|5\nModèle:B|1\nModèle:C|5\nModèle:E|26|R|Modèle:A\nPage|13|H\n");
+    CBL_ASSERT(!cbl::fileExists(dataDir + "titles.dat.delta"));
+  }
+
+  CBL_TEST_CASE(runOnChangedPagesKeepsCorruptedOutput) {
+    cbl::TempDir tempDir;
+    const string dataDir = tempDir.path() + "/";
+    mwc::MockWiki wiki;
+    Environment environment(wiki, dataDir);
+    cbl::writeFile(dataDir + "disambig.txt", R"(\{\{[Hh]omonymie\}\})");
+    const string outputPath = dataDir + "titles.dat.gz";
+    {
+      cbl::CompressedFileWriter writer(outputPath);
+      for (int i = 0; i < 10000; i++) {
+        fprintf(writer.file(), "Page %i|%i\n", i, i);
+      }
+      writer.close();
+    }
+    CBL_ASSERT_EQ(truncate(outputPath.c_str(), cbl::readFile(outputPath).size() / 2), 0);
+    const string oldContent = cbl::readFile(outputPath);
+
+    wiki.setPageContent("Page 1", "New content");
+    ProcessGroup processGroup(&environment);
+    processGroup.addProcessByName("titles", "input_disambigregexp:disambig.txt,output:titles.dat.gz");
+    try {
+      processGroup.runOnChangedPages({"Page 1"});
+      CBL_ASSERT(false) << "SystemError not thrown";
+    } catch (const cbl::SystemError&) {
+    }
+    // Records after the corrupted part must not be dropped silently.
+    CBL_ASSERT(cbl::readFile(outputPath) == oldContent);
+    CBL_ASSERT(!cbl::fileExists(outputPath + ".new"));
+  }
+
+  CBL_TEST_CASE(runOnDumpSkipsUnwantedPages) {
+    cbl::TempDir tempDir;
+    const string dataDir = tempDir.path() + "/";
+    mwc::MockWiki wiki;
+    Environment environment(wiki, dataDir);
+    writeDump(dataDir + "dump.xml",
+              {
+                  {"Modèle:A", 1, "A1\nA2"},
+                  {"Article", 2, "Line 1\n&lt;/text&gt;&lt;title&gt;Fake&lt;/title&gt;\nLine 3"},
+                  {"Modèle:B", 3, "B &amp; B"},
+                  {"Module:C", 4, "return {}"},
+              });
+
+    ProcessGroup processGroup(&environment);
+    processGroup.addProcessByName("templates", "output:templates.dat");
+    processGroup.addProcessByName("modules", "output:modules.dat.gz");
+    FILE* dumpFile = fopen((dataDir + "dump.xml").c_str(), "r");
+    CBL_ASSERT(dumpFile != nullptr);
+    mwc::PagesDump dump(dumpFile);
+    processGroup.runOnDump(dump);
+    fclose(dumpFile);
+    CBL_ASSERT_EQ(cbl::readFile(dataDir + "templates.dat"), "Modèle:A\n A1\n A2\nModèle:B\n B & B\n");
+    CBL_ASSERT(cbl::readFile(dataDir + "modules.dat.gz").starts_with("\x1F\x8B"));
+    cbl::CompressedFileInputStream modulesStream(dataDir + "modules.dat.gz");
+    string modulesContent((std::istreambuf_iterator<char>(modulesStream)), std::istreambuf_iterator<char>());
+    CBL_ASSERT_EQ(modulesContent, "Module:C\n return {}\n");
+  }
+
+  CBL_TEST_CASE(stats) {
+    cbl::TempDir tempDir;
+    const string dataDir = tempDir.path() + "/";
+    mwc::MockWiki wiki;
+    Environment environment(wiki, dataDir);
+    writeDump(dataDir + "dump.xml",
+              {
+                  {"Modèle:A", 1, "A1\nA2"},
+                  {"Article", 2, "Text"},
+                  {"Modèle:B", 3, "B &amp; B"},
+                  {"Module:C", 4, "return {}"},
+                  {"Article 2", 5, "Text"},
+              });
+
+    ProcessGroup processGroup(&environment);
+    processGroup.addProcessByName("templates", "output:templates.dat");
+    processGroup.addProcessByName("modules", "output:modules.dat.gz");
+    processGroup.setStatsFile(dataDir + "stats.json");
+    FILE* dumpFile = fopen((dataDir + "dump.xml").c_str(), "r");
+    CBL_ASSERT(dumpFile != nullptr);
+    mwc::PagesDump dump(dumpFile);
+    std::ostringstream errorStream;
+    std::streambuf* oldErrorBuffer = std::cerr.rdbuf(errorStream.rdbuf());
+    {
+      cbl::RunOnDestroy restoreErrorBuffer([&]() { std::cerr.rdbuf(oldErrorBuffer); });
+      processGroup.runOnDump(dump);
+    }
+    fclose(dumpFile);
+
+    // Times depend on the machine, so only the counters are checked exactly.
+    json::Value stats = json::parse(cbl::readFile(dataDir + "stats.json"));
+    CBL_ASSERT_EQ(stats["skipped_pages"].numberAsInt64(), 2);
+    CBL_ASSERT(stats["wall_time_ms"].numberAsInt64() >= stats["reading_time_ms"].numberAsInt64()) << stats;
+    CBL_ASSERT(stats["peak_rss_kb"].numberAsInt64() > 0) << stats;
+    const json::Value& templatesStats = stats["processes"]["templates"];
+    CBL_ASSERT_EQ(templatesStats["pages"].numberAsInt64(), 2);
+    // Sizes are computed on the unescaped code.
+    CBL_ASSERT_EQ(templatesStats["bytes"].numberAsInt64(), 10);
+    CBL_ASSERT(templatesStats["processing_time_ms"].numberAsInt64() >= 0) << stats;
+    CBL_ASSERT_EQ(templatesStats["parsing_time_ms"].numberAsInt64(), 0);
+    const json::Value& modulesStats = stats["processes"]["modules"];
+    CBL_ASSERT_EQ(modulesStats["pages"].numberAsInt64(), 1);
+    CBL_ASSERT_EQ(modulesStats["bytes"].numberAsInt64(), 9);
+
+    string errorOutput = errorStream.str();
+    CBL_ASSERT(errorOutput.starts_with("5 pages read (2 skipped, reading: ")) << errorOutput;
+    CBL_ASSERT(errorOutput.find("s, templates: ") != string::npos) << errorOutput;
+    CBL_ASSERT(errorOutput.find("s, modules: ") != string::npos) << errorOutput;
+    CBL_ASSERT(errorOutput.find(" MB)\n") != string::npos) << errorOutput;
+  }
+
+  CBL_TEST_CASE(redirects) {
+    cbl::TempDir tempDir;
+    const string dataDir = tempDir.path() + "/";
+    mwc::MockWiki wiki;
+    Environment environment(wiki, dataDir);
+    {
+      ProcessGroup processGroup(&environment);
+      processGroup.addProcessByName("redirects", "output:redirections.dat,table:redirects.bin");
+      vector<mwc::Revision> revisions(4);
+      revisions[0].title = "A";
+      revisions[0].content = "#REDIRECTION [[b#Section]]";
+      revisions[1].title = "B";
+      revisions[1].content = "#REDIRECT [[C]]";
+      revisions[2].title = "C";
+      revisions[2].content = "Text";
+      revisions[3].title = "D";
+      revisions[3].content = "#REDIRECTION [[D]]";
+      processGroup.runOnPagesForTest(revisions);
+    }
+    CBL_ASSERT_EQ(cbl::readFile(dataDir + "redirections.dat"), "A|B\nB|C\nD|D\n");
+    redirect_table::RedirectTable redirectTable(dataDir + "redirects.bin");
+    CBL_ASSERT_EQ(redirectTable.size(), 3u);
+    CBL_ASSERT_EQ(redirectTable.resolve("A"), "C");
+    CBL_ASSERT_EQ(redirectTable.resolve("B"), "C");
+    CBL_ASSERT_EQ(redirectTable.resolve("C"), "C");
+    CBL_ASSERT_EQ(redirectTable.resolve("D"), "");
+  }
+
+  CBL_TEST_CASE(links) {
+    cbl::TempDir tempDir;
+    const string dataDir = tempDir.path() + "/";
+    mwc::MockWiki wiki;
+    Environment environment(wiki, dataDir);
+
+    wiki.setPageContent("A", "[[B]] [[C|text]] [[b]] [[A]] [[#Section]] [[Missing]] [[en:B]] [[Catégorie:D]]");
+    wiki.setPageContent("B", "#REDIRECTION [[C]]");
+    wiki.setPageContent("C", "[[:Catégorie:D]] [[B#Section]] [[Fichier:E.jpg]]");
+    wiki.setPageContent("Catégorie:D", "");
+    {
+      ProcessGroup processGroup(&environment);
+      processGroup.addProcessByName("links", "output:links");
+      vector<mwc::Revision> revisions(4);
+      revisions[0].title = "A";
+      revisions[1].title = "B";
+      revisions[2].title = "C";
+      revisions[3].title = "Catégorie:D";
+      wiki.readPages(mwc::RP_TITLE | mwc::RP_TIMESTAMP | mwc::RP_CONTENT, revisions);
+      processGroup.runOnPagesForTest(revisions);
+    }
+    link_graph::LinkGraph graph(dataDir + "links");
+    CBL_ASSERT_EQ(graph.numNodes(), 4u);
+    link_graph::NodeId nodeA = graph.findNode("A");
+    link_graph::NodeId nodeB = graph.findNode("B");
+    link_graph::NodeId nodeC = graph.findNode("C");
+    link_graph::NodeId nodeD = graph.findNode("Catégorie:D");
+    CBL_ASSERT(nodeD != link_graph::LinkGraph::NOT_FOUND);
+    // The link to the redirect B is resolved to C. Self-links, links to missing pages, interwikis and categorization
+    // links are dropped.
+    CBL_ASSERT(graph.getLinks(nodeA) == vector<link_graph::NodeId>({nodeC}));
+    CBL_ASSERT(graph.getLinks(nodeC) == vector<link_graph::NodeId>({nodeD}));
+    // Redirects are not backlinks of their target.
+    CBL_ASSERT(graph.getLinks(nodeB).empty());
+    CBL_ASSERT(graph.getBacklinks(nodeC) == vector<link_graph::NodeId>({nodeA}));
+    CBL_ASSERT(graph.getBacklinks(nodeD) == vector<link_graph::NodeId>({nodeC}));
+  }
+
+  // Runs "templates" and "modules" on the dump with a checkpoint every 2 pages.
+  void runTemplatesAndModules(const string& dataDir, FILE* dumpFile, bool resume) {
+    mwc::MockWiki wiki;
+    Environment environment(wiki, dataDir);
+    ProcessGroup processGroup(&environment);
+    processGroup.addProcessByName("templates", "output:templates.dat");
+    processGroup.addProcessByName("modules", "output:modules.dat.gz");
+    processGroup.setCheckpoint(dataDir + "checkpoint.json", 2);
+    mwc::PagesDump dump(dumpFile);
+    processGroup.runOnDump(dump, resume);
+  }
+
+  CBL_TEST_CASE(resumeFromCheckpoint) {
+    cbl::TempDir tempDir;
+    const string dumpPath = tempDir.path() + "/dump.xml";
+    writeDump(dumpPath, {
+                            {"Modèle:A", 1, "A"},
+                            {"Module:B", 2, "return 'B'"},
+                            {"Modèle:C", 3, "C1\nC2"},
+                            {"Module:D", 4, "return 'D'"},
+                            {"Article", 5, "E"},
+                            {"Modèle:F", 6, "F"},
+                        });
+    const string dumpXML = cbl::readFile(dumpPath);
+
+    const string referenceDir = tempDir.path() + "/reference/";
+    cbl::makeDir(referenceDir);
+    FILE* dumpFile = fopen(dumpPath.c_str(), "r");
+    CBL_ASSERT(dumpFile != nullptr);
+    runTemplatesAndModules(referenceDir, dumpFile, false);
+    fclose(dumpFile);
+
+    // Simulate a crash: a child process reads the beginning of the dump from a pipe and is killed after writing the
+    // checkpoint. The pipe is not closed, so the child is still waiting for the rest of the dump at that time.
+    const string resumedDir = tempDir.path() + "/resumed/";
+    cbl::makeDir(resumedDir);
+    const string checkpointPath = resumedDir + "checkpoint.json";
+    int fds[2];
+    CBL_ASSERT_EQ(pipe(fds), 0);
+    pid_t pid = fork();
+    CBL_ASSERT(pid >= 0);
+    if (pid == 0) {
+      close(fds[1]);
+      runTemplatesAndModules(resumedDir, fdopen(fds[0], "r"), false);
+      _exit(1);  // Not expected, since the input never ends.
+    }
+    close(fds[0]);
+    // Pages A, B, C and the beginning of D.
+    size_t prefixSize = dumpXML.find("return 'D'");
+    CBL_ASSERT_EQ(write(fds[1], dumpXML.data(), prefixSize), static_cast<ssize_t>(prefixSize));
+    for (int i = 0; i < 1000 && !cbl::fileExists(checkpointPath); i++) {
+      usleep(10000);
+    }
+    kill(pid, SIGKILL);
+    int status = 0;
+    CBL_ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    close(fds[1]);
+    CBL_ASSERT(WIFSIGNALED(status));
+    CBL_ASSERT(cbl::fileExists(checkpointPath));
+
+    dumpFile = fopen(dumpPath.c_str(), "r");
+    CBL_ASSERT(dumpFile != nullptr);
+    runTemplatesAndModules(resumedDir, dumpFile, true);
+    fclose(dumpFile);
+    CBL_ASSERT(!cbl::fileExists(checkpointPath));
+    CBL_ASSERT_EQ(cbl::readFile(resumedDir + "templates.dat"), "Modèle:A\n A\nModèle:C\n C1\n C2\nModèle:F\n F\n");
+    CBL_ASSERT_EQ(cbl::readFile(resumedDir + "templates.dat"), cbl::readFile(referenceDir + "templates.dat"));
+    for (const string& dir : {referenceDir, resumedDir}) {
+      cbl::CompressedFileInputStream modulesStream(dir + "modules.dat.gz");
+      string modulesContent((std::istreambuf_iterator<char>(modulesStream)), std::istreambuf_iterator<char>());
+      CBL_ASSERT_EQ(modulesContent, "Module:B\n return 'B'\nModule:D\n return 'D'\n") << dir;
+    }
+  }
+
+  CBL_TEST_CASE(linksCannotBeResumed) {
+    cbl::TempDir tempDir;
+    const string dataDir = tempDir.path() + "/";
+    mwc::MockWiki wiki;
+    Environment environment(wiki, dataDir);
+    writeDump(dataDir + "dump.xml", {{"A", 1, "[[B]]"}, {"B", 2, "[[A]]"}});
+    const string checkpointPath = dataDir + "checkpoint.json";
+    cbl::writeFile(checkpointPath, "{}");
+    cbl::writeFile(dataDir + "disambig.txt", R"(\{\{[Hh]omonymie\}\})");
+
+    ProcessGroup processGroup(&environment);
+    processGroup.addProcessByName("titles", "input_disambigregexp:disambig.txt,output:titles.dat");
+    CBL_ASSERT(processGroup.isResumable());
+    processGroup.addProcessByName("links", "output:links");
+    CBL_ASSERT(!processGroup.isResumable());
+    processGroup.setCheckpoint(checkpointPath, 1);
+    FILE* dumpFile = fopen((dataDir + "dump.xml").c_str(), "r");
+    CBL_ASSERT(dumpFile != nullptr);
+    mwc::PagesDump dump(dumpFile);
+    try {
+      processGroup.runOnDump(dump, /* resume = */ true);
+      CBL_ASSERT(false) << "std::invalid_argument not thrown";
+    } catch (const std::invalid_argument&) {
+    }
+    // Nothing was done.
+    CBL_ASSERT_EQ(cbl::readFile(checkpointPath), "{}");
+    CBL_ASSERT(!cbl::fileExists(dataDir + "titles.dat"));
+    // Without --resume, the run completes without writing checkpoints.
+    processGroup.runOnDump(dump);
+    fclose(dumpFile);
+    CBL_ASSERT_EQ(cbl::readFile(dataDir + "titles.dat"), "A|5\nB|5\n");
+    CBL_ASSERT(!cbl::fileExists(checkpointPath));
+  }
+};
+
+}  // namespace dump_processing
+
+int main() {
+  dump_processing::ProcessingLibTest().run();
+  return 0;
+}
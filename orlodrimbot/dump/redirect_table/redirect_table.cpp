@@ -0,0 +1,161 @@
+#include "redirect_table.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "cbl/error.h"
+#include "cbl/mapped_file.h"
+
+using std::pair;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace redirect_table {
+
+static const char REDIRECT_TABLE_MAGIC[8] = {'R', 'E', 'D', 'I', 'R', 'T', 'B', '1'};
+
+struct RedirectTableHeader {
+  char magic[8];
+  uint64_t numEntries;
+  uint64_t stringsSize;
+};
+
+struct RedirectTableEntry {
+  uint64_t sourceOffset;
+  uint64_t targetOffset;
+  uint32_t sourceLength;
+  uint32_t targetLength;
+};
+
+void writeRedirectTable(const string& path, vector<pair<string, string>> redirects) {
+  std::sort(redirects.begin(), redirects.end());
+  size_t numRedirects = redirects.size();
+  for (size_t i = 1; i < numRedirects; i++) {
+    if (redirects[i].first == redirects[i - 1].first) {
+      throw std::invalid_argument("Duplicate redirect '" + redirects[i].first + "' in writeRedirectTable");
+    }
+  }
+  auto findRedirect = [&](const string& title) -> size_t {
+    auto it = std::lower_bound(
+        redirects.begin(), redirects.end(), title,
+        [](const pair<string, string>& redirect, const string& value) { return redirect.first < value; });
+    return it != redirects.end() && it->first == title ? it - redirects.begin() : numRedirects;
+  };
+
+  // Collapse chains. finalTargets[i] is the final target of redirect i, with an empty value for cycles.
+  enum class State { NOT_VISITED, IN_PROGRESS, DONE };
+  vector<State> states(numRedirects, State::NOT_VISITED);
+  vector<string> finalTargets(numRedirects);
+  vector<size_t> chain;
+  for (size_t start = 0; start < numRedirects; start++) {
+    chain.clear();
+    string finalTarget;
+    for (size_t i = start;;) {
+      if (states[i] == State::DONE) {
+        finalTarget = finalTargets[i];
+        break;
+      } else if (states[i] == State::IN_PROGRESS) {
+        break;  // Cycle. Everything in the chain is in the cycle or leads to it, so finalTarget stays empty.
+      }
+      states[i] = State::IN_PROGRESS;
+      chain.push_back(i);
+      size_t next = findRedirect(redirects[i].second);
+      if (next == numRedirects) {
+        finalTarget = redirects[i].second;
+        break;
+      }
+      i = next;
+    }
+    for (size_t i : chain) {
+      finalTargets[i] = finalTarget;
+      states[i] = State::DONE;
+    }
+  }
+
+  vector<RedirectTableEntry> entries(numRedirects);
+  string strings;
+  for (size_t i = 0; i < numRedirects; i++) {
+    const string& source = redirects[i].first;
+    const string& target = finalTargets[i];
+    if (source.size() > UINT32_MAX || target.size() > UINT32_MAX) {
+      throw std::invalid_argument("Title too long in writeRedirectTable");
+    }
+    entries[i] = {.sourceOffset = strings.size(),
+                  .targetOffset = strings.size() + source.size(),
+                  .sourceLength = static_cast<uint32_t>(source.size()),
+                  .targetLength = static_cast<uint32_t>(target.size())};
+    strings += source;
+    strings += target;
+  }
+
+  RedirectTableHeader header;
+  memcpy(header.magic, REDIRECT_TABLE_MAGIC, sizeof(header.magic));
+  header.numEntries = numRedirects;
+  header.stringsSize = strings.size();
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    throw cbl::SystemError("Cannot open '" + path + "' for writing: " + cbl::getCErrorString(errno));
+  }
+  bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(entries.data(), sizeof(RedirectTableEntry), entries.size(), file) == entries.size() &&
+                 fwrite(strings.data(), 1, strings.size(), file) == strings.size();
+  if (fclose(file) != 0 || !success) {
+    throw cbl::SystemError("Cannot write '" + path + "'");
+  }
+}
+
+RedirectTable::RedirectTable(const string& path) : m_file(path) {
+  if (m_file.size() < sizeof(RedirectTableHeader)) {
+    throw cbl::ParseError("File '" + path + "' is too short to be a redirect table");
+  }
+  const RedirectTableHeader* header = reinterpret_cast<const RedirectTableHeader*>(m_file.data());
+  uint64_t expectedSize = 0;
+  // Sizes are checked first so that the computation of expectedSize cannot overflow.
+  if (memcmp(header->magic, REDIRECT_TABLE_MAGIC, sizeof(header->magic)) == 0 &&
+      header->numEntries <= m_file.size() / sizeof(RedirectTableEntry) && header->stringsSize <= m_file.size()) {
+    expectedSize =
+        sizeof(RedirectTableHeader) + header->numEntries * sizeof(RedirectTableEntry) + header->stringsSize;
+  }
+  if (expectedSize != m_file.size()) {
+    throw cbl::ParseError("File '" + path + "' is not a valid redirect table");
+  }
+  m_numEntries = header->numEntries;
+  m_entries = reinterpret_cast<const RedirectTableEntry*>(header + 1);
+  m_strings = reinterpret_cast<const char*>(m_entries + m_numEntries);
+}
+
+string_view RedirectTable::source(size_t i) const {
+  return string_view(m_strings + m_entries[i].sourceOffset, m_entries[i].sourceLength);
+}
+
+string_view RedirectTable::target(size_t i) const {
+  return string_view(m_strings + m_entries[i].targetOffset, m_entries[i].targetLength);
+}
+
+size_t RedirectTable::find(string_view title) const {
+  size_t begin = 0;
+  size_t end = m_numEntries;
+  while (begin < end) {
+    size_t middle = begin + (end - begin) / 2;
+    if (source(middle) < title) {
+      begin = middle + 1;
+    } else {
+      end = middle;
+    }
+  }
+  return begin < m_numEntries && source(begin) == title ? begin : NOT_FOUND;
+}
+
+string_view RedirectTable::resolve(string_view title) const {
+  size_t i = find(title);
+  return i != NOT_FOUND ? target(i) : title;
+}
+
+}  // namespace redirect_table
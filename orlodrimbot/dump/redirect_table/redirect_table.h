@@ -0,0 +1,59 @@
+// Table of redirects of a wiki, as produced by the "redirects" dump process.
+//
+// Chains of redirects are collapsed when the table is written, so each redirect directly points to its final target
+// (the first page of the chain that is not a redirect). Redirects that are part of a cycle or lead to one have an
+// empty target.
+// The file contains a header, an array of entries sorted by source title and a pool of strings. It is mapped in
+// memory, so loading it takes almost no time and lookups are binary searches in the mapped array.
+#ifndef REDIRECT_TABLE_H
+#define REDIRECT_TABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "cbl/mapped_file.h"
+
+namespace redirect_table {
+
+struct RedirectTableEntry;
+
+// Writes a table from a list of (source, target) pairs, where targets are normalized titles without anchor.
+// Each source must appear only once.
+// Throws: SystemError, std::invalid_argument if a source appears twice.
+void writeRedirectTable(const std::string& path, std::vector<std::pair<std::string, std::string>> redirects);
+
+class RedirectTable {
+public:
+  // Throws: FileNotFoundError, SystemError, ParseError if the file is not a valid redirect table.
+  explicit RedirectTable(const std::string& path);
+  RedirectTable(const RedirectTable&) = delete;
+  RedirectTable& operator=(const RedirectTable&) = delete;
+
+  // Number of redirects.
+  size_t size() const { return m_numEntries; }
+  // Source and final target of the i-th redirect in byte order of sources.
+  std::string_view source(size_t i) const;
+  std::string_view target(size_t i) const;
+
+  bool isRedirect(std::string_view title) const { return find(title) != NOT_FOUND; }
+  // If `title` is a redirect, returns its final target, or an empty string if it is in a cycle. Otherwise, returns
+  // `title` itself.
+  std::string_view resolve(std::string_view title) const;
+
+private:
+  static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+  // Returns the index of `title` or NOT_FOUND.
+  size_t find(std::string_view title) const;
+
+  cbl::MappedFile m_file;
+  size_t m_numEntries = 0;
+  const RedirectTableEntry* m_entries = nullptr;
+  const char* m_strings = nullptr;
+};
+
+}  // namespace redirect_table
+
+#endif
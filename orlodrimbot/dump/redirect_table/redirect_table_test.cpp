@@ -0,0 +1,74 @@
+#include "redirect_table.h"
+#include <string>
+#include "cbl/error.h"
+#include "cbl/file.h"
+#include "cbl/log.h"
+#include "cbl/tempfile.h"
+#include "cbl/unittest.h"
+
+using std::string;
+
+namespace redirect_table {
+
+class RedirectTableTest : public cbl::Test {
+private:
+  CBL_TEST_CASE(ChainsAndCycles) {
+    cbl::TempDir tempDir;
+    const string path = tempDir.path() + "/redirects.bin";
+    writeRedirectTable(path, {
+                                 {"D", "E"},
+                                 {"A", "Page"},
+                                 {"B", "A"},
+                                 {"C", "B"},
+                                 {"E", "F"},
+                                 {"F", "D"},
+                                 {"G", "E"},
+                                 {"H", "H"},
+                             });
+
+    RedirectTable table(path);
+    CBL_ASSERT_EQ(table.size(), 8u);
+    CBL_ASSERT_EQ(table.source(0), "A");
+    CBL_ASSERT_EQ(table.target(0), "Page");
+    CBL_ASSERT_EQ(table.resolve("A"), "Page");
+    CBL_ASSERT_EQ(table.resolve("B"), "Page");
+    CBL_ASSERT_EQ(table.resolve("C"), "Page");
+    CBL_ASSERT_EQ(table.resolve("D"), "");
+    CBL_ASSERT_EQ(table.resolve("E"), "");
+    CBL_ASSERT_EQ(table.resolve("F"), "");
+    CBL_ASSERT_EQ(table.resolve("G"), "");
+    CBL_ASSERT_EQ(table.resolve("H"), "");
+    CBL_ASSERT_EQ(table.resolve("Page"), "Page");
+    CBL_ASSERT(table.isRedirect("C"));
+    CBL_ASSERT(!table.isRedirect("Page"));
+    CBL_ASSERT(!table.isRedirect(""));
+    CBL_ASSERT(!table.isRedirect("Z"));
+  }
+
+  CBL_TEST_CASE(EmptyTable) {
+    cbl::TempDir tempDir;
+    const string path = tempDir.path() + "/redirects.bin";
+    writeRedirectTable(path, {});
+    RedirectTable table(path);
+    CBL_ASSERT_EQ(table.size(), 0u);
+    CBL_ASSERT_EQ(table.resolve("A"), "A");
+  }
+
+  CBL_TEST_CASE(InvalidFile) {
+    cbl::TempDir tempDir;
+    const string path = tempDir.path() + "/redirects.bin";
+    cbl::writeFile(path, "REDIRTB1 but truncated");
+    try {
+      RedirectTable table(path);
+      CBL_ASSERT(false) << "ParseError not thrown";
+    } catch (const cbl::ParseError&) {
+    }
+  }
+};
+
+}  // namespace redirect_table
+
+int main() {
+  redirect_table::RedirectTableTest().run();
+  return 0;
+}
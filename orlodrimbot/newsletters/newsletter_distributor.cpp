@@ -242,7 +242,8 @@ bool Distributor::isValidTargetPage(const string& targetPage, const string& orig
   return false;
 }
 
-void Distributor::postMessage(const string& issue, const string& targetPage, bool deleteOld, bool dryRun) {
+void Distributor::postMessage(const string& issue, const string& targetPage, bool deleteOld, bool dryRun,
+                              mwc::EditQueue& editQueue) {
   string messageTitle;
   string messageNowikiTitle;
   string messageContent;
@@ -352,7 +353,8 @@ void Distributor::postMessage(const string& issue, const string& targetPage, boo
     std::cout << ">>>>>>>>\n" << message << "\n";
     std::cout << "comment=" << editSummary << "\n";
     if (!dryRun) {
-      m_wiki->writePage(resolvedTargetPage, newCode, writeToken, editSummary);
+      editQueue.add(
+          {.title = resolvedTargetPage, .content = newCode, .writeToken = writeToken, .summary = editSummary});
     } else {
       CBL_INFO << "[DRY RUN] Writing '" << resolvedTargetPage << "'";
     }
@@ -444,6 +446,23 @@ void Distributor::runInternal(const string& forcedIssue, const string& fromPage,
     saveState(dryRun);
   }
 
+  // The page of the next subscriber is read while waiting for the delay between edits. Reading further ahead would not
+  // make the distribution faster and would make edit conflicts more likely.
+  mwc::EditQueue editQueue(*m_wiki);
+  editQueue.setMaxSize(1);
+  try {
+    distributeToSubscribers(newIssue, issueNumber, subscribers, fromPage, singlePage, dryRun, editQueue);
+  } catch (...) {
+    // Messages already prepared are not discarded.
+    editQueue.flush();
+    throw;
+  }
+  editQueue.flush();
+}
+
+void Distributor::distributeToSubscribers(const string& newIssue, int issueNumber,
+                                          const vector<Subscriber>& subscribers, const string& fromPage,
+                                          const string& singlePage, bool dryRun, mwc::EditQueue& editQueue) {
   bool afterStartPoint = fromPage.empty();
   for (const Subscriber& subscriber : subscribers) {
     if (!singlePage.empty() && subscriber.page != singlePage) {
@@ -460,7 +479,7 @@ void Distributor::runInternal(const string& forcedIssue, const string& fromPage,
       if (subscriber.page == TWITTER_SUBSCRIBER) {
         addTweetProposal(newIssue, issueNumber, dryRun);
       } else {
-        postMessage(newIssue, subscriber.page, subscriber.deleteOldMessages, dryRun);
+        postMessage(newIssue, subscriber.page, subscriber.deleteOldMessages, dryRun, editQueue);
       }
     } catch (const mwc::WikiError& error) {
       CBL_ERROR << error.what();
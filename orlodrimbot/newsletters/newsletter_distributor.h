@@ -6,6 +6,7 @@
 #include <vector>
 #include "cbl/error.h"
 #include "cbl/json.h"
+#include "mwclient/edit_queue.h"
 #include "mwclient/wiki.h"
 #include "orlodrimbot/live_replication/recent_changes_reader.h"
 
@@ -88,8 +89,14 @@ private:
   // Throws: DistributorError.
   void runInternal(const std::string& forcedIssue, const std::string& fromPage, const std::string& singlePage,
                    bool force, bool dryRun);
+  // Posts the issue on the page of each subscriber. Errors for a single subscriber are logged.
+  void distributeToSubscribers(const std::string& newIssue, int issueNumber, const std::vector<Subscriber>& subscribers,
+                               const std::string& fromPage, const std::string& singlePage, bool dryRun,
+                               mwc::EditQueue& editQueue);
+  // The edit is added to `editQueue`, so errors while writing the page are only logged.
   // Throws: UpdatePageError, mwc::WikiError.
-  void postMessage(const std::string& issue, const std::string& targetPage, bool deleteOld, bool dryRun);
+  void postMessage(const std::string& issue, const std::string& targetPage, bool deleteOld, bool dryRun,
+                   mwc::EditQueue& editQueue);
   // Throws: UpdatePageError, mwc::WikiError.
   void addTweetProposal(const std::string& issue, int issueNumber, bool dryRun);
 
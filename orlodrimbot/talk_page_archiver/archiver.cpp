@@ -102,15 +102,9 @@ void saveStableRevids(const string& path, const set<revid_t>& revids) {
   }
 }
 
-void filterStablePages(Wiki& wiki, const vector<string>& pages, const set<revid_t>& oldStableRevids,
+// Adds the revisions that are in oldStableRevids to stableRevids and the other ones to pagesToUpdate.
+void filterStablePages(const vector<Revision>& revisions, const set<revid_t>& oldStableRevids,
                        vector<string>& pagesToUpdate, set<revid_t>& stableRevids) {
-  vector<Revision> revisions(pages.size());
-  for (size_t i = 0; i < pages.size(); i++) {
-    revisions[i].title = pages[i];
-  }
-  wiki.readPages(mwc::RP_REVID, revisions);
-  pagesToUpdate.clear();
-  stableRevids.clear();
   for (const Revision& revision : revisions) {
     if (oldStableRevids.count(revision.revid) != 0) {
       CBL_INFO << "Skipping stable page '" << revision.title << "'";
@@ -714,7 +708,15 @@ void Archiver::archivePage(const string& title) {
 }
 
 void Archiver::archivePages(const vector<string>& pages) {
-  for (const string& page : pages) {
+  // Pages are read one batch at a time instead of one request per page. Prefetching the next batch only when it is
+  // needed keeps memory usage bounded on large runs.
+  const size_t batchSize = m_wiki->apiTitlesLimit();
+  for (size_t i = 0; i < pages.size(); i++) {
+    const string& page = pages[i];
+    if (i % batchSize == 0) {
+      m_wiki->prefetchPages(vector<string>(pages.begin() + i, pages.begin() + std::min(i + batchSize, pages.size())),
+                            mwc::RP_CONTENT | mwc::RP_REVID);
+    }
     try {
       archivePage(page);
     } catch (const mwc::WikiError& error) {
@@ -723,6 +725,7 @@ void Archiver::archivePages(const vector<string>& pages) {
       CBL_ERROR << "Failed to archive '" << page << "': " << error.what();
     }
   }
+  m_wiki->clearPrefetchedPages();
 }
 
 void Archiver::archiveAll() {
@@ -730,9 +733,17 @@ void Archiver::archiveAll() {
   set<revid_t> oldStableRevids = loadStableRevids(revidsFile);
 
   CBL_INFO << "Reading transclusions of {{" << ARCHIVE_TEMPLATE_NAME << "}}";
-  vector<string> pages = m_wiki->getTransclusions(cbl::concat("Template:", ARCHIVE_TEMPLATE_NAME));
+  // The last revid of each page is read with the list of transclusions, to skip pages that did not change since the
+  // last run without sending another request.
   vector<string> pagesToUpdate;
-  filterStablePages(*m_wiki, pages, oldStableRevids, pagesToUpdate, m_stableRevids);
+  m_stableRevids.clear();
+  m_wiki->readPagesFromGenerator(
+      {.type = mwc::GEN_TRANSCLUSIONS, .title = cbl::concat("Template:", ARCHIVE_TEMPLATE_NAME)}, mwc::RP_REVID,
+      [&](const vector<Revision>& revisions) {
+        filterStablePages(revisions, oldStableRevids, pagesToUpdate, m_stableRevids);
+        return true;
+      },
+      mwc::ENUM_PIPELINED);
   archivePages(pagesToUpdate);
 
   if (!m_dryRun) {
@@ -18,6 +18,7 @@ using cbl::Date;
 using cbl::DateDiff;
 using mwc::Revision;
 using mwc::RP_CONTENT;
+using mwc::RP_REVID;
 using mwc::RP_TIMESTAMP;
 using mwc::Wiki;
 using std::string;
@@ -51,14 +52,18 @@ void HistoryCache::loadVersion(const Date& date) {
   mwc::HistoryParams histParams;
   histParams.title = m_title;
   histParams.start = date;
-  histParams.prop = RP_CONTENT | RP_TIMESTAMP;
+  // Old revisions are often the same from one run to the next, so their content may be in the revision store. If
+  // there is none, the content is read in the same request as the history.
+  const bool useRevisionStore = m_wiki->revisionStore() != nullptr;
+  histParams.prop = RP_TIMESTAMP | (useRevisionStore ? RP_REVID : RP_CONTENT);
   histParams.limit = 1;
   vector<Revision> history = m_wiki->getHistory(histParams);
 
   vector<Thread> threads;
   if (!history.empty()) {
     CBL_INFO << "First revision of '" << m_title << "' before " << date << ": " << history[0].timestamp;
-    threads = parseCodeAsThreads(history[0].content);
+    threads = parseCodeAsThreads(useRevisionStore ? m_wiki->readRevisionContent(history[0].revid)
+                                                  : history[0].content);
   } else {
     CBL_INFO << "No revision of '" << m_title << "' before " << date;
   }
@@ -0,0 +1,42 @@
+// Computes template statistics from the XML dump of all pages read from stdin, in a single process (see pipeline.h).
+// The dump directory must contain the output of the "modules", "redirects" and "templates" dump processes, as well as
+// luadb_wiki.txt.
+#include <cstdint>
+#include <string>
+#include "cbl/args_parser.h"
+#include "mwclient/util/init_wiki.h"
+#include "mwclient/wiki.h"
+#include "pipeline.h"
+
+using std::string;
+
+int main(int argc, char** argv) {
+  mwc::WikiFlags wikiFlags(mwc::FRENCH_WIKIPEDIA_BOT);
+  string dumpDir;
+  string outputDir;  // Defaults to "<dumpdir>/stat-templates".
+  bool debug = false;  // If true, write intermediate files to the output directory.
+  int sortMemoryMB = 2048;
+  int sortThreads = 4;
+  int statsThreads = 2;  // Threads for each set of statistics (there are two of them).
+  cbl::parseArgs(argc, argv, &wikiFlags, "--dumpdir,required", &dumpDir, "--outputdir", &outputDir, "--debug", &debug,
+                 "--sort-memory-mb", &sortMemoryMB, "--sort-threads", &sortThreads, "--stats-threads", &statsThreads);
+  if (outputDir.empty()) {
+    outputDir = dumpDir + "/stat-templates";
+  }
+  mwc::Wiki wiki;
+  mwc::initWikiFromFlags(wikiFlags, wiki);
+
+  templates_stats::computeTemplatesStats(
+      wiki, {.templatesDumpPath = dumpDir + "/templates.dat",
+             .modulesDumpPath = dumpDir + "/modules.dat",
+             .redirectTablePath = dumpDir + "/redirects.bin",
+             .luaDBWikiPath = dumpDir + "/luadb_wiki.txt",
+             .luaDBAutoPath = dumpDir + "/luadb_auto.txt",
+             .outputDir = outputDir,
+             .debugDir = debug ? outputDir : "",
+             .sorterParams = {.memoryBudget = static_cast<int64_t>(sortMemoryMB) << 20,
+                              .numThreads = sortThreads,
+                              .tempDir = outputDir},
+             .statsThreads = statsThreads});
+  return 0;
+}
@@ -66,9 +66,10 @@ def get_bzcat_dump_command(dump_dir):
 
 
 def sort_with_c_order(input_files, output_file):
+    """Sorts lines in byte order, which is the same as `LC_ALL=C sort`."""
     if not isinstance(input_files, list):
         input_files = [input_files]
-    Command("sort", input_files + ["-o", output_file], env={"LC_ALL": "C"}).run()
+    Command("%BOT_BIN%/templates_stats/sort_lines", input_files + [f"--output={output_file}"]).run()
 
 
 def create_dump_of_templates(dump_dir):
@@ -80,8 +81,9 @@ def create_dump_of_templates(dump_dir):
         "%BOT_BIN%/dump/processing/processing",
         [
             f"--datadir={dump_dir}",
-            "--processes=modules,templates,titles",
+            "--processes=modules,redirects,templates,titles",
             "--modules-params=output:modules.dat",
+            "--redirects-params=output:redirections.dat,table:redirects.bin",
             "--templates-params=output:templates.dat",
             "--titles-params=input_disambigregexp:dummy-disambig-re2.txt,output:titles-unsorted.dat",
         ],
@@ -91,15 +93,9 @@ def create_dump_of_templates(dump_dir):
         os.path.join(dump_dir, "titles-unsorted.dat"),
         os.path.join(dump_dir, "titles.dat"),
     )
-    Command("%BOT_CODE%/dump/processing/list_redirects.sh", [dump_dir]).run()
 
 
 def extract_templates_inclusions(dump_dir, stats_dir, compact_format):
-    with open(os.path.join(dump_dir, "templates-redirections.dat"), "w") as f:
-        Command(
-            "grep", ["^Modèle:", os.path.join(dump_dir, "redirections.dat")], stdout=f
-        ).run()
-
     Command(
         "%BOT_BIN%/templates_stats/parse_templates",
         [
@@ -147,13 +143,12 @@ def extract_templates_inclusions(dump_dir, stats_dir, compact_format):
     extract_command = Command(
         "%BOT_BIN%/templates_stats/extract_templates",
         [
-            f"--redirects={dump_dir}/templates-redirections.dat",
+            f"--redirect-table={dump_dir}/redirects.bin",
             f"--templates-names={stats_dir}/templates-and-modules-for-stats-names.dat",
+            "--sort",
+            f"--sort-tempdir={stats_dir}",
         ],
     )
-    sort_command = Command(
-        "sort", ["--compress-program=/bin/gzip"], env={"LC_ALL": "C"}
-    )
     if compact_format:
         index_command = Command(
             "%BOT_BIN%/templates_stats/create_indexed_extraction",
@@ -164,7 +159,7 @@ def extract_templates_inclusions(dump_dir, stats_dir, compact_format):
     extraction_path = os.path.join(stats_dir, "extraction-sorted.dat")
     with open(extraction_path, "wb") as index_file:
         pipe_commands(
-            [bzcat_command, extract_command, sort_command, index_command],
+            [bzcat_command, extract_command, index_command],
             stdout=index_file,
         )
     return extraction_path
@@ -194,6 +189,16 @@ def compute_stats_from_extraction(
     stats_command.run()
 
 
+def compute_stats_in_single_process(dump_dir, stats_dir):
+    """Runs parse_templates, extract_templates and stat in a single process, without intermediate files."""
+    bzcat_command = get_bzcat_dump_command(dump_dir)
+    stats_command = Command(
+        "%BOT_BIN%/templates_stats/compute_templates_stats",
+        [f"--dumpdir={dump_dir}", f"--outputdir={stats_dir}"],
+    )
+    pipe_commands([bzcat_command, stats_command])
+
+
 def create_templates_stats(dump_dir, dump_date, has_templates_dump, compact_format):
     lua_db_path = os.path.join(dump_dir, "luadb_merged.txt")
     stats_dir = os.path.join(dump_dir, "stat-templates")
@@ -202,6 +207,11 @@ def create_templates_stats(dump_dir, dump_date, has_templates_dump, compact_form
     if not has_templates_dump:
         create_dump_of_templates(dump_dir)
 
+    if not compact_format:
+        compute_stats_in_single_process(dump_dir, stats_dir)
+        return
+
+    # The compact format of the extraction is only supported by the multi-process version.
     os.makedirs(stats_dir, exist_ok=True)
     extraction_path = extract_templates_inclusions(dump_dir, stats_dir, compact_format=compact_format)
 
@@ -1,5 +1,7 @@
+#include <iostream>
 #include <string>
 #include "cbl/args_parser.h"
+#include "cbl/external_sorter.h"
 #include "mwclient/util/init_wiki.h"
 #include "mwclient/wiki.h"
 #include "extract_templates_lib.h"
@@ -8,17 +10,37 @@ using std::string;
 
 int main(int argc, char** argv) {
   mwc::WikiFlags wikiFlags(mwc::FRENCH_WIKIPEDIA_BOT);
-  string redirects;                // File with templates redirects (required).
+  string redirects;                // Text file with templates redirects (this or --redirect-table is required).
+  string redirectTable;            // Redirect table generated by the "redirects" dump process.
   string templatesWithParameters;  // File containing the list of templates with parameters (required).
   string outputFileName;           // Output file with all inclusions.
-  cbl::parseArgs(argc, argv, &wikiFlags, "--redirects,required", &redirects, "--templates-names,required",
-                 &templatesWithParameters, "--output", &outputFileName);
+  bool sortOutput = false;         // If true, sort the output in byte order (replaces a pipe to `LC_ALL=C sort`).
+  int sortMemoryMB = 2048;
+  int sortThreads = 4;
+  string sortTempDir = "/tmp";
+  cbl::parseArgs(argc, argv, &wikiFlags, "--redirects", &redirects, "--redirect-table", &redirectTable,
+                 "--templates-names,required", &templatesWithParameters, "--output", &outputFileName, "--sort",
+                 &sortOutput, "--sort-memory-mb", &sortMemoryMB, "--sort-threads", &sortThreads, "--sort-tempdir",
+                 &sortTempDir);
+  if (redirects.empty() == redirectTable.empty()) {
+    std::cerr << "Exactly one of --redirects and --redirect-table is required\n";
+    return 1;
+  }
   mwc::Wiki wiki;
   mwc::initWikiFromFlags(wikiFlags, wiki);
 
   TemplateExtractor templateExtractor(&wiki);
   templateExtractor.readTemplates(templatesWithParameters);
-  templateExtractor.readRedirects(redirects);
+  if (!redirectTable.empty()) {
+    templateExtractor.readRedirectTable(redirectTable);
+  } else {
+    templateExtractor.readRedirects(redirects);
+  }
+  if (sortOutput) {
+    templateExtractor.enableSortedOutput({.memoryBudget = static_cast<int64_t>(sortMemoryMB) << 20,
+                                          .numThreads = sortThreads,
+                                          .tempDir = sortTempDir});
+  }
   templateExtractor.processDump(outputFileName);
   return 0;
 }
@@ -3,9 +3,14 @@
 #include <algorithm>
 #include <cstdio>
 #include <fstream>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
+#include "cbl/compressed_file.h"
+#include "cbl/external_sorter.h"
 #include "cbl/log.h"
 #include "cbl/string.h"
 #include "mwclient/parser.h"
@@ -13,8 +18,10 @@
 #include "mwclient/util/include_tags.h"
 #include "mwclient/util/xml_dump.h"
 #include "mwclient/wiki.h"
+#include "orlodrimbot/dump/redirect_table/redirect_table.h"
 
 using std::string;
+using std::string_view;
 using std::unordered_map;
 using std::vector;
 
@@ -27,7 +34,23 @@ void TemplateExtractor::readTemplates(const string& fileName) {
   CBL_ASSERT(is) << "Cannot open '" << fileName << "'";
   string line;
   while (getline(is, line)) {
-    m_templatesAndRedirects[line];
+    addTemplate(line);
+  }
+}
+
+void TemplateExtractor::addTemplate(const string& name) {
+  m_templatesAndRedirects[name];
+}
+
+void TemplateExtractor::addRedirect(string_view title, string_view target) {
+  const string templatePrefix = m_siteInfo.namespaces().at(mwc::NS_TEMPLATE).name + ":";
+  if (!title.starts_with(templatePrefix) || !target.starts_with(templatePrefix)) return;
+  target.remove_prefix(templatePrefix.size());
+  CBL_ASSERT(!target.empty());
+  unordered_map<string, string>::iterator it = m_templatesAndRedirects.find(string(target));
+  if (it != m_templatesAndRedirects.end() && it->second.empty()) {
+    title.remove_prefix(templatePrefix.size());
+    m_templatesAndRedirects[string(title)] = string(target);
   }
 }
 
@@ -36,32 +59,72 @@ void TemplateExtractor::readRedirects(const string& fileName) {
   std::ifstream is(fileName.c_str());
   CBL_ASSERT(is) << "Cannot open '" << fileName << "'";
   const string templatePrefix = m_siteInfo.namespaces().at(mwc::NS_TEMPLATE).name + ":";
-  string line, title, target;
+  string line;
   while (getline(is, line)) {
-    int i = line.find('|');
-    CBL_ASSERT(i != -1);
-    title = line.substr(0, i);
-    target = line.substr(i + 1);
+    size_t i = line.find('|');
+    CBL_ASSERT(i != string::npos);
+    string_view title = string_view(line).substr(0, i);
     CBL_ASSERT(title.starts_with(templatePrefix));
-    if (!target.starts_with(templatePrefix)) continue;
-    target = target.substr(templatePrefix.size());
-    CBL_ASSERT(!target.empty());
-    unordered_map<string, string>::iterator it = m_templatesAndRedirects.find(target);
-    if (it != m_templatesAndRedirects.end() && it->second.empty()) {
-      title = title.substr(templatePrefix.size());
-      m_templatesAndRedirects[title] = target;
-    }
+    addRedirect(title, string_view(line).substr(i + 1));
+  }
+}
+
+void TemplateExtractor::readRedirectTable(const string& fileName) {
+  CBL_ASSERT(!m_templatesAndRedirects.empty());
+  redirect_table::RedirectTable redirectTable(fileName);
+  for (size_t i = 0; i < redirectTable.size(); i++) {
+    addRedirect(redirectTable.source(i), redirectTable.target(i));
+  }
+}
+
+void TemplateExtractor::enableSortedOutput(const cbl::ExternalSorter::Params& params) {
+  m_sorter = std::make_unique<cbl::ExternalSorter>(params);
+}
+
+void TemplateExtractor::writeLine(string_view line) {
+  if (m_sorter) {
+    m_sorter->add(line.substr(0, line.size() - 1));
+  } else {
+    m_outputCallback(line.substr(0, line.size() - 1));
   }
 }
 
 void TemplateExtractor::processDump(const string& outputFileName) {
+  std::unique_ptr<cbl::CompressedFileWriter> compressedOutput;
+  FILE* outputFile = nullptr;
   if (outputFileName.empty()) {
-    m_outputFile = stdout;
+    outputFile = stdout;
+  } else if (cbl::isCompressedFileName(outputFileName)) {
+    compressedOutput = std::make_unique<cbl::CompressedFileWriter>(outputFileName);
+    outputFile = compressedOutput->file();
   } else {
-    m_outputFile = fopen(outputFileName.c_str(), "w");
-    CBL_ASSERT(m_outputFile) << "Cannot open '" << outputFileName << "'";
+    outputFile = fopen(outputFileName.c_str(), "w");
+    CBL_ASSERT(outputFile) << "Cannot open '" << outputFileName << "'";
+  }
+
+  processDump([outputFile](string_view line) {
+    CBL_ASSERT(fwrite(line.data(), 1, line.size(), outputFile) == line.size() && putc('\n', outputFile) != EOF)
+        << "Failed to write inclusions";
+  });
+  if (compressedOutput) {
+    compressedOutput->close();
+  } else if (!outputFileName.empty()) {
+    const int fcloseResult = fclose(outputFile);
+    CBL_ASSERT_EQ(fcloseResult, 0) << "Cannot close '" << outputFileName << "'";
   }
+}
+
+void TemplateExtractor::processDump(const std::function<void(string_view line)>& callback) {
+  m_outputCallback = callback;
+  processPages();
+  if (m_sorter) {
+    m_sorter->finish(callback);
+    m_sorter.reset();
+  }
+  m_outputCallback = nullptr;
+}
 
+void TemplateExtractor::processPages() {
   mwc::PagesDump dump;
   string wcode;
   for (int iPage = 1; dump.getArticle(); iPage++) {
@@ -77,11 +140,6 @@ void TemplateExtractor::processDump(const string& outputFileName) {
     dump.getContent(wcode);
     processPage(dump.title(), wcode);
   }
-
-  if (!outputFileName.empty()) {
-    const int fcloseResult = fclose(m_outputFile);
-    CBL_ASSERT_EQ(fcloseResult, 0) << "Cannot close '" << outputFileName << "'";
-  }
 }
 
 bool TemplateExtractor::extractInvokedModule(const string& str, string& module) {
@@ -113,13 +171,11 @@ void TemplateExtractor::extractFromParsedCode(const string& title, const wikicod
     if (it == m_templatesAndRedirects.end()) continue;
     const string& normalizedTemplateName = it->second.empty() ? it->first : it->second;
     string bufferNorm = cbl::collapseSpace(template_.toString());
+    string line = cbl::concat(normalizedTemplateName, "|", title, "|", bufferNorm, "\n");
     if (list != nullptr) {
-      list->push_back(string());
-      cbl::append(list->back(), normalizedTemplateName, "|", title, "|", bufferNorm, "\n");
+      list->push_back(std::move(line));
     } else {
-      int fprintfResult =
-          fprintf(m_outputFile, "%s|%s|%s\n", normalizedTemplateName.c_str(), title.c_str(), bufferNorm.c_str());
-      CBL_ASSERT(fprintfResult >= 0);
+      writeLine(line);
     }
   }
 }
@@ -153,8 +209,7 @@ void TemplateExtractor::processPage(const string& title, const string& wcode) {
                        fullList.begin();
 
     for (int i = 0; i < numTemplates; i++) {
-      int fwriteResult = fwrite(fullList[i].c_str(), 1, fullList[i].size(), m_outputFile);
-      CBL_ASSERT(fwriteResult >= 0);
+      writeLine(fullList[i]);
     }
   }
 }
@@ -2,20 +2,45 @@
 #define EXTRACT_TEMPLATES_LIB_H
 
 #include <cstdio>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
+#include "cbl/external_sorter.h"
 #include "mwclient/parser.h"
 #include "mwclient/wiki.h"
 
 class TemplateExtractor {
 public:
   explicit TemplateExtractor(mwc::Wiki* wiki);
+  // Reads the list of templates for which inclusions are extracted (one per line, without namespace except for
+  // modules).
   void readTemplates(const std::string& fileName);
+  void addTemplate(const std::string& name);
+  // Reads redirects to templates from a text file with lines "<source>|<target>". Only one level of redirect is
+  // followed.
   void readRedirects(const std::string& fileName);
+  // Same as readRedirects(), but from a redirect table built by the "redirects" dump process. Chains of redirects are
+  // already collapsed in the table, so double redirects are also resolved.
+  void readRedirectTable(const std::string& fileName);
+  // Makes processDump() write inclusions in byte order (as `LC_ALL=C sort` would do) instead of dump order.
+  void enableSortedOutput(const cbl::ExternalSorter::Params& params);
+  // Writes inclusions to `outputFileName`, or to stdout if it is empty. The output is compressed if the file name ends
+  // with ".gz".
   void processDump(const std::string& outputFileName);
+  // Calls `callback` for each inclusion. Lines do not end with '\n'.
+  void processDump(const std::function<void(std::string_view line)>& callback);
 
 private:
+  // Registers `title` as a redirect to `target` if both are templates and `target` is in the list of templates.
+  void addRedirect(std::string_view title, std::string_view target);
+  // Reads the dump from stdin and calls processPage() on each page. Inclusions are passed to writeLine() and then to
+  // m_outputCallback, except if the output is sorted.
+  void processPages();
+  // `line` must end with '\n'.
+  void writeLine(std::string_view line);
   bool extractInvokedModule(const std::string& str, std::string& module);
   void extractFromParsedCode(const std::string& title, const wikicode::List& parsedCode,
                              std::vector<std::string>* list);
@@ -24,7 +49,8 @@ private:
   mwc::Wiki* m_wiki;
   mwc::SiteInfo m_siteInfo;
   std::unordered_map<std::string, std::string> m_templatesAndRedirects;
-  FILE* m_outputFile = nullptr;
+  std::function<void(std::string_view line)> m_outputCallback;
+  std::unique_ptr<cbl::ExternalSorter> m_sorter;
 };
 
 #endif
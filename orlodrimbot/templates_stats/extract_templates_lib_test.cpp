@@ -5,6 +5,7 @@
 #include "cbl/log.h"
 #include "cbl/tempfile.h"
 #include "mwclient/mock_wiki.h"
+#include "orlodrimbot/dump/redirect_table/redirect_table.h"
 
 using cbl::TempFile;
 using std::string;
@@ -17,8 +18,10 @@ private:
   mwc::MockWiki m_wiki;
   TempFile m_templatesFile;
   TempFile m_redirectsFile;
+  TempFile m_redirectTableFile;
   TempFile m_dumpFile;
   TempFile m_outputFile;
+  TempFile m_sortedOutputFile;
 };
 
 void TemplateExtractorTest::runTests() {
@@ -52,6 +55,34 @@ void TemplateExtractorTest::runTests() {
                 "Test1|Page 2|{{OtherRedirectToTest1|abc}}\n"
                 "Test1|Page 2|{{RedirectToTest1|abc}}\n"
                 "Test1|Module:Test/Documentation|{{Test1}}\n");
+
+  CBL_ASSERT(freopen("testdata/extract_templates_pages_dump.txt", "r", stdin));
+  templateExtractor.enableSortedOutput({.memoryBudget = 100, .numThreads = 2});
+  templateExtractor.processDump(m_sortedOutputFile.path());
+  fclose(stdin);
+  CBL_ASSERT_EQ(cbl::readFile(m_sortedOutputFile.path()),
+                "Module:Wikiprojet|Page 1|{{#invoke:Wikiprojet|someFunction|abc}}\n"
+                "Module:Wikiprojet|Page 1|{{#invoquE :Wikiprojet|someFunction2|def}}\n"
+                "Module:Wikiprojet|Page 1|{{{{{|safesubst:}}}#invoke:Wikiprojet|someFunction3|ghi}}\n"
+                "TemplateWithSubst1|Page 1|{{subst:TemplateWithSubst1}}\n"
+                "TemplateWithSubst2|Page 1|{{ {{{|safesubst:}}} TemplateWithSubst2}}\n"
+                "Test1|Module:Test/Documentation|{{Test1}}\n"
+                "Test1|Page 1|{{Test1|{{Test2}}}}\n"
+                "Test1|Page 2|{{OtherRedirectToTest1|abc}}\n"
+                "Test1|Page 2|{{RedirectToTest1|abc}}\n"
+                "Test2|Page 1|{{Test2}}\n");
+
+  // With a redirect table, double redirects are resolved.
+  TemplateExtractor templateExtractorWithTable(&m_wiki);
+  redirect_table::writeRedirectTable(m_redirectTableFile.path(),
+                                     {{"Modèle:RedirectToTest1", "Modèle:Test1"},
+                                      {"Modèle:OtherRedirectToTest1", "Modèle:RedirectToTest1"}});
+  templateExtractorWithTable.readTemplates(m_templatesFile.path());
+  templateExtractorWithTable.readRedirectTable(m_redirectTableFile.path());
+  CBL_ASSERT(freopen("testdata/extract_templates_pages_dump.txt", "r", stdin));
+  templateExtractorWithTable.processDump(m_outputFile.path());
+  fclose(stdin);
+  CBL_ASSERT_EQ(cbl::readFile(m_outputFile.path()), outputFileContent);
 }
 
 int main() {
@@ -1,7 +1,7 @@
 // Extract templates parameters from a dump of templates.
 // Input flags:
 //   --templatesdump: A "simple dump" of all templates on the wiki (see processSimpleDump in parse_templates_lib.cpp for
-//     the format).
+//     the format). It can be compressed with gzip.
 // Output flags:
 //   --withparam: A filtered list of templates in the dump and their parameters (uninteresting templates such as
 //     documentation pages without parameters are excluded).
@@ -20,15 +20,14 @@
 //       Exemple|{{Exemple|p1=|q1=|p2=}}
 //     This matches the format used in Utilisateur:Orlodrim/LuaConfig which was the original way of specifying
 //     parameters for templates using modules.
-#include <fstream>
 #include <string>
 #include "cbl/args_parser.h"
+#include "cbl/compressed_file.h"
 #include "cbl/log.h"
 #include "mwclient/util/init_wiki.h"
 #include "mwclient/wiki.h"
 #include "parse_templates_lib.h"
 
-using std::ifstream;
 using std::string;
 
 int main(int argc, char** argv) {
@@ -43,7 +42,7 @@ int main(int argc, char** argv) {
   mwc::Wiki wiki;
   mwc::initWikiFromFlags(wikiFlags, wiki);
 
-  ifstream templatesDumpStream(templatesDumpPath.c_str());
+  cbl::CompressedFileInputStream templatesDumpStream(templatesDumpPath);
   CBL_ASSERT(templatesDumpStream) << "Cannot read from '" << templatesDumpPath << "'";
   parseTemplatesFromDump(wiki, templatesDumpStream, withParam, withParamNames, templateData);
 
@@ -9,6 +9,7 @@
 #include <string_view>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 #include "cbl/error.h"
 #include "cbl/json.h"
 #include "cbl/log.h"
@@ -26,6 +27,7 @@ using std::set;
 using std::string;
 using std::string_view;
 using std::unordered_set;
+using std::vector;
 
 namespace {
 
@@ -41,8 +43,6 @@ namespace {
 void processSimpleDump(istream& inputStream,
                        const std::function<void(const string& title, const string& content)>& processPage) {
   string line, title, content;
-  inputStream.clear();
-  inputStream.seekg(0);
   while (getline(inputStream, line)) {
     CBL_ASSERT(!line.empty());
     if (line[0] == ' ') {
@@ -83,16 +83,6 @@ bool containsInvoke(const string& code) {
   return RE2::PartialMatch(code, reModuleInvoke);
 }
 
-unordered_set<string> getTemplatesWithInvoke(istream& inputStream) {
-  unordered_set<string> templates;
-  processSimpleDump(inputStream, [&](const string& title, const string& content) {
-    if (containsInvoke(content)) {
-      templates.insert(title);
-    }
-  });
-  return templates;
-}
-
 string generateCompactTemplateCode(const string& fullCode) {
   wikicode::List parsedCode = wikicode::parse(fullCode);
   string compactCode;
@@ -122,24 +112,26 @@ void extractParams(Wiki& wiki, const string& title, bool isDocPage, const string
   paramsFile << unprefixedTitle << "|" << compactCode << "\n";
 }
 
-void extractTemplateData(Wiki& wiki, const string& title, const string& content, ostream& outputStream) {
+// If `content` contains templatedata, returns the corresponding line for the Lua DB (see --templatedata in
+// parse_templates.cpp), including the final '\n'. Otherwise, returns an empty string.
+string extractTemplateData(Wiki& wiki, const string& title, const string& content) {
   // Does the code contain a "<templatedata>" section?
   static const re2::RE2 reTemplateDataStart(R"((<(?i:templatedata)(?:\s[^<>]*)?>))");
   static const re2::RE2 reTemplateDataEnd("(</(?i:templatedata)>)");
   re2::StringPiece tag;
-  if (!RE2::PartialMatch(content, reTemplateDataStart, &tag)) return;
+  if (!RE2::PartialMatch(content, reTemplateDataStart, &tag)) return "";
   string_view templateDataText = string_view(content).substr(tag.data() + tag.size() - content.c_str());
-  if (!RE2::PartialMatch(templateDataText, reTemplateDataEnd, &tag)) return;
+  if (!RE2::PartialMatch(templateDataText, reTemplateDataEnd, &tag)) return "";
   templateDataText = templateDataText.substr(0, tag.data() - templateDataText.data());
   json::Value templateData;
   try {
     templateData = json::parse(templateDataText);
   } catch (const cbl::ParseError& error) {
     // TODO: Surface the list of templates with invalid templatedata somewhere.
-    return;
+    return "";
   }
   const json::Value& paramsField = templateData["params"];
-  if (paramsField.object().empty()) return;
+  if (paramsField.object().empty()) return "";
 
   set<string> parameters;
   for (const auto& [paramName, paramSpec] : paramsField) {
@@ -151,31 +143,31 @@ void extractTemplateData(Wiki& wiki, const string& title, const string& content,
 
   string unprefixedTitle = wiki.stripNamespace(title, mwc::NS_TEMPLATE);
   if (unprefixedTitle.empty()) {
-    return;
+    return "";
   }
-  outputStream << unprefixedTitle << "|{{" << unprefixedTitle;
+  string line = cbl::concat(unprefixedTitle, "|{{", unprefixedTitle);
   for (const string& param : parameters) {
     if (!param.empty() && param.find_first_of("|{}[]<>\n") == string::npos) {
-      outputStream << "|" << param << "=";
+      cbl::append(line, "|", param, "=");
     }
   }
-  outputStream << "}}\n";
+  line += "}}\n";
+  return line;
 }
 
 }  // namespace
 
-void parseTemplatesFromDump(Wiki& wiki, istream& inputStream, const string& paramsPath, const string& namesPath,
-                            const string& templateDataPath) {
-  unordered_set<string> templatesWithInvoke = getTemplatesWithInvoke(inputStream);
-
-  ofstream paramsFile(paramsPath.c_str());
-  ofstream namesFile(namesPath.c_str());
-  ofstream templateDataFile(templateDataPath.c_str());
-  CBL_ASSERT(paramsFile) << "Cannot write to '" << paramsPath.c_str() << "'";
-  CBL_ASSERT(namesFile) << "Cannot write to '" << namesPath.c_str() << "'";
-  CBL_ASSERT(templateDataFile) << "Cannot write to '" << templateDataPath.c_str() << "'";
+void parseTemplatesFromDump(Wiki& wiki, istream& inputStream, ostream& paramsStream, ostream& namesStream,
+                            ostream& templateDataStream) {
+  unordered_set<string> templatesWithInvoke;
+  // Templatedata is only extracted for templates that call a module, which is only known at the end of the dump since
+  // documentation pages can come before their template. Candidate lines are kept in dump order until then.
+  vector<pair<string, string>> templateDataByBaseTitle;
 
   processSimpleDump(inputStream, [&](const string& title, const string& content) {
+    if (containsInvoke(content)) {
+      templatesWithInvoke.insert(title);
+    }
     if (!shouldProcessTemplate(title)) {
       // Skip based on the title.
       return;
@@ -184,9 +176,27 @@ void parseTemplatesFromDump(Wiki& wiki, istream& inputStream, const string& para
       return;
     }
     auto [titleBase, isDocPage] = parseDocPageTitle(title);
-    extractParams(wiki, title, isDocPage, content, namesFile, paramsFile);
-    if (templatesWithInvoke.count(titleBase) != 0) {
-      extractTemplateData(wiki, titleBase, content, templateDataFile);
+    extractParams(wiki, title, isDocPage, content, namesStream, paramsStream);
+    string templateData = extractTemplateData(wiki, titleBase, content);
+    if (!templateData.empty()) {
+      templateDataByBaseTitle.emplace_back(titleBase, std::move(templateData));
     }
   });
+
+  for (const auto& [titleBase, templateData] : templateDataByBaseTitle) {
+    if (templatesWithInvoke.count(titleBase) != 0) {
+      templateDataStream << templateData;
+    }
+  }
+}
+
+void parseTemplatesFromDump(Wiki& wiki, istream& inputStream, const string& paramsPath, const string& namesPath,
+                            const string& templateDataPath) {
+  ofstream paramsFile(paramsPath.c_str());
+  ofstream namesFile(namesPath.c_str());
+  ofstream templateDataFile(templateDataPath.c_str());
+  CBL_ASSERT(paramsFile) << "Cannot write to '" << paramsPath.c_str() << "'";
+  CBL_ASSERT(namesFile) << "Cannot write to '" << namesPath.c_str() << "'";
+  CBL_ASSERT(templateDataFile) << "Cannot write to '" << templateDataPath.c_str() << "'";
+  parseTemplatesFromDump(wiki, inputStream, paramsFile, namesFile, templateDataFile);
 }
@@ -2,10 +2,19 @@
 #define TEMPLATES_STATS_PARSE_TEMPLATES_LIB_H
 
 #include <istream>
+#include <ostream>
 #include <string>
 #include "mwclient/wiki.h"
 
-// inputStream must be seekable because it is read twice.
+// Reads a simple dump of templates from `inputStream` in a single pass and writes:
+// - to `paramsStream`, a line "<template>|<compact code>" for each template that is not a redirect (documentation
+//   pages are only included if they have parameters);
+// - to `namesStream`, the names of these templates;
+// - to `templateDataStream`, parameters declared in the templatedata of templates calling a module.
+// See parse_templates.cpp for details on formats.
+void parseTemplatesFromDump(mwc::Wiki& wiki, std::istream& inputStream, std::ostream& paramsStream,
+                            std::ostream& namesStream, std::ostream& templateDataStream);
+// Same as above, writing to files.
 void parseTemplatesFromDump(mwc::Wiki& wiki, std::istream& inputStream, const std::string& paramsPath,
                             const std::string& namesPath, const std::string& templateDataPath);
 
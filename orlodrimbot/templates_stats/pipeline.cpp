@@ -0,0 +1,181 @@
+#include "pipeline.h"
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "cbl/compressed_file.h"
+#include "cbl/directory.h"
+#include "cbl/file.h"
+#include "cbl/log.h"
+#include "cbl/string.h"
+#include "mwclient/wiki.h"
+#include "extract_templates_lib.h"
+#include "parse_templates_lib.h"
+#include "side_template_data.h"
+#include "stat_lib.h"
+#include "templateinfo.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace templates_stats {
+namespace {
+
+// Splits `text` into lines and sorts them in byte order, like `LC_ALL=C sort`.
+vector<string> splitAndSortLines(string_view text) {
+  vector<string> lines;
+  for (string_view line : cbl::splitLines(text)) {
+    lines.emplace_back(line);
+  }
+  // std::string comparison is the byte order.
+  std::sort(lines.begin(), lines.end());
+  return lines;
+}
+
+string joinLines(const vector<string>& lines) {
+  string text;
+  for (const string& line : lines) {
+    text += line;
+    text += '\n';
+  }
+  return text;
+}
+
+// Reads the titles of pages in a simple dump of modules.
+vector<string> readModuleNames(const string& modulesDumpPath) {
+  cbl::CompressedFileInputStream modulesDump(modulesDumpPath);
+  CBL_ASSERT(modulesDump) << "Cannot open '" << modulesDumpPath << "'";
+  vector<string> names;
+  string line;
+  while (getline(modulesDump, line)) {
+    if (!line.empty() && line[0] != ' ') {
+      names.push_back(line);
+    }
+  }
+  return names;
+}
+
+// Computes one set of statistics in a thread, reading inclusions from a queue.
+class StatsThread {
+public:
+  StatsThread(mwc::Wiki& wiki, const string& templatesCode, const SideTemplateData& sideTemplateData,
+              const StatsOptions& options)
+      : m_templatesCode(templatesCode) {
+    m_thread = std::thread([this, &wiki, &sideTemplateData, options]() {
+      try {
+        computeStats(m_templatesCode, m_inclusions, options, wiki, sideTemplateData);
+      } catch (...) {
+        m_exception = std::current_exception();
+      }
+      // The producer must not be blocked if computeStats() stops before the end of inclusions.
+      m_inclusions.discardRemaining();
+    });
+  }
+  InclusionsQueue& inclusions() { return m_inclusions; }
+  // Waits for the end of the thread. Must be called after inclusions().close().
+  void join() {
+    m_thread.join();
+    if (m_exception) {
+      std::rethrow_exception(m_exception);
+    }
+  }
+
+private:
+  std::istringstream m_templatesCode;
+  InclusionsQueue m_inclusions;
+  std::exception_ptr m_exception;
+  std::thread m_thread;
+};
+
+}  // namespace
+
+void computeTemplatesStats(mwc::Wiki& wiki, const PipelineOptions& options) {
+  const bool debug = !options.debugDir.empty();
+  cbl::makeDir(options.outputDir);
+  if (debug) {
+    cbl::makeDir(options.debugDir);
+  }
+
+  // Step 1: parameters of templates and modules (formerly parse_templates and a few shell commands).
+  std::ostringstream templatesParams, templatesNames, templateData;
+  {
+    cbl::CompressedFileInputStream templatesDump(options.templatesDumpPath);
+    CBL_ASSERT(templatesDump) << "Cannot open '" << options.templatesDumpPath << "'";
+    parseTemplatesFromDump(wiki, templatesDump, templatesParams, templatesNames, templateData);
+  }
+  cbl::writeFile(options.luaDBAutoPath, templateData.str());
+  SideTemplateData sideTemplateData;
+  sideTemplateData.loadFromWikicode(templateData.str() + cbl::readFile(options.luaDBWikiPath));
+
+  vector<string> moduleNames = readModuleNames(options.modulesDumpPath);
+  string namesText = templatesNames.str();
+  string codeText = templatesParams.str();
+  for (const string& moduleName : moduleNames) {
+    namesText += moduleName + "\n";
+    codeText += moduleName + "|\n";
+  }
+  vector<string> names = splitAndSortLines(namesText);
+  const string sortedCode = joinLines(splitAndSortLines(codeText));
+  namesText.clear();
+  codeText.clear();
+  if (debug) {
+    cbl::writeFile(options.debugDir + "/templates-and-modules-for-stats-names.dat", joinLines(names));
+    cbl::writeFile(options.debugDir + "/templates-and-modules-for-stats.dat", sortedCode);
+  }
+
+  // Step 2: extraction and sorting of inclusions (formerly extract_templates --sort).
+  TemplateExtractor templateExtractor(&wiki);
+  for (const string& name : names) {
+    templateExtractor.addTemplate(name);
+  }
+  names.clear();
+  templateExtractor.readRedirectTable(options.redirectTablePath);
+  templateExtractor.enableSortedOutput(options.sorterParams);
+
+  // Step 3: statistics (formerly stat), computed as the sorted inclusions are produced.
+  const string dataDir = options.outputDir + "/data/";
+  const string dataAllNsDir = options.outputDir + "/data-allns/";
+  cbl::makeDir(dataDir);
+  cbl::makeDir(dataAllNsDir);
+  StatsThread mainNamespacesStats(wiki, sortedCode, sideTemplateData,
+                                  {.outputFormats = OF_JSON,
+                                   .jsonOutputDir = dataDir,
+                                   .listByCountFileName = dataDir + "templates-direct-inclusions.dat",
+                                   .noTalk = true,
+                                   .noUser = true,
+                                   .numThreads = options.statsThreads});
+  StatsThread allNamespacesStats(wiki, sortedCode, sideTemplateData,
+                                 {.outputFormats = OF_JSON,
+                                  .jsonOutputDir = dataAllNsDir,
+                                  .listByCountFileName = dataAllNsDir + "templates-direct-inclusions.dat",
+                                  .numThreads = options.statsThreads});
+
+  std::unique_ptr<cbl::CompressedFileWriter> extractionDebugFile;
+  if (debug) {
+    extractionDebugFile = std::make_unique<cbl::CompressedFileWriter>(options.debugDir + "/extraction-sorted.dat.gz");
+  }
+  templateExtractor.processDump([&](string_view line) {
+    mainNamespacesStats.inclusions().push(line);
+    allNamespacesStats.inclusions().push(line);
+    if (extractionDebugFile) {
+      FILE* file = extractionDebugFile->file();
+      CBL_ASSERT(fwrite(line.data(), 1, line.size(), file) == line.size() && putc('\n', file) != EOF)
+          << "Failed to write extraction-sorted.dat.gz";
+    }
+  });
+  mainNamespacesStats.inclusions().close();
+  allNamespacesStats.inclusions().close();
+  if (extractionDebugFile) {
+    extractionDebugFile->close();
+  }
+  mainNamespacesStats.join();
+  allNamespacesStats.join();
+}
+
+}  // namespace templates_stats
@@ -0,0 +1,40 @@
+// Computation of template statistics in a single process, equivalent to running parse_templates, extract_templates,
+// sort_lines and stat twice (once for main namespaces and once for all namespaces) as create_templates_stats.py used
+// to do, but without writing intermediate files.
+#ifndef TEMPLATES_STATS_PIPELINE_H
+#define TEMPLATES_STATS_PIPELINE_H
+
+#include <string>
+#include "cbl/external_sorter.h"
+#include "mwclient/wiki.h"
+
+namespace templates_stats {
+
+struct PipelineOptions {
+  // Simple dumps of templates and modules, written by the "templates" and "modules" dump processes.
+  std::string templatesDumpPath;
+  std::string modulesDumpPath;
+  // Redirect table written by the "redirects" dump process.
+  std::string redirectTablePath;
+  // Copy of Utilisateur:Orlodrim/LuaConfig.
+  std::string luaDBWikiPath;
+  // Output file for parameters extracted from templatedata (luadb_auto.txt).
+  std::string luaDBAutoPath;
+  // Statistics are written to "<outputDir>/data" and "<outputDir>/data-allns".
+  std::string outputDir;
+  // If not empty, intermediate data is also written to this directory, with the same file names as the multi-process
+  // version.
+  std::string debugDir;
+  // Parameters to sort inclusions. Only inclusions exceeding the memory budget are written to temporary files.
+  cbl::ExternalSorter::Params sorterParams;
+  // Number of threads for each of the two sets of statistics (see StatsOptions::numThreads).
+  int statsThreads = 1;
+};
+
+// Reads the XML dump of all pages from stdin and writes statistics. Both sets of statistics are computed in parallel,
+// by threads consuming inclusions as they come out of the sorter.
+void computeTemplatesStats(mwc::Wiki& wiki, const PipelineOptions& options);
+
+}  // namespace templates_stats
+
+#endif
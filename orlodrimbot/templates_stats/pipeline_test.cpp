@@ -0,0 +1,76 @@
+#include "pipeline.h"
+#include <cstdio>
+#include <string>
+#include "cbl/file.h"
+#include "cbl/log.h"
+#include "cbl/tempfile.h"
+#include "cbl/unittest.h"
+#include "mwclient/mock_wiki.h"
+#include "orlodrimbot/dump/redirect_table/redirect_table.h"
+
+using std::string;
+
+namespace templates_stats {
+
+class PipelineTest : public cbl::Test {
+private:
+  CBL_TEST_CASE(computeTemplatesStats) {
+    cbl::TempDir tempDir;
+    const string dir = tempDir.path();
+    cbl::writeFile(dir + "/templates.dat",
+                   "Modèle:Lien\n"
+                   " {{{lang}}} {{{trad}}} {{{fr}}}\n"
+                   "Modèle:Link\n"
+                   " #redirect[[Modèle:Lien]]\n"
+                   "Modèle:Infobox\n"
+                   " {{#invoke:Infobox|create|some_param}}\n"
+                   "Modèle:Infobox/Documentation\n"
+                   " <templatedata>{\"params\":{\"titre\":{}}}</templatedata>\n");
+    cbl::writeFile(dir + "/modules.dat", "Module:Infobox\n local p = {}\n");
+    redirect_table::writeRedirectTable(dir + "/redirects.bin", {{"Modèle:Link", "Modèle:Lien"}});
+    cbl::writeFile(dir + "/luadb_wiki.txt", "<!-- Empty for the test -->");
+    string xml = "<mediawiki>\n";
+    auto addPage = [&](const string& title, int pageid, const string& code) {
+      xml += "  <page>\n    <title>" + title + "</title>\n    <id>" + std::to_string(pageid) +
+             "</id>\n    <revision>\n      <timestamp>2000-01-01T00:00:00Z</timestamp>\n"
+             "      <text xml:space=\"preserve\">" +
+             code + "</text>\n    </revision>\n  </page>\n";
+    };
+    addPage("Modèle:Infobox", 1, "{{#invoke:Infobox|create|some_param}}");
+    addPage("Vénus (planète)", 2, "{{Infobox|titre=Vénus}} {{Link|fr=Terre}}");
+    addPage("Utilisateur:Bob", 3, "{{Lien|lang=en}}");
+    xml += "</mediawiki>\n";
+    cbl::writeFile(dir + "/dump.xml", xml);
+
+    mwc::MockWiki wiki;
+    CBL_ASSERT(freopen((dir + "/dump.xml").c_str(), "r", stdin));
+    computeTemplatesStats(wiki, {.templatesDumpPath = dir + "/templates.dat",
+                                 .modulesDumpPath = dir + "/modules.dat",
+                                 .redirectTablePath = dir + "/redirects.bin",
+                                 .luaDBWikiPath = dir + "/luadb_wiki.txt",
+                                 .luaDBAutoPath = dir + "/luadb_auto.txt",
+                                 .outputDir = dir + "/out",
+                                 .debugDir = dir + "/debug",
+                                 .sorterParams = {.memoryBudget = 10, .numThreads = 2, .tempDir = dir}});
+    fclose(stdin);
+
+    CBL_ASSERT_EQ(cbl::readFile(dir + "/luadb_auto.txt"), "Infobox|{{Infobox|titre=}}\n");
+    CBL_ASSERT_EQ(cbl::readFile(dir + "/debug/templates-and-modules-for-stats-names.dat"),
+                  "Infobox\nLien\nModule:Infobox\n");
+    CBL_ASSERT_EQ(cbl::readFile(dir + "/out/data/templates-direct-inclusions.dat"),
+                  "Infobox|1\nLien|1\nModule:Infobox|1\n");
+    CBL_ASSERT_EQ(cbl::readFile(dir + "/out/data-allns/templates-direct-inclusions.dat"),
+                  "Infobox|1\nLien|2\nModule:Infobox|1\n");
+    string json = cbl::readFile(dir + "/out/data/json.dat");
+    CBL_ASSERT(json.starts_with(
+        "{\"name\":\"Infobox\",\"inclusions\":1,\"pages\":1,\"parameters\":[{\"name\":\"titre\",\"pages\":1,"))
+        << json;
+  }
+};
+
+}  // namespace templates_stats
+
+int main() {
+  templates_stats::PipelineTest().run();
+  return 0;
+}
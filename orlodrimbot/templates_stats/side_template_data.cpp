@@ -33,7 +33,7 @@ void SideTemplateData::loadFromWikicode(const string& code) {
     string templateName = unicode_fr::capitalize(template_.name());
     if (templateName.empty() || templateName == "Nobots") continue;
     int iParam = 0;
-    TemplateSpec& templateSpec = m_templates[templateName];
+    ParamValidator& templateSpec = m_templates[templateName];
     vector<string> regExps;
     string param;
     for (int i = 1; i < template_.size(); i++) {
@@ -56,14 +56,14 @@ void SideTemplateData::loadFromWikicode(const string& code) {
         regExp += ')';
       }
       if (regExp.empty()) {
-        templateSpec.standardParams.insert(param);
+        templateSpec.m_standardParams.insert(param);
       } else {
         regExp += RE2::QuoteMeta(paramSuffix);
         regExps.push_back(std::move(regExp));
       }
     }
     if (!regExps.empty()) {
-      templateSpec.regExp = std::make_unique<RE2>(cbl::join(regExps, "|"));
+      templateSpec.m_regExp = std::make_unique<RE2>(cbl::join(regExps, "|"));
     }
   }
 }
@@ -76,22 +76,24 @@ bool SideTemplateData::isTemplateInLuaDB(const string& templateName) const {
   return m_templates.count(templateName) != 0;
 }
 
+const SideTemplateData::ParamValidator* SideTemplateData::getParamValidator(const string& templateName) const {
+  TemplateSpecMap::const_iterator templateSpecIt = m_templates.find(templateName);
+  return templateSpecIt != m_templates.end() ? &templateSpecIt->second : nullptr;
+}
+
 vector<string> SideTemplateData::getValidParams(const string& templateName, const map<string, string>& fields) const {
   vector<string> validParams;
-  TemplateSpecMap::const_iterator templateSpecIt = m_templates.find(templateName);
-  if (templateSpecIt != m_templates.end()) {
-    const TemplateSpec& templateSpec = templateSpecIt->second;
+  const ParamValidator* paramValidator = getParamValidator(templateName);
+  if (paramValidator != nullptr) {
     for (const auto& [param, unusedValue] : fields) {
-      bool paramIsValid = false;
-      if (templateSpec.standardParams.count(param) != 0) {
-        paramIsValid = true;
-      } else if (templateSpec.regExp) {
-        paramIsValid = RE2::FullMatch(param, *templateSpec.regExp);
-      }
-      if (paramIsValid) {
+      if (paramValidator->isValid(param)) {
         validParams.push_back(param);
       }
     }
   }
   return validParams;
 }
+
+bool SideTemplateData::ParamValidator::isValid(const string& param) const {
+  return m_standardParams.count(param) != 0 || (m_regExp && RE2::FullMatch(param, *m_regExp));
+}
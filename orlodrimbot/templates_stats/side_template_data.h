@@ -11,6 +11,19 @@
 
 class SideTemplateData {
 public:
+  // Parameters declared for a template.
+  class ParamValidator {
+  public:
+    bool isValid(const std::string& param) const;
+
+  private:
+    friend class SideTemplateData;
+    // Parameters without numbered part.
+    std::unordered_set<std::string> m_standardParams;
+    // Single regexp matching all numbered parameters such as "auteur[1-]", or null if there is none.
+    std::unique_ptr<re2::RE2> m_regExp;
+  };
+
   SideTemplateData() = default;
   SideTemplateData(const SideTemplateData&) = delete;
   SideTemplateData(SideTemplateData&&) = default;
@@ -20,6 +33,8 @@ public:
   void loadFromWikicode(const std::string& wcode);
   // templateName is the template name without a namespace.
   bool isTemplateInLuaDB(const std::string& templateName) const;
+  // Returns null if the template is not in the Lua DB. The returned object remains valid until the next load.
+  const ParamValidator* getParamValidator(const std::string& templateName) const;
   std::vector<std::string> getValidParams(const std::string& templateName,
                                           const std::map<std::string, std::string>& fields) const;
 
@@ -28,11 +43,7 @@ private:
     int min;
     int max;
   };
-  struct TemplateSpec {
-    std::unordered_set<std::string> standardParams;
-    std::unique_ptr<re2::RE2> regExp;
-  };
-  using TemplateSpecMap = std::unordered_map<std::string, TemplateSpec>;
+  using TemplateSpecMap = std::unordered_map<std::string, ParamValidator>;
   TemplateSpecMap m_templates;
 };
 
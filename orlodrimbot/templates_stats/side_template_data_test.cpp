@@ -51,6 +51,18 @@ private:
     CBL_ASSERT_EQ(cbl::join(validParams, ","), "a1b1,a1b99,a3b1,a3b99");
   }
 
+  CBL_TEST_CASE(ParamValidator) {
+    SideTemplateData helper = createHelperFromString("<pre>{{TestTemplate|titre=|auteur[1-]=}}</pre>");
+    CBL_ASSERT(helper.getParamValidator("OtherTemplate") == nullptr);
+    const SideTemplateData::ParamValidator* validator = helper.getParamValidator("TestTemplate");
+    CBL_ASSERT(validator != nullptr);
+    CBL_ASSERT(validator->isValid("titre"));
+    CBL_ASSERT(validator->isValid("auteur12"));
+    CBL_ASSERT(!validator->isValid("auteur0"));
+    CBL_ASSERT(!validator->isValid("auteur"));
+    CBL_ASSERT(!validator->isValid("autre"));
+  }
+
   cbl::TempFile m_tempFile;
 };
 
@@ -0,0 +1,63 @@
+// Sorts lines in byte order, like `LC_ALL=C sort`, with bounded memory usage.
+// Reads the files passed as arguments, or stdin if there is none. Temporary files are compressed, which makes this
+// faster than `sort --compress-program=gzip` on large inputs with many similar lines such as template inclusions.
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cbl/args_parser.h"
+#include "cbl/external_sorter.h"
+#include "cbl/log.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+static void addLinesFromFile(FILE* file, cbl::ExternalSorter& sorter) {
+  char* buffer = nullptr;
+  size_t bufferSize = 0;
+  ssize_t lineLength;
+  while ((lineLength = getline(&buffer, &bufferSize, file)) != -1) {
+    string_view line(buffer, lineLength);
+    if (line.ends_with('\n')) {
+      line.remove_suffix(1);
+    }
+    sorter.add(line);
+  }
+  free(buffer);
+}
+
+int main(int argc, char** argv) {
+  string outputFileName;
+  int memoryMB = 2048;
+  int numThreads = 4;
+  string tempDir = "/tmp";
+  int compressionLevel = 1;
+  vector<string> inputFileNames;
+  cbl::parseArgs(argc, argv, "--output", &outputFileName, "--memory-mb", &memoryMB, "--threads", &numThreads,
+                 "--tempdir", &tempDir, "--compression-level", &compressionLevel, "inputs", &inputFileNames);
+
+  cbl::ExternalSorter sorter({.memoryBudget = static_cast<int64_t>(memoryMB) << 20,
+                              .numThreads = numThreads,
+                              .tempDir = tempDir,
+                              .compressionLevel = compressionLevel});
+  if (inputFileNames.empty()) {
+    addLinesFromFile(stdin, sorter);
+  }
+  for (const string& inputFileName : inputFileNames) {
+    FILE* inputFile = fopen(inputFileName.c_str(), "r");
+    CBL_ASSERT(inputFile != nullptr) << "Cannot open '" << inputFileName << "'";
+    addLinesFromFile(inputFile, sorter);
+    fclose(inputFile);
+  }
+
+  FILE* outputFile = stdout;
+  if (!outputFileName.empty()) {
+    outputFile = fopen(outputFileName.c_str(), "w");
+    CBL_ASSERT(outputFile != nullptr) << "Cannot open '" << outputFileName << "'";
+  }
+  sorter.finish(outputFile);
+  CBL_ASSERT_EQ(fclose(outputFile), 0) << "Cannot close the output file";
+  return 0;
+}
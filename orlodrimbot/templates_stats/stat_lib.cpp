@@ -0,0 +1,353 @@
+#include "stat_lib.h"
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "cbl/compressed_file.h"
+#include "cbl/directory.h"
+#include "cbl/log.h"
+#include "cbl/string.h"
+#include "mwclient/parser.h"
+#include "mwclient/wiki.h"
+#include "side_template_data.h"
+#include "templateinfo.h"
+
+using mwc::NS_MEDIAWIKI;
+using mwc::NS_USER;
+using mwc::Wiki;
+using std::istream;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace templates_stats {
+
+bool InclusionsReader::read(const string& templateName, string& page, string& code) {
+  if (!m_started) {
+    m_started = true;
+    readNextLine();
+  }
+  if (m_currentTemplate != templateName) {
+    CBL_ASSERT(cbl::concat(m_currentTemplate, "|") > templateName + "|" || m_currentTemplate.empty());
+    return false;
+  }
+  size_t pageStart = m_currentTemplate.size() + 1;
+  size_t pageEnd = m_currentLine.find('|', pageStart);
+  CBL_ASSERT(pageEnd != string::npos);
+  page.assign(m_currentLine, pageStart, pageEnd - pageStart);
+  code.assign(m_currentLine, pageEnd + 1);
+  readNextLine();
+  return true;
+}
+
+void InclusionsReader::readNextLine() {
+  if (!readLine(m_currentLine)) {
+    m_currentLine.clear();
+    m_currentTemplate = "";
+  } else {
+    size_t pipePosition = m_currentLine.find('|');
+    CBL_ASSERT(pipePosition != string::npos);
+    m_currentTemplate = string_view(m_currentLine).substr(0, pipePosition);
+  }
+}
+
+InclusionsFileReader::InclusionsFileReader(const string& fileName) : m_file(fileName) {
+  CBL_ASSERT(m_file) << "Cannot open '" << fileName << "'";
+}
+
+bool InclusionsFileReader::readLine(string& line) {
+  return static_cast<bool>(getline(m_file, line));
+}
+
+void InclusionsQueue::push(string_view line) {
+  m_batchToPush.emplace_back(line);
+  if (m_batchToPush.size() >= BATCH_SIZE) {
+    pushBatch();
+  }
+}
+
+void InclusionsQueue::close() {
+  if (!m_batchToPush.empty()) {
+    pushBatch();
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_closed = true;
+  m_queueChanged.notify_all();
+}
+
+void InclusionsQueue::pushBatch() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_queueChanged.wait(lock, [this]() { return m_batches.size() < MAX_PENDING_BATCHES; });
+  m_batches.push_back(std::move(m_batchToPush));
+  m_batchToPush.clear();
+  m_queueChanged.notify_all();
+}
+
+bool InclusionsQueue::readLine(string& line) {
+  if (m_positionInBatch >= m_batchToRead.size()) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_queueChanged.wait(lock, [this]() { return !m_batches.empty() || m_closed; });
+    if (m_batches.empty()) {
+      return false;
+    }
+    m_batchToRead = std::move(m_batches.front());
+    m_batches.pop_front();
+    m_positionInBatch = 0;
+    m_queueChanged.notify_all();
+  }
+  line = std::move(m_batchToRead[m_positionInBatch++]);
+  return true;
+}
+
+void InclusionsQueue::discardRemaining() {
+  string line;
+  while (readLine(line)) {
+  }
+}
+
+namespace {
+
+struct Inclusion {
+  string page;
+  string code;
+};
+
+// Inclusions of a template, or of a range of pages for a template with many inclusions.
+struct TemplatePart {
+  string name;
+  string code;
+  vector<Inclusion> inclusions;
+  bool isFirstPart = true;
+  bool isLastPart = true;
+};
+
+// Output for a template. Empty strings if the template is not written.
+struct TemplateOutput {
+  string text;
+  string json;
+  string listByCountLine;
+};
+
+struct PartResult {
+  // Set if the template has several parts. Parts are merged before generating the output.
+  std::unique_ptr<TemplateInfo> templateInfo;
+  bool isFirstPart = true;
+  bool isLastPart = true;
+  // Set for templates that have a single part.
+  TemplateOutput output;
+};
+
+string generateInfoAsString(TemplateInfo& templateInfo, OutputFormat format) {
+  char* buffer = nullptr;
+  size_t size = 0;
+  FILE* file = open_memstream(&buffer, &size);
+  CBL_ASSERT(file != nullptr);
+  templateInfo.generateInfo(file, format);
+  fputc('\n', file);
+  fclose(file);
+  string str(buffer, size);
+  free(buffer);
+  return str;
+}
+
+TemplateOutput generateOutput(const string& templateName, TemplateInfo& templateInfo, const StatsOptions& options) {
+  TemplateOutput output;
+  if (templateInfo.namespace_() == TemplateInfo::TN_TEMPLATE) {
+    if (!templateInfo.hasParameters() && templateName.ends_with("/Documentation")) {
+      return output;
+    }
+  } else if (templateInfo.namespace_() == TemplateInfo::TN_MODULE) {
+    // HACK (à mettre en liste noire avant)
+    if (templateName.ends_with("/Documentation")) {
+      return output;
+    }
+  }
+  if (options.outputFormats & OF_TEXT) {
+    output.text = generateInfoAsString(templateInfo, OF_TEXT);
+  }
+  if (options.outputFormats & OF_JSON) {
+    output.json = generateInfoAsString(templateInfo, OF_JSON);
+  }
+  output.listByCountLine = cbl::concat(templateName, "|", std::to_string(templateInfo.getArticlesCount()), "\n");
+  return output;
+}
+
+vector<PartResult> processTask(const vector<TemplatePart>& task, const StatsOptions& options, Wiki& wiki,
+                               const SideTemplateData& sideTemplateData) {
+  vector<PartResult> results;
+  for (const TemplatePart& part : task) {
+    TemplateInfo templateInfo(part.name, part.code, sideTemplateData, /* logWarnings = */ part.isFirstPart);
+    for (const Inclusion& inclusion : part.inclusions) {
+      const string& page = inclusion.page;
+      int namespace_ = wiki.getTitleNamespace(page);
+      if (options.noUser && namespace_ == NS_USER) {
+        continue;
+      } else if (options.noTalk && mwc::isTalkNamespace(namespace_)) {
+        continue;
+      } else if ((namespace_ == NS_USER || namespace_ == NS_MEDIAWIKI) &&
+                 (page.ends_with(".js") || page.ends_with(".css"))) {
+        continue;
+      }
+      wikicode::List parsedCode = wikicode::parse(inclusion.code);
+      if (parsedCode.size() != 1 || parsedCode[0].type() != wikicode::NT_TEMPLATE) {
+        // I think I checked a long time ago that there were some special cases when a syntax error can cause
+        // this. Error log disabled because those are very long lines.
+        // std::cerr << "Invalid line: " << line << std::endl;
+      } else {
+        templateInfo.readInclusion(wiki, page, parsedCode[0].asTemplate());
+      }
+    }
+    PartResult& result = results.emplace_back();
+    result.isFirstPart = part.isFirstPart;
+    result.isLastPart = part.isLastPart;
+    if (part.isFirstPart && part.isLastPart) {
+      result.output = generateOutput(part.name, templateInfo, options);
+    } else {
+      result.templateInfo = std::make_unique<TemplateInfo>(std::move(templateInfo));
+    }
+  }
+  return results;
+}
+
+// Writes outputs in the order of templates and merges parts of templates split between several tasks.
+class OutputWriter {
+public:
+  explicit OutputWriter(const StatsOptions& options) : m_options(options) {
+    if (options.outputFormats & OF_TEXT) {
+      CBL_ASSERT(!options.textOutputFileName.empty());
+      m_textOutputFile = fopen(options.textOutputFileName.c_str(), "w");
+      CBL_ASSERT(m_textOutputFile != nullptr);
+    }
+    if (options.outputFormats & OF_JSON) {
+      CBL_ASSERT(!options.jsonOutputDir.empty());
+      cbl::makeDir(options.jsonOutputDir);
+      const string jsonFileName = options.jsonOutputDir + "json.dat";
+      m_jsonFile = fopen(jsonFileName.c_str(), "w");
+    }
+    if (!options.listByCountFileName.empty()) {
+      m_listByCountFile = fopen(options.listByCountFileName.c_str(), "w");
+      CBL_ASSERT(m_listByCountFile != nullptr);
+    }
+  }
+  ~OutputWriter() {
+    for (FILE* file : {m_textOutputFile, m_jsonFile, m_listByCountFile}) {
+      if (file != nullptr) {
+        fclose(file);
+      }
+    }
+  }
+
+  void write(vector<PartResult>&& results) {
+    for (PartResult& result : results) {
+      if (!result.templateInfo) {
+        writeOutput(result.output);
+        continue;
+      }
+      if (result.isFirstPart) {
+        m_templateInfo = std::move(result.templateInfo);
+      } else {
+        m_templateInfo->merge(std::move(*result.templateInfo));
+      }
+      if (result.isLastPart) {
+        writeOutput(generateOutput(m_templateInfo->name(), *m_templateInfo, m_options));
+        m_templateInfo.reset();
+      }
+    }
+  }
+
+private:
+  static void writeString(FILE* file, const string& str) {
+    if (file != nullptr && !str.empty()) {
+      CBL_ASSERT_EQ(fwrite(str.data(), 1, str.size(), file), str.size());
+    }
+  }
+  void writeOutput(const TemplateOutput& output) {
+    writeString(m_textOutputFile, output.text);
+    writeString(m_jsonFile, output.json);
+    writeString(m_listByCountFile, output.listByCountLine);
+  }
+
+  const StatsOptions& m_options;
+  FILE* m_textOutputFile = nullptr;
+  FILE* m_jsonFile = nullptr;
+  FILE* m_listByCountFile = nullptr;
+  std::unique_ptr<TemplateInfo> m_templateInfo;
+};
+
+}  // namespace
+
+void computeStats(istream& templatesCodeStream, InclusionsReader& inclusionsReader, const StatsOptions& options,
+                  Wiki& wiki, const SideTemplateData& sideTemplateData) {
+  CBL_ASSERT(options.numThreads >= 1 && options.inclusionsPerTask >= 1);
+  OutputWriter outputWriter(options);
+  // Tasks are run by std::async(), which creates one thread per task. Each task is large enough for this to be
+  // negligible. With a single thread, tasks are run by the current thread when their result is needed.
+  const std::launch launchPolicy = options.numThreads > 1 ? std::launch::async : std::launch::deferred;
+  std::deque<std::future<vector<PartResult>>> pendingTasks;
+  vector<TemplatePart> task;
+  int taskSize = 0;
+  auto submitTask = [&]() {
+    if (static_cast<int>(pendingTasks.size()) >= options.numThreads) {
+      outputWriter.write(pendingTasks.front().get());
+      pendingTasks.pop_front();
+    }
+    pendingTasks.push_back(std::async(launchPolicy, [&options, &wiki, &sideTemplateData, task = std::move(task)]() {
+      return processTask(task, options, wiki, sideTemplateData);
+    }));
+    task.clear();
+    taskSize = 0;
+  };
+
+  int lineIndex = 0;
+  string line;
+  string inclusionPage, inclusionCode;
+  for (int templateCount = 0; getline(templatesCodeStream, line); templateCount++) {
+    if (options.limit != 0 && templateCount >= options.limit) {
+      break;
+    }
+    if (taskSize >= options.inclusionsPerTask) {
+      submitTask();
+    }
+    TemplatePart* part = &task.emplace_back();
+    {
+      size_t pipePosition = line.find('|');
+      CBL_ASSERT(pipePosition != string::npos);
+      part->name.assign(line, 0, pipePosition);
+      part->code.assign(line, pipePosition + 1, line.size() - (pipePosition + 1));
+    }
+    taskSize++;
+    while (inclusionsReader.read(part->name, inclusionPage, inclusionCode)) {
+      lineIndex++;
+      if (lineIndex % 100000 == 0) {
+        std::cerr << lineIndex << " lignes lues" << std::endl;
+      }
+      // Templates are only split between two pages, so that all inclusions in a page are in the same part.
+      if (taskSize >= options.inclusionsPerTask && !part->inclusions.empty() &&
+          part->inclusions.back().page != inclusionPage) {
+        TemplatePart nextPart{.name = part->name, .code = part->code, .isFirstPart = false};
+        part->isLastPart = false;
+        submitTask();
+        part = &task.emplace_back(std::move(nextPart));
+      }
+      part->inclusions.push_back({.page = inclusionPage, .code = inclusionCode});
+      taskSize++;
+    }
+  }
+  if (!task.empty()) {
+    submitTask();
+  }
+  for (; !pendingTasks.empty(); pendingTasks.pop_front()) {
+    outputWriter.write(pendingTasks.front().get());
+  }
+}
+
+}  // namespace templates_stats
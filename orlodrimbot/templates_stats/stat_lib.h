@@ -0,0 +1,109 @@
+#ifndef TEMPLATES_STATS_STAT_LIB_H
+#define TEMPLATES_STATS_STAT_LIB_H
+
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cbl/compressed_file.h"
+#include "mwclient/wiki.h"
+#include "side_template_data.h"
+#include "templateinfo.h"
+
+namespace templates_stats {
+
+// Source of inclusions sorted by template, in the format written by extract_templates: "<template>|<page>|<code>".
+class InclusionsReader {
+public:
+  virtual ~InclusionsReader() = default;
+  // If the next inclusion is an inclusion of `templateName`, reads it into `page` and `code` and returns true.
+  // Otherwise, returns false without consuming anything. Must be called with templates in increasing order.
+  bool read(const std::string& templateName, std::string& page, std::string& code);
+
+protected:
+  // Reads the next line into `line`. Returns false at the end of the input.
+  virtual bool readLine(std::string& line) = 0;
+
+private:
+  void readNextLine();
+
+  bool m_started = false;
+  std::string m_currentLine;
+  std::string_view m_currentTemplate;
+};
+
+// Reads inclusions from a file, which may be compressed.
+class InclusionsFileReader : public InclusionsReader {
+public:
+  explicit InclusionsFileReader(const std::string& fileName);
+
+protected:
+  bool readLine(std::string& line) override;
+
+private:
+  cbl::CompressedFileInputStream m_file;
+};
+
+// Inclusions passed from a producer thread to a consumer thread. push() blocks when too many lines are waiting.
+class InclusionsQueue : public InclusionsReader {
+public:
+  // Adds a line. Lines are transferred in batches, so they may not be visible to the reader before the next call to
+  // close().
+  void push(std::string_view line);
+  // Must be called by the producer after the last line.
+  void close();
+  // Reads and drops all lines until close() is called. Allows the consumer to stop early without blocking the producer.
+  void discardRemaining();
+
+protected:
+  bool readLine(std::string& line) override;
+
+private:
+  static constexpr size_t BATCH_SIZE = 1000;
+  static constexpr size_t MAX_PENDING_BATCHES = 64;
+
+  void pushBatch();
+
+  std::mutex m_mutex;
+  std::condition_variable m_queueChanged;
+  std::deque<std::vector<std::string>> m_batches;
+  bool m_closed = false;
+  // Owned by the producer.
+  std::vector<std::string> m_batchToPush;
+  // Owned by the consumer.
+  std::vector<std::string> m_batchToRead;
+  size_t m_positionInBatch = 0;
+};
+
+struct StatsOptions {
+  // Combination of OutputFormat values.
+  int outputFormats = OF_TEXT;
+  // Required if outputFormats contains OF_TEXT.
+  std::string textOutputFileName;
+  // Required if outputFormats contains OF_JSON. Must end with '/'.
+  std::string jsonOutputDir;
+  // If not empty, "<template>|<number of pages>" is written to this file for each template.
+  std::string listByCountFileName;
+  bool noTalk = false;
+  bool noUser = false;
+  // Maximum number of templates to process (0 = no limit).
+  int limit = 0;
+  // Number of threads reading inclusions. Templates are processed in parallel and templates with many inclusions are
+  // split by range of pages. The output does not depend on this parameter.
+  int numThreads = 1;
+  // Number of inclusions processed by each task. Mostly useful for tests.
+  int inclusionsPerTask = 20000;
+};
+
+// Computes statistics on parameters of templates.
+// `templatesCode` contains lines "<template>|<compact code>" sorted in byte order (see parse_templates.cpp) and
+// `inclusionsReader` reads inclusions sorted in the same order.
+void computeStats(std::istream& templatesCode, InclusionsReader& inclusionsReader, const StatsOptions& options,
+                  mwc::Wiki& wiki, const SideTemplateData& sideTemplateData);
+
+}  // namespace templates_stats
+
+#endif
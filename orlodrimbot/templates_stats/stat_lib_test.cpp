@@ -0,0 +1,92 @@
+#include "stat_lib.h"
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cbl/file.h"
+#include "cbl/log.h"
+#include "cbl/tempfile.h"
+#include "cbl/unittest.h"
+#include "mwclient/mock_wiki.h"
+#include "side_template_data.h"
+#include "templateinfo.h"
+
+using std::string;
+using std::vector;
+
+namespace templates_stats {
+
+class InclusionsVectorReader : public InclusionsReader {
+public:
+  explicit InclusionsVectorReader(const vector<string>& lines) : m_lines(lines) {}
+
+protected:
+  bool readLine(string& line) override {
+    if (m_position >= m_lines.size()) {
+      return false;
+    }
+    line = m_lines[m_position++];
+    return true;
+  }
+
+private:
+  const vector<string>& m_lines;
+  size_t m_position = 0;
+};
+
+class StatLibTest : public cbl::Test {
+private:
+  // Returns the text output followed by the JSON output.
+  string computeStatsAsString(const StatsOptions& baseOptions) {
+    cbl::TempDir tempDir;
+    StatsOptions options = baseOptions;
+    options.outputFormats = OF_TEXT | OF_JSON;
+    options.textOutputFileName = tempDir.path() + "/stats.txt";
+    options.jsonOutputDir = tempDir.path() + "/json/";
+    options.listByCountFileName = tempDir.path() + "/count.txt";
+    std::istringstream templatesCode(
+        "Big|{{{a}}}\n"
+        "Empty|\n"
+        "Module:M|\n"
+        "Small|{{{x}}}\n");
+    vector<string> inclusions;
+    for (int i = 0; i < 30; i++) {
+      string page = "Page " + std::to_string(100 + i);
+      inclusions.push_back("Big|" + page + "|{{Big|a=1|invalid=" + (i % 3 == 0 ? "" : "x") + "}}");
+      if (i % 4 == 0) {
+        inclusions.push_back("Big|" + page + "|{{Big|a=2|a=3}}");
+      }
+    }
+    for (int i = 0; i < 8; i++) {
+      inclusions.push_back("Module:M|Page " + std::to_string(i) + "|{{#invoke:M|f" + std::to_string(i % 2) + "}}");
+    }
+    inclusions.push_back("Small|Page 1|{{Small}}");
+    inclusions.push_back("Small|Utilisateur:Bob|{{Small|x=}}");
+    InclusionsVectorReader inclusionsReader(inclusions);
+    mwc::MockWiki wiki;
+    SideTemplateData sideTemplateData;
+    computeStats(templatesCode, inclusionsReader, options, wiki, sideTemplateData);
+    return cbl::readFile(options.textOutputFileName) + cbl::readFile(options.jsonOutputDir + "json.dat") +
+           cbl::readFile(options.listByCountFileName);
+  }
+
+  CBL_TEST_CASE(outputDoesNotDependOnThreads) {
+    string expectedOutput = computeStatsAsString({});
+    CBL_ASSERT(expectedOutput.find("Big|30\nEmpty|0\nModule:M|8\nSmall|2\n") != string::npos) << expectedOutput;
+    CBL_ASSERT(expectedOutput.find("*invalid (pages : 30, non vide : 20, existe : non)") != string::npos)
+        << expectedOutput;
+    for (int numThreads : {1, 3}) {
+      for (int inclusionsPerTask : {1, 2, 7}) {
+        CBL_ASSERT_EQ(computeStatsAsString({.numThreads = numThreads, .inclusionsPerTask = inclusionsPerTask}),
+                      expectedOutput)
+            << "numThreads=" << numThreads << " inclusionsPerTask=" << inclusionsPerTask;
+      }
+    }
+  }
+};
+
+}  // namespace templates_stats
+
+int main() {
+  templates_stats::StatLibTest().run();
+  return 0;
+}
@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <map>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -20,6 +21,7 @@ using std::make_pair;
 using std::map;
 using std::pair;
 using std::string;
+using std::string_view;
 using std::unordered_set;
 using std::vector;
 
@@ -32,39 +34,67 @@ bool containsInvoke(const string& code) {
   return RE2::PartialMatch(code, reModuleInvoke);
 }
 
-void pushInVector(vector<string>& v, int& size, const string& value, int maxCount) {
-  if (v.empty() || v.back() != value) {
-    if ((int) v.size() >= maxCount) {
-      v.pop_back();
+}  // namespace
+
+void TitleTable::setCurrentPage(const string& title) {
+  if (m_currentPageIndex == -1 || title != m_currentTitle) {
+    m_currentTitle = title;
+    m_currentPageIndex++;
+    m_currentTitleInTable = false;
+  }
+}
+
+TitleTable::Id TitleTable::currentTitleId() {
+  if (!m_currentTitleInTable) {
+    m_currentTitleId = addTitle(m_currentTitle);
+    m_currentTitleInTable = true;
+  }
+  return m_currentTitleId;
+}
+
+TitleTable::Id TitleTable::addTitle(const string& title) {
+  m_titles.push_back(title);
+  return m_titles.size() - 1;
+}
+
+void PageList::addCurrentPage(TitleTable& titleTable, int maxExamples) {
+  if (m_lastPageIndex != titleTable.currentPageIndex()) {
+    m_lastPageIndex = titleTable.currentPageIndex();
+    m_count++;
+    if (static_cast<int>(m_examples.size()) < maxExamples) {
+      m_examples.push_back(titleTable.currentTitleId());
     }
-    v.push_back(value);
-    size++;
   }
 }
 
-}  // namespace
+void PageList::merge(const PageList& other, const vector<TitleTable::Id>& titleIds, int maxExamples) {
+  m_count += other.m_count;
+  for (TitleTable::Id id : other.m_examples) {
+    if (static_cast<int>(m_examples.size()) >= maxExamples) {
+      break;
+    }
+    m_examples.push_back(titleIds[id]);
+  }
+}
 
-void FieldInfo::addValue(const string& title, const string& value, int templateUID) {
+void FieldInfo::addValue(TitleTable& titleTable, const string& value, int templateUID) {
   if (lastTemplateUID == templateUID) {
-    pushInVector(articlesDup, numArticlesDup, title, 5000);
+    pagesDup.addCurrentPage(titleTable, MAX_ERROR_EXAMPLES);
   }
   lastTemplateUID = templateUID;
-  pushInVector(articles, numArticles, title, MAX_VECTOR_SIZE);
-  if (!value.empty()) {
-    pushInVector(articlesNE, numArticlesNE, title, fieldDef != FD_NO ? MAX_VECTOR_SIZE : 5000);
-  } else {
-    pushInVector(articlesE, numArticlesE, title, fieldDef != FD_NO ? MAX_VECTOR_SIZE : 5000);
-  }
+  pages.addCurrentPage(titleTable, MAX_VECTOR_SIZE);
+  PageList& pagesForValue = value.empty() ? pagesE : pagesNE;
+  // Pages with invalid parameters are listed in errors, so more of them are kept.
+  pagesForValue.addCurrentPage(titleTable, fieldDef != FD_NO ? MAX_VECTOR_SIZE : MAX_ERROR_EXAMPLES);
 }
 
-void FunctionInfo::addCall(const string& title) {
-  pushInVector(articles, numArticles, title, MAX_VECTOR_SIZE);
+void FunctionInfo::addCall(TitleTable& titleTable) {
+  pages.addCurrentPage(titleTable, MAX_VECTOR_SIZE);
 }
 
 TemplateInfo::TemplateInfo(const string& templateName, const string& templateCode,
-                           const SideTemplateData& sideTemplateData)
-    : m_templateName(templateName), m_numInclusions(0), m_numErrors(-1), m_numArticles(0), m_numArticlesNP(0),
-      m_sideTemplateData(&sideTemplateData) {
+                           const SideTemplateData& sideTemplateData, bool logWarnings)
+    : m_templateName(templateName), m_numInclusions(0), m_numErrors(-1) {
   // HACK
   if (templateName.starts_with("Module:")) {
     m_fullPageName = templateName;
@@ -73,11 +103,13 @@ TemplateInfo::TemplateInfo(const string& templateName, const string& templateCod
     m_fullPageName = "Modèle:" + templateName;
     m_namespace = TN_TEMPLATE;
   }
-  m_inLuaDB = m_sideTemplateData->isTemplateInLuaDB(templateName);
-  if (m_inLuaDB && !containsInvoke(templateCode)) {
-    CBL_WARNING << "Modèle enregistré dans la base de données lua, mais ne faisant pas appel à un module : '"
-                << templateName << "'\n";
-    m_inLuaDB = false;
+  m_luaParamValidator = sideTemplateData.getParamValidator(templateName);
+  if (m_luaParamValidator != nullptr && !containsInvoke(templateCode)) {
+    if (logWarnings) {
+      CBL_WARNING << "Modèle enregistré dans la base de données lua, mais ne faisant pas appel à un module : '"
+                  << templateName << "'\n";
+    }
+    m_luaParamValidator = nullptr;
   }
   if (m_namespace == TN_TEMPLATE) {
     extractVars(templateCode);
@@ -106,30 +138,30 @@ private:
 
 void TemplateInfo::readInclusion(Wiki& wiki, const string& title, const wikicode::Template& template_) {
   m_numInclusions++;
-  pushInVector(m_articles, m_numArticles, title, MAX_VECTOR_SIZE);
+  m_titleTable.setCurrentPage(title);
+  m_pages.addCurrentPage(m_titleTable, MAX_VECTOR_SIZE);
   switch (m_namespace) {
     case TN_TEMPLATE:
-      readTemplateInclusion(wiki, title, template_);
+      readTemplateInclusion(wiki, template_);
       break;
     case TN_MODULE:
-      readModuleInclusion(title, template_);
+      readModuleInclusion(template_);
       break;
   }
 }
 
-void TemplateInfo::readTemplateInclusion(Wiki& wiki, const string& title, const wikicode::Template& template_) {
+void TemplateInfo::readTemplateInclusion(Wiki& wiki, const wikicode::Template& template_) {
   string unprefixedTitle(wiki.parseTitle(template_.name()).unprefixedTitle());
-  RedirInfo& redirInfo = m_redirInfos[unprefixedTitle];
-  pushInVector(redirInfo.articles, redirInfo.numArticles, title, MAX_VECTOR_SIZE);
+  m_redirInfos[unprefixedTitle].pages.addCurrentPage(m_titleTable, MAX_VECTOR_SIZE);
   if (template_.size() == 1) {
-    pushInVector(m_articlesNP, m_numArticlesNP, title, MAX_VECTOR_SIZE);
+    m_pagesNP.addCurrentPage(m_titleTable, MAX_VECTOR_SIZE);
   }
 
   ParamEnumerator enumerator(template_);
   string param, value;
-  if (m_nestedVariables.empty() && !m_inLuaDB) {
+  if (m_nestedVariables.empty() && m_luaParamValidator == nullptr) {
     while (enumerator.read(param, value)) {
-      m_fieldInfos[param].addValue(title, value, m_numInclusions);
+      m_fieldInfos[param].addValue(m_titleTable, value, m_numInclusions);
     }
   } else {
     map<string, string> fields;
@@ -137,26 +169,26 @@ void TemplateInfo::readTemplateInclusion(Wiki& wiki, const string& title, const
       // FIXME: pour les paramètres non nommés, il ne faudrait pas faire de trim (enfin pas tout de suite)
       fields[param] = value;
     }
-    if (m_inLuaDB) {
-      for (const string& param : m_sideTemplateData->getValidParams(m_templateName, fields)) {
-        FieldInfo& fieldInfo = m_fieldInfos[param];
-        if (fieldInfo.fieldDef == FD_NO) {
-          fieldInfo.fieldDef = FD_LUA;
-        }
-      }
-    }
     if (!m_nestedVariables.empty()) {
       // TODO: The support of nested variables is very hacky and it is hard to improve.
       // Either make sure it works well enough for the few templates relying on them and publish the code, or get rid
       // of this entirely.
     }
     for (const pair<const string, string>& field : fields) {
-      m_fieldInfos[field.first].addValue(title, field.second, m_numInclusions);
+      FieldInfo& fieldInfo = m_fieldInfos[field.first];
+      // The same parameters are used in most inclusions, so each one is only checked once against the Lua DB.
+      if (m_luaParamValidator != nullptr && !fieldInfo.checkedInLuaDB) {
+        fieldInfo.checkedInLuaDB = true;
+        if (fieldInfo.fieldDef == FD_NO && m_luaParamValidator->isValid(field.first)) {
+          fieldInfo.fieldDef = FD_LUA;
+        }
+      }
+      fieldInfo.addValue(m_titleTable, field.second, m_numInclusions);
     }
   }
 }
 
-void TemplateInfo::readModuleInclusion(const string& title, const wikicode::Template& template_) {
+void TemplateInfo::readModuleInclusion(const wikicode::Template& template_) {
   string functionName;
   if (template_.size() >= 2) {
     functionName = template_[1].toString();
@@ -165,30 +197,61 @@ void TemplateInfo::readModuleInclusion(const string& title, const wikicode::Temp
   }
   if (functionName.find("{{") == string::npos) {
     if (functionName.empty()) {
-      pushInVector(m_articlesNP, m_numArticlesNP, title, 5000);
+      m_pagesNP.addCurrentPage(m_titleTable, MAX_ERROR_EXAMPLES);
     } else {
-      m_functionInfos[functionName].addCall(title);
+      m_functionInfos[functionName].addCall(m_titleTable);
+    }
+  }
+}
+
+void TemplateInfo::merge(TemplateInfo&& other) {
+  CBL_ASSERT_EQ(m_templateName, other.m_templateName);
+  vector<TitleTable::Id> titleIds(other.m_titleTable.size());
+  for (int i = 0; i < other.m_titleTable.size(); i++) {
+    titleIds[i] = m_titleTable.addTitle(other.m_titleTable.title(i));
+  }
+  const int maxExamplesNP = m_namespace == TN_MODULE ? MAX_ERROR_EXAMPLES : MAX_VECTOR_SIZE;
+  m_numInclusions += other.m_numInclusions;
+  m_pages.merge(other.m_pages, titleIds, MAX_VECTOR_SIZE);
+  m_pagesNP.merge(other.m_pagesNP, titleIds, maxExamplesNP);
+  for (const auto& [redirectName, otherRedirInfo] : other.m_redirInfos) {
+    m_redirInfos[redirectName].pages.merge(otherRedirInfo.pages, titleIds, MAX_VECTOR_SIZE);
+  }
+  for (const auto& [functionName, otherFunctionInfo] : other.m_functionInfos) {
+    m_functionInfos[functionName].pages.merge(otherFunctionInfo.pages, titleIds, MAX_VECTOR_SIZE);
+  }
+  for (const auto& [fieldName, otherFieldInfo] : other.m_fieldInfos) {
+    FieldInfo& fieldInfo = m_fieldInfos[fieldName];
+    if (otherFieldInfo.fieldDef == FD_YES || (otherFieldInfo.fieldDef == FD_LUA && fieldInfo.fieldDef == FD_NO)) {
+      fieldInfo.fieldDef = otherFieldInfo.fieldDef;
     }
+    // Same limits as in FieldInfo::addValue(). The limit for a parameter that became valid through the Lua DB is lower
+    // than when it was added, but examples are only written if there are less than MAX_VECTOR_SIZE pages.
+    const int maxExamplesForValue = fieldInfo.fieldDef != FD_NO ? MAX_VECTOR_SIZE : MAX_ERROR_EXAMPLES;
+    fieldInfo.pages.merge(otherFieldInfo.pages, titleIds, MAX_VECTOR_SIZE);
+    fieldInfo.pagesE.merge(otherFieldInfo.pagesE, titleIds, maxExamplesForValue);
+    fieldInfo.pagesNE.merge(otherFieldInfo.pagesNE, titleIds, maxExamplesForValue);
+    fieldInfo.pagesDup.merge(otherFieldInfo.pagesDup, titleIds, MAX_ERROR_EXAMPLES);
   }
 }
 
 void TemplateInfo::generateTextInfo(FILE* file) {
   fprintf(file, "== [[%s]] ==\n", m_fullPageName.c_str());
   fprintf(file, "*inclusions : %i\n", m_numInclusions);
-  fprintf(file, "*pages : %i\n", m_numArticles);
+  fprintf(file, "*pages : %i\n", m_pages.count());
 
   for (const pair<const string, RedirInfo>& redir : m_redirInfos) {
     if (redir.first != m_templateName) {
       fprintf(file, "*pages utilisant la redirection [[Modèle:%s]] : %i\n", redir.first.c_str(),
-              redir.second.numArticles);
+              redir.second.pages.count());
     }
   }
 
-  if (m_numArticlesNP > 0) {
-    fprintf(file, "*pages utilisant le modèle sans paramètres : %i", m_numArticlesNP);
-    if (m_numArticlesNP <= MAX_VECTOR_SIZE) {
-      for (const string& article : m_articlesNP) {
-        fprintf(file, " - [[%s]]", article.c_str());
+  if (m_pagesNP.count() > 0) {
+    fprintf(file, "*pages utilisant le modèle sans paramètres : %i", m_pagesNP.count());
+    if (m_pagesNP.count() <= MAX_VECTOR_SIZE) {
+      for (TitleTable::Id article : m_pagesNP.examples()) {
+        fprintf(file, " - [[%s]]", m_titleTable.title(article).c_str());
       }
     }
     fprintf(file, "\n");
@@ -198,15 +261,15 @@ void TemplateInfo::generateTextInfo(FILE* file) {
   for (const pair<int, string>& itParam : m_paramByCount) {
     const string& param = itParam.second;
     FieldInfo& fi = m_fieldInfos[param];
-    fprintf(file, "*%.100s (pages : %i, non vide : %i, existe : %s)", param.c_str(), fi.numArticles, fi.numArticlesNE,
-            fi.fieldDef == FD_YES ? "oui" : (fi.fieldDef == FD_LUA ? "indirect" : "non"));
-    if (fi.numArticlesNE <= MAX_VECTOR_SIZE) {
-      for (const string& article : fi.articlesNE) {
-        fprintf(file, " - [[%s]]", article.c_str());
+    fprintf(file, "*%.100s (pages : %i, non vide : %i, existe : %s)", param.c_str(), fi.pages.count(),
+            fi.pagesNE.count(), fi.fieldDef == FD_YES ? "oui" : (fi.fieldDef == FD_LUA ? "indirect" : "non"));
+    if (fi.pagesNE.count() <= MAX_VECTOR_SIZE) {
+      for (TitleTable::Id article : fi.pagesNE.examples()) {
+        fprintf(file, " - [[%s]]", m_titleTable.title(article).c_str());
       }
-      if (fi.numArticles <= MAX_VECTOR_SIZE) {
-        for (const string& article : fi.articlesE) {
-          fprintf(file, " - [[%s]]", article.c_str());
+      if (fi.pages.count() <= MAX_VECTOR_SIZE) {
+        for (TitleTable::Id article : fi.pagesE.examples()) {
+          fprintf(file, " - [[%s]]", m_titleTable.title(article).c_str());
         }
       }
     }
@@ -218,7 +281,7 @@ void TemplateInfo::generateJSONInfo(FILE* file) {
   JSONObject jsonInfo;
   jsonInfo.add("name", m_templateName);
   jsonInfo.add("inclusions", m_numInclusions);
-  jsonInfo.add("pages", m_numArticles);
+  jsonInfo.add("pages", m_pages.count());
   if (m_namespace == TN_TEMPLATE) {
     JSONArray jsonRedirects;
     int numRedirects = 0;
@@ -226,7 +289,7 @@ void TemplateInfo::generateJSONInfo(FILE* file) {
       if (redirectName != m_templateName) {
         JSONObject jsonRedirect;
         jsonRedirect.add("name", redirectName);
-        jsonRedirect.add("pages", redirectInfo.numArticles);
+        jsonRedirect.add("pages", redirectInfo.pages.count());
         jsonRedirects.add(jsonRedirect);
         numRedirects++;
       }
@@ -248,25 +311,25 @@ void TemplateInfo::generateJSONInfo(FILE* file) {
       FieldInfo& fi = m_fieldInfos[param];
 
       jsonParameter.add("name", shortParam);
-      jsonParameter.add("pages", fi.numArticles);
-      jsonParameter.add("nonemptypages", fi.numArticlesNE);
+      jsonParameter.add("pages", fi.pages.count());
+      jsonParameter.add("nonemptypages", fi.pagesNE.count());
       jsonParameter.add("valid", fi.fieldDef);
 
-      if (fi.numArticlesNE <= MAX_VECTOR_SIZE) {
+      if (fi.pagesNE.count() <= MAX_VECTOR_SIZE) {
         JSONArray jsonExamples;
-        unordered_set<string> firstList;
-        for (const string& article : fi.articlesNE) {
+        unordered_set<TitleTable::Id> firstList;
+        for (TitleTable::Id article : fi.pagesNE.examples()) {
           JSONObject jsonExample;
-          jsonExample.add("title", article);
+          jsonExample.add("title", m_titleTable.title(article));
           jsonExample.add("type", "nonempty");
           jsonExamples.add(jsonExample);
           firstList.insert(article);
         }
-        if (fi.numArticles <= MAX_VECTOR_SIZE) {
-          for (const string& article : fi.articlesE) {
+        if (fi.pages.count() <= MAX_VECTOR_SIZE) {
+          for (TitleTable::Id article : fi.pagesE.examples()) {
             if (firstList.find(article) == firstList.end()) {
               JSONObject jsonExample;
-              jsonExample.add("title", article);
+              jsonExample.add("title", m_titleTable.title(article));
               jsonExample.add("type", "empty");
               jsonExamples.add(jsonExample);
             }
@@ -294,11 +357,11 @@ void TemplateInfo::generateJSONInfo(FILE* file) {
 
       JSONObject jsonFunction;
       jsonFunction.add("name", shortFunctionName);
-      jsonFunction.add("pages", functionInfo.numArticles);
-      if (functionInfo.numArticles <= MAX_VECTOR_SIZE) {
+      jsonFunction.add("pages", functionInfo.pages.count());
+      if (functionInfo.pages.count() <= MAX_VECTOR_SIZE) {
         JSONArray jsonExamples;
-        for (const string& article : functionInfo.articles) {
-          jsonExamples.add(article);
+        for (TitleTable::Id article : functionInfo.pages.examples()) {
+          jsonExamples.add(m_titleTable.title(article));
         }
         jsonFunction.add("examples", jsonExamples);
       }
@@ -312,29 +375,29 @@ void TemplateInfo::generateJSONInfo(FILE* file) {
     JSONArray jsonErrors;
     const int MAX_ERRORS = 5000;
     int errorsLimit = MAX_ERRORS;
-    for (const pair<const string, ArticleErrors>& article : m_articlesWithErrors) {
+    for (const pair<const string_view, ArticleErrors>& article : m_articlesWithErrors) {
       errorsLimit--;
       if (errorsLimit < 0) break;
 
       JSONObject jsonError;
       string shortParam;
-      jsonError.add("title", article.first);
+      jsonError.add("title", string(article.first));
       JSONArray jsonErrParams;
-      for (const string& parameter : article.second.badParamsNE) {
+      for (string_view parameter : article.second.badParamsNE) {
         JSONObject jsonErrParam;
         shortParam = cbl::legacyStringConv(cbl::utf8::substring(parameter, 0, 100));
         jsonErrParam.add("name", shortParam);
         jsonErrParam.add("type", "nonempty");
         jsonErrParams.add(jsonErrParam);
       }
-      for (const string& parameter : article.second.badParamsE) {
+      for (string_view parameter : article.second.badParamsE) {
         JSONObject jsonErrParam;
         shortParam = cbl::legacyStringConv(cbl::utf8::substring(parameter, 0, 100));
         jsonErrParam.add("name", shortParam);
         jsonErrParam.add("type", "empty");
         jsonErrParams.add(jsonErrParam);
       }
-      for (const string& parameter : article.second.dupParams) {
+      for (string_view parameter : article.second.dupParams) {
         JSONObject jsonErrParam;
         shortParam = cbl::legacyStringConv(cbl::utf8::substring(parameter, 0, 100));
         jsonErrParam.add("name", shortParam);
@@ -357,7 +420,7 @@ void TemplateInfo::generateInfo(FILE* file, OutputFormat format) {
   if (m_paramByCount.empty()) {
     for (const auto& [fieldName, fieldInfo] : m_fieldInfos) {
       if (fieldName.find("{{") == string::npos || fieldInfo.fieldDef != FD_NO) {
-        m_paramByCount.push_back(make_pair(-fieldInfo.numArticles, fieldName));
+        m_paramByCount.push_back(make_pair(-fieldInfo.pages.count(), fieldName));
       }
     }
     std::sort(m_paramByCount.begin(), m_paramByCount.end());
@@ -367,23 +430,23 @@ void TemplateInfo::generateInfo(FILE* file, OutputFormat format) {
     if (m_namespace == TN_TEMPLATE) {
       for (const auto& [fieldName, fieldInfo] : m_fieldInfos) {
         if (fieldInfo.fieldDef != FD_NO) {
-          for (const string& title : fieldInfo.articlesDup) {
-            m_articlesWithErrors[title].dupParams.push_back(fieldName);
+          for (TitleTable::Id title : fieldInfo.pagesDup.examples()) {
+            m_articlesWithErrors[m_titleTable.title(title)].dupParams.push_back(fieldName);
           }
         } else {
-          for (const string& title : fieldInfo.articlesNE) {
-            m_articlesWithErrors[title].badParamsNE.push_back(fieldName);
+          for (TitleTable::Id title : fieldInfo.pagesNE.examples()) {
+            m_articlesWithErrors[m_titleTable.title(title)].badParamsNE.push_back(fieldName);
           }
           if (!RE2::FullMatch(fieldName, reNumericField)) {
-            for (const string& title : fieldInfo.articlesE) {
-              m_articlesWithErrors[title].badParamsE.push_back(fieldName);
+            for (TitleTable::Id title : fieldInfo.pagesE.examples()) {
+              m_articlesWithErrors[m_titleTable.title(title)].badParamsE.push_back(fieldName);
             }
           }
         }
       }
     } else if (m_namespace == TN_MODULE) {
-      for (const string& title : m_articlesNP) {
-        m_articlesWithErrors.insert(make_pair(title, ArticleErrors()));
+      for (TitleTable::Id title : m_pagesNP.examples()) {
+        m_articlesWithErrors.insert(make_pair(m_titleTable.title(title), ArticleErrors()));
       }
     }
     m_numErrors = m_articlesWithErrors.size();
@@ -1,16 +1,22 @@
 #ifndef TEMPLATEINFO_H
 #define TEMPLATEINFO_H
 
+#include <cstdint>
 #include <cstdio>
+#include <deque>
 #include <map>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include "mwclient/parser.h"
 #include "mwclient/wiki.h"
 #include "side_template_data.h"
 
+// Maximum number of examples for parameters, redirects, etc. Examples are only written if there are no more pages.
 const int MAX_VECTOR_SIZE = 10;
+// Maximum number of pages kept for each kind of error (invalid parameter, duplicate parameter...).
+const int MAX_ERROR_EXAMPLES = 5000;
 
 enum OutputFormat {
   OF_TEXT = 1,
@@ -25,35 +31,75 @@ enum FieldDef {
   FD_LUA,
 };
 
+// Titles of pages stored as examples in PageList objects. Each title is stored once, even if it is an example for
+// many parameters, and lists only contain ids. Titles that are never stored as examples are not kept at all.
+class TitleTable {
+public:
+  using Id = uint32_t;
+
+  // Sets the page being read. All inclusions of a template in a page must be read consecutively.
+  void setCurrentPage(const std::string& title);
+  // Index of the current page, i.e. number of distinct pages read before it.
+  int currentPageIndex() const { return m_currentPageIndex; }
+  // Returns the id of the current page, adding its title to the table if needed.
+  Id currentTitleId();
+  Id addTitle(const std::string& title);
+  int size() const { return m_titles.size(); }
+  const std::string& title(Id id) const { return m_titles[id]; }
+
+private:
+  // std::deque so that references to titles remain valid when titles are added.
+  std::deque<std::string> m_titles;
+  std::string m_currentTitle;
+  int m_currentPageIndex = -1;
+  Id m_currentTitleId = 0;
+  bool m_currentTitleInTable = false;
+};
+
+// Set of pages using a template, a parameter, etc. Pages are counted, but only the first ones are kept as examples.
+class PageList {
+public:
+  // Adds the current page of `titleTable` if it is not already the last page added. Only the first `maxExamples`
+  // pages are kept as examples.
+  void addCurrentPage(TitleTable& titleTable, int maxExamples);
+  // Adds pages of `other`, which must all come after pages of this list. `titleIds` maps ids of the table of `other`
+  // to ids of the table of this list.
+  void merge(const PageList& other, const std::vector<TitleTable::Id>& titleIds, int maxExamples);
+  int count() const { return m_count; }
+  const std::vector<TitleTable::Id>& examples() const { return m_examples; }
+
+private:
+  std::vector<TitleTable::Id> m_examples;
+  int m_count = 0;
+  int m_lastPageIndex = -1;
+};
+
 class FieldInfo {
 public:
-  FieldInfo() : numArticles(0), numArticlesE(0), numArticlesNE(0), fieldDef(FD_NO), lastTemplateUID(-1) {}
-  std::vector<std::string> articles, articlesE, articlesNE, articlesDup;
-  int numArticles, numArticlesE, numArticlesNE, numArticlesDup;
-  FieldDef fieldDef;
-  void addValue(const std::string& title, const std::string& value, int templateUID);
+  PageList pages, pagesE, pagesNE, pagesDup;
+  FieldDef fieldDef = FD_NO;
+  // True if the parameter has been checked against the Lua DB (TemplateInfo only does it once per parameter).
+  bool checkedInLuaDB = false;
+  void addValue(TitleTable& titleTable, const std::string& value, int templateUID);
 
 private:
-  int lastTemplateUID;
+  int lastTemplateUID = -1;
 };
 
 class FunctionInfo {
 public:
-  FunctionInfo() : numArticles(0) {}
-  void addCall(const std::string& title);
-  std::vector<std::string> articles;
-  int numArticles;
+  void addCall(TitleTable& titleTable);
+  PageList pages;
 };
 
 struct RedirInfo {
-  std::vector<std::string> articles;
-  int numArticles;
+  PageList pages;
 };
 
 struct ArticleErrors {
-  std::vector<std::string> badParamsNE;
-  std::vector<std::string> badParamsE;
-  std::vector<std::string> dupParams;
+  std::vector<std::string_view> badParamsNE;
+  std::vector<std::string_view> badParamsE;
+  std::vector<std::string_view> dupParams;
 };
 
 class TemplateInfo {
@@ -62,18 +108,25 @@ public:
     TN_TEMPLATE,
     TN_MODULE,
   };
+  // If `logWarnings` is false, inconsistencies between the code of the template and `sideTemplateData` are not
+  // logged. This avoids logging them several times when inclusions are split between several objects.
   TemplateInfo(const std::string& templateName, const std::string& templateCode,
-               const SideTemplateData& sideTemplateData);
+               const SideTemplateData& sideTemplateData, bool logWarnings = true);
   void readInclusion(mwc::Wiki& wiki, const std::string& title, const wikicode::Template& template_);
+  // Adds inclusions read by `other`, which must have been created with the same parameters and must contain inclusions
+  // of pages that come after those of this object. This allows reading inclusions of a template in parallel in several
+  // objects. No inclusion can be read after that.
+  void merge(TemplateInfo&& other);
   void generateInfo(FILE* file, OutputFormat format);
+  const std::string& name() const { return m_templateName; }
   TemplateNamespace namespace_() { return m_namespace; }
   bool hasParameters() { return !m_fieldInfos.empty(); }
-  int getArticlesCount() { return m_numArticles; }
+  int getArticlesCount() { return m_pages.count(); }
   int getErrorsCount() { return m_numErrors; }
 
 private:
-  void readTemplateInclusion(mwc::Wiki& wiki, const std::string& title, const wikicode::Template& template_);
-  void readModuleInclusion(const std::string& title, const wikicode::Template& template_);
+  void readTemplateInclusion(mwc::Wiki& wiki, const wikicode::Template& template_);
+  void readModuleInclusion(const wikicode::Template& template_);
   void extractVars(const std::string& templateCode);
   void generateTextInfo(FILE* file);
   void generateJSONInfo(FILE* file);
@@ -86,16 +139,16 @@ private:
   std::map<std::string, RedirInfo> m_redirInfos;
   std::map<std::string, FieldInfo> m_fieldInfos;
   std::map<std::string, FunctionInfo> m_functionInfos;
-  std::vector<std::string> m_articles;
-  std::vector<std::string> m_articlesNP;
-  int m_numArticles;
-  int m_numArticlesNP;
+  TitleTable m_titleTable;
+  PageList m_pages;
+  PageList m_pagesNP;
   std::vector<std::pair<std::string, wikicode::List>> m_nestedVariables;
-  const SideTemplateData* m_sideTemplateData;
-  bool m_inLuaDB;
+  // Null if the template is not in the Lua DB.
+  const SideTemplateData::ParamValidator* m_luaParamValidator;
 
   std::vector<std::pair<int, std::string>> m_paramByCount;
-  std::map<std::string, ArticleErrors> m_articlesWithErrors;
+  // Keys are references to titles of m_titleTable.
+  std::map<std::string_view, ArticleErrors> m_articlesWithErrors;
 };
 
 #endif
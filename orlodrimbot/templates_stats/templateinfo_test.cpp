@@ -31,5 +31,26 @@ int main() {
   CBL_ASSERT(textOutput.find("\n*def (pages : 1, non vide : 1, existe : non)") != string::npos);
   // The use of {{{|safesubst:}}} in the template should not declare "" as a valid parameter.
   CBL_ASSERT(textOutput.find("\n* (pages") == string::npos);
+
+  // Pages are counted once even if they contain several inclusions, and examples are only listed for small counts.
+  TemplateInfo templateInfo2("Test", "{{{a}}} {{{b}}}", sideTemplateData);
+  wikicode::List inclusion2 = wikicode::parse("{{Test|a=1}}");
+  wikicode::List inclusion3 = wikicode::parse("{{Test|b=}}");
+  for (int i = 0; i < 12; i++) {
+    templateInfo2.readInclusion(wiki, "Page " + std::to_string(i), inclusion2[0].asTemplate());
+    if (i < 2) {
+      templateInfo2.readInclusion(wiki, "Page " + std::to_string(i), inclusion2[0].asTemplate());
+      templateInfo2.readInclusion(wiki, "Page " + std::to_string(i), inclusion3[0].asTemplate());
+    }
+  }
+  CBL_ASSERT_EQ(templateInfo2.getArticlesCount(), 12);
+  outputFile = tmpfile();
+  templateInfo2.generateInfo(outputFile, OF_TEXT);
+  textOutput = cbl::readOpenedFile(outputFile);
+  fclose(outputFile);
+  CBL_ASSERT(textOutput.find("\n*a (pages : 12, non vide : 12, existe : oui)\n") != string::npos) << textOutput;
+  CBL_ASSERT(textOutput.find("\n*b (pages : 2, non vide : 0, existe : oui) - [[Page 0]] - [[Page 1]]\n") !=
+             string::npos)
+      << textOutput;
   return 0;
 }
@@ -10,6 +10,7 @@ _LIB_BY_HEADER = {
   'curl/curl.h': 'curl',
   're2/re2.h': 're2',
   'sqlite3.h': 'sqlite3',
+  'zlib.h': 'z',
 }
 
 